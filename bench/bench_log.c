@@ -0,0 +1,168 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/log.h"
+
+// Cost of a request-path log message to the thread that logs it, with
+// several threads logging at once: fprintf to a shared stream, as the
+// servers printed, against the asynchronous log, and a log call below the
+// level. fprintf writes to /dev/null, the log to a temporary file. Measured
+// as CPU time of the logging threads, so the flusher's formatting is not
+// charged to them. The asynchronous log runs without a rate limit and each
+// thread logs more than its ring holds, so threads wait for the flusher
+// rather than drop. Fails if a message is dropped, or if the file is not
+// every message in timestamp order, stamped with the wall-clock time of
+// the run.
+
+#define THREADS 4
+#define MESSAGES 200000
+
+static FILE *sink;
+static double cpu_ns[THREADS];
+
+static double thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void *log_fprintf(void *arg) {
+    long id = (long)arg;
+    double start = thread_cpu_ns();
+    for (int i = 0; i < MESSAGES; i++) {
+        fprintf(sink, "Answering get-config %ld-%d with %d interfaces\n", id, i, 1);
+    }
+    cpu_ns[id] = thread_cpu_ns() - start;
+    return NULL;
+}
+
+static void *log_async(void *arg) {
+    long id = (long)arg;
+    double start = thread_cpu_ns();
+    for (int i = 0; i < MESSAGES; i++) {
+        log_info("Answering get-config %ld-%d with %d interfaces", id, i, 1);
+    }
+    cpu_ns[id] = thread_cpu_ns() - start;
+    return NULL;
+}
+
+static void *log_filtered(void *arg) {
+    long id = (long)arg;
+    double start = thread_cpu_ns();
+    for (int i = 0; i < MESSAGES; i++) {
+        log_debug("Answering get-config %ld-%d with %d interfaces", id, i, 1);
+    }
+    cpu_ns[id] = thread_cpu_ns() - start;
+    return NULL;
+}
+
+// Every message written, timestamps never going back and within the
+// seconds from started to finished. Records are stamped on the monotonic
+// clock and written in wall-clock time.
+static int check_log(const char *path, time_t started, time_t finished) {
+    char first[32], last_second[32];
+    struct tm tm;
+    strftime(first, sizeof(first), "%Y-%m-%d %H:%M:%S", localtime_r(&started, &tm));
+    strftime(last_second, sizeof(last_second), "%Y-%m-%d %H:%M:%S", localtime_r(&finished, &tm));
+    
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+    
+    char line[256];
+    char last[32] = "";
+    long lines = 0;
+    long out_of_order = 0;
+    long off_clock = 0;
+    while (fgets(line, sizeof(line), file)) {
+        // "2026-01-31 12:00:00.123456 INFO ...": the stamp sorts as text
+        if (strncmp(line, last, 26) < 0) {
+            out_of_order++;
+        }
+        if (strncmp(line, first, 19) < 0 || strncmp(line, last_second, 19) > 0) {
+            off_clock++;
+        }
+        memcpy(last, line, 26);
+        lines++;
+    }
+    fclose(file);
+    
+    printf("%-28s %8ld lines, %ld out of order, %ld outside the run\n", "async log file", lines,
+           out_of_order, off_clock);
+    if (lines != (long)THREADS * MESSAGES || out_of_order > 0 || off_clock > 0) {
+        fprintf(stderr, "FAIL: expected %ld lines in timestamp order, from %s to %s\n",
+                (long)THREADS * MESSAGES, first, last_second);
+        return -1;
+    }
+    return 0;
+}
+
+// Mean CPU time per message of the logging threads
+static double run(void *(*worker)(void *)) {
+    pthread_t threads[THREADS];
+    double total = 0;
+    
+    for (long i = 0; i < THREADS; i++) {
+        pthread_create(&threads[i], NULL, worker, (void *)i);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        total += cpu_ns[i];
+    }
+    return total / ((double)THREADS * MESSAGES);
+}
+
+int main(void) {
+    sink = fopen("/dev/null", "w");
+    if (!sink) {
+        perror("/dev/null");
+        return 1;
+    }
+    
+    char path[] = "/tmp/bench_log.XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+    
+    log_config_t config;
+    log_default_config(&config);
+    config.path = path;
+    config.rate_limit = 0;
+    config.ring_size = 1024 * 1024;
+    if (log_init(&config) != 0) {
+        unlink(path);
+        return 1;
+    }
+    
+    time_t started = time(NULL);
+    double fprintf_ns = run(log_fprintf);
+    double async_ns = run(log_async);
+    double filtered_ns = run(log_filtered);
+    log_shutdown();
+    time_t finished = time(NULL);
+    fclose(sink);
+    
+    printf("%d threads, %d messages each\n", THREADS, MESSAGES);
+    printf("%-28s %8.1f ns/msg\n", "fprintf (shared stream)", fprintf_ns);
+    printf("%-28s %8.1f ns/msg %llu dropped\n", "async log", async_ns,
+           (unsigned long long)log_dropped());
+    printf("%-28s %8.1f ns/msg\n", "below level", filtered_ns);
+    
+    int status = check_log(path, started, finished);
+    unlink(path);
+    if (log_dropped() != 0) {
+        fprintf(stderr, "FAIL: %llu messages dropped\n", (unsigned long long)log_dropped());
+        status = -1;
+    }
+    return status == 0 ? 0 : 1;
+}
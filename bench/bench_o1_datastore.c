@@ -0,0 +1,246 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/o1_datastore.h"
+#include "../src/o1_filter.h"
+
+// Fills the running datastore with N interfaces (default 1M), then measures
+// get-config style lookups alone and while a writer thread keeps editing,
+// a complete subtree-filtered get-config for one interface, and commits
+// of interfaces spread over the datastore with readers checking that none
+// sees part of one.
+
+#define COMMIT_SIZE 1000
+
+static o1_datastore_t *ds;
+static long num_interfaces = 1000000;
+static volatile int writer_running;
+static volatile int committer_running;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void make_update(long i, char *traceid, char *spanid, o1_interface_update_t *update) {
+    snprintf(traceid, 33, "%016lx%016lx", i, ~i);
+    snprintf(spanid, 17, "%016lx", i);
+    update->fields = O1_DS_STATUS | O1_DS_TRACEID | O1_DS_SPANID;
+    update->status = (i & 1) ? O1_IF_DOWN : O1_IF_UP;
+    update->traceid = traceid;
+    update->spanid = spanid;
+}
+
+static void *writer_main(void *arg) {
+    long *edits = arg;
+    char name[32], traceid[33], spanid[17];
+    o1_interface_update_t update;
+    unsigned int seed = 1;
+    
+    while (writer_running) {
+        long i = rand_r(&seed) % num_interfaces;
+        int len = snprintf(name, sizeof(name), "eth%ld", i);
+        make_update(i + *edits, traceid, spanid, &update);
+        o1_datastore_merge(ds, name, len, &update);
+        (*edits)++;
+    }
+    return NULL;
+}
+
+// One commit setting its generation as the timestamp of commit_size
+// interfaces, `stride` apart
+static void make_commit(o1_ds_change_t *changes, long commit_size, long stride,
+                        uint64_t generation) {
+    for (long n = 0; n < commit_size; n++) {
+        o1_ds_change_t *change = &changes[n];
+        memset(change, 0, sizeof(*change));
+        change->name_len = (uint8_t)snprintf(change->name, sizeof(change->name), "eth%ld",
+                                             n * stride);
+        change->fields = O1_DS_TIMESTAMP;
+        change->timestamp = generation;
+    }
+}
+
+static void *committer_main(void *arg) {
+    long *commits = arg;
+    long commit_size = num_interfaces < COMMIT_SIZE ? num_interfaces : COMMIT_SIZE;
+    o1_ds_change_t *changes = malloc(commit_size * sizeof(*changes));
+    
+    while (changes && committer_running) {
+        make_commit(changes, commit_size, num_interfaces / commit_size, 1000 + *commits);
+        if (o1_datastore_commit(ds, changes, commit_size) != 0) {
+            fprintf(stderr, "Commit failed\n");
+            break;
+        }
+        (*commits)++;
+    }
+    free(changes);
+    return NULL;
+}
+
+// Average ns per view reading the first and last interface of a commit;
+// `torn` counts views in which they differ, having seen part of one
+static double run_view_pairs(long count, long *torn) {
+    long commit_size = num_interfaces < COMMIT_SIZE ? num_interfaces : COMMIT_SIZE;
+    char first[32], last[32];
+    int first_len = snprintf(first, sizeof(first), "eth0");
+    int last_len = snprintf(last, sizeof(last), "eth%ld",
+                            (commit_size - 1) * (num_interfaces / commit_size));
+    o1_interface_record_t a, b;
+    o1_ds_view_t view;
+    
+    double start = now_ns();
+    for (long n = 0; n < count; n++) {
+        o1_datastore_view_begin(ds, &view);
+        int ret = o1_datastore_view_get(&view, first, first_len, &a) |
+                  o1_datastore_view_get(&view, last, last_len, &b);
+        o1_datastore_view_end(&view);
+        if (ret != 0 || a.timestamp != b.timestamp) {
+            (*torn)++;
+        }
+    }
+    return (now_ns() - start) / count;
+}
+
+// Average ns per get-config selecting one interface by key: filter
+// compile, index lookup and reply rendering
+static double run_filtered_get(long count) {
+    char xml[512];
+    o1_filter_t filter;
+    o1_reply_t out;
+    o1_ds_view_t view;
+    unsigned int seed = 11;
+    
+    o1_reply_init(&out, 0);
+    double start = now_ns();
+    for (long n = 0; n < count; n++) {
+        long i = rand_r(&seed) % num_interfaces;
+        int len = snprintf(xml, sizeof(xml),
+            "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"1\">"
+            "<get-config><source><running/></source><filter type=\"subtree\">"
+            "<o1-interface xmlns=\"urn:example:o1-interface\"><interface><name>eth%ld</name>"
+            "</interface></o1-interface></filter></get-config></rpc>", i);
+        o1_reply_reset(&out);
+        o1_datastore_view_begin(ds, &view);
+        int ret = o1_filter_parse(xml, len, &filter) != 0 || o1_reply_begin(&out, "1", 1) != 0 ||
+                  o1_filter_render(&filter, &view, NULL, &out) != 1;
+        o1_datastore_view_end(&view);
+        if (ret || o1_reply_end(&out) != 0 || !o1_reply_flatten(&out)) {
+            fprintf(stderr, "Filtered get-config failed for eth%ld\n", i);
+            break;
+        }
+    }
+    double elapsed = now_ns() - start;
+    
+    o1_reply_free(&out);
+    return elapsed / count;
+}
+
+// Average ns per lookup of random existing names
+static double run_lookups(long count) {
+    char name[32];
+    o1_interface_record_t record;
+    unsigned int seed = 7;
+    long misses = 0;
+    
+    double start = now_ns();
+    for (long n = 0; n < count; n++) {
+        long i = rand_r(&seed) % num_interfaces;
+        int len = snprintf(name, sizeof(name), "eth%ld", i);
+        if (o1_datastore_get(ds, name, len, &record) != 0) {
+            misses++;
+        }
+    }
+    double elapsed = now_ns() - start;
+    
+    if (misses) {
+        fprintf(stderr, "%ld lookups missed\n", misses);
+    }
+    return elapsed / count;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        num_interfaces = atol(argv[1]);
+    }
+    if (num_interfaces < 1) {
+        fprintf(stderr, "Usage: %s [interfaces]\n", argv[0]);
+        return 1;
+    }
+    
+    ds = o1_datastore_create(num_interfaces);
+    if (!ds) {
+        fprintf(stderr, "Failed to create datastore\n");
+        return 1;
+    }
+    
+    char name[32], traceid[33], spanid[17];
+    o1_interface_update_t update;
+    double start = now_ns();
+    for (long i = 0; i < num_interfaces; i++) {
+        int len = snprintf(name, sizeof(name), "eth%ld", i);
+        make_update(i, traceid, spanid, &update);
+        if (o1_datastore_merge(ds, name, len, &update) != 0) {
+            fprintf(stderr, "Failed to insert %s\n", name);
+            return 1;
+        }
+    }
+    double fill_ns = now_ns() - start;
+    
+    size_t memory = o1_datastore_memory(ds);
+    printf("interfaces:        %zu\n", o1_datastore_count(ds));
+    printf("fill:              %.1f ns/insert\n", fill_ns / num_interfaces);
+    printf("memory:            %.1f MB (%.0f bytes/interface)\n",
+           memory / (1024.0 * 1024.0), (double)memory / num_interfaces);
+    printf("lookup:            %.1f ns/op\n", run_lookups(2000000));
+    printf("filtered get:      %.1f ns/op\n", run_filtered_get(500000));
+    
+    // Readers never wait for the writer lock; only a racing edit of the
+    // same interface makes a lookup retry
+    long edits = 0;
+    pthread_t writer;
+    writer_running = 1;
+    pthread_create(&writer, NULL, writer_main, &edits);
+    start = now_ns();
+    double lookup_ns = run_lookups(2000000);
+    double write_s = (now_ns() - start) / 1e9;
+    writer_running = 0;
+    pthread_join(writer, NULL);
+    printf("lookup + writer:   %.1f ns/op (%.0f edits/s alongside)\n", lookup_ns, edits / write_s);
+    
+    // A commit copies the pages it touches and swaps in a new version
+    long commit_size = num_interfaces < COMMIT_SIZE ? num_interfaces : COMMIT_SIZE;
+    o1_ds_change_t *changes = malloc(commit_size * sizeof(*changes));
+    if (!changes) {
+        return 1;
+    }
+    start = now_ns();
+    for (int n = 0; n < 20; n++) {
+        make_commit(changes, commit_size, num_interfaces / commit_size, n + 1);
+        o1_datastore_commit(ds, changes, commit_size);
+    }
+    printf("commit:            %.3f ms for %ld interfaces, %ld apart\n",
+           (now_ns() - start) / 20 / 1e6, commit_size, num_interfaces / commit_size);
+    free(changes);
+    
+    // Readers see a commit whole or not at all, and never wait for it
+    long commits = 0, torn = 0;
+    pthread_t committer;
+    committer_running = 1;
+    pthread_create(&committer, NULL, committer_main, &commits);
+    start = now_ns();
+    double view_ns = run_view_pairs(1000000, &torn);
+    double commit_s = (now_ns() - start) / 1e9;
+    committer_running = 0;
+    pthread_join(committer, NULL);
+    printf("view + commits:    %.1f ns/view of 2 (%.0f commits/s alongside, %ld torn)\n",
+           view_ns, commits / commit_s, torn);
+    
+    o1_datastore_destroy(ds);
+    return 0;
+}
@@ -0,0 +1,84 @@
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/o1_hist.h"
+
+// Records a million log-uniformly distributed latencies (1 us to 10 s) and
+// compares the histogram against keeping every sample and sorting, the
+// exact answer: cost per recorded value, and the error of p50/p99/p99.9.
+// Fails if an error exceeds the histogram's 1/128 bucket precision.
+
+#define SAMPLES 1000000
+
+static uint64_t samples[SAMPLES];
+static uint64_t sorted[SAMPLES];
+static o1_hist_t hist;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t xorshift(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+int main(void) {
+    static const double percentiles[] = { 50.0, 99.0, 99.9 };
+    uint64_t state = 88172645463325252ULL;
+    
+    // 1 us .. 10 s, log-uniform: every bucket group gets used
+    for (int i = 0; i < SAMPLES; i++) {
+        double exponent = 3.0 + 7.0 * (double)(xorshift(&state) >> 11) / 9007199254740992.0;
+        samples[i] = (uint64_t)pow(10.0, exponent);
+    }
+    
+    o1_hist_init(&hist);
+    double start = now_ns();
+    for (int i = 0; i < SAMPLES; i++) {
+        o1_hist_record(&hist, samples[i]);
+    }
+    double record_ns = (now_ns() - start) / SAMPLES;
+    
+    start = now_ns();
+    for (int i = 0; i < SAMPLES; i++) {
+        sorted[i] = samples[i];
+    }
+    qsort(sorted, SAMPLES, sizeof(sorted[0]), compare_u64);
+    double sort_ns = (now_ns() - start) / SAMPLES;
+    
+    printf("%-28s %8.1f ns/value\n", "o1_hist_record", record_ns);
+    printf("%-28s %8.1f ns/value\n", "store + qsort", sort_ns);
+    
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+        size_t rank = (size_t)(percentiles[i] / 100.0 * SAMPLES + 0.5);
+        uint64_t exact = sorted[rank > 0 ? rank - 1 : 0];
+        uint64_t estimate = o1_hist_percentile(&hist, percentiles[i]);
+        double error = ((double)estimate - (double)exact) / (double)exact;
+        
+        printf("p%-27g %12llu ns exact %12llu ns  %+.3f%%\n", percentiles[i],
+               (unsigned long long)estimate, (unsigned long long)exact, error * 100);
+        if (error < -1.0 / 128 || error > 1.0 / 128) {
+            failed = 1;
+        }
+    }
+    
+    if (failed) {
+        fprintf(stderr, "Percentile outside bucket precision\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/o1_metrics.h"
+
+// Cost of recording one RPC (latency histogram and a counter) with several
+// threads recording at once: the per-thread shards against one set of
+// counters shared by all threads, updated under a mutex and with atomic
+// adds. Then renders the exposition and checks that no update was lost.
+
+#define THREADS 4
+#define RECORDS 2000000
+
+static const char *const rpc_names[] = { "get-config", "edit-config" };
+
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long long shared_count[2], shared_sum[2], shared_bytes;
+static double cpu_ns[THREADS];
+
+static double thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void *record_sharded(void *arg) {
+    long id = (long)arg;
+    double start = thread_cpu_ns();
+    for (int i = 0; i < RECORDS; i++) {
+        o1_metrics_rpc(i & 1, 20000 + (i & 1023) * 100, 0);
+        o1_metrics_add(O1_METRIC_REPLY_BYTES, 300);
+    }
+    cpu_ns[id] = thread_cpu_ns() - start;
+    return NULL;
+}
+
+static void *record_mutex(void *arg) {
+    long id = (long)arg;
+    double start = thread_cpu_ns();
+    for (int i = 0; i < RECORDS; i++) {
+        pthread_mutex_lock(&shared_lock);
+        shared_count[i & 1]++;
+        shared_sum[i & 1] += 20000 + (i & 1023) * 100;
+        shared_bytes += 300;
+        pthread_mutex_unlock(&shared_lock);
+    }
+    cpu_ns[id] = thread_cpu_ns() - start;
+    return NULL;
+}
+
+static void *record_atomic(void *arg) {
+    long id = (long)arg;
+    double start = thread_cpu_ns();
+    for (int i = 0; i < RECORDS; i++) {
+        __atomic_fetch_add(&shared_count[i & 1], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&shared_sum[i & 1], 20000 + (i & 1023) * 100, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&shared_bytes, 300, __ATOMIC_RELAXED);
+    }
+    cpu_ns[id] = thread_cpu_ns() - start;
+    return NULL;
+}
+
+// Mean CPU time per record of the recording threads
+static double run(void *(*worker)(void *)) {
+    pthread_t threads[THREADS];
+    double total = 0;
+    
+    for (long i = 0; i < THREADS; i++) {
+        pthread_create(&threads[i], NULL, worker, (void *)i);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        total += cpu_ns[i];
+    }
+    return total / ((double)THREADS * RECORDS);
+}
+
+int main(void) {
+    char expected[128];
+    o1_buf_t out;
+    
+    o1_metrics_init(rpc_names, 2);
+    double sharded_ns = run(record_sharded);
+    double mutex_ns = run(record_mutex);
+    double atomic_ns = run(record_atomic);
+    
+    o1_buf_init(&out);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int ret = o1_metrics_render(&out);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double render_us = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+    
+    printf("%d threads, %d records each\n", THREADS, RECORDS);
+    printf("%-28s %8.1f ns/record\n", "per-thread shards", sharded_ns);
+    printf("%-28s %8.1f ns/record\n", "shared, mutex", mutex_ns);
+    printf("%-28s %8.1f ns/record\n", "shared, atomic add", atomic_ns);
+    printf("%-28s %8.1f us, %zu bytes\n", "render exposition", render_us, out.len);
+    
+    snprintf(expected, sizeof(expected), "o1_rpc_duration_seconds_count{rpc=\"get-config\"} %d\n",
+             THREADS * RECORDS / 2);
+    int ok = ret == 0 && strstr(out.data, expected) != NULL;
+    snprintf(expected, sizeof(expected), "o1_reply_bytes_total %llu\n", 300ULL * THREADS * RECORDS);
+    ok = ok && strstr(out.data, expected) != NULL;
+    o1_buf_free(&out);
+    
+    if (!ok) {
+        fprintf(stderr, "Exposition is missing updates\n");
+        return 1;
+    }
+    return 0;
+}
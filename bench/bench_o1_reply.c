@@ -0,0 +1,224 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/o1_reply.h"
+#include "../src/o1_xml.h"
+
+// Builds the same one-interface get-config reply three ways: one snprintf
+// into a stack buffer, as the server built fixed replies; one o1_buf_printf
+// per element, as it rendered get-config data; and with the reply builder
+// in pretty and compact mode, including the flatten for the transport.
+// Each is timed as the fastest of several runs, as the VM is noisy.
+
+#define ITERATIONS 500000
+#define RUNS 5
+
+static const o1_reply_tag_t tag_data = O1_REPLY_TAG("data");
+static const o1_reply_tag_t tag_o1_interface = O1_REPLY_TAG_NS("o1-interface", O1_NS_INTERFACE);
+static const o1_reply_tag_t tag_interface = O1_REPLY_TAG("interface");
+static const o1_reply_tag_t tag_name = O1_REPLY_TAG("name");
+static const o1_reply_tag_t tag_status = O1_REPLY_TAG("status");
+static const o1_reply_tag_t tag_tracing = O1_REPLY_TAG("tracing");
+static const o1_reply_tag_t tag_traceid = O1_REPLY_TAG("traceid");
+static const o1_reply_tag_t tag_spanid = O1_REPLY_TAG("spanid");
+static const o1_reply_tag_t tag_timestamp = O1_REPLY_TAG("timestamp");
+
+static const char *name = "eth0";
+static const char *traceid = "0af7651916cd43dd8448eb211c80319c";
+static const char *spanid = "b7ad6b7169203331";
+static const unsigned long long timestamp = 1700000000000ULL;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int build_snprintf(char *out, size_t size) {
+    return snprintf(out, size,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<rpc-reply xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"1\">\n"
+        "  <data>\n"
+        "    <o1-interface xmlns=\"urn:example:o1-interface\">\n"
+        "      <interface>\n"
+        "        <name>%s</name>\n"
+        "        <status>%s</status>\n"
+        "        <tracing>\n"
+        "          <traceid>%s</traceid>\n"
+        "          <spanid>%s</spanid>\n"
+        "          <timestamp>%llu</timestamp>\n"
+        "        </tracing>\n"
+        "      </interface>\n"
+        "    </o1-interface>\n"
+        "  </data>\n"
+        "</rpc-reply>\n",
+        name, "up", traceid, spanid, timestamp);
+}
+
+static int build_snprintf_compact(char *out, size_t size) {
+    return snprintf(out, size,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<rpc-reply xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"1\">"
+        "<data><o1-interface xmlns=\"urn:example:o1-interface\"><interface>"
+        "<name>%s</name><status>%s</status><tracing>"
+        "<traceid>%s</traceid><spanid>%s</spanid><timestamp>%llu</timestamp>"
+        "</tracing></interface></o1-interface></data></rpc-reply>",
+        name, "up", traceid, spanid, timestamp);
+}
+
+static const char *build_printf(o1_buf_t *out) {
+    o1_buf_reset(out);
+    o1_buf_puts(out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                     "<rpc-reply xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"1\">\n");
+    o1_buf_puts(out, "  <data>\n"
+                     "    <o1-interface xmlns=\"urn:example:o1-interface\">\n");
+    o1_buf_puts(out, "      <interface>\n");
+    o1_buf_printf(out, "%s<%s>%.*s</%s>\n", "        ", "name", (int)strlen(name), name, "name");
+    o1_buf_printf(out, "%s<%s>%.*s</%s>\n", "        ", "status", 2, "up", "status");
+    o1_buf_printf(out, "        <%s>\n", "tracing");
+    o1_buf_printf(out, "%s<%s>%.*s</%s>\n", "          ", "traceid", (int)strlen(traceid), traceid,
+                  "traceid");
+    o1_buf_printf(out, "%s<%s>%.*s</%s>\n", "          ", "spanid", (int)strlen(spanid), spanid,
+                  "spanid");
+    o1_buf_printf(out, "%s<%s>%llu</%s>\n", "          ", "timestamp", timestamp, "timestamp");
+    o1_buf_printf(out, "        </%s>\n", "tracing");
+    o1_buf_puts(out, "      </interface>\n");
+    o1_buf_puts(out, "    </o1-interface>\n"
+                     "  </data>\n");
+    o1_buf_puts(out, "</rpc-reply>\n");
+    return out->data;
+}
+
+static const char *build_reply(o1_reply_t *reply) {
+    o1_reply_reset(reply);
+    o1_reply_begin(reply, "1", 1);
+    o1_reply_open(reply, &tag_data);
+    o1_reply_open(reply, &tag_o1_interface);
+    o1_reply_open(reply, &tag_interface);
+    o1_reply_leaf(reply, &tag_name, name, strlen(name));
+    o1_reply_leaf(reply, &tag_status, "up", 2);
+    o1_reply_open(reply, &tag_tracing);
+    o1_reply_leaf(reply, &tag_traceid, traceid, strlen(traceid));
+    o1_reply_leaf(reply, &tag_spanid, spanid, strlen(spanid));
+    o1_reply_leaf_u64(reply, &tag_timestamp, timestamp);
+    o1_reply_close(reply, &tag_tracing);
+    o1_reply_close(reply, &tag_interface);
+    o1_reply_close(reply, &tag_o1_interface);
+    o1_reply_close(reply, &tag_data);
+    return o1_reply_end(reply) == 0 ? o1_reply_flatten(reply) : NULL;
+}
+
+typedef enum {
+    BUILD_SNPRINTF,
+    BUILD_SNPRINTF_COMPACT,
+    BUILD_PRINTF,
+    BUILD_PRETTY,
+    BUILD_COMPACT,
+    BUILD_COUNT
+} build_t;
+
+static char scratch[2048];
+static o1_buf_t out;
+static o1_reply_t pretty, compact;
+
+static size_t build(build_t how) {
+    switch (how) {
+    case BUILD_SNPRINTF:
+        return (size_t)build_snprintf(scratch, sizeof(scratch));
+    case BUILD_SNPRINTF_COMPACT:
+        return (size_t)build_snprintf_compact(scratch, sizeof(scratch));
+    case BUILD_PRINTF:
+        return strlen(build_printf(&out));
+    case BUILD_PRETTY:
+        return build_reply(&pretty) ? o1_reply_length(&pretty) : 0;
+    default:
+        return build_reply(&compact) ? o1_reply_length(&compact) : 0;
+    }
+}
+
+int main(void) {
+    char expected[2048];
+    volatile size_t sink = 0;
+    
+    o1_reply_init(&pretty, 1);
+    o1_reply_init(&compact, 0);
+    o1_buf_init(&out);
+    
+    // The pretty builder output must match the old hand-formatted reply,
+    // and the compact one the same reply without the indentation
+    build_snprintf(expected, sizeof(expected));
+    const char *xml = build_reply(&pretty);
+    if (!xml || strcmp(xml, expected) != 0) {
+        fprintf(stderr, "Pretty reply differs:\n%s\n", xml ? xml : "(null)");
+        return 1;
+    }
+    if (strcmp(build_printf(&out), expected) != 0) {
+        fprintf(stderr, "o1_buf_printf reply differs:\n%s\n", out.data);
+        return 1;
+    }
+    build_snprintf_compact(expected, sizeof(expected));
+    xml = build_reply(&compact);
+    if (!xml || strcmp(xml, expected) != 0) {
+        fprintf(stderr, "Compact reply differs:\n%s\n", xml ? xml : "(null)");
+        return 1;
+    }
+    
+    // Variable text is escaped; markup is not
+    static const o1_reply_tag_t tag_error_tag = O1_REPLY_TAG("error-tag");
+    o1_reply_reset(&compact);
+    o1_reply_begin(&compact, "a\"&1", 4);
+    o1_reply_leaf(&compact, &tag_error_tag, "<&>", 3);
+    o1_reply_end(&compact);
+    xml = o1_reply_flatten(&compact);
+    if (!xml || !strstr(xml, "message-id=\"a&quot;&amp;1\">"
+                             "<error-tag>&lt;&amp;&gt;</error-tag></rpc-reply>")) {
+        fprintf(stderr, "Escaping failed:\n%s\n", xml ? xml : "(null)");
+        return 1;
+    }
+    
+    // Runs of the different builders are interleaved, so a slow spell of
+    // the VM does not favour one of them
+    double best[BUILD_COUNT];
+    size_t bytes[BUILD_COUNT];
+    for (int how = 0; how < BUILD_COUNT; how++) {
+        best[how] = 0;
+    }
+    for (int run = 0; run < RUNS; run++) {
+        for (int how = 0; how < BUILD_COUNT; how++) {
+            double start = now_ns();
+            for (int n = 0; n < ITERATIONS; n++) {
+                sink += build((build_t)how);
+            }
+            double ns = (now_ns() - start) / ITERATIONS;
+            if (run == 0 || ns < best[how]) {
+                best[how] = ns;
+            }
+            bytes[how] = build((build_t)how);
+        }
+    }
+    
+    int segments = 0;
+    o1_reply_iov(&compact, &segments);
+    
+    static const char *const labels[BUILD_COUNT] = {
+        "snprintf (pretty)", "snprintf (compact)", "o1_buf_printf per element",
+        "reply builder (pretty)", "reply builder (compact)"
+    };
+    for (int how = 0; how < BUILD_COUNT; how++) {
+        double baseline = best[how == BUILD_COMPACT || how == BUILD_SNPRINTF_COMPACT ?
+                               BUILD_SNPRINTF_COMPACT : BUILD_SNPRINTF];
+        printf("%-28s %8.1f ns/op %6zu bytes %5.2fx", labels[how], best[how], bytes[how],
+               baseline / best[how]);
+        if (how == BUILD_COMPACT) {
+            printf(" %d segment%s", segments, segments == 1 ? "" : "s");
+        }
+        printf("\n");
+    }
+    
+    o1_buf_free(&out);
+    o1_reply_free(&pretty);
+    o1_reply_free(&compact);
+    return sink == 0;
+}
@@ -0,0 +1,399 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/log.h"
+#include "../src/o1_rpc.h"
+
+// Drives the server's decode -> dispatch -> reply path for one session
+// without a transport, and counts the heap allocations it makes once warm.
+// Linked with --wrap for malloc, calloc and realloc, so every allocation
+// made by the O1 sources goes through the counters below. Fails unless a
+// steady-state RPC allocates nothing and every reply echoes its message-id,
+// or if a malformed message is not answered with a malformed-message error,
+// or if an edit-config with an invalid entry applies any of its entries,
+// or if a supported operation is not found by the dispatch table, or if
+// entity and character references in a request are not decoded exactly
+// once.
+// The request log is written to /dev/null through the asynchronous logger,
+// whose flusher thread is counted too.
+
+#define NUM_INTERFACES 64
+#define NUM_REQUESTS 256
+#define ITERATIONS 200000
+#define BULK_INTERFACES 24      // more than an edit-config searches in order
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static unsigned long allocations;
+
+void *__wrap_malloc(size_t size) {
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __real_realloc(ptr, size);
+}
+
+static char requests[NUM_REQUESTS][2048];
+static size_t request_len[NUM_REQUESTS];
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// A mix of filtered get-config, whole-list get-config, edit-config of one
+// interface and of BULK_INTERFACES, and the interface status RPCs, each
+// with its own message-id. The status RPCs name an interface created by an
+// earlier edit.
+static void make_requests(void) {
+    for (int i = 0; i < NUM_REQUESTS; i++) {
+        int n = i % NUM_INTERFACES;
+        int len;
+        
+        if (i % 32 == 3) {
+            len = snprintf(requests[i], sizeof(requests[i]),
+                "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"%d\">"
+                "<edit-config><target><running/></target><config>"
+                "<o1-interface xmlns=\"urn:example:o1-interface\">", i);
+            for (int k = 0; k < BULK_INTERFACES; k++) {
+                len += snprintf(requests[i] + len, sizeof(requests[i]) - len,
+                    "<interface><name>eth%d</name><status>%s</status></interface>",
+                    (n + 3 * k) % NUM_INTERFACES, ((i + k) & 1) ? "down" : "up");
+            }
+            len += snprintf(requests[i] + len, sizeof(requests[i]) - len,
+                "</o1-interface></config></edit-config></rpc>");
+        } else if (i % 4 == 0) {
+            len = snprintf(requests[i], sizeof(requests[i]),
+                "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"%d\">"
+                "<edit-config><target><running/></target><config>"
+                "<o1-interface xmlns=\"urn:example:o1-interface\"><interface><name>eth%d</name>"
+                "<status>%s</status><tracing xmlns=\"urn:example:tracing\">"
+                "<traceid>%016x%016x</traceid><spanid>%016x</spanid></tracing>"
+                "</interface></o1-interface></config></edit-config></rpc>",
+                i, n, (i & 4) ? "down" : "up", i, n, i);
+        } else if (i % 8 == 2) {
+            len = snprintf(requests[i], sizeof(requests[i]),
+                "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"%d\">"
+                "<get-interface-status xmlns=\"urn:example:o1-interface\">"
+                "<interface-name>eth%d</interface-name></get-interface-status></rpc>",
+                i, n & ~3);
+        } else if (i % 8 == 6) {
+            len = snprintf(requests[i], sizeof(requests[i]),
+                "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"%d\">"
+                "<set-interface-status xmlns=\"urn:example:o1-interface\">"
+                "<interface-name>eth%d</interface-name><status>%s</status>"
+                "<tracing><traceid>%016x%016x</traceid><spanid>%016x</spanid></tracing>"
+                "</set-interface-status></rpc>",
+                i, n & ~3, (i & 8) ? "down" : "up", i, n, i);
+        } else if (i % 16 == 1) {
+            len = snprintf(requests[i], sizeof(requests[i]),
+                "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id='id-%d'>"
+                "<get-config><source><running/></source></get-config></rpc>", i);
+        } else {
+            len = snprintf(requests[i], sizeof(requests[i]),
+                "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"%d\">"
+                "<get-config><source><running/></source><filter type=\"subtree\">"
+                "<o1-interface xmlns=\"urn:example:o1-interface\"><interface><name>eth%d</name>"
+                "</interface></o1-interface></filter></get-config></rpc>", i, n);
+        }
+        request_len[i] = (size_t)len;
+    }
+}
+
+static int echoes_message_id(o1_rpc_session_t *session, int i) {
+    char expected[64];
+    const char *xml = o1_reply_flatten(&session->reply);
+    
+    if (i % 16 == 1) {
+        snprintf(expected, sizeof(expected), "message-id=\"id-%d\"", i);
+    } else {
+        snprintf(expected, sizeof(expected), "message-id=\"%d\"", i);
+    }
+    return xml && strstr(xml, expected) && !strstr(xml, "<rpc-error>");
+}
+
+// Messages that are not a well-formed <rpc>, and the message-id the error
+// must echo (NULL when it cannot be read)
+static const struct {
+    const char *xml;
+    const char *message_id;
+} malformed[] = {
+    { "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"m1\">", "m1" },
+    { "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"m2\"><get-config", "m2" },
+    { "<rpc message-id=\"m3\"><get-config/></rpc>", NULL },
+    { "<hello xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\"/>", NULL },
+    { "get-config", NULL },
+};
+
+static int answers_malformed(o1_rpc_session_t *session) {
+    for (size_t i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++) {
+        char expected[64];
+        const char *xml = NULL;
+        
+        if (o1_rpc_handle(session, malformed[i].xml, strlen(malformed[i].xml)) == 0) {
+            xml = o1_reply_flatten(&session->reply);
+        }
+        snprintf(expected, sizeof(expected), "message-id=\"%s\"",
+                 malformed[i].message_id ? malformed[i].message_id : "");
+        if (!xml || !session->malformed || !session->error ||
+            !strstr(xml, "<error-type>rpc</error-type><error-tag>malformed-message</error-tag>") ||
+            (malformed[i].message_id != NULL) != (strstr(xml, "message-id=") != NULL) ||
+            (malformed[i].message_id && !strstr(xml, expected))) {
+            fprintf(stderr, "Malformed message %zu not answered:\n%s\n", i, xml ? xml : "(none)");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Every supported operation, as a request names it. The dispatch table is
+// a perfect hash; an operation whose slot collides with another's, or that
+// sits in the wrong slot, is not found.
+static const struct {
+    const char *ns;
+    const char *name;
+    o1_rpc_op_t op;
+} operations[] = {
+    { O1_NS_NETCONF, "get-config", O1_RPC_OP_GET_CONFIG },
+    { O1_NS_NETCONF, "edit-config", O1_RPC_OP_EDIT_CONFIG },
+    { O1_NS_INTERFACE, "get-interface-status", O1_RPC_OP_GET_INTERFACE_STATUS },
+    { O1_NS_INTERFACE, "set-interface-status", O1_RPC_OP_SET_INTERFACE_STATUS },
+    { O1_NS_NETCONF, "commit", O1_RPC_OP_COMMIT },
+    { O1_NS_NETCONF, "discard-changes", O1_RPC_OP_DISCARD_CHANGES },
+};
+
+static int dispatches_every_operation(o1_rpc_session_t *session) {
+    size_t count = sizeof(operations) / sizeof(operations[0]);
+    if (count != O1_RPC_OP_COUNT - 1) {
+        fprintf(stderr, "%zu operations checked, %d supported: add the new one here\n",
+                count, O1_RPC_OP_COUNT - 1);
+        return 0;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        char xml[256];
+        int len = snprintf(xml, sizeof(xml),
+            "<rpc xmlns=\"" O1_NS_NETCONF "\" message-id=\"op\"><%s xmlns=\"%s\"/></rpc>",
+            operations[i].name, operations[i].ns);
+        
+        // The operation is known before its handler runs, whatever it replies
+        o1_rpc_handle(session, xml, (size_t)len);
+        if (session->op != operations[i].op) {
+            fprintf(stderr, "Operation %s not dispatched\n", operations[i].name);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// An edit-config of two interfaces, of running or of the candidate
+static int edit_two(o1_rpc_session_t *session, const char *target, const char *first,
+                    const char *second) {
+    char xml[1024];
+    int len = snprintf(xml, sizeof(xml),
+        "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"edit\">"
+        "<edit-config><target><%s/></target><config>"
+        "<o1-interface xmlns=\"urn:example:o1-interface\">"
+        "<interface><name>%s</name></interface><interface><name>%s</name></interface>"
+        "</o1-interface></config></edit-config></rpc>",
+        target, first, second);
+    if (o1_rpc_handle(session, xml, (size_t)len) != 0) {
+        return -1;
+    }
+    return session->error ? -1 : 0;
+}
+
+static int has_status(o1_datastore_t *ds, const char *name, o1_if_status_t status) {
+    o1_interface_record_t record;
+    return o1_datastore_get(ds, name, strlen(name), &record) == 0 && record.status == status;
+}
+
+// An edit whose second entry is invalid must leave the target as it was:
+// neither a new interface nor a changed leaf from the first entry
+static int edits_atomically(void) {
+    o1_datastore_t *ds = o1_datastore_create(16);
+    o1_candidate_t *candidate = ds ? o1_candidate_create(ds, 16) : NULL;
+    o1_rpc_session_t *session = candidate ? o1_rpc_session_create(ds, candidate, 0) : NULL;
+    o1_interface_record_t record;
+    const char *failed = NULL;
+    
+    if (!session) {
+        failed = "setup";
+    } else if (edit_two(session, "running",
+                        "a</name><status>down", "b</name><status>down") != 0 ||
+               !has_status(ds, "a", O1_IF_DOWN) || !has_status(ds, "b", O1_IF_DOWN)) {
+        failed = "valid edit of running";
+    } else if (edit_two(session, "running",
+                        "a</name><status>up", "b</name><status>sideways") == 0 ||
+               !has_status(ds, "a", O1_IF_DOWN)) {
+        failed = "changed leaf kept after an invalid entry";
+    } else if (edit_two(session, "running",
+                        "c</name><status>up", "b</name><tracing>"
+                        "<traceid>xyz</traceid></tracing>") == 0 ||
+               o1_datastore_get(ds, "c", 1, &record) == 0) {
+        failed = "new interface kept after an invalid entry";
+    } else if (edit_two(session, "candidate",
+                        "c</name><status>up", "b</name><status>sideways") == 0 ||
+               o1_candidate_changes(candidate) != 0) {
+        failed = "candidate edited after an invalid entry";
+    } else if (edit_two(session, "candidate",
+                        "c</name><status>up", "a</name><status>up") != 0 ||
+               o1_candidate_changes(candidate) != 2) {
+        failed = "valid edit of the candidate";
+    }
+    
+    if (failed) {
+        fprintf(stderr, "edit-config not atomic: %s\n", failed);
+    }
+    o1_rpc_session_destroy(session);
+    o1_candidate_destroy(candidate);
+    o1_datastore_destroy(ds);
+    return failed == NULL;
+}
+
+// The reply to one request, or NULL
+static const char *handle(o1_rpc_session_t *session, const char *xml) {
+    if (o1_rpc_handle(session, xml, strlen(xml)) != 0) {
+        return NULL;
+    }
+    return o1_reply_flatten(&session->reply);
+}
+
+// References in request values are decoded before they are stored or
+// compared, so the reply escapes the value once. A malformed reference
+// is an error, and a message-id holding one cannot be echoed.
+static int decodes_entities(void) {
+    o1_datastore_t *ds = o1_datastore_create(16);
+    o1_rpc_session_t *session = ds ? o1_rpc_session_create(ds, NULL, 0) : NULL;
+    o1_interface_record_t record;
+    const char *failed = NULL;
+    const char *xml = NULL;
+    
+    if (!session) {
+        failed = "setup";
+    } else if (!(xml = handle(session,
+                   "<rpc xmlns=\"" O1_NS_NETCONF "\" message-id=\"a&amp;&#x3C;&#98;\">"
+                   "<edit-config><target><running/></target><config>"
+                   "<o1-interface xmlns=\"" O1_NS_INTERFACE "\"><interface>"
+                   "<name>eth&amp;0</name><status>d&#111;wn</status></interface>"
+                   "</o1-interface></config></edit-config></rpc>")) ||
+               session->error || !strstr(xml, "message-id=\"a&amp;&lt;b\"")) {
+        failed = "edit-config";
+    } else if (o1_datastore_get(ds, "eth&0", 5, &record) != 0 || record.status != O1_IF_DOWN) {
+        failed = "stored name";
+    } else if (!(xml = handle(session,
+                   "<rpc xmlns=\"" O1_NS_NETCONF "\" message-id=\"g\">"
+                   "<get-config><source><running/></source><filter type=\"subtree\">"
+                   "<o1-interface xmlns=\"" O1_NS_INTERFACE "\"><interface>"
+                   "<name>eth&#38;0</name></interface></o1-interface></filter>"
+                   "</get-config></rpc>")) ||
+               !strstr(xml, "<name>eth&amp;0</name>") || strstr(xml, "&amp;amp;")) {
+        failed = "get-config filter";
+    } else if (!(xml = handle(session,
+                   "<rpc xmlns=\"" O1_NS_NETCONF "\" message-id=\"s\">"
+                   "<get-interface-status xmlns=\"" O1_NS_INTERFACE "\">"
+                   "<interface-name>eth&#x26;0</interface-name></get-interface-status></rpc>")) ||
+               session->error) {
+        failed = "get-interface-status";
+    } else if (!(xml = handle(session,
+                   "<rpc xmlns=\"" O1_NS_NETCONF "\" message-id=\"m\">"
+                   "<edit-config><target><running/></target><config>"
+                   "<o1-interface xmlns=\"" O1_NS_INTERFACE "\"><interface>"
+                   "<name>eth&nbsp;1</name></interface>"
+                   "</o1-interface></config></edit-config></rpc>")) ||
+               !session->error || o1_datastore_get(ds, "eth&nbsp;1", 10, &record) == 0) {
+        failed = "unknown entity accepted";
+    } else if (!(xml = handle(session,
+                   "<rpc xmlns=\"" O1_NS_NETCONF "\" message-id=\"x&#0;\">"
+                   "<get-config/></rpc>")) ||
+               !session->malformed || strstr(xml, "message-id=")) {
+        failed = "malformed message-id";
+    }
+    
+    if (failed) {
+        fprintf(stderr, "References not decoded: %s\n%s\n", failed, xml ? xml : "");
+    }
+    o1_rpc_session_destroy(session);
+    o1_datastore_destroy(ds);
+    return failed == NULL;
+}
+
+int main(void) {
+    // The RPC path logs every request
+    log_config_t log_config;
+    log_default_config(&log_config);
+    log_config.level = LOG_LEVEL_DEBUG;
+    log_config.path = "/dev/null";
+    if (log_init(&log_config) != 0) {
+        return 1;
+    }
+    
+    o1_datastore_t *ds = o1_datastore_create(NUM_INTERFACES);
+    o1_rpc_session_t *session = ds ? o1_rpc_session_create(ds, NULL, 0) : NULL;
+    if (!session) {
+        fprintf(stderr, "Failed to create datastore or session\n");
+        return 1;
+    }
+    make_requests();
+    if (!answers_malformed(session) || !dispatches_every_operation(session) ||
+        !edits_atomically() || !decodes_entities()) {
+        return 1;
+    }
+    
+    // Warm up: the edits populate the datastore, the whole-list get-config
+    // grows the session's reply buffers to their largest
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < NUM_REQUESTS; i++) {
+            if (o1_rpc_handle(session, requests[i], request_len[i]) != 0 ||
+                !echoes_message_id(session, i)) {
+                fprintf(stderr, "Request %d failed:\n%s\n", i, o1_reply_flatten(&session->reply));
+                return 1;
+            }
+        }
+    }
+    
+    // Let the flusher make its one-time allocations (stdio buffer, time zone)
+    struct timespec flush_wait = { 0, 50 * 1000000L };
+    nanosleep(&flush_wait, NULL);
+    
+    __atomic_store_n(&allocations, 0, __ATOMIC_RELAXED);
+    double start = now_ns();
+    for (int n = 0; n < ITERATIONS; n++) {
+        int i = n % NUM_REQUESTS;
+        if (o1_rpc_handle(session, requests[i], request_len[i]) != 0 ||
+            !o1_reply_flatten(&session->reply)) {
+            fprintf(stderr, "Request %d failed\n", i);
+            return 1;
+        }
+    }
+    double rpc_ns = (now_ns() - start) / ITERATIONS;
+    nanosleep(&flush_wait, NULL);
+    unsigned long steady = __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+    
+    printf("%-28s %8.1f ns/op\n", "decode+dispatch+reply", rpc_ns);
+    printf("%-28s %8lu over %d RPCs\n", "heap allocations", steady, ITERATIONS);
+    
+    o1_rpc_session_destroy(session);
+    o1_datastore_destroy(ds);
+    log_shutdown();
+    
+    if (steady != 0) {
+        fprintf(stderr, "Steady-state RPCs allocated memory\n");
+        return 1;
+    }
+    return 0;
+}
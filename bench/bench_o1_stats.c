@@ -0,0 +1,148 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../src/o1_stats.h"
+
+// Cost of one interface counter update with several feed threads writing
+// at once: each on its own shard against all of them on one shared array
+// with atomic adds, both with and without a reader summing every interface
+// in a loop (as get-config does). Then checks that no update was lost.
+
+#define THREADS 4
+#define INTERFACES 65536
+#define UPDATES 4000000
+
+static o1_stats_t *stats;
+static o1_if_counters_t *shared;
+static volatile int reading;
+static double cpu_ns[THREADS];
+static unsigned long long reader_passes;
+
+static double thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Interfaces are visited in a scattered but fixed order per thread
+static size_t next_index(size_t i, long id) {
+    return (i * 40503u + (size_t)id * 7919u) & (INTERFACES - 1);
+}
+
+static void *update_sharded(void *arg) {
+    long id = (long)arg;
+    o1_if_counters_t delta = { 1, 2, 1500, 3000 };
+    int shard = o1_stats_claim_shard(stats);
+    double start = thread_cpu_ns();
+    for (size_t i = 0; i < UPDATES; i++) {
+        o1_stats_add(stats, shard, next_index(i, id), &delta);
+    }
+    cpu_ns[id] = thread_cpu_ns() - start;
+    o1_stats_release_shard(stats, shard);
+    return NULL;
+}
+
+static void *update_shared(void *arg) {
+    long id = (long)arg;
+    double start = thread_cpu_ns();
+    for (size_t i = 0; i < UPDATES; i++) {
+        o1_if_counters_t *counters = &shared[next_index(i, id)];
+        __atomic_fetch_add(&counters->packets_in, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&counters->packets_out, 2, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&counters->bytes_in, 1500, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&counters->bytes_out, 3000, __ATOMIC_RELAXED);
+    }
+    cpu_ns[id] = thread_cpu_ns() - start;
+    return NULL;
+}
+
+static void *read_sharded(void *arg) {
+    (void)arg;
+    o1_if_counters_t total;
+    while (reading) {
+        for (size_t i = 0; i < INTERFACES; i++) {
+            o1_stats_read(stats, i, &total);
+        }
+        reader_passes++;
+    }
+    return NULL;
+}
+
+static void *read_shared(void *arg) {
+    (void)arg;
+    volatile uint64_t sink = 0;
+    while (reading) {
+        for (size_t i = 0; i < INTERFACES; i++) {
+            sink += __atomic_load_n(&shared[i].packets_in, __ATOMIC_RELAXED) +
+                    __atomic_load_n(&shared[i].packets_out, __ATOMIC_RELAXED) +
+                    __atomic_load_n(&shared[i].bytes_in, __ATOMIC_RELAXED) +
+                    __atomic_load_n(&shared[i].bytes_out, __ATOMIC_RELAXED);
+        }
+        reader_passes++;
+    }
+    return NULL;
+}
+
+// Mean CPU time per update of the writing threads
+static double run(void *(*writer)(void *), void *(*reader)(void *)) {
+    pthread_t threads[THREADS], reader_thread;
+    double total = 0;
+    
+    reader_passes = 0;
+    reading = 1;
+    if (reader) {
+        pthread_create(&reader_thread, NULL, reader, NULL);
+    }
+    for (long i = 0; i < THREADS; i++) {
+        pthread_create(&threads[i], NULL, writer, (void *)i);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        total += cpu_ns[i];
+    }
+    reading = 0;
+    if (reader) {
+        pthread_join(reader_thread, NULL);
+    }
+    return total / ((double)THREADS * UPDATES);
+}
+
+int main(void) {
+    stats = o1_stats_create(INTERFACES, THREADS);
+    shared = calloc(INTERFACES, sizeof(*shared));
+    if (!stats || !shared) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    
+    printf("%d threads, %d updates each over %d interfaces\n", THREADS, UPDATES, INTERFACES);
+    double ns = run(update_sharded, NULL);
+    printf("%-32s %8.1f ns/update\n", "per-writer shards", ns);
+    ns = run(update_sharded, read_sharded);
+    printf("%-32s %8.1f ns/update, %llu reader passes\n", "per-writer shards, reader", ns, reader_passes);
+    ns = run(update_shared, NULL);
+    printf("%-32s %8.1f ns/update\n", "shared, atomic add", ns);
+    ns = run(update_shared, read_shared);
+    printf("%-32s %8.1f ns/update, %llu reader passes\n", "shared, atomic add, reader", ns, reader_passes);
+    
+    // Two sharded runs went into stats
+    o1_if_counters_t total, sum = { 0, 0, 0, 0 };
+    for (size_t i = 0; i < INTERFACES; i++) {
+        o1_stats_read(stats, i, &total);
+        sum.packets_in += total.packets_in;
+        sum.bytes_out += total.bytes_out;
+    }
+    unsigned long long expected = 2ULL * THREADS * UPDATES;
+    int ok = sum.packets_in == expected && sum.bytes_out == 3000 * expected;
+    
+    o1_stats_destroy(stats);
+    free(shared);
+    if (!ok) {
+        fprintf(stderr, "Statistics are missing updates\n");
+        return 1;
+    }
+    return 0;
+}
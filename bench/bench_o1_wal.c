@@ -0,0 +1,336 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../src/o1_datastore.h"
+#include "../src/o1_wal.h"
+
+// Persistence of the running datastore in a scratch directory. A child
+// process measures group-committed edits from several threads, fills the
+// datastore to N interfaces (default 1M), takes a snapshot, edits a tail of
+// M interfaces (default 100k) and exits without closing, as in a crash.
+// The parent then times a restart: snapshot load plus log replay.
+//
+// Last, several threads commit batches of new interfaces while snapshots
+// are taken back to back, and a restart must find every one of them.
+
+#define COMMIT_THREADS 8
+#define COMMITS_PER_THREAD 2000
+
+// Commits large enough that snapshots land in the middle of them
+#define RACE_THREADS 4
+#define RACE_COMMITS 16
+#define RACE_BATCH 4096         // interfaces per commit
+
+static o1_datastore_t *ds;
+static long num_interfaces = 1000000;
+static long tail = 100000;
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void make_update(long i, char *traceid, char *spanid, o1_interface_update_t *update) {
+    snprintf(traceid, 33, "%016lx%016lx", i, ~i);
+    snprintf(spanid, 17, "%016lx", i);
+    update->fields = O1_DS_STATUS | O1_DS_TRACEID | O1_DS_SPANID;
+    update->status = (i & 1) ? O1_IF_DOWN : O1_IF_UP;
+    update->traceid = traceid;
+    update->spanid = spanid;
+}
+
+// One edit-config at a time, each waiting for its edit to be durable
+static void *committer_main(void *arg) {
+    long thread = (long)arg;
+    char name[32], traceid[33], spanid[17];
+    o1_interface_update_t update;
+    
+    for (long n = 0; n < COMMITS_PER_THREAD; n++) {
+        long i = (thread * COMMITS_PER_THREAD + n) % num_interfaces;
+        int len = snprintf(name, sizeof(name), "eth%ld", i);
+        make_update(i, traceid, spanid, &update);
+        if (o1_datastore_merge(ds, name, len, &update) != 0 || o1_datastore_sync(ds) != 0) {
+            fprintf(stderr, "Commit of %s failed\n", name);
+            break;
+        }
+    }
+    return NULL;
+}
+
+static int write_phase(const char *dir) {
+    o1_wal_config_t config;
+    o1_wal_default_config(&config);
+    config.dir = dir;
+    config.snapshot_interval = 0;
+    
+    ds = o1_datastore_create(num_interfaces);
+    o1_wal_t *wal = ds ? o1_wal_open(&config, ds) : NULL;
+    if (!wal) {
+        fprintf(stderr, "Failed to open write-ahead log in %s\n", dir);
+        return 1;
+    }
+    
+    // Group commit: concurrent edits share each fsync
+    pthread_t threads[COMMIT_THREADS];
+    double start = now_ns();
+    for (long t = 0; t < COMMIT_THREADS; t++) {
+        pthread_create(&threads[t], NULL, committer_main, (void *)t);
+    }
+    for (int t = 0; t < COMMIT_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    double commit_s = (now_ns() - start) / 1e9;
+    o1_wal_stats_t stats;
+    o1_wal_stats(wal, &stats);
+    long commits = (long)COMMIT_THREADS * COMMITS_PER_THREAD;
+    printf("durable edits:     %.0f/s from %d threads, %.1f edits per fsync\n",
+           commits / commit_s, COMMIT_THREADS, (double)commits / stats.syncs);
+    
+    char name[32], traceid[33], spanid[17];
+    o1_interface_update_t update;
+    start = now_ns();
+    for (long i = 0; i < num_interfaces; i++) {
+        int len = snprintf(name, sizeof(name), "eth%ld", i);
+        make_update(i, traceid, spanid, &update);
+        if (o1_datastore_merge(ds, name, len, &update) != 0) {
+            fprintf(stderr, "Failed to insert %s\n", name);
+            return 1;
+        }
+    }
+    o1_datastore_sync(ds);
+    printf("logged fill:       %.1f ns/insert, one sync\n", (now_ns() - start) / num_interfaces);
+    
+    start = now_ns();
+    if (o1_wal_snapshot(wal) != 0) {
+        fprintf(stderr, "Snapshot failed\n");
+        return 1;
+    }
+    printf("snapshot:          %.3f s for %zu interfaces\n", (now_ns() - start) / 1e9,
+           o1_datastore_count(ds));
+    
+    // Edits after the snapshot, replayed from the log on restart
+    for (long n = 0; n < tail; n++) {
+        long i = (n * 7919) % num_interfaces;
+        int len = snprintf(name, sizeof(name), "eth%ld", i);
+        make_update(i + 1, traceid, spanid, &update);
+        o1_datastore_merge(ds, name, len, &update);
+    }
+    o1_datastore_sync(ds);
+    
+    // Crash: no close, no final snapshot
+    fflush(stdout);
+    _exit(0);
+}
+
+static int racing;              // race threads still committing
+
+static int race_name(long thread, long commit, long k, char *name) {
+    return snprintf(name, O1_DS_NAME_MAX + 1, "race%ld.%ld.%ld", thread, commit, k);
+}
+
+// Commits of RACE_BATCH new interfaces each; the timestamp tells them apart
+static void *race_main(void *arg) {
+    long thread = (long)arg;
+    o1_ds_change_t *changes = malloc(RACE_BATCH * sizeof(*changes));
+    
+    for (long n = 0; changes && n < RACE_COMMITS; n++) {
+        memset(changes, 0, RACE_BATCH * sizeof(*changes));
+        for (long k = 0; k < RACE_BATCH; k++) {
+            changes[k].name_len = race_name(thread, n, k, changes[k].name);
+            changes[k].fields = O1_DS_STATUS | O1_DS_TIMESTAMP;
+            changes[k].status = (k & 1) ? O1_IF_DOWN : O1_IF_UP;
+            changes[k].timestamp = n * RACE_BATCH + k + 1;
+        }
+        if (o1_datastore_commit(ds, changes, RACE_BATCH) != 0) {
+            fprintf(stderr, "Commit %ld of thread %ld failed\n", n, thread);
+            break;
+        }
+    }
+    free(changes);
+    __atomic_sub_fetch(&racing, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Commits racing forced snapshots, then a crash
+static int race_phase(const char *dir) {
+    o1_wal_config_t config;
+    o1_wal_default_config(&config);
+    config.dir = dir;
+    config.snapshot_interval = 0;
+    
+    ds = o1_datastore_create((size_t)RACE_THREADS * RACE_COMMITS * RACE_BATCH);
+    o1_wal_t *wal = ds ? o1_wal_open(&config, ds) : NULL;
+    if (!wal) {
+        fprintf(stderr, "Failed to open write-ahead log in %s\n", dir);
+        return 1;
+    }
+    
+    pthread_t threads[RACE_THREADS];
+    racing = RACE_THREADS;
+    for (long t = 0; t < RACE_THREADS; t++) {
+        pthread_create(&threads[t], NULL, race_main, (void *)t);
+    }
+    int snapshots = 0;
+    while (__atomic_load_n(&racing, __ATOMIC_ACQUIRE) > 0) {
+        if (o1_wal_snapshot(wal) != 0) {
+            fprintf(stderr, "Snapshot failed\n");
+            return 1;
+        }
+        snapshots++;
+    }
+    for (int t = 0; t < RACE_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    o1_datastore_sync(ds);
+    printf("commit race:       %d snapshots during %d commits\n", snapshots,
+           RACE_THREADS * RACE_COMMITS);
+    
+    fflush(stdout);
+    _exit(0);
+}
+
+// Reopen what race_phase left and look for every interface it committed
+static int check_race(const char *dir) {
+    o1_wal_config_t config;
+    o1_wal_default_config(&config);
+    config.dir = dir;
+    config.snapshot_interval = 0;
+    
+    ds = o1_datastore_create((size_t)RACE_THREADS * RACE_COMMITS * RACE_BATCH);
+    o1_wal_t *wal = ds ? o1_wal_open(&config, ds) : NULL;
+    if (!wal) {
+        fprintf(stderr, "Failed to reopen %s\n", dir);
+        o1_datastore_destroy(ds);
+        return -1;
+    }
+    
+    long lost = 0;
+    for (long t = 0; t < RACE_THREADS; t++) {
+        for (long n = 0; n < RACE_COMMITS; n++) {
+            for (long k = 0; k < RACE_BATCH; k++) {
+                char name[O1_DS_NAME_MAX + 1];
+                o1_interface_record_t record;
+                int len = race_name(t, n, k, name);
+                if (o1_datastore_get(ds, name, len, &record) != 0 ||
+                    record.timestamp != (uint64_t)(n * RACE_BATCH + k + 1) ||
+                    record.status != ((k & 1) ? O1_IF_DOWN : O1_IF_UP)) {
+                    lost++;
+                }
+            }
+        }
+    }
+    
+    o1_wal_close(wal);
+    o1_datastore_destroy(ds);
+    if (lost > 0) {
+        fprintf(stderr, "%ld committed interfaces missing after restart\n", lost);
+        return -1;
+    }
+    return 0;
+}
+
+static void remove_dir(const char *dir) {
+    DIR *d = opendir(dir);
+    struct dirent *entry;
+    char path[4096];
+    
+    while (d && (entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] != '.') {
+            snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+            unlink(path);
+        }
+    }
+    if (d) {
+        closedir(d);
+    }
+    rmdir(dir);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        num_interfaces = atol(argv[1]);
+    }
+    if (argc > 2) {
+        tail = atol(argv[2]);
+    }
+    if (num_interfaces < 1 || tail < 0) {
+        fprintf(stderr, "Usage: %s [interfaces] [tail-edits]\n", argv[0]);
+        return 1;
+    }
+    
+    char dir[] = "/tmp/bench_o1_wal.XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        return write_phase(dir);
+    }
+    int status;
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+        remove_dir(dir);
+        return 1;
+    }
+    
+    // Restart into an empty datastore
+    o1_wal_config_t config;
+    o1_wal_default_config(&config);
+    config.dir = dir;
+    config.snapshot_interval = 0;
+    
+    ds = o1_datastore_create(num_interfaces);
+    double start = now_ns();
+    o1_wal_t *wal = ds ? o1_wal_open(&config, ds) : NULL;
+    double open_s = (now_ns() - start) / 1e9;
+    if (!wal) {
+        fprintf(stderr, "Failed to reopen %s\n", dir);
+        remove_dir(dir);
+        return 1;
+    }
+    
+    o1_wal_stats_t stats;
+    o1_wal_stats(wal, &stats);
+    printf("restart:           %.3f s (%zu from snapshot, %zu log records replayed)\n",
+           open_s, stats.loaded, stats.replayed);
+    
+    o1_interface_record_t record;
+    long last = ((tail - 1) * 7919) % num_interfaces;
+    char name[32];
+    int len = snprintf(name, sizeof(name), "eth%ld", last);
+    if (o1_datastore_count(ds) != (size_t)num_interfaces ||
+        (tail > 0 && (o1_datastore_get(ds, name, len, &record) != 0 ||
+                      record.status != (((last + 1) & 1) ? O1_IF_DOWN : O1_IF_UP)))) {
+        fprintf(stderr, "Restored datastore does not match what was written\n");
+    }
+    
+    o1_wal_close(wal);
+    o1_datastore_destroy(ds);
+    remove_dir(dir);
+    
+    char race_dir[] = "/tmp/bench_o1_wal.XXXXXX";
+    if (!mkdtemp(race_dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0) {
+        return race_phase(race_dir);
+    }
+    int ret = pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+              WEXITSTATUS(status) == 0 ? check_race(race_dir) : -1;
+    remove_dir(race_dir);
+    return ret == 0 ? 0 : 1;
+}
@@ -0,0 +1,427 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/o1_xml.h"
+
+// Compares the single-pass tokenizer against the strstr-based parsers it
+// replaced in o1_netconf_server.c. First on the bodies the server actually
+// receives, all under 1 KB: an edit-config of one interface, a filtered
+// get-config and the two interface status RPCs, which never had a strstr
+// parser and are compared with one written the same way. Then on
+// edit-configs of 1 KB to 64 KB whose leaves follow a long description.
+// Each time is the fastest of several runs, as the VM is noisy.
+//
+// On the small bodies the tokenizer is the slower one, at 0.05x-0.6x: it
+// tokenizes every tag, where the baseline jumps between two or three
+// substrings. It overtakes strstr at about 8 KB.
+//
+// Before timing, documents cut off inside a tag are checked to be rejected
+// without reading past their end.
+
+typedef struct {
+    char traceid[33];
+    char spanid[17];
+    char interface_name[64];
+    char operation[32];
+    char status[32];
+} legacy_o1_data_t;
+
+// The previous parse_o1_get_config(), kept verbatim as the baseline
+static int legacy_parse_o1_get_config(const char *xml_data, legacy_o1_data_t *o1_data) {
+    if (!xml_data || !o1_data) {
+        return -1;
+    }
+    
+    // Simple XML parsing for get-config
+    char *interface_start = strstr(xml_data, "<name>");
+    if (interface_start) {
+        interface_start += 6; // Skip "<name>"
+        char *interface_end = strstr(interface_start, "</name>");
+        if (interface_end) {
+            size_t len = interface_end - interface_start;
+            if (len < sizeof(o1_data->interface_name)) {
+                strncpy(o1_data->interface_name, interface_start, len);
+                o1_data->interface_name[len] = '\0';
+                strcpy(o1_data->operation, "get");
+                return 0;
+            }
+        }
+    }
+    
+    return -1;
+}
+
+// The previous parse_o1_edit_config(), kept verbatim as the baseline
+static int legacy_parse_o1_edit_config(const char *xml_data, legacy_o1_data_t *o1_data) {
+    char *interface_start = strstr(xml_data, "<name>");
+    char *status_start = strstr(xml_data, "<status>");
+    char *traceid_start = strstr(xml_data, "<traceid>");
+    char *spanid_start = strstr(xml_data, "<spanid>");
+    
+    if (interface_start && status_start && traceid_start && spanid_start) {
+        interface_start += 6;
+        char *interface_end = strstr(interface_start, "</name>");
+        if (interface_end) {
+            size_t len = interface_end - interface_start;
+            if (len < sizeof(o1_data->interface_name)) {
+                strncpy(o1_data->interface_name, interface_start, len);
+                o1_data->interface_name[len] = '\0';
+            }
+        }
+        
+        status_start += 8;
+        char *status_end = strstr(status_start, "</status>");
+        if (status_end) {
+            size_t len = status_end - status_start;
+            if (len < sizeof(o1_data->status)) {
+                strncpy(o1_data->status, status_start, len);
+                o1_data->status[len] = '\0';
+            }
+        }
+        
+        traceid_start += 9;
+        char *traceid_end = strstr(traceid_start, "</traceid>");
+        if (traceid_end) {
+            size_t len = traceid_end - traceid_start;
+            if (len < sizeof(o1_data->traceid)) {
+                strncpy(o1_data->traceid, traceid_start, len);
+                o1_data->traceid[len] = '\0';
+            }
+        }
+        
+        spanid_start += 8;
+        char *spanid_end = strstr(spanid_start, "</spanid>");
+        if (spanid_end) {
+            size_t len = spanid_end - spanid_start;
+            if (len < sizeof(o1_data->spanid)) {
+                strncpy(o1_data->spanid, spanid_start, len);
+                o1_data->spanid[len] = '\0';
+            }
+        }
+        
+        strcpy(o1_data->operation, "edit");
+        return 0;
+    }
+    
+    return -1;
+}
+
+// The status RPCs in the style of the parsers above: each leaf that is
+// present is copied out, interface-name is required
+static int strstr_leaf(const char *xml, const char *open, const char *close, char *dst,
+                       size_t size) {
+    const char *start = strstr(xml, open);
+    if (!start) {
+        return -1;
+    }
+    start += strlen(open);
+    const char *end = strstr(start, close);
+    if (!end || (size_t)(end - start) >= size) {
+        return -1;
+    }
+    memcpy(dst, start, end - start);
+    dst[end - start] = '\0';
+    return 0;
+}
+
+static int strstr_parse_rpc_input(const char *xml, legacy_o1_data_t *o1_data) {
+    if (strstr_leaf(xml, "<interface-name>", "</interface-name>", o1_data->interface_name,
+                    sizeof(o1_data->interface_name)) != 0) {
+        return -1;
+    }
+    strstr_leaf(xml, "<status>", "</status>", o1_data->status, sizeof(o1_data->status));
+    strstr_leaf(xml, "<traceid>", "</traceid>", o1_data->traceid, sizeof(o1_data->traceid));
+    strstr_leaf(xml, "<spanid>", "</spanid>", o1_data->spanid, sizeof(o1_data->spanid));
+    return 0;
+}
+
+// Bodies as o1_netconf_client and o1_loadgen send them
+static const char edit_config_body[] =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"2\">\n"
+    "  <edit-config>\n"
+    "    <target>\n"
+    "      <running/>\n"
+    "    </target>\n"
+    "    <config>\n"
+    "      <o1-interface xmlns=\"urn:example:o1-interface\">\n"
+    "        <interface>\n"
+    "          <name>eth0</name>\n"
+    "          <status>up</status>\n"
+    "          <tracing>\n"
+    "            <traceid>0af7651916cd43dd8448eb211c80319c</traceid>\n"
+    "            <spanid>b7ad6b7169203331</spanid>\n"
+    "          </tracing>\n"
+    "        </interface>\n"
+    "      </o1-interface>\n"
+    "    </config>\n"
+    "  </edit-config>\n"
+    "</rpc>\n";
+
+static const char get_config_body[] =
+    "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"1\">\n"
+    "  <get-config>\n"
+    "    <source>\n"
+    "      <running/>\n"
+    "    </source>\n"
+    "    <filter type=\"subtree\">\n"
+    "      <o1-interface xmlns=\"urn:example:o1-interface\">\n"
+    "        <interface>\n"
+    "          <name>eth0</name>\n"
+    "        </interface>\n"
+    "      </o1-interface>\n"
+    "    </filter>\n"
+    "  </get-config>\n"
+    "</rpc>\n";
+
+static const char get_status_body[] =
+    "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"3\">\n"
+    "  <get-interface-status xmlns=\"urn:example:o1-interface\">\n"
+    "    <interface-name>eth0</interface-name>\n"
+    "  </get-interface-status>\n"
+    "</rpc>\n";
+
+static const char set_status_body[] =
+    "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"4\">\n"
+    "  <set-interface-status xmlns=\"urn:example:o1-interface\">\n"
+    "    <interface-name>eth0</interface-name>\n"
+    "    <status>down</status>\n"
+    "    <tracing>\n"
+    "      <traceid>0af7651916cd43dd8448eb211c80319c</traceid>\n"
+    "      <spanid>b7ad6b7169203331</spanid>\n"
+    "    </tracing>\n"
+    "  </set-interface-status>\n"
+    "</rpc>\n";
+
+// edit-config whose interface entry carries a description of the given
+// size ahead of the leaves the parsers look for
+static char *build_payload(size_t target_size, size_t *len) {
+    static const char head[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"2\">\n"
+        "  <edit-config>\n"
+        "    <target>\n"
+        "      <running/>\n"
+        "    </target>\n"
+        "    <config>\n"
+        "      <o1-interface xmlns=\"urn:example:o1-interface\">\n"
+        "        <description>";
+    static const char tail[] =
+        "</description>\n"
+        "        <name>eth0</name>\n"
+        "        <status>up</status>\n"
+        "        <tracing>\n"
+        "          <traceid>0af7651916cd43dd8448eb211c80319c</traceid>\n"
+        "          <spanid>b7ad6b7169203331</spanid>\n"
+        "        </tracing>\n"
+        "      </o1-interface>\n"
+        "    </config>\n"
+        "  </edit-config>\n"
+        "</rpc>\n";
+    size_t fixed = sizeof(head) - 1 + sizeof(tail) - 1;
+    size_t filler = target_size > fixed ? target_size - fixed : 0;
+    
+    char *buf = malloc(fixed + filler + 1);
+    if (!buf) {
+        return NULL;
+    }
+    
+    char *p = buf;
+    memcpy(p, head, sizeof(head) - 1);
+    p += sizeof(head) - 1;
+    for (size_t i = 0; i < filler; i++) {
+        p[i] = (i % 64 == 63) ? '\n' : "abcdefghijklmnopqrstuvwxyz "[i % 27];
+    }
+    p += filler;
+    memcpy(p, tail, sizeof(tail));
+    
+    *len = fixed + filler;
+    return buf;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+typedef enum {
+    PARSE_LEGACY_EDIT,
+    PARSE_LEGACY_GET,
+    PARSE_STRSTR_RPC,
+    PARSE_EDIT,
+    PARSE_EDIT_ENTRIES,
+    PARSE_GET,
+    PARSE_RPC
+} parser_t;
+
+static int count_entry(const o1_interface_view_t *entry, void *arg) {
+    (void)entry;
+    (*(int *)arg)++;
+    return 0;
+}
+
+static int parse(parser_t parser, const char *xml, size_t len) {
+    legacy_o1_data_t legacy;
+    o1_interface_view_t view;
+    int entries = 0;
+    
+    switch (parser) {
+    case PARSE_LEGACY_EDIT:
+        return legacy_parse_o1_edit_config(xml, &legacy);
+    case PARSE_LEGACY_GET:
+        return legacy_parse_o1_get_config(xml, &legacy);
+    case PARSE_STRSTR_RPC:
+        return strstr_parse_rpc_input(xml, &legacy);
+    case PARSE_EDIT:
+        return o1_parse_edit_config(xml, len, &view);
+    case PARSE_EDIT_ENTRIES:
+        return o1_parse_edit_config_entries(xml, len, count_entry, &entries) == 1 ? 0 : -1;
+    case PARSE_GET:
+        return o1_parse_get_config(xml, len, &view);
+    case PARSE_RPC:
+        return o1_parse_rpc_input(xml, len, &view) == 0 && view.interface_name.ptr ? 0 : -1;
+    }
+    return -1;
+}
+
+// Fastest of 10 runs of about 20 ms each, in ns per parse
+static double time_parser(parser_t parser, const char *xml, size_t len) {
+    double best = 0;
+    
+    for (int run = 0; run < 10; run++) {
+        long iterations = 0;
+        double elapsed;
+        double start = now_ns();
+        do {
+            for (int i = 0; i < 100; i++) {
+                // Keep the compiler from hoisting the parse out of the loop
+                const char *input = xml;
+                __asm__ volatile("" : "+r"(input));
+                parse(parser, input, len);
+            }
+            iterations += 100;
+        } while ((elapsed = now_ns() - start) < 2e7);
+        
+        if (run == 0 || elapsed / iterations < best) {
+            best = elapsed / iterations;
+        }
+    }
+    return best;
+}
+
+static int compare(const char *label, const char *xml, size_t len, parser_t baseline,
+                   parser_t tokenizer) {
+    if (parse(baseline, xml, len) != 0 || parse(tokenizer, xml, len) != 0) {
+        fprintf(stderr, "Parser rejected %s\n", label);
+        return -1;
+    }
+    
+    double baseline_ns = time_parser(baseline, xml, len);
+    double tokenizer_ns = time_parser(tokenizer, xml, len);
+    printf("%-22s %6zu %14.1f %15.1f %9.2fx\n", label, len, baseline_ns, tokenizer_ns,
+           baseline_ns / tokenizer_ns);
+    return 0;
+}
+
+// Each truncated tag, alone and at the end of the documents each parser
+// takes, must be an error. The input ends right before a page that cannot
+// be read, so a parser that looks past it crashes the bench.
+static int check_truncated(void) {
+    static const char *const tags[] = { "<a", "<a ", "<a b='x'", "</a" };
+    static const char *const prefixes[] = {
+        "",
+        "<rpc xmlns=\"" O1_NS_NETCONF "\"><edit-config><target><running/></target>"
+        "<config><o1-interface xmlns=\"" O1_NS_INTERFACE "\"><name>eth0</name>",
+        "<rpc xmlns=\"" O1_NS_NETCONF "\"><get-config><source>",
+        "<rpc xmlns=\"" O1_NS_NETCONF "\"><get-interface-status xmlns=\"" O1_NS_INTERFACE
+        "\">",
+    };
+    long page = sysconf(_SC_PAGESIZE);
+    char *map = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED || mprotect(map + page, page, PROT_NONE) != 0) {
+        fprintf(stderr, "Failed to map guard page\n");
+        return -1;
+    }
+    
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++) {
+        for (size_t j = 0; j < sizeof(tags) / sizeof(tags[0]); j++) {
+            size_t prefix_len = strlen(prefixes[i]);
+            size_t len = prefix_len + strlen(tags[j]);
+            char *xml = map + page - len;
+            memcpy(xml, prefixes[i], prefix_len);
+            memcpy(xml + prefix_len, tags[j], len - prefix_len);
+            
+            o1_xml_reader_t reader;
+            o1_xml_token_t token;
+            o1_xml_token_type_t type;
+            o1_xml_reader_init(&reader, xml, len);
+            while ((type = o1_xml_next(&reader, &token)) != O1_XML_EOF && type != O1_XML_ERROR) {
+            }
+            
+            o1_interface_view_t view;
+            o1_str_t name;
+            int entries = 0;
+            if (type != O1_XML_ERROR || o1_parse_get_config(xml, len, &view) != -1 ||
+                o1_parse_edit_config(xml, len, &view) != -1 ||
+                o1_parse_edit_config_entries(xml, len, count_entry, &entries) != -1 ||
+                o1_parse_rpc_input(xml, len, &view) != -1 ||
+                o1_parse_datastore(xml, len, "source", &name) != -1) {
+                fprintf(stderr, "Truncated document accepted: %.*s\n", (int)len, xml);
+                failures++;
+            }
+        }
+    }
+    
+    munmap(map, 2 * page);
+    return failures ? -1 : 0;
+}
+
+int main(void) {
+    if (check_truncated() != 0) {
+        return 1;
+    }
+    
+    printf("%-22s %6s %14s %15s %10s\n", "payload", "bytes", "strstr ns/op", "tokenizer ns/op",
+           "speedup");
+    
+    // What the server receives; edit-config entries is the parse it does
+    if (compare("edit-config", edit_config_body, sizeof(edit_config_body) - 1,
+                PARSE_LEGACY_EDIT, PARSE_EDIT) != 0 ||
+        compare("edit-config entries", edit_config_body, sizeof(edit_config_body) - 1,
+                PARSE_LEGACY_EDIT, PARSE_EDIT_ENTRIES) != 0 ||
+        compare("get-config filter", get_config_body, sizeof(get_config_body) - 1,
+                PARSE_LEGACY_GET, PARSE_GET) != 0 ||
+        compare("get-interface-status", get_status_body, sizeof(get_status_body) - 1,
+                PARSE_STRSTR_RPC, PARSE_RPC) != 0 ||
+        compare("set-interface-status", set_status_body, sizeof(set_status_body) - 1,
+                PARSE_STRSTR_RPC, PARSE_RPC) != 0) {
+        return 1;
+    }
+    
+    printf("\nLeaves after a description of the given size:\n");
+    for (size_t size = 1024; size <= 64 * 1024; size *= 2) {
+        size_t len;
+        char *xml = build_payload(size, &len);
+        if (!xml) {
+            fprintf(stderr, "Failed to allocate payload\n");
+            return 1;
+        }
+        
+        char label[32];
+        snprintf(label, sizeof(label), "edit-config %zu KB", size / 1024);
+        int ret = compare(label, xml, len, PARSE_LEGACY_EDIT, PARSE_EDIT);
+        free(xml);
+        if (ret != 0) {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
@@ -0,0 +1,77 @@
+#define _POSIX_C_SOURCE 200809L
+#include <regex.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/hex.h"
+#include "../src/o1_yang.h"
+
+// Checks a traceid against its YANG constraints three ways: the pattern as
+// a compiled POSIX regex (what a generic schema validator does per value),
+// the shared SIMD hex validator, and the generated specialized validator.
+
+#define ITERATIONS 2000000
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void) {
+    static const char *ids[] = {
+        "0af7651916cd43dd8448eb211c80319c",
+        "0AF7651916CD43DD8448EB211C80319C",
+        "0af7651916cd43dd8448eb211c80319g",
+        "0af7651916cd43dd8448eb211c8031",
+    };
+    const int num_ids = sizeof(ids) / sizeof(ids[0]);
+    volatile int sink = 0;
+    
+    regex_t re;
+    if (regcomp(&re, "^[0-9a-fA-F]{32}$", REG_EXTENDED | REG_NOSUB) != 0) {
+        fprintf(stderr, "Failed to compile pattern\n");
+        return 1;
+    }
+    
+    // All three must agree before timing anything
+    for (int i = 0; i < num_ids; i++) {
+        size_t len = strlen(ids[i]);
+        int by_regex = regexec(&re, ids[i], 0, NULL, 0) == 0;
+        int by_hex = len == 32 && hex_validate(ids[i], len);
+        int by_yang = o1_interface_interface_tracing_traceid_valid(ids[i], len);
+        if (by_regex != by_hex || by_regex != by_yang) {
+            fprintf(stderr, "Validators disagree on %s\n", ids[i]);
+            return 1;
+        }
+    }
+    
+    double start = now_ns();
+    for (int n = 0; n < ITERATIONS; n++) {
+        sink += regexec(&re, ids[n % num_ids], 0, NULL, 0) == 0;
+    }
+    double regex_ns = (now_ns() - start) / ITERATIONS;
+    
+    start = now_ns();
+    for (int n = 0; n < ITERATIONS; n++) {
+        const char *id = ids[n % num_ids];
+        size_t len = strlen(id);
+        sink += len == 32 && hex_validate(id, len);
+    }
+    double hex_ns = (now_ns() - start) / ITERATIONS;
+    
+    start = now_ns();
+    for (int n = 0; n < ITERATIONS; n++) {
+        const char *id = ids[n % num_ids];
+        sink += o1_interface_interface_tracing_traceid_valid(id, strlen(id));
+    }
+    double yang_ns = (now_ns() - start) / ITERATIONS;
+    
+    printf("%-28s %8.1f ns/op\n", "regexec (pattern)", regex_ns);
+    printf("%-28s %8.1f ns/op\n", "hex_validate", hex_ns);
+    printf("%-28s %8.1f ns/op\n", "generated traceid validator", yang_ns);
+    
+    regfree(&re);
+    return sink < 0;
+}
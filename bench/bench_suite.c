@@ -0,0 +1,329 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../src/o1_reply.h"
+#include "../src/o1_xml.h"
+#include "../src/trace_id.h"
+
+// Microbenchmarks of the per-message work, each over a range of payload
+// sizes: trace ID generation, tracing data parsing, get-config and
+// edit-config parsing, and reply formatting. Reports ns/op and heap
+// allocations/op; linked with --wrap for malloc, calloc and realloc like
+// bench_o1_rpc. With -o, appends the run as one JSON line to a file so
+// results can be compared between commits.
+//
+// Usage: bench_suite [-o results.jsonl] [-l label] [-t ms per case] [filter]
+
+#define MAX_SIZES 4
+#define MAX_ENTRIES 256
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static unsigned long allocations;
+
+void *__wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+
+// One benchmark: prepare() builds the input for a size, run() does one
+// operation and returns non-zero if it failed
+typedef struct {
+    const char *name;
+    const char *unit;       // what `size` counts
+    size_t sizes[MAX_SIZES];
+    int (*prepare)(size_t size);
+    int (*run)(void);
+} bench_case_t;
+
+typedef struct {
+    const char *name;
+    const char *unit;
+    size_t size;
+    unsigned long iterations;
+    double ns_per_op;
+    double allocs_per_op;
+} bench_result_t;
+
+static o1_buf_t payload;
+static size_t entries;
+static tracing_data_t ids[MAX_ENTRIES];
+static o1_reply_t reply;
+
+static const o1_reply_tag_t tag_data = O1_REPLY_TAG("data");
+static const o1_reply_tag_t tag_o1_interface = O1_REPLY_TAG_NS("o1-interface", O1_NS_INTERFACE);
+static const o1_reply_tag_t tag_interface = O1_REPLY_TAG("interface");
+static const o1_reply_tag_t tag_name = O1_REPLY_TAG("name");
+static const o1_reply_tag_t tag_status = O1_REPLY_TAG("status");
+static const o1_reply_tag_t tag_tracing = O1_REPLY_TAG_NS("tracing", O1_NS_TRACING);
+static const o1_reply_tag_t tag_traceid = O1_REPLY_TAG("traceid");
+static const o1_reply_tag_t tag_spanid = O1_REPLY_TAG("spanid");
+static const o1_reply_tag_t tag_timestamp = O1_REPLY_TAG("timestamp");
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// trace_id_generate_bulk: `size` IDs per operation
+static int prepare_generate(size_t size) {
+    entries = size;
+    return 0;
+}
+
+static int run_generate(void) {
+    return trace_id_generate_bulk(ids, entries);
+}
+
+// trace_id_parse_json: a frame of `size` bytes, the IDs after a filler field
+static int prepare_parse_json(size_t size) {
+    o1_buf_reset(&payload);
+    int ret = o1_buf_puts(&payload, "{\"payload\": \"");
+    while (ret == 0 && payload.len + 100 < size) {
+        ret = o1_buf_append(&payload, "x", 1);
+    }
+    if (ret == 0) {
+        ret = o1_buf_puts(&payload, "\", \"traceid\": \"0af7651916cd43dd8448eb211c80319c\", "
+                                    "\"spanid\": \"b7ad6b7169203331\"}");
+    }
+    return ret;
+}
+
+static int run_parse_json(void) {
+    tracing_data_t tracing;
+    return trace_id_parse_json(payload.data, &tracing);
+}
+
+// o1_parse_get_config: a filter of about `size` bytes, other modules'
+// subtrees ahead of the o1-interface one
+static int prepare_get_config(size_t size) {
+    o1_buf_reset(&payload);
+    int ret = o1_buf_puts(&payload,
+        "<rpc xmlns=\"" O1_NS_NETCONF "\" message-id=\"1\">"
+        "<get-config><source><running/></source><filter type=\"subtree\">");
+    for (int i = 0; ret == 0 && payload.len + 250 < size; i++) {
+        ret = o1_buf_printf(&payload,
+            "<system xmlns=\"urn:example:system\"><hostname>node%d</hostname></system>", i);
+    }
+    if (ret == 0) {
+        ret = o1_buf_puts(&payload,
+            "<o1-interface xmlns=\"" O1_NS_INTERFACE "\"><interface><name>eth0</name>"
+            "</interface></o1-interface></filter></get-config></rpc>");
+    }
+    return ret;
+}
+
+static int run_get_config(void) {
+    o1_interface_view_t view;
+    return o1_parse_get_config(payload.data, payload.len, &view);
+}
+
+// o1_parse_edit_config_entries: an edit-config of `size` interfaces
+static int prepare_edit_config(size_t size) {
+    entries = size;
+    o1_buf_reset(&payload);
+    int ret = o1_buf_puts(&payload,
+        "<rpc xmlns=\"" O1_NS_NETCONF "\" message-id=\"1\">"
+        "<edit-config><target><running/></target><config>"
+        "<o1-interface xmlns=\"" O1_NS_INTERFACE "\">");
+    for (size_t i = 0; ret == 0 && i < size; i++) {
+        ret = o1_buf_printf(&payload,
+            "<interface><name>eth%zu</name><status>%s</status>"
+            "<tracing xmlns=\"" O1_NS_TRACING "\"><traceid>%016zx%016zx</traceid>"
+            "<spanid>%016zx</spanid></tracing></interface>",
+            i, (i & 1) ? "down" : "up", i, ~i, i);
+    }
+    if (ret == 0) {
+        ret = o1_buf_puts(&payload, "</o1-interface></config></edit-config></rpc>");
+    }
+    return ret;
+}
+
+static int count_entry(const o1_interface_view_t *entry, void *arg) {
+    (void)entry;
+    (*(size_t *)arg)++;
+    return 0;
+}
+
+static int run_edit_config(void) {
+    size_t count = 0;
+    if (o1_parse_edit_config_entries(payload.data, payload.len, count_entry, &count) < 0) {
+        return -1;
+    }
+    return count == entries ? 0 : -1;
+}
+
+// o1_reply: a compact get-config reply of `size` interfaces, flattened
+static int prepare_reply(size_t size) {
+    entries = size;
+    return trace_id_generate_bulk(ids, size);
+}
+
+static int run_reply(void) {
+    char name[16];
+    
+    o1_reply_reset(&reply);
+    o1_reply_begin(&reply, "1", 1);
+    o1_reply_open(&reply, &tag_data);
+    o1_reply_open(&reply, &tag_o1_interface);
+    for (size_t i = 0; i < entries; i++) {
+        int len = snprintf(name, sizeof(name), "eth%zu", i);
+        o1_reply_open(&reply, &tag_interface);
+        o1_reply_leaf(&reply, &tag_name, name, (size_t)len);
+        o1_reply_leaf(&reply, &tag_status, "up", 2);
+        o1_reply_open(&reply, &tag_tracing);
+        o1_reply_leaf(&reply, &tag_traceid, ids[i].traceid, 32);
+        o1_reply_leaf(&reply, &tag_spanid, ids[i].spanid, 16);
+        o1_reply_leaf_u64(&reply, &tag_timestamp, 1700000000000ULL + i);
+        o1_reply_close(&reply, &tag_tracing);
+        o1_reply_close(&reply, &tag_interface);
+    }
+    o1_reply_close(&reply, &tag_o1_interface);
+    o1_reply_close(&reply, &tag_data);
+    o1_reply_end(&reply);
+    return o1_reply_flatten(&reply) ? 0 : -1;
+}
+
+static const bench_case_t cases[] = {
+    { "trace_id_generate", "ids", { 1, 16, 256 }, prepare_generate, run_generate },
+    { "trace_id_parse_json", "bytes", { 128, 1024, 16384 }, prepare_parse_json, run_parse_json },
+    { "o1_parse_get_config", "bytes", { 256, 4096, 65536 }, prepare_get_config, run_get_config },
+    { "o1_parse_edit_config", "entries", { 1, 16, 256 }, prepare_edit_config, run_edit_config },
+    { "o1_reply_get_config", "entries", { 1, 16, 256 }, prepare_reply, run_reply },
+};
+
+// Doubles the iteration count until a pass takes `target_ns`, after a
+// warm-up pass that lets buffers reach their steady-state size
+static int measure(const bench_case_t *bench, double target_ns, bench_result_t *result) {
+    unsigned long iterations = 1;
+    
+    for (;;) {
+        unsigned long before = allocations;
+        double start = now_ns();
+        for (unsigned long i = 0; i < iterations; i++) {
+            if (bench->run() != 0) {
+                return -1;
+            }
+        }
+        double elapsed = now_ns() - start;
+        
+        if (elapsed >= target_ns || iterations >= (1UL << 30)) {
+            result->iterations = iterations;
+            result->ns_per_op = elapsed / iterations;
+            result->allocs_per_op = (double)(allocations - before) / iterations;
+            return 0;
+        }
+        iterations *= 2;
+    }
+}
+
+static int write_json(const char *path, const char *label, const bench_result_t *results, int count) {
+    FILE *out = fopen(path, "a");
+    if (!out) {
+        perror(path);
+        return -1;
+    }
+    
+    // Labels come from the command line; quotes and backslashes are dropped
+    fprintf(out, "{\"label\": \"");
+    for (const char *c = label; *c; c++) {
+        if (*c != '"' && *c != '\\' && (unsigned char)*c >= 0x20) {
+            fputc(*c, out);
+        }
+    }
+    fprintf(out, "\", \"time\": %lld, \"results\": [", (long long)time(NULL));
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "%s{\"name\": \"%s\", \"size\": %zu, \"unit\": \"%s\", \"iterations\": %lu, "
+                "\"ns_per_op\": %.2f, \"allocs_per_op\": %.4f}", i ? ", " : "",
+                results[i].name, results[i].size, results[i].unit, results[i].iterations,
+                results[i].ns_per_op, results[i].allocs_per_op);
+    }
+    fprintf(out, "]}\n");
+    
+    int ret = ferror(out) ? -1 : 0;
+    if (fclose(out) != 0 || ret != 0) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    static bench_result_t results[sizeof(cases) / sizeof(cases[0]) * MAX_SIZES];
+    const char *output = NULL;
+    const char *label = "";
+    const char *filter = NULL;
+    double target_ns = 200e6;
+    int count = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            label = argv[++i];
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            target_ns = atof(argv[++i]) * 1e6;
+        } else if (argv[i][0] != '-' && !filter) {
+            filter = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s [-o results.jsonl] [-l label] [-t ms] [filter]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    o1_buf_init(&payload);
+    o1_reply_init(&reply, 0);
+    
+    printf("%-24s %8s %-8s %12s %12s\n", "benchmark", "size", "unit", "ns/op", "allocs/op");
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        const bench_case_t *bench = &cases[c];
+        if (filter && !strstr(bench->name, filter)) {
+            continue;
+        }
+        
+        for (int s = 0; s < MAX_SIZES && bench->sizes[s] > 0; s++) {
+            bench_result_t *result = &results[count];
+            result->name = bench->name;
+            result->unit = bench->unit;
+            result->size = bench->sizes[s];
+            
+            if (bench->prepare(bench->sizes[s]) != 0 || bench->run() != 0 ||
+                measure(bench, target_ns, result) != 0) {
+                fprintf(stderr, "%s (%zu %s) failed\n", bench->name, bench->sizes[s], bench->unit);
+                return 1;
+            }
+            // Inputs measured in bytes report their actual length
+            if (strcmp(bench->unit, "bytes") == 0) {
+                result->size = payload.len;
+            }
+            
+            printf("%-24s %8zu %-8s %12.1f %12.3f\n", result->name, result->size, result->unit,
+                   result->ns_per_op, result->allocs_per_op);
+            count++;
+        }
+    }
+    
+    o1_reply_free(&reply);
+    o1_buf_free(&payload);
+    
+    if (output && write_json(output, label, results, count) != 0) {
+        return 1;
+    }
+    return 0;
+}
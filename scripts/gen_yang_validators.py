@@ -0,0 +1,400 @@
+#!/usr/bin/env python3
+"""Generate C validators and enum mappers from the O1 YANG modules.
+
+For every leaf of the given modules this emits, depending on its type:
+  - string:       <name>_valid(s, len), checking the length ranges and a
+                  single-character-class pattern ("[0-9a-fA-F]{32}"). Classes
+                  of up to four ranges become compare arithmetic, others a
+                  256-entry table; fixed lengths become constant loop bounds
+                  the compiler unrolls and vectorizes
+  - enumeration:  a C enum, <name>_from_str(s, len) returning the value or -1
+                  (a switch on the length, then memcmp), and <name>_to_str()
+  - uintN:        <name>_parse(s, len, &value) with overflow and range checks
+
+Names are the module name followed by the schema path, '-' mapped to '_';
+a top-level container named like its module is left out of the path.
+The generated code does not allocate.
+
+Usage: gen_yang_validators.py -o src/o1_yang config/o1-interface.yang ...
+"""
+
+import argparse
+import os
+import re
+import sys
+
+
+class YangError(Exception):
+    pass
+
+
+def tokenize(text, path):
+    """Split YANG text into keywords/arguments and the ';', '{', '}' punctuation."""
+    tokens = []
+    i, n = 0, len(text)
+    while i < n:
+        c = text[i]
+        if c.isspace():
+            i += 1
+        elif text.startswith('//', i):
+            i = text.find('\n', i)
+            i = n if i < 0 else i
+        elif text.startswith('/*', i):
+            end = text.find('*/', i + 2)
+            if end < 0:
+                raise YangError('%s: unterminated comment' % path)
+            i = end + 2
+        elif c in ';{}':
+            tokens.append(c)
+            i += 1
+        elif c in '"\'':
+            # Quoted strings, joined with '+' into one argument
+            value = ''
+            while True:
+                end = i + 1
+                while end < n and text[end] != c:
+                    end += 2 if c == '"' and text[end] == '\\' else 1
+                if end >= n:
+                    raise YangError('%s: unterminated string' % path)
+                raw = text[i + 1:end]
+                if c == '"':
+                    raw = re.sub(r'\\(.)', lambda m: {'n': '\n', 't': '\t'}.get(m.group(1), m.group(1)), raw)
+                value += raw
+                i = end + 1
+                m = re.compile(r'\s*\+\s*(["\'])').match(text, i)
+                if not m:
+                    break
+                i = m.end() - 1
+                c = text[i]
+            tokens.append(('str', value))
+        else:
+            m = re.compile(r'[^\s;{}"\']+').match(text, i)
+            tokens.append(('str', m.group(0)))
+            i = m.end()
+    return tokens
+
+
+def parse_statements(tokens, pos, path):
+    """Parse statements up to a closing brace; returns (statements, pos)."""
+    stmts = []
+    while pos < len(tokens) and tokens[pos] != '}':
+        tok = tokens[pos]
+        if not isinstance(tok, tuple):
+            raise YangError('%s: unexpected %r' % (path, tok))
+        keyword = tok[1]
+        pos += 1
+        arg = None
+        if pos < len(tokens) and isinstance(tokens[pos], tuple):
+            arg = tokens[pos][1]
+            pos += 1
+        if pos >= len(tokens):
+            raise YangError('%s: truncated statement %s' % (path, keyword))
+        children = []
+        if tokens[pos] == '{':
+            children, pos = parse_statements(tokens, pos + 1, path)
+            if pos >= len(tokens):
+                raise YangError('%s: missing }' % path)
+        elif tokens[pos] != ';':
+            raise YangError('%s: expected ; or { after %s' % (path, keyword))
+        stmts.append((keyword, arg, children))
+        pos += 1
+    return stmts, pos
+
+
+def child(stmt, keyword):
+    for s in stmt[2]:
+        if s[0] == keyword:
+            return s
+    return None
+
+
+def c_ident(name):
+    return re.sub(r'[^0-9A-Za-z]', '_', name)
+
+
+def parse_ranges(expr, lo, hi):
+    """'1..4 | 8 | min..max' to [(lo, hi), ...]."""
+    ranges = []
+    for part in expr.split('|'):
+        bounds = [b.strip() for b in part.split('..')]
+        vals = [lo if b == 'min' else hi if b == 'max' else int(b) for b in bounds]
+        ranges.append((vals[0], vals[-1]))
+    return ranges
+
+
+def parse_pattern(pattern, where):
+    """Single character class with a quantifier: '[0-9a-f]{16}', '[a-z]+'.
+    Returns (set of byte values, min, max or None)."""
+    m = re.fullmatch(r'\[([^\]]+)\](\{(\d+)(,(\d*))?\}|\+|\*)?', pattern)
+    if not m:
+        raise YangError('%s: unsupported pattern %r' % (where, pattern))
+    body, quant = m.group(1), m.group(2)
+    allowed = set()
+    i = 0
+    while i < len(body):
+        if i + 2 < len(body) and body[i + 1] == '-':
+            allowed.update(range(ord(body[i]), ord(body[i + 2]) + 1))
+            i += 3
+        else:
+            allowed.add(ord(body[i]))
+            i += 1
+    if quant is None:
+        return allowed, 1, 1
+    if quant == '+':
+        return allowed, 1, None
+    if quant == '*':
+        return allowed, 0, None
+    lo = int(m.group(3))
+    if m.group(4) is None:
+        return allowed, lo, lo
+    return allowed, lo, int(m.group(5)) if m.group(5) else None
+
+
+UINT_MAX = {'uint8': 0xff, 'uint16': 0xffff, 'uint32': 0xffffffff, 'uint64': 0xffffffffffffffff}
+
+
+UINT_HELPER = '''// Decimal digits only, no sign or whitespace, rejecting overflow
+static int yang_parse_uint(const char *s, size_t len, uint64_t *value) {
+    if (len == 0 || len > 20) {
+        return -1;
+    }
+    
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned d = (unsigned char)s[i] - '0';
+        if (d > 9 || v > (UINT64_MAX - d) / 10) {
+            return -1;
+        }
+        v = v * 10 + d;
+    }
+    
+    *value = v;
+    return 0;
+}'''
+
+
+class Generator:
+    def __init__(self):
+        self.decls = []
+        self.defs = []
+        self.tables = []    # distinct character classes
+        self.need_uint = False
+
+    def class_check(self, allowed):
+        """A few ranges become compare arithmetic that vectorizes over a
+        fixed-length loop; other classes use a lookup table."""
+        spans = []
+        for c in sorted(allowed):
+            if spans and spans[-1][1] == c - 1:
+                spans[-1][1] = c
+            else:
+                spans.append([c, c])
+        if len(spans) > 4:
+            return self.class_table(allowed)
+
+        def lit(c):
+            return "'%s'" % chr(c) if 0x20 < c < 0x7f and chr(c) not in "'\\" else str(c)
+        terms = []
+        for lo, hi in spans:
+            if lo == hi:
+                terms.append('(c == %s)' % lit(lo))
+            else:
+                terms.append('((unsigned char)(c - %s) <= %d)' % (lit(lo), hi - lo))
+        return ' | '.join(terms)
+
+    def class_table(self, allowed):
+        key = frozenset(allowed)
+        if key not in self.tables:
+            self.tables.append(key)
+        return 'yang_class_%d' % self.tables.index(key)
+
+    def leaf(self, name, type_stmt, where):
+        kind = type_stmt[1]
+        if kind == 'string':
+            self.string_leaf(name, type_stmt, where)
+        elif kind == 'enumeration':
+            self.enum_leaf(name, type_stmt)
+        elif kind in UINT_MAX:
+            self.uint_leaf(name, type_stmt, UINT_MAX[kind])
+
+    def string_leaf(self, name, type_stmt, where):
+        length = child(type_stmt, 'length')
+        pattern = child(type_stmt, 'pattern')
+        ranges = parse_ranges(length[1], 0, None) if length else []
+        checks = []
+        table = None
+        if pattern:
+            allowed, pmin, pmax = parse_pattern(pattern[1], where)
+            table = self.class_check(allowed)
+            ranges = ranges or [(pmin, pmax)]
+            if (pmin, pmax) != (0, None):
+                # The pattern's repetition bounds apply on top of length
+                ranges = [(max(lo, pmin), hi if pmax is None else (pmax if hi is None else min(hi, pmax)))
+                          for lo, hi in ranges]
+
+        fixed = len(ranges) == 1 and ranges[0][0] == ranges[0][1]
+        for lo, hi in ranges:
+            if lo == hi:
+                checks.append('len == %d' % lo)
+            elif hi is None:
+                checks.append('len >= %d' % lo if lo else '1')
+            else:
+                checks.append('(len >= %d && len <= %d)' % (lo, hi) if lo else 'len <= %d' % hi)
+
+        self.decls.append('int %s_valid(const char *s, size_t len);' % name)
+        body = ['int %s_valid(const char *s, size_t len) {' % name]
+        if len(checks) == 1 and fixed:
+            body += ['    if (len != %d) {' % ranges[0][0], '        return 0;', '    }']
+        elif checks and checks != ['1']:
+            body += ['    if (!(%s)) {' % ' || '.join(checks), '        return 0;', '    }']
+        if table:
+            count = str(ranges[0][0]) if fixed else 'len'
+            body += ['    ',
+                     '    // Accumulate instead of branching per character',
+                     '    unsigned char ok = 1;',
+                     '    for (size_t i = 0; i < %s; i++) {' % count]
+            if table.startswith('yang_class_'):
+                body.append('        ok &= %s[(unsigned char)s[i]];' % table)
+            else:
+                body += ['        unsigned char c = (unsigned char)s[i];',
+                         '        ok &= %s;' % table]
+            body += ['    }',
+                     '    return ok;']
+        else:
+            if not checks or checks == ['1']:
+                body.append('    (void)len;')
+            body += ['    (void)s;', '    return 1;']
+        body.append('}')
+        self.defs.append('\n'.join(body))
+
+    def enum_leaf(self, name, type_stmt):
+        values = []
+        next_value = 0
+        for s in type_stmt[2]:
+            if s[0] != 'enum':
+                continue
+            value = child(s, 'value')
+            v = int(value[1]) if value else next_value
+            values.append((s[1], v))
+            next_value = v + 1
+
+        upper = name.upper()
+        self.decls.append('typedef enum {\n%s\n} %s_t;' % (
+            '\n'.join('    %s_%s = %d,' % (upper, c_ident(e).upper(), v) for e, v in values), name))
+        self.decls.append('int %s_from_str(const char *s, size_t len);' % name)
+        self.decls.append('const char *%s_to_str(int value);' % name)
+
+        by_len = {}
+        for e, v in values:
+            by_len.setdefault(len(e), []).append((e, v))
+        body = ['int %s_from_str(const char *s, size_t len) {' % name,
+                '    // Lengths tell most names apart; one memcmp confirms',
+                '    switch (len) {']
+        for n in sorted(by_len):
+            body.append('    case %d:' % n)
+            for e, v in by_len[n]:
+                body += ['        if (memcmp(s, "%s", %d) == 0) {' % (e, n),
+                         '            return %s_%s;' % (upper, c_ident(e).upper()),
+                         '        }']
+            body.append('        break;')
+        body += ['    }', '    return -1;', '}', '',
+                 'const char *%s_to_str(int value) {' % name,
+                 '    switch (value) {']
+        for e, v in values:
+            body += ['    case %s_%s:' % (upper, c_ident(e).upper()), '        return "%s";' % e]
+        body += ['    default:', '        return NULL;', '    }', '}']
+        self.defs.append('\n'.join(body))
+
+    def uint_leaf(self, name, type_stmt, type_max):
+        rng = child(type_stmt, 'range')
+        ranges = parse_ranges(rng[1], 0, type_max) if rng else [(0, type_max)]
+        self.decls.append('int %s_parse(const char *s, size_t len, uint64_t *value);' % name)
+        self.need_uint = True
+        body = ['int %s_parse(const char *s, size_t len, uint64_t *value) {' % name,
+                '    uint64_t v;',
+                '    if (yang_parse_uint(s, len, &v) != 0) {',
+                '        return -1;',
+                '    }']
+        checks = []
+        for lo, hi in ranges:
+            parts = []
+            if lo > 0:
+                parts.append('v >= %dULL' % lo)
+            if hi < 0xffffffffffffffff:
+                parts.append('v <= %dULL' % hi)
+            elif lo == 0 and type_max < 0xffffffffffffffff:
+                parts.append('v <= %dULL' % type_max)
+            checks.append(' && '.join(parts) if parts else '1')
+        if checks != ['1']:
+            body += ['    if (!(%s)) {' % ' || '.join('(%s)' % c for c in checks),
+                     '        return -1;',
+                     '    }']
+        body += ['    ', '    *value = v;', '    return 0;', '}']
+        self.defs.append('\n'.join(body))
+
+    def walk(self, module, stmts, path, where):
+        for s in stmts:
+            keyword, arg = s[0], s[1]
+            if keyword in ('container', 'list', 'rpc', 'input', 'output', 'notification',
+                           'choice', 'case', 'grouping'):
+                seg = arg if arg else keyword
+                # container o1-interface in module o1-interface adds nothing to the name
+                skip = not path and keyword == 'container' and arg == module
+                self.walk(module, s[2], path if skip else path + [seg], where)
+            elif keyword == 'leaf':
+                type_stmt = child(s, 'type')
+                if type_stmt:
+                    name = c_ident('_'.join([module] + path + [arg]))
+                    self.leaf(name, type_stmt, '%s: leaf %s' % (where, arg))
+
+    def table_defs(self):
+        out = []
+        for i, allowed in enumerate(self.tables):
+            rows = []
+            for r in range(0, 256, 16):
+                rows.append('    ' + ', '.join('1' if c in allowed else '0' for c in range(r, r + 16)) + ',')
+            out.append('static const unsigned char yang_class_%d[256] = {\n%s\n};' % (i, '\n'.join(rows)))
+        if self.need_uint:
+            out.append(UINT_HELPER)
+        return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Generate C validators from YANG modules')
+    ap.add_argument('-o', '--output', required=True, help='output path without .c/.h suffix')
+    ap.add_argument('modules', nargs='+')
+    args = ap.parse_args()
+
+    gen = Generator()
+    for path in args.modules:
+        with open(path) as f:
+            tokens = tokenize(f.read(), path)
+        stmts, pos = parse_statements(tokens, 0, path)
+        if pos != len(tokens) or len(stmts) != 1 or stmts[0][0] != 'module':
+            raise YangError('%s: expected a single module' % path)
+        gen.walk(stmts[0][1], stmts[0][2], [], path)
+
+    base = os.path.basename(args.output)
+    guard = c_ident(base).upper() + '_H'
+    sources = ' '.join(args.modules)
+    banner = '// Generated by scripts/gen_yang_validators.py from %s; do not edit.\n' % sources
+
+    with open(args.output + '.h', 'w') as f:
+        f.write(banner)
+        f.write('#ifndef %s\n#define %s\n\n#include <stddef.h>\n#include <stdint.h>\n\n' % (guard, guard))
+        f.write('\n\n'.join(gen.decls))
+        f.write('\n\n#endif // %s\n' % guard)
+
+    with open(args.output + '.c', 'w') as f:
+        f.write(banner)
+        f.write('#include <string.h>\n\n#include "%s.h"\n\n' % base)
+        f.write('\n\n'.join(gen.table_defs() + gen.defs))
+        f.write('\n')
+    return 0
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main())
+    except YangError as e:
+        sys.exit('gen_yang_validators: %s' % e)
@@ -31,7 +31,7 @@ int main(int argc, char *argv[]) {
     printf("Connecting to %s:%d as %s\n", config.host, config.port, config.username);
     
     // Initialize logging
-    init_logging();
+    init_logging(LOG_LEVEL_INFO);
     
     // Generate tracing data
     if (generate_tracing_data(&tracing) != SUCCESS) {
@@ -46,6 +46,7 @@ int main(int argc, char *argv[]) {
     // Create NETCONF session
     if (create_netconf_session(&session, &config) != SUCCESS) {
         fprintf(stderr, "Failed to create NETCONF session\n");
+        cleanup_netconf_pool();
         cleanup_logging();
         return 1;
     }
@@ -54,6 +55,7 @@ int main(int argc, char *argv[]) {
     if (send_tracing_data(session, &tracing) != SUCCESS) {
         fprintf(stderr, "Failed to send tracing data\n");
         cleanup_netconf_session(session);
+        cleanup_netconf_pool();
         cleanup_logging();
         return 1;
     }
@@ -63,6 +65,7 @@ int main(int argc, char *argv[]) {
     if (receive_tracing_data(session, &received_tracing) != SUCCESS) {
         fprintf(stderr, "Failed to receive response\n");
         cleanup_netconf_session(session);
+        cleanup_netconf_pool();
         cleanup_logging();
         return 1;
     }
@@ -70,7 +73,8 @@ int main(int argc, char *argv[]) {
     printf("Successfully sent tracing data to server\n");
     
     // Cleanup
-    cleanup_netconf_session(session);
+    release_netconf_session(session);
+    cleanup_netconf_pool();
     cleanup_logging();
     
     printf("Client completed successfully\n");
@@ -1,12 +1,31 @@
 #include "common.h"
+#include "o1_client_pool.h"
 #include <openssl/rand.h>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include <time.h>
 
-void init_logging(void) {
-    // Initialize NETCONF logging
-    nc_verbosity(NC_VERB_VERBOSE);
+// Sessions and keys kept for the life of the process
+static o1_client_pool_t *client_pool = NULL;
+static pthread_once_t client_pool_once = PTHREAD_ONCE_INIT;
+
+static void create_client_pool(void) {
+    o1_client_pool_config_t config;
+    o1_client_pool_default_config(&config);
+    client_pool = o1_client_pool_create(&config);
+}
+
+void init_logging(log_level_t level) {
+    log_config_t config;
+    log_default_config(&config);
+    config.level = level;
+    if (log_init(&config) != 0) {
+        fprintf(stderr, "Failed to start logging, printing synchronously\n");
+    }
+    
+    // Initialize NETCONF logging; verbose output only when debugging
+    nc_verbosity(level >= LOG_LEVEL_DEBUG ? NC_VERB_VERBOSE :
+                 level >= LOG_LEVEL_WARN ? NC_VERB_WARNING : NC_VERB_ERROR);
     
     // Initialize OpenSSL
     SSL_library_init();
@@ -21,6 +40,7 @@ void cleanup_logging(void) {
     EVP_cleanup();
     ERR_free_strings();
     
+    log_shutdown();
     printf("Logging cleaned up\n");
 }
 
@@ -29,30 +49,12 @@ int generate_tracing_data(tracing_data_t *tracing) {
         return ERROR_INIT;
     }
     
-    // Generate random traceid (32 hex characters)
-    unsigned char traceid_bytes[16];
-    if (RAND_bytes(traceid_bytes, 16) != 1) {
-        fprintf(stderr, "Failed to generate random traceid\n");
+    // Random traceid (32 hex characters) and spanid (16 hex characters)
+    if (trace_id_generate(tracing) != 0) {
+        fprintf(stderr, "Failed to generate tracing data\n");
         return ERROR_INIT;
     }
     
-    for (int i = 0; i < 16; i++) {
-        sprintf(&tracing->traceid[i * 2], "%02x", traceid_bytes[i]);
-    }
-    tracing->traceid[32] = '\0';
-    
-    // Generate random spanid (16 hex characters)
-    unsigned char spanid_bytes[8];
-    if (RAND_bytes(spanid_bytes, 8) != 1) {
-        fprintf(stderr, "Failed to generate random spanid\n");
-        return ERROR_INIT;
-    }
-    
-    for (int i = 0; i < 8; i++) {
-        sprintf(&tracing->spanid[i * 2], "%02x", spanid_bytes[i]);
-    }
-    tracing->spanid[16] = '\0';
-    
     return SUCCESS;
 }
 
@@ -82,11 +84,19 @@ int create_netconf_session(nc_session **session, const netconf_config_t *config)
         return ERROR_INIT;
     }
     
-    // Create SSH session
-    ret = nc_connect_ssh(config->host, config->port, config->username, 
-                        config->private_key_path, config->password, &sess);
-    if (ret != NC_MSG_HELLO) {
-        fprintf(stderr, "Failed to connect to NETCONF server: %s\n", nc_strerror(ret));
+    pthread_once(&client_pool_once, create_client_pool);
+    if (!client_pool) {
+        fprintf(stderr, "Failed to create session pool\n");
+        return ERROR_INIT;
+    }
+    
+    // Reuse an idle session to the same server and user, else connect
+    o1_client_target_t target = {
+        config->host, config->port, config->username, config->password, config->private_key_path
+    };
+    sess = o1_client_pool_acquire(client_pool, &target);
+    if (!sess) {
+        fprintf(stderr, "Failed to connect to NETCONF server\n");
         return ERROR_SESSION;
     }
     
@@ -95,13 +105,27 @@ int create_netconf_session(nc_session **session, const netconf_config_t *config)
     return SUCCESS;
 }
 
+// Return a session to the pool for the next create_netconf_session()
+void release_netconf_session(nc_session *session) {
+    if (session) {
+        o1_client_pool_release(client_pool, session, 1);
+    }
+}
+
+// Close a session that failed; it is not reused
 void cleanup_netconf_session(nc_session *session) {
     if (session) {
-        nc_session_free(session, NULL);
+        o1_client_pool_release(client_pool, session, 0);
         printf("NETCONF session cleaned up\n");
     }
 }
 
+// Close every pooled session
+void cleanup_netconf_pool(void) {
+    o1_client_pool_destroy(client_pool);
+    client_pool = NULL;
+}
+
 int send_tracing_data(nc_session *session, const tracing_data_t *tracing) {
     if (!session || !tracing) {
         return ERROR_INIT;
@@ -19,11 +19,8 @@
 #include <libnetconf2/log.h>
 #include <libyang/libyang.h>
 
-// Tracing structure
-typedef struct {
-    char traceid[33];  // 32 hex chars + null terminator
-    char spanid[17];   // 16 hex chars + null terminator
-} tracing_data_t;
+#include "log.h"
+#include "trace_id.h"
 
 // Configuration structure
 typedef struct {
@@ -36,12 +33,14 @@ typedef struct {
 } netconf_config_t;
 
 // Function declarations
-void init_logging(void);
+void init_logging(log_level_t level);
 void cleanup_logging(void);
 int generate_tracing_data(tracing_data_t *tracing);
 void print_tracing_data(const tracing_data_t *tracing);
 int create_netconf_session(nc_session **session, const netconf_config_t *config);
+void release_netconf_session(nc_session *session);
 void cleanup_netconf_session(nc_session *session);
+void cleanup_netconf_pool(void);
 int send_tracing_data(nc_session *session, const tracing_data_t *tracing);
 int receive_tracing_data(nc_session *session, tracing_data_t *tracing);
 int create_self_signed_cert(const char *cert_path, const char *key_path);
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "frame.h"
+
+int frame_buf_init(frame_buf_t *buf, size_t cap) {
+    buf->data = malloc(cap);
+    if (!buf->data) {
+        return -1;
+    }
+    buf->start = 0;
+    buf->len = 0;
+    buf->cap = cap;
+    return 0;
+}
+
+void frame_buf_free(frame_buf_t *buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->start = buf->len = buf->cap = 0;
+}
+
+size_t frame_buf_pending(const frame_buf_t *buf) {
+    return buf->len - buf->start;
+}
+
+// Move unconsumed bytes to the front to make room at the end
+static void frame_buf_compact(frame_buf_t *buf) {
+    if (buf->start == 0) {
+        return;
+    }
+    memmove(buf->data, buf->data + buf->start, buf->len - buf->start);
+    buf->len -= buf->start;
+    buf->start = 0;
+}
+
+// One recv() into the free space. Returns the byte count, 0 on EOF, or -1
+// with errno set (EAGAIN/EWOULDBLOCK when the socket is drained, EMSGSIZE
+// when the buffer is full without holding a complete frame).
+int frame_buf_read(frame_buf_t *buf, int fd) {
+    if (buf->len == buf->cap) {
+        frame_buf_compact(buf);
+        if (buf->len == buf->cap) {
+            errno = EMSGSIZE;
+            return -1;
+        }
+    }
+    
+    while (1) {
+        ssize_t n = recv(fd, buf->data + buf->len, buf->cap - buf->len, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n > 0) {
+            buf->len += n;
+        }
+        return (int)n;
+    }
+}
+
+// Next complete frame, NUL-terminated in place of its newline, or NULL if
+// only a partial frame is buffered. The pointer stays valid until the next
+// frame_buf_read() on this buffer.
+char *frame_next(frame_buf_t *buf, size_t *len) {
+    char *start = buf->data + buf->start;
+    size_t avail = buf->len - buf->start;
+    
+    char *nl = memchr(start, '\n', avail);
+    if (!nl) {
+        if (avail >= FRAME_MAX_SIZE) {
+            // Oversized frame: report it so the caller can drop the peer
+            errno = EMSGSIZE;
+        } else {
+            errno = 0;
+        }
+        if (avail == 0) {
+            buf->start = buf->len = 0;
+        }
+        return NULL;
+    }
+    
+    *nl = '\0';
+    *len = nl - start;
+    buf->start += *len + 1;
+    return start;
+}
+
+int frame_buf_append(frame_buf_t *buf, const char *data, size_t len) {
+    if (buf->cap - buf->len < len) {
+        frame_buf_compact(buf);
+        if (buf->cap - buf->len < len) {
+            errno = ENOBUFS;
+            return -1;
+        }
+    }
+    
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    return 0;
+}
+
+// Write as much queued output as the socket accepts. Returns the number of
+// bytes still queued, or -1 on a socket error.
+int frame_buf_flush(frame_buf_t *buf, int fd) {
+    while (buf->start < buf->len) {
+        ssize_t n = send(fd, buf->data + buf->start, buf->len - buf->start, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return -1;
+        }
+        buf->start += n;
+    }
+    
+    if (buf->start == buf->len) {
+        buf->start = buf->len = 0;
+    }
+    return (int)(buf->len - buf->start);
+}
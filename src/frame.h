@@ -0,0 +1,33 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stddef.h>
+
+// Newline-delimited framing for the simple tracing protocol: every record
+// is one line of JSON terminated by '\n'. A frame_buf_t collects bytes from
+// a socket and yields complete frames, or queues outgoing frames until the
+// socket accepts them. Partial reads/writes and several frames coalesced
+// into one read are both handled.
+
+#define FRAME_MAX_SIZE 4096             // longest accepted frame, newline included
+#define FRAME_BUF_SIZE (16 * FRAME_MAX_SIZE)
+
+typedef struct {
+    char *data;
+    size_t start;   // first unconsumed byte
+    size_t len;     // end of valid data
+    size_t cap;
+} frame_buf_t;
+
+// Function declarations
+int frame_buf_init(frame_buf_t *buf, size_t cap);
+void frame_buf_free(frame_buf_t *buf);
+size_t frame_buf_pending(const frame_buf_t *buf);
+
+int frame_buf_read(frame_buf_t *buf, int fd);
+char *frame_next(frame_buf_t *buf, size_t *len);
+
+int frame_buf_append(frame_buf_t *buf, const char *data, size_t len);
+int frame_buf_flush(frame_buf_t *buf, int fd);
+
+#endif // FRAME_H
@@ -0,0 +1,215 @@
+#include <stdint.h>
+
+#include "hex.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HEX_X86 1
+#include <immintrin.h>
+#endif
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static void hex_encode_scalar(char *dst, const unsigned char *src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        dst[i * 2] = hex_digits[src[i] >> 4];
+        dst[i * 2 + 1] = hex_digits[src[i] & 0x0f];
+    }
+}
+
+static int hex_validate_scalar(const char *src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)src[i];
+        unsigned char lower = c | 0x20;
+        if ((unsigned char)(c - '0') > 9 && (unsigned char)(lower - 'a') > 5) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#ifdef HEX_X86
+
+// Nibbles (0..15) to ASCII: '0' + n, plus 39 more for n > 9 to reach 'a'
+__attribute__((target("sse2")))
+static inline __m128i nibbles_to_ascii_sse2(__m128i n) {
+    __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(n, _mm_set1_epi8(9)), _mm_set1_epi8(39));
+    return _mm_add_epi8(_mm_add_epi8(n, _mm_set1_epi8('0')), letters);
+}
+
+__attribute__((target("sse2")))
+static void hex_encode_sse2(char *dst, const unsigned char *src, size_t len) {
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    
+    while (len >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)src);
+        __m128i hi = nibbles_to_ascii_sse2(_mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        __m128i lo = nibbles_to_ascii_sse2(_mm_and_si128(v, mask));
+        _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi8(hi, lo));
+        src += 16;
+        dst += 32;
+        len -= 16;
+    }
+    
+    // Span IDs are 8 bytes: one half-width step
+    if (len >= 8) {
+        __m128i v = _mm_loadl_epi64((const __m128i *)src);
+        __m128i hi = nibbles_to_ascii_sse2(_mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        __m128i lo = nibbles_to_ascii_sse2(_mm_and_si128(v, mask));
+        _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi8(hi, lo));
+        src += 8;
+        dst += 16;
+        len -= 8;
+    }
+    
+    hex_encode_scalar(dst, src, len);
+}
+
+// Lanes where lo <= v <= hi (unsigned)
+__attribute__((target("sse2")))
+static inline __m128i in_range_sse2(__m128i v, char lo, char hi) {
+    __m128i t = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8((char)(hi - lo))), t);
+}
+
+__attribute__((target("sse2")))
+static int hex_validate_sse2(const char *src, size_t len) {
+    while (len >= 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)src);
+        __m128i ok = _mm_or_si128(in_range_sse2(v, '0', '9'),
+                                  in_range_sse2(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'f'));
+        if (_mm_movemask_epi8(ok) != 0xffff) {
+            return 0;
+        }
+        src += 16;
+        len -= 16;
+    }
+    
+    return hex_validate_scalar(src, len);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i nibbles_to_ascii_avx2(__m256i n) {
+    __m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(n, _mm256_set1_epi8(9)),
+                                       _mm256_set1_epi8(39));
+    return _mm256_add_epi8(_mm256_add_epi8(n, _mm256_set1_epi8('0')), letters);
+}
+
+__attribute__((target("avx2")))
+static void hex_encode_avx2(char *dst, const unsigned char *src, size_t len) {
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+    
+    while (len >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)src);
+        __m256i hi = nibbles_to_ascii_avx2(_mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+        __m256i lo = nibbles_to_ascii_avx2(_mm256_and_si256(v, mask));
+        // Unpacks work per 128-bit lane; permute the halves back into order
+        __m256i a = _mm256_unpacklo_epi8(hi, lo);
+        __m256i b = _mm256_unpackhi_epi8(hi, lo);
+        _mm256_storeu_si256((__m256i *)dst, _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + 32), _mm256_permute2x128_si256(a, b, 0x31));
+        src += 32;
+        dst += 64;
+        len -= 32;
+    }
+    
+    hex_encode_sse2(dst, src, len);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i in_range_avx2(__m256i v, char lo, char hi) {
+    __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8((char)(hi - lo))), t);
+}
+
+__attribute__((target("avx2")))
+static int hex_validate_avx2(const char *src, size_t len) {
+    while (len >= 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)src);
+        __m256i ok = _mm256_or_si256(in_range_avx2(v, '0', '9'),
+                                     in_range_avx2(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'f'));
+        if ((uint32_t)_mm256_movemask_epi8(ok) != 0xffffffffu) {
+            return 0;
+        }
+        src += 32;
+        len -= 32;
+    }
+    
+    return hex_validate_sse2(src, len);
+}
+
+#endif // HEX_X86
+
+// Runtime dispatch: the first call resolves the implementation for this CPU
+typedef struct {
+    const char *name;
+    void (*encode)(char *dst, const unsigned char *src, size_t len);
+    int (*validate)(const char *src, size_t len);
+} hex_impl_t;
+
+static const hex_impl_t hex_impls[] = {
+    { "scalar", hex_encode_scalar, hex_validate_scalar },
+#ifdef HEX_X86
+    { "sse2", hex_encode_sse2, hex_validate_sse2 },
+    { "avx2", hex_encode_avx2, hex_validate_avx2 },
+#endif
+};
+
+static const hex_impl_t *hex_impl = NULL;
+
+static const hex_impl_t *hex_resolve(void) {
+    const hex_impl_t *impl = __atomic_load_n(&hex_impl, __ATOMIC_ACQUIRE);
+    if (impl) {
+        return impl;
+    }
+    
+    impl = &hex_impls[0];
+#ifdef HEX_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        impl = &hex_impls[2];
+    } else if (__builtin_cpu_supports("sse2")) {
+        impl = &hex_impls[1];
+    }
+#endif
+    
+    // Every thread resolves to the same entry, so a racing store is harmless
+    __atomic_store_n(&hex_impl, impl, __ATOMIC_RELEASE);
+    return impl;
+}
+
+void hex_encode(char *dst, const unsigned char *src, size_t len) {
+    hex_resolve()->encode(dst, src, len);
+}
+
+int hex_validate(const char *src, size_t len) {
+    return hex_resolve()->validate(src, len);
+}
+
+static int hex_nibble(unsigned char c) {
+    if ((unsigned char)(c - '0') <= 9) {
+        return c - '0';
+    }
+    c |= 0x20;
+    if ((unsigned char)(c - 'a') <= 5) {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// IDs are decoded once per stored edit, so the scalar loop is enough here
+int hex_decode(unsigned char *dst, const char *src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        int hi = hex_nibble((unsigned char)src[i * 2]);
+        int lo = hex_nibble((unsigned char)src[i * 2 + 1]);
+        if (hi < 0 || lo < 0) {
+            return -1;
+        }
+        dst[i] = (unsigned char)(hi << 4 | lo);
+    }
+    return 0;
+}
+
+const char *hex_impl_name(void) {
+    return hex_resolve()->name;
+}
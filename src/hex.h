@@ -0,0 +1,22 @@
+#ifndef HEX_H
+#define HEX_H
+
+#include <stddef.h>
+
+// Lower-case hex encoding, decoding and validation for trace/span IDs.
+// On x86-64 the AVX2 or SSE2 implementation is picked at first use;
+// other targets use the scalar code.
+
+// Writes 2 * len characters to dst; no NUL terminator is added
+void hex_encode(char *dst, const unsigned char *src, size_t len);
+
+// Returns 1 if all len characters are [0-9a-fA-F], 0 otherwise
+int hex_validate(const char *src, size_t len);
+
+// Decodes 2 * len hex characters into len bytes; -1 on a non-hex character
+int hex_decode(unsigned char *dst, const char *src, size_t len);
+
+// Name of the implementation selected for this CPU ("avx2", "sse2", "scalar")
+const char *hex_impl_name(void);
+
+#endif // HEX_H
@@ -0,0 +1,1061 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "log.h"
+
+#define LOG_MAX_RECORD 4096     // captured arguments of one message, header included
+#define LOG_MAX_STRING 1024     // longer %s arguments are cut
+#define LOG_OUT_SIZE (64 * 1024)
+#define LOG_CLOCK_JITTER_NS 10000   // wall-clock offset changes below this are noise
+
+// Record header in a thread's ring. A header whose site is NULL pads the
+// ring up to its end; fewer than sizeof(log_record_t) bytes left at the end
+// are skipped without one.
+typedef struct {
+    uint32_t size;              // header and arguments, rounded up to 8 bytes
+    uint32_t suppressed;        // rate limited messages of this site before this one
+    const log_site_t *site;
+    uint64_t timestamp;         // CLOCK_MONOTONIC nanoseconds
+} log_record_t;
+
+// Single producer (the owning thread), single consumer (the flusher). head
+// and tail count bytes ever written and read; only their owner stores them.
+// stamping is set from before a record's timestamp is taken until it is
+// published. read and limit are the flusher's position and end while it
+// merges.
+typedef struct log_ring {
+    char *data;
+    size_t mask;
+    uint64_t head;
+    uint64_t tail;
+    int stamping;
+    uint64_t read;
+    uint64_t limit;
+    unsigned id;
+    int exited;
+    struct log_ring *next;
+} log_ring_t;
+
+// Text being batched for one output stream
+typedef struct {
+    FILE *file;
+    char *data;
+    size_t len;
+} log_out_t;
+
+int log_threshold = LOG_LEVEL_INFO;
+
+static struct {
+    log_config_t config;
+    int running;
+    unsigned generation;
+    pthread_t flusher;
+    pthread_mutex_t lock;       // rings list, stopping, waiters
+    pthread_cond_t wake;        // timed on CLOCK_MONOTONIC
+    pthread_cond_t drained;     // broadcast after every flush
+    int stopping;
+    int waiters;                // threads waiting for room in their ring
+    log_ring_t *rings;
+    unsigned next_ring_id;
+    pthread_key_t ring_key;
+    unsigned rate_limit;
+    uint64_t dropped;
+    uint64_t dropped_reported;
+    uint64_t wall_offset;       // CLOCK_REALTIME minus CLOCK_MONOTONIC at the last flush
+    uint32_t next_site_id;
+    FILE *file;                 // config.path opened, or NULL
+    log_out_t out[2];           // [0] warnings and errors, [1] the rest; one stream with a path
+    char line[LOG_MAX_LINE];
+} logger = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .drained = PTHREAD_COND_INITIALIZER
+};
+
+static __thread log_ring_t *thread_ring;
+static __thread unsigned thread_generation;
+static __thread char scratch[LOG_MAX_RECORD];
+
+// log_site_t.prepared
+enum { SITE_UNPREPARED, SITE_PREPARING, SITE_KINDS, SITE_FORMAT };
+
+static const char *level_names[] = { "ERROR", "WARN", "INFO", "DEBUG" };
+
+void log_default_config(log_config_t *config) {
+    config->level = LOG_LEVEL_INFO;
+    config->path = NULL;
+    config->binary = 0;
+    config->ring_size = LOG_DEFAULT_RING_SIZE;
+    config->rate_limit = LOG_DEFAULT_RATE_LIMIT;
+    config->drop_when_full = 0;
+    config->flush_interval = LOG_DEFAULT_FLUSH_INTERVAL;
+}
+
+void log_set_level(log_level_t level) {
+    __atomic_store_n(&log_threshold, (int)level, __ATOMIC_RELAXED);
+}
+
+void log_set_rate_limit(unsigned per_second) {
+    __atomic_store_n(&logger.rate_limit, per_second, __ATOMIC_RELAXED);
+}
+
+int log_parse_level(const char *name, log_level_t *level) {
+    for (size_t i = 0; i < sizeof(level_names) / sizeof(level_names[0]); i++) {
+        if (strcasecmp(name, level_names[i]) == 0) {
+            *level = (log_level_t)i;
+            return 0;
+        }
+    }
+    if (strcasecmp(name, "warning") == 0) {
+        *level = LOG_LEVEL_WARN;
+        return 0;
+    }
+    return -1;
+}
+
+const char *log_level_name(log_level_t level) {
+    if ((unsigned)level >= sizeof(level_names) / sizeof(level_names[0])) {
+        return "?";
+    }
+    return level_names[level];
+}
+
+uint64_t log_dropped(void) {
+    return __atomic_load_n(&logger.dropped, __ATOMIC_RELAXED);
+}
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Offset from the monotonic clock to the wall clock. Both advance together
+// while NTP slews, so only a step changes it. A change smaller than the
+// jitter of reading the two clocks is ignored, so that records converted
+// in different flushes stay in order, and reads interrupted for longer
+// than that are retried.
+static void update_wall_offset(void) {
+    for (int tries = 0; tries < 3; tries++) {
+        uint64_t before = clock_ns(CLOCK_MONOTONIC);
+        uint64_t wall = clock_ns(CLOCK_REALTIME);
+        uint64_t after = clock_ns(CLOCK_MONOTONIC);
+        if (after - before >= LOG_CLOCK_JITTER_NS) {
+            continue;
+        }
+        
+        uint64_t offset = wall - (before + (after - before) / 2);
+        int64_t change = (int64_t)(offset - logger.wall_offset);
+        if (logger.wall_offset == 0 || change >= LOG_CLOCK_JITTER_NS ||
+            change <= -LOG_CLOCK_JITTER_NS) {
+            logger.wall_offset = offset;
+        }
+        return;
+    }
+}
+
+// Argument capture: each conversion of the format in order, integers
+// widened to 64 bits, doubles as doubles, strings as a 32-bit length and
+// their bytes. The format itself stays with the call site.
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} log_args_t;
+
+static void put(log_args_t *args, const void *value, size_t size) {
+    if (args->len + size <= args->cap) {
+        memcpy(args->data + args->len, value, size);
+        args->len += size;
+    }
+}
+
+static void put_u64(log_args_t *args, uint64_t value) {
+    put(args, &value, sizeof(value));
+}
+
+static void put_str(log_args_t *args, const char *s, long precision) {
+    if (!s) {
+        s = "(null)";
+    }
+    size_t limit = precision >= 0 && precision < LOG_MAX_STRING ? (size_t)precision : LOG_MAX_STRING;
+    size_t len = strnlen(s, limit);
+    if (args->len + sizeof(uint32_t) + len > args->cap) {
+        len = args->cap - args->len > sizeof(uint32_t) ? args->cap - args->len - sizeof(uint32_t) : 0;
+    }
+    uint32_t len32 = (uint32_t)len;
+    put(args, &len32, sizeof(len32));
+    put(args, s, len);
+}
+
+enum { LEN_NONE, LEN_HH, LEN_H, LEN_L, LEN_LL, LEN_Z, LEN_J, LEN_T, LEN_BIG_L };
+
+// Skip flags, width and precision of the conversion at *p (just past the
+// '%'). Stars are reported through star_width/star_precision so the caller
+// can consume or read them in order.
+static const char *parse_spec(const char *p, int *star_width, int *star_precision,
+                              long *precision, int *length) {
+    *star_width = 0;
+    *star_precision = 0;
+    *precision = -1;
+    while (*p && strchr("-+ #0'", *p)) {
+        p++;
+    }
+    if (*p == '*') {
+        *star_width = 1;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    if (*p == '.') {
+        p++;
+        *precision = 0;
+        if (*p == '*') {
+            *star_precision = 1;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') {
+                *precision = *precision * 10 + (*p - '0');
+                p++;
+            }
+        }
+    }
+    
+    *length = LEN_NONE;
+    switch (*p) {
+    case 'h':
+        p++;
+        *length = LEN_H;
+        if (*p == 'h') {
+            p++;
+            *length = LEN_HH;
+        }
+        break;
+    case 'l':
+        p++;
+        *length = LEN_L;
+        if (*p == 'l') {
+            p++;
+            *length = LEN_LL;
+        }
+        break;
+    case 'z': p++; *length = LEN_Z; break;
+    case 'j': p++; *length = LEN_J; break;
+    case 't': p++; *length = LEN_T; break;
+    case 'L': p++; *length = LEN_BIG_L; break;
+    }
+    return p;
+}
+
+// The va_arg type a conversion consumes and how it is stored
+enum {
+    ARG_END,
+    ARG_INT, ARG_SCHAR, ARG_SHORT, ARG_LONG, ARG_LLONG, ARG_SSIZE, ARG_INTMAX, ARG_PTRDIFF,
+    ARG_UINT, ARG_UCHAR, ARG_USHORT, ARG_ULONG, ARG_ULLONG, ARG_SIZE, ARG_UINTMAX,
+    ARG_STRING, ARG_POINTER, ARG_DOUBLE, ARG_LDOUBLE, ARG_SKIP
+};
+
+static int arg_kind(char conversion, int length) {
+    static const unsigned char signed_kinds[] = {
+        ARG_INT, ARG_SCHAR, ARG_SHORT, ARG_LONG, ARG_LLONG, ARG_SSIZE, ARG_INTMAX, ARG_PTRDIFF, ARG_INT
+    };
+    static const unsigned char unsigned_kinds[] = {
+        ARG_UINT, ARG_UCHAR, ARG_USHORT, ARG_ULONG, ARG_ULLONG, ARG_SIZE, ARG_UINTMAX, ARG_PTRDIFF, ARG_UINT
+    };
+    
+    switch (conversion) {
+    case 'd':
+    case 'i':
+        return signed_kinds[length];
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+        return unsigned_kinds[length];
+    case 'c':
+        return ARG_INT;
+    case 's':
+        return ARG_STRING;
+    case 'p':
+        return ARG_POINTER;
+    case 'f': case 'F': case 'e': case 'E':
+    case 'g': case 'G': case 'a': case 'A':
+        return length == LEN_BIG_L ? ARG_LDOUBLE : ARG_DOUBLE;
+    case 'n':
+        return ARG_SKIP;
+    default:
+        return -1;
+    }
+}
+
+static void capture_arg(log_args_t *args, int kind, va_list *ap, long precision) {
+    double value;
+    
+    switch (kind) {
+    case ARG_INT:     put_u64(args, (uint64_t)(int64_t)va_arg(*ap, int)); break;
+    case ARG_SCHAR:   put_u64(args, (uint64_t)(int64_t)(signed char)va_arg(*ap, int)); break;
+    case ARG_SHORT:   put_u64(args, (uint64_t)(int64_t)(short)va_arg(*ap, int)); break;
+    case ARG_LONG:    put_u64(args, (uint64_t)(int64_t)va_arg(*ap, long)); break;
+    case ARG_LLONG:   put_u64(args, (uint64_t)(int64_t)va_arg(*ap, long long)); break;
+    case ARG_SSIZE:   put_u64(args, (uint64_t)(int64_t)va_arg(*ap, ssize_t)); break;
+    case ARG_INTMAX:  put_u64(args, (uint64_t)(int64_t)va_arg(*ap, intmax_t)); break;
+    case ARG_PTRDIFF: put_u64(args, (uint64_t)(int64_t)va_arg(*ap, ptrdiff_t)); break;
+    case ARG_UINT:    put_u64(args, va_arg(*ap, unsigned int)); break;
+    case ARG_UCHAR:   put_u64(args, (unsigned char)va_arg(*ap, unsigned int)); break;
+    case ARG_USHORT:  put_u64(args, (unsigned short)va_arg(*ap, unsigned int)); break;
+    case ARG_ULONG:   put_u64(args, va_arg(*ap, unsigned long)); break;
+    case ARG_ULLONG:  put_u64(args, va_arg(*ap, unsigned long long)); break;
+    case ARG_SIZE:    put_u64(args, va_arg(*ap, size_t)); break;
+    case ARG_UINTMAX: put_u64(args, va_arg(*ap, uintmax_t)); break;
+    case ARG_STRING:  put_str(args, va_arg(*ap, const char *), precision); break;
+    case ARG_POINTER: put_u64(args, (uint64_t)(uintptr_t)va_arg(*ap, void *)); break;
+    case ARG_DOUBLE:
+        value = va_arg(*ap, double);
+        put(args, &value, sizeof(value));
+        break;
+    case ARG_LDOUBLE:
+        value = (double)va_arg(*ap, long double);
+        put(args, &value, sizeof(value));
+        break;
+    case ARG_SKIP:
+        (void)va_arg(*ap, void *);
+        break;
+    }
+}
+
+// Walk the format for every message; used for sites prepare_site() rejects
+static void capture_args(log_args_t *args, const char *fmt, va_list *ap) {
+    for (const char *p = fmt; *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        if (p[1] == '%') {
+            p++;
+            continue;
+        }
+        
+        int star_width, star_precision, length;
+        long precision;
+        p = parse_spec(p + 1, &star_width, &star_precision, &precision, &length);
+        if (star_width) {
+            capture_arg(args, ARG_INT, ap, -1);
+        }
+        if (star_precision) {
+            int value = va_arg(*ap, int);
+            put_u64(args, (uint64_t)(int64_t)value);
+            precision = value < 0 ? -1 : value;
+        }
+        
+        int kind = arg_kind(*p, length);
+        if (kind < 0) {
+            // Unknown conversion: nothing after it can be captured reliably
+            return;
+        }
+        capture_arg(args, kind, ap, precision);
+    }
+}
+
+// Record the argument kinds of a site's format once, so later messages
+// skip the format. Formats with a string precision, an unknown conversion
+// or more than LOG_SITE_ARGS arguments keep walking it.
+static int prepare_site(log_site_t *site) {
+    size_t count = 0;
+    
+    for (const char *p = site->fmt; *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        if (p[1] == '%') {
+            p++;
+            continue;
+        }
+        
+        int star_width, star_precision, length;
+        long precision;
+        p = parse_spec(p + 1, &star_width, &star_precision, &precision, &length);
+        int kind = arg_kind(*p, length);
+        if (kind < 0 || (kind == ARG_STRING && precision >= 0) ||
+            count + (size_t)star_width + (size_t)star_precision + 1 >= LOG_SITE_ARGS) {
+            return -1;
+        }
+        if (star_width) {
+            site->kinds[count++] = ARG_INT;
+        }
+        if (star_precision) {
+            site->kinds[count++] = ARG_INT;
+        }
+        site->kinds[count++] = (uint8_t)kind;
+    }
+    
+    site->kinds[count] = ARG_END;
+    return 0;
+}
+
+static void capture_kinds(log_args_t *args, const uint8_t *kinds, va_list *ap) {
+    for (; *kinds != ARG_END; kinds++) {
+        capture_arg(args, *kinds, ap, -1);
+    }
+}
+
+// Formatting, done by the flusher and by log_decode: every conversion is
+// rebuilt with a 64-bit length modifier and its captured value.
+
+typedef struct {
+    const char *data;
+    size_t len;
+    size_t pos;
+    int short_read;
+} log_reader_t;
+
+static int take(log_reader_t *reader, void *value, size_t size) {
+    if (reader->pos + size > reader->len) {
+        reader->short_read = 1;
+        memset(value, 0, size);
+        return -1;
+    }
+    memcpy(value, reader->data + reader->pos, size);
+    reader->pos += size;
+    return 0;
+}
+
+static size_t append(size_t size, size_t pos, int written) {
+    if (written < 0 || pos >= size) {
+        return pos;
+    }
+    return pos + ((size_t)written < size - pos ? (size_t)written : size - pos - 1);
+}
+
+static size_t format_args(char *out, size_t size, size_t pos, const char *fmt,
+                          const void *data, size_t len) {
+    log_reader_t reader = { data, len, 0, 0 };
+    char spec[64];
+    
+    for (const char *p = fmt; *p && pos + 1 < size; p++) {
+        if (*p != '%') {
+            out[pos++] = *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[pos++] = '%';
+            p++;
+            continue;
+        }
+        
+        const char *start = p + 1;
+        int star_width, star_precision, length;
+        long precision;
+        p = parse_spec(start, &star_width, &star_precision, &precision, &length);
+        
+        // Flags as written; width and precision substituted when starred
+        size_t n = 0;
+        spec[n++] = '%';
+        const char *q = start;
+        while (*q && strchr("-+ #0'", *q)) {
+            if (n < 16) {
+                spec[n++] = *q;
+            }
+            q++;
+        }
+        int64_t value;
+        if (star_width) {
+            take(&reader, &value, sizeof(value));
+            n += (size_t)snprintf(spec + n, 24, "%d", (int)value);
+        } else {
+            while (*q >= '0' && *q <= '9' && n < 40) {
+                spec[n++] = *q++;
+            }
+        }
+        if (star_precision) {
+            take(&reader, &value, sizeof(value));
+            if (value >= 0 && *p != 's') {
+                n += (size_t)snprintf(spec + n, 16, ".%d", (int)value);
+            }
+        } else if (precision >= 0 && *p != 's') {
+            n += (size_t)snprintf(spec + n, 16, ".%ld", precision);
+        }
+        
+        switch (*p) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            uint64_t raw;
+            take(&reader, &raw, sizeof(raw));
+            spec[n++] = 'l';
+            spec[n++] = 'l';
+            spec[n++] = *p;
+            spec[n] = '\0';
+            if (*p == 'd' || *p == 'i') {
+                pos = append(size, pos, snprintf(out + pos, size - pos, spec, (long long)(int64_t)raw));
+            } else {
+                pos = append(size, pos, snprintf(out + pos, size - pos, spec, (unsigned long long)raw));
+            }
+            break;
+        }
+        case 'c':
+        case 'p': {
+            uint64_t raw;
+            take(&reader, &raw, sizeof(raw));
+            spec[n++] = *p;
+            spec[n] = '\0';
+            if (*p == 'c') {
+                pos = append(size, pos, snprintf(out + pos, size - pos, spec, (int)raw));
+            } else {
+                pos = append(size, pos, snprintf(out + pos, size - pos, spec, (void *)(uintptr_t)raw));
+            }
+            break;
+        }
+        case 's': {
+            // The captured bytes already respect the precision
+            uint32_t slen;
+            if (take(&reader, &slen, sizeof(slen)) != 0 || reader.pos + slen > reader.len) {
+                reader.short_read = 1;
+                slen = 0;
+            }
+            memcpy(spec + n, ".*s", 4);
+            pos = append(size, pos, snprintf(out + pos, size - pos, spec, (int)slen,
+                                                  reader.data + reader.pos));
+            reader.pos += slen;
+            break;
+        }
+        case 'f': case 'F': case 'e': case 'E':
+        case 'g': case 'G': case 'a': case 'A': {
+            double raw;
+            take(&reader, &raw, sizeof(raw));
+            spec[n++] = *p;
+            spec[n] = '\0';
+            pos = append(size, pos, snprintf(out + pos, size - pos, spec, raw));
+            break;
+        }
+        case 'n':
+            break;
+        default:
+            pos = append(size, pos, snprintf(out + pos, size - pos, "%s", p));
+            return pos;
+        }
+        
+        if (!*p || reader.short_read) {
+            break;
+        }
+    }
+    
+    if (reader.short_read) {
+        pos = append(size, pos, snprintf(out + pos, size - pos, " <truncated>"));
+    }
+    return pos;
+}
+
+// "2026-01-31 12:00:00.123456 INFO  [3] message\n"
+size_t log_format_line(char *out, size_t size, uint64_t timestamp, log_level_t level,
+                       unsigned thread, const char *fmt, const void *args, size_t args_len) {
+    time_t seconds = (time_t)(timestamp / 1000000000ull);
+    struct tm tm;
+    size_t pos = 0;
+    
+    localtime_r(&seconds, &tm);
+    pos = strftime(out, size, "%Y-%m-%d %H:%M:%S", &tm);
+    pos = append(size, pos, snprintf(out + pos, size - pos, ".%06u %-5s [%u] ",
+                                          (unsigned)(timestamp % 1000000000ull / 1000),
+                                          log_level_name(level), thread));
+    pos = format_args(out, size, pos, fmt, args, args_len);
+    if (pos + 1 < size) {
+        out[pos++] = '\n';
+    } else {
+        out[size - 2] = '\n';
+        pos = size - 1;
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+// Producer side
+
+static void ring_exit(void *arg) {
+    log_ring_t *ring = arg;
+    __atomic_store_n(&ring->exited, 1, __ATOMIC_RELEASE);
+}
+
+static log_ring_t *ring_register(void) {
+    log_ring_t *ring = calloc(1, sizeof(*ring));
+    size_t size = 2 * LOG_MAX_RECORD;  // any record fits after padding
+    
+    while (size < logger.config.ring_size) {
+        size <<= 1;
+    }
+    if (!ring || !(ring->data = malloc(size))) {
+        free(ring);
+        return NULL;
+    }
+    ring->mask = size - 1;
+    
+    pthread_mutex_lock(&logger.lock);
+    ring->id = ++logger.next_ring_id;
+    ring->next = logger.rings;
+    logger.rings = ring;
+    pthread_mutex_unlock(&logger.lock);
+    
+    pthread_setspecific(logger.ring_key, ring);
+    thread_ring = ring;
+    thread_generation = logger.generation;
+    return ring;
+}
+
+static int rate_limited(log_site_t *site, uint32_t *suppressed) {
+    unsigned limit = __atomic_load_n(&logger.rate_limit, __ATOMIC_RELAXED);
+    *suppressed = 0;
+    if (limit == 0) {
+        return 0;
+    }
+    
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    uint32_t now = (uint32_t)ts.tv_sec;
+    if (__atomic_load_n(&site->window, __ATOMIC_RELAXED) != now) {
+        __atomic_store_n(&site->window, now, __ATOMIC_RELAXED);
+        __atomic_store_n(&site->count, 0, __ATOMIC_RELAXED);
+    }
+    if (__atomic_add_fetch(&site->count, 1, __ATOMIC_RELAXED) > limit) {
+        __atomic_add_fetch(&site->suppressed, 1, __ATOMIC_RELAXED);
+        return 1;
+    }
+    *suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// Wake the flusher and sleep until it has made room for needed bytes.
+// Fails only once the log is shutting down.
+static int wait_for_room(log_ring_t *ring, size_t needed) {
+    size_t ring_size = ring->mask + 1;
+    int status = 0;
+    
+    pthread_mutex_lock(&logger.lock);
+    while (ring->head + needed - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > ring_size) {
+        if (logger.stopping) {
+            status = -1;
+            break;
+        }
+        logger.waiters++;
+        pthread_cond_signal(&logger.wake);
+        pthread_cond_wait(&logger.drained, &logger.lock);
+        logger.waiters--;
+    }
+    pthread_mutex_unlock(&logger.lock);
+    return status;
+}
+
+static void write_sync(const log_site_t *site, va_list ap) {
+    FILE *stream = site->level <= LOG_LEVEL_WARN ? stderr : stdout;
+    vfprintf(stream, site->fmt, ap);
+    fputc('\n', stream);
+}
+
+void log_write(log_site_t *site, ...) {
+    va_list ap;
+    
+    if (!__atomic_load_n(&logger.running, __ATOMIC_ACQUIRE)) {
+        va_start(ap, site);
+        write_sync(site, ap);
+        va_end(ap);
+        return;
+    }
+    
+    uint32_t suppressed;
+    if (rate_limited(site, &suppressed)) {
+        return;
+    }
+    
+    log_ring_t *ring = thread_ring;
+    if (!ring || thread_generation != logger.generation) {
+        ring = ring_register();
+        if (!ring) {
+            __atomic_add_fetch(&logger.dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    
+    log_args_t args = { scratch + sizeof(log_record_t), 0, sizeof(scratch) - sizeof(log_record_t) };
+    int prepared = __atomic_load_n(&site->prepared, __ATOMIC_ACQUIRE);
+    if (prepared == SITE_UNPREPARED) {
+        int expected = SITE_UNPREPARED;
+        if (__atomic_compare_exchange_n(&site->prepared, &expected, SITE_PREPARING, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            prepared = prepare_site(site) == 0 ? SITE_KINDS : SITE_FORMAT;
+            __atomic_store_n(&site->prepared, prepared, __ATOMIC_RELEASE);
+        }
+    }
+    va_start(ap, site);
+    if (prepared == SITE_KINDS) {
+        capture_kinds(&args, site->kinds, &ap);
+    } else {
+        capture_args(&args, site->fmt, &ap);
+    }
+    va_end(ap);
+    
+    log_record_t *record = (log_record_t *)scratch;
+    record->size = (uint32_t)((sizeof(log_record_t) + args.len + 7) & ~(size_t)7);
+    record->suppressed = suppressed;
+    record->site = site;
+    
+    // Records never wrap: the space left at the end is padded first
+    size_t ring_size = ring->mask + 1;
+    uint64_t head = ring->head;
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    size_t pos = head & ring->mask;
+    size_t pad = ring_size - pos < record->size ? ring_size - pos : 0;
+    if (head + pad + record->size - tail > ring_size &&
+        (logger.config.drop_when_full || wait_for_room(ring, pad + record->size) != 0)) {
+        __atomic_add_fetch(&logger.dropped, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&site->suppressed, suppressed, __ATOMIC_RELAXED);
+        return;
+    }
+    if (pad >= sizeof(log_record_t)) {
+        log_record_t padding = { (uint32_t)pad, 0, NULL, 0 };
+        memcpy(ring->data + pos, &padding, sizeof(padding));
+    }
+    head += pad;
+    
+    // Stamped only once there is room, so waiting cannot publish a stale
+    // time. The monotonic clock keeps each ring in order and the flusher's
+    // cutoff meaningful when the wall clock is stepped back.
+    __atomic_store_n(&ring->stamping, 1, __ATOMIC_SEQ_CST);
+    record->timestamp = clock_ns(CLOCK_MONOTONIC);
+    memcpy(ring->data + (head & ring->mask), scratch, sizeof(log_record_t) + args.len);
+    __atomic_store_n(&ring->head, head + record->size, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->stamping, 0, __ATOMIC_RELEASE);
+}
+
+// Flusher side
+
+static void out_flush(log_out_t *out) {
+    if (out->len > 0) {
+        fwrite(out->data, 1, out->len, out->file);
+        out->len = 0;
+    }
+}
+
+static void out_write(log_out_t *out, const void *data, size_t len) {
+    if (out->len + len > LOG_OUT_SIZE) {
+        out_flush(out);
+        if (len > LOG_OUT_SIZE) {
+            fwrite(data, 1, len, out->file);
+            return;
+        }
+    }
+    memcpy(out->data + out->len, data, len);
+    out->len += len;
+}
+
+static void emit_text(log_level_t level, unsigned thread, uint64_t timestamp, const char *fmt,
+                      const void *args, size_t args_len) {
+    log_out_t *out = &logger.out[logger.file || level > LOG_LEVEL_WARN ? 1 : 0];
+    size_t len = log_format_line(logger.line, sizeof(logger.line), timestamp, level, thread,
+                                 fmt, args, args_len);
+    out_write(out, logger.line, len);
+}
+
+static void emit_suppressed(const log_site_t *site, unsigned thread, uint64_t timestamp,
+                            uint32_t suppressed) {
+    char args[sizeof(uint64_t) * 2 + sizeof(uint32_t) + 256];
+    log_args_t captured = { args, 0, sizeof(args) };
+    
+    put_u64(&captured, suppressed);
+    put_str(&captured, site->file, 200);
+    put_u64(&captured, (uint64_t)site->line);
+    emit_text(LOG_LEVEL_WARN, thread, timestamp, "%u messages suppressed by rate limit at %s:%d",
+              args, captured.len);
+}
+
+// Binary entries: 'S' defines a call site the first time one of its records
+// is written, 'R' is a record, 'D' the total of messages dropped so far.
+static void emit_binary_site(log_site_t *site) {
+    log_out_t *out = &logger.out[1];
+    uint8_t level = (uint8_t)site->level;
+    uint32_t line = (uint32_t)site->line;
+    uint16_t file_len = (uint16_t)strnlen(site->file, UINT16_MAX);
+    uint16_t fmt_len = (uint16_t)strnlen(site->fmt, UINT16_MAX);
+    
+    site->id = ++logger.next_site_id;
+    out_write(out, "S", 1);
+    out_write(out, &site->id, sizeof(site->id));
+    out_write(out, &level, sizeof(level));
+    out_write(out, &line, sizeof(line));
+    out_write(out, &file_len, sizeof(file_len));
+    out_write(out, site->file, file_len);
+    out_write(out, &fmt_len, sizeof(fmt_len));
+    out_write(out, site->fmt, fmt_len);
+}
+
+static void emit_binary(log_site_t *site, unsigned thread, uint64_t timestamp,
+                        const log_record_t *record, const void *args, uint32_t args_len) {
+    log_out_t *out = &logger.out[1];
+    
+    if (site->id == 0) {
+        emit_binary_site(site);
+    }
+    out_write(out, "R", 1);
+    out_write(out, &site->id, sizeof(site->id));
+    out_write(out, &thread, sizeof(uint32_t));
+    out_write(out, &timestamp, sizeof(timestamp));
+    out_write(out, &record->suppressed, sizeof(record->suppressed));
+    out_write(out, &args_len, sizeof(args_len));
+    out_write(out, args, args_len);
+}
+
+// Records are written with wall-clock time, in the text and binary formats
+// alike
+static void emit_record(log_ring_t *ring, const log_record_t *record) {
+    log_site_t *site = (log_site_t *)record->site;
+    const char *args = (const char *)(record + 1);
+    uint32_t args_len = record->size - (uint32_t)sizeof(*record);
+    uint64_t timestamp = record->timestamp + logger.wall_offset;
+    
+    if (logger.config.binary) {
+        emit_binary(site, ring->id, timestamp, record, args, args_len);
+    } else {
+        if (record->suppressed) {
+            emit_suppressed(site, ring->id, timestamp, record->suppressed);
+        }
+        emit_text(site->level, ring->id, timestamp, site->fmt, args, args_len);
+    }
+}
+
+// The record at the flusher's position, past any padding, or NULL
+static const log_record_t *ring_next(log_ring_t *ring) {
+    size_t ring_size = ring->mask + 1;
+    
+    while (ring->read < ring->limit) {
+        size_t pos = ring->read & ring->mask;
+        if (ring_size - pos < sizeof(log_record_t)) {
+            ring->read += ring_size - pos;
+            continue;
+        }
+        
+        const log_record_t *record = (const log_record_t *)(ring->data + pos);
+        if (record->site) {
+            return record;
+        }
+        ring->read += record->size;
+    }
+    return NULL;
+}
+
+// Where a ring's published records end. A record stamped before now is
+// published first: its thread set stamping before taking the time, so
+// either that is seen here or the stamp is later than now.
+static uint64_t ring_limit(log_ring_t *ring) {
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&ring->stamping, __ATOMIC_SEQ_CST)) {
+        while (__atomic_load_n(&ring->stamping, __ATOMIC_ACQUIRE) &&
+               __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == head) {
+            sched_yield();
+        }
+    }
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+}
+
+// Each ring is in timestamp order, being one thread's, so the rings are
+// merged: the oldest next record of any ring goes out first. Records
+// stamped after the flush began stay for the next one, so none can be
+// overtaken by a record another thread was still writing. The wall clock
+// is read once per flush to convert the monotonic stamps, so a step of it
+// shows in the times written from the next flush on.
+static void drain_all(void) {
+    pthread_mutex_lock(&logger.lock);
+    update_wall_offset();
+    uint64_t cutoff = clock_ns(CLOCK_MONOTONIC);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    for (log_ring_t *ring = logger.rings; ring; ring = ring->next) {
+        ring->read = ring->tail;
+        ring->limit = ring_limit(ring);
+    }
+    
+    for (;;) {
+        log_ring_t *oldest = NULL;
+        const log_record_t *record = NULL;
+        for (log_ring_t *ring = logger.rings; ring; ring = ring->next) {
+            const log_record_t *next = ring_next(ring);
+            if (next && next->timestamp <= cutoff && (!record || next->timestamp < record->timestamp)) {
+                oldest = ring;
+                record = next;
+            }
+        }
+        if (!oldest) {
+            break;
+        }
+        emit_record(oldest, record);
+        oldest->read += record->size;
+    }
+    
+    log_ring_t **link = &logger.rings;
+    while (*link) {
+        log_ring_t *ring = *link;
+        __atomic_store_n(&ring->tail, ring->read, __ATOMIC_RELEASE);
+        if (__atomic_load_n(&ring->exited, __ATOMIC_ACQUIRE) &&
+            ring->read == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+            *link = ring->next;
+            free(ring->data);
+            free(ring);
+        } else {
+            link = &ring->next;
+        }
+    }
+    pthread_cond_broadcast(&logger.drained);
+    pthread_mutex_unlock(&logger.lock);
+    
+    uint64_t dropped = log_dropped();
+    if (dropped != logger.dropped_reported) {
+        if (logger.config.binary) {
+            out_write(&logger.out[1], "D", 1);
+            out_write(&logger.out[1], &dropped, sizeof(dropped));
+        } else {
+            char args[sizeof(uint64_t)];
+            memcpy(args, &(uint64_t){ dropped - logger.dropped_reported }, sizeof(args));
+            // Stamped no later than the records held back, to stay in order
+            emit_text(LOG_LEVEL_WARN, 0, cutoff + logger.wall_offset,
+                      "%llu log messages dropped, buffer full", args, sizeof(args));
+        }
+        logger.dropped_reported = dropped;
+    }
+    
+    for (int i = 0; i < 2; i++) {
+        if (logger.out[i].file) {
+            out_flush(&logger.out[i]);
+            fflush(logger.out[i].file);
+        }
+    }
+}
+
+static void *flusher_main(void *arg) {
+    (void)arg;
+    
+    for (;;) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_nsec += (long)logger.config.flush_interval * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        
+        pthread_mutex_lock(&logger.lock);
+        int stopping = logger.stopping;
+        if (!stopping && !logger.waiters) {
+            pthread_cond_timedwait(&logger.wake, &logger.lock, &deadline);
+            stopping = logger.stopping;
+        }
+        pthread_mutex_unlock(&logger.lock);
+        
+        drain_all();
+        if (stopping) {
+            return NULL;
+        }
+    }
+}
+
+int log_init(const log_config_t *config) {
+    if (logger.running) {
+        return 0;
+    }
+    
+    logger.config = *config;
+    if (logger.config.flush_interval <= 0) {
+        logger.config.flush_interval = LOG_DEFAULT_FLUSH_INTERVAL;
+    }
+    logger.stopping = 0;
+    logger.dropped = 0;
+    logger.dropped_reported = 0;
+    logger.wall_offset = 0;
+    logger.next_site_id = 0;
+    logger.file = NULL;
+    
+    if (config->path) {
+        logger.file = fopen(config->path, config->binary ? "wb" : "a");
+        if (!logger.file) {
+            fprintf(stderr, "Failed to open log file %s: %s\n", config->path, strerror(errno));
+            return -1;
+        }
+    }
+    logger.out[0].file = logger.file ? NULL : stderr;
+    logger.out[1].file = logger.file ? logger.file : stdout;
+    for (int i = 0; i < 2; i++) {
+        logger.out[i].len = 0;
+        logger.out[i].data = logger.out[i].file ? malloc(LOG_OUT_SIZE) : NULL;
+        if (logger.out[i].file && !logger.out[i].data) {
+            fprintf(stderr, "Failed to allocate log buffer\n");
+            log_shutdown();
+            return -1;
+        }
+    }
+    if (config->binary) {
+        out_write(&logger.out[1], LOG_BINARY_MAGIC, sizeof(LOG_BINARY_MAGIC));
+    }
+    
+    // The flusher's timed wait must not stretch when the wall clock is
+    // stepped back; nothing waits on wake before the flusher starts
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_destroy(&logger.wake);
+    pthread_cond_init(&logger.wake, &attr);
+    pthread_condattr_destroy(&attr);
+    
+    if (pthread_key_create(&logger.ring_key, ring_exit) != 0) {
+        fprintf(stderr, "Failed to create log thread key\n");
+        log_shutdown();
+        return -1;
+    }
+    if (pthread_create(&logger.flusher, NULL, flusher_main, NULL) != 0) {
+        fprintf(stderr, "Failed to start log flusher\n");
+        pthread_key_delete(logger.ring_key);
+        log_shutdown();
+        return -1;
+    }
+    
+    log_set_level(config->level);
+    log_set_rate_limit(config->rate_limit);
+    logger.generation++;
+    __atomic_store_n(&logger.running, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Drain whatever is buffered and fall back to synchronous printing
+void log_shutdown(void) {
+    if (__atomic_load_n(&logger.running, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&logger.running, 0, __ATOMIC_RELEASE);
+        
+        pthread_mutex_lock(&logger.lock);
+        logger.stopping = 1;
+        pthread_cond_signal(&logger.wake);
+        pthread_mutex_unlock(&logger.lock);
+        pthread_join(logger.flusher, NULL);
+        pthread_key_delete(logger.ring_key);
+        
+        while (logger.rings) {
+            log_ring_t *ring = logger.rings;
+            logger.rings = ring->next;
+            free(ring->data);
+            free(ring);
+        }
+    }
+    
+    for (int i = 0; i < 2; i++) {
+        free(logger.out[i].data);
+        logger.out[i].data = NULL;
+        logger.out[i].file = NULL;
+    }
+    if (logger.file) {
+        fclose(logger.file);
+        logger.file = NULL;
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Asynchronous logging for the request paths of the servers.
+//
+// A log call checks the level, captures its printf arguments (numbers as
+// raw values, strings as bytes) into a ring buffer owned by the calling
+// thread, and returns. It takes no lock and formats nothing. A background
+// flusher drains every thread's ring, formats the messages and writes them
+// in batches. In binary mode it writes the captured records unformatted,
+// with each call site's format string once, for log_decode to format
+// offline.
+//
+// The flusher merges the rings, so the output is in timestamp order. A
+// thread whose ring is full wakes the flusher and waits for it, unless
+// drop_when_full is set; then the message is dropped, and drops are
+// counted and reported. Each call site is limited to rate_limit messages
+// per second; the number suppressed is reported with the site's next
+// message.
+//
+// Before log_init() and after log_shutdown(), messages are printed
+// synchronously. log_shutdown() must run after every logging thread has
+// stopped.
+
+typedef enum {
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG
+} log_level_t;
+
+typedef struct {
+    log_level_t level;
+    const char *path;       // NULL: warnings and errors to stderr, the rest to stdout
+    int binary;             // write records for log_decode instead of text
+    size_t ring_size;       // bytes per thread, rounded up to a power of two
+    unsigned rate_limit;    // messages per second per call site, 0 for no limit
+    int drop_when_full;     // drop messages when a ring is full instead of waiting
+    int flush_interval;     // milliseconds between flushes
+} log_config_t;
+
+#define LOG_DEFAULT_RING_SIZE (256 * 1024)
+#define LOG_DEFAULT_RATE_LIMIT 1000
+#define LOG_DEFAULT_FLUSH_INTERVAL 10
+
+#define LOG_SITE_ARGS 16
+
+// One per log statement, created by the logging macros
+typedef struct {
+    const char *fmt;
+    const char *file;
+    int line;
+    log_level_t level;
+    uint32_t id;            // binary mode dictionary id, owned by the flusher
+    uint32_t window;        // rate limiting: current second, messages in it,
+    uint32_t count;         // and messages suppressed since the last one
+    uint32_t suppressed;
+    int prepared;           // kinds filled in by the first message
+    uint8_t kinds[LOG_SITE_ARGS];
+} log_site_t;
+
+extern int log_threshold;
+
+#define log_enabled(level) ((int)(level) <= __atomic_load_n(&log_threshold, __ATOMIC_RELAXED))
+
+// The dead printf() only lets the compiler check the format
+#define log_at(lvl, format, ...) do { \
+    if (log_enabled(lvl)) { \
+        static log_site_t log_site_ = { .fmt = format, .file = __FILE__, .line = __LINE__, .level = lvl }; \
+        log_write(&log_site_, ##__VA_ARGS__); \
+    } \
+    if (0) { \
+        printf(format, ##__VA_ARGS__); \
+    } \
+} while (0)
+
+#define log_error(...) log_at(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define log_warn(...)  log_at(LOG_LEVEL_WARN, __VA_ARGS__)
+#define log_info(...)  log_at(LOG_LEVEL_INFO, __VA_ARGS__)
+#define log_debug(...) log_at(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+// Function declarations
+void log_default_config(log_config_t *config);
+int log_init(const log_config_t *config);
+void log_shutdown(void);
+void log_set_level(log_level_t level);
+void log_set_rate_limit(unsigned per_second);
+int log_parse_level(const char *name, log_level_t *level);
+const char *log_level_name(log_level_t level);
+uint64_t log_dropped(void);
+
+void log_write(log_site_t *site, ...);
+
+// Shared with log_decode
+#define LOG_BINARY_MAGIC "O1LOGB1"
+#define LOG_MAX_LINE 8192
+
+size_t log_format_line(char *out, size_t size, uint64_t timestamp, log_level_t level,
+                       unsigned thread, const char *fmt, const void *args, size_t args_len);
+
+#endif // LOG_H
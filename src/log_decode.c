@@ -0,0 +1,144 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+
+// Formats a binary log written with log_config_t.binary (the servers' -B
+// option) as the text lines the servers would have written.
+
+typedef struct {
+    char *fmt;
+    log_level_t level;
+} site_t;
+
+static site_t *sites;
+static size_t site_count;
+
+static int read_exact(FILE *in, void *data, size_t len) {
+    return fread(data, 1, len, in) == len ? 0 : -1;
+}
+
+static char *read_string(FILE *in) {
+    uint16_t len;
+    if (read_exact(in, &len, sizeof(len)) != 0) {
+        return NULL;
+    }
+    char *s = malloc((size_t)len + 1);
+    if (!s || read_exact(in, s, len) != 0) {
+        free(s);
+        return NULL;
+    }
+    s[len] = '\0';
+    return s;
+}
+
+static int read_site(FILE *in) {
+    uint32_t id, line;
+    uint8_t level;
+    
+    if (read_exact(in, &id, sizeof(id)) != 0 || read_exact(in, &level, sizeof(level)) != 0 ||
+        read_exact(in, &line, sizeof(line)) != 0) {
+        return -1;
+    }
+    char *file = read_string(in);
+    char *fmt = file ? read_string(in) : NULL;
+    free(file);
+    if (!fmt || id == 0) {
+        free(fmt);
+        return -1;
+    }
+    
+    if (id > site_count) {
+        site_t *grown = realloc(sites, id * sizeof(*sites));
+        if (!grown) {
+            free(fmt);
+            return -1;
+        }
+        memset(grown + site_count, 0, (id - site_count) * sizeof(*sites));
+        sites = grown;
+        site_count = id;
+    }
+    free(sites[id - 1].fmt);
+    sites[id - 1].fmt = fmt;
+    sites[id - 1].level = (log_level_t)level;
+    return 0;
+}
+
+static int read_record(FILE *in, char *line) {
+    static char args[LOG_MAX_LINE];
+    uint32_t id, thread, suppressed, args_len;
+    uint64_t timestamp;
+    
+    if (read_exact(in, &id, sizeof(id)) != 0 || read_exact(in, &thread, sizeof(thread)) != 0 ||
+        read_exact(in, &timestamp, sizeof(timestamp)) != 0 ||
+        read_exact(in, &suppressed, sizeof(suppressed)) != 0 ||
+        read_exact(in, &args_len, sizeof(args_len)) != 0 || args_len > sizeof(args) ||
+        read_exact(in, args, args_len) != 0) {
+        return -1;
+    }
+    if (id == 0 || id > site_count || !sites[id - 1].fmt) {
+        fprintf(stderr, "Record for undefined call site %u\n", id);
+        return -1;
+    }
+    
+    if (suppressed) {
+        printf("%u messages suppressed by rate limit before:\n", suppressed);
+    }
+    log_format_line(line, LOG_MAX_LINE, timestamp, sites[id - 1].level, thread,
+                    sites[id - 1].fmt, args, args_len);
+    fputs(line, stdout);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    static char line[LOG_MAX_LINE];
+    char magic[sizeof(LOG_BINARY_MAGIC)];
+    int status = 0;
+    
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s binary_log\n", argv[0]);
+        return 1;
+    }
+    
+    FILE *in = strcmp(argv[1], "-") == 0 ? stdin : fopen(argv[1], "rb");
+    if (!in) {
+        perror(argv[1]);
+        return 1;
+    }
+    if (read_exact(in, magic, sizeof(magic)) != 0 || memcmp(magic, LOG_BINARY_MAGIC, sizeof(magic)) != 0) {
+        fprintf(stderr, "%s is not a binary log\n", argv[1]);
+        return 1;
+    }
+    
+    int type;
+    while ((type = fgetc(in)) != EOF) {
+        if (type == 'S') {
+            status = read_site(in);
+        } else if (type == 'R') {
+            status = read_record(in, line);
+        } else if (type == 'D') {
+            uint64_t dropped;
+            status = read_exact(in, &dropped, sizeof(dropped));
+            if (status == 0) {
+                printf("%llu log messages dropped so far, buffer full\n", (unsigned long long)dropped);
+            }
+        } else {
+            status = -1;
+        }
+        if (status != 0) {
+            fprintf(stderr, "Corrupt or truncated log at offset %ld\n", ftell(in));
+            break;
+        }
+    }
+    
+    if (in != stdin) {
+        fclose(in);
+    }
+    for (size_t i = 0; i < site_count; i++) {
+        free(sites[i].fmt);
+    }
+    free(sites);
+    return status == 0 ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "o1_buf.h"
+
+#define O1_BUF_MIN_CAP 256
+
+void o1_buf_init(o1_buf_t *buf) {
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+}
+
+void o1_buf_free(o1_buf_t *buf) {
+    free(buf->data);
+    o1_buf_init(buf);
+}
+
+// Keep the allocation for reuse
+void o1_buf_reset(o1_buf_t *buf) {
+    buf->len = 0;
+    if (buf->data) {
+        buf->data[0] = '\0';
+    }
+}
+
+// Make room for extra bytes plus the terminator, growing geometrically
+int o1_buf_reserve(o1_buf_t *buf, size_t extra) {
+    size_t need = buf->len + extra + 1;
+    if (need <= buf->cap) {
+        return 0;
+    }
+    
+    size_t cap = buf->cap ? buf->cap : O1_BUF_MIN_CAP;
+    while (cap < need) {
+        cap *= 2;
+    }
+    
+    char *data = realloc(buf->data, cap);
+    if (!data) {
+        return -1;
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return 0;
+}
+
+int o1_buf_append(o1_buf_t *buf, const char *data, size_t len) {
+    if (o1_buf_reserve(buf, len) != 0) {
+        return -1;
+    }
+    
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    buf->data[buf->len] = '\0';
+    return 0;
+}
+
+int o1_buf_puts(o1_buf_t *buf, const char *str) {
+    return o1_buf_append(buf, str, strlen(str));
+}
+
+int o1_buf_vprintf(o1_buf_t *buf, const char *fmt, va_list ap) {
+    va_list copy;
+    va_copy(copy, ap);
+    int n = vsnprintf(buf->data ? buf->data + buf->len : NULL,
+                      buf->data ? buf->cap - buf->len : 0, fmt, copy);
+    va_end(copy);
+    if (n < 0) {
+        return -1;
+    }
+    
+    // Formatted output did not fit: grow and format again
+    if (!buf->data || (size_t)n >= buf->cap - buf->len) {
+        if (o1_buf_reserve(buf, n) != 0) {
+            return -1;
+        }
+        vsnprintf(buf->data + buf->len, buf->cap - buf->len, fmt, ap);
+    }
+    
+    buf->len += n;
+    return 0;
+}
+
+int o1_buf_printf(o1_buf_t *buf, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int ret = o1_buf_vprintf(buf, fmt, ap);
+    va_end(ap);
+    return ret;
+}
@@ -0,0 +1,24 @@
+#ifndef O1_BUF_H
+#define O1_BUF_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+// Growable, always NUL-terminated byte buffer for building XML documents
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} o1_buf_t;
+
+// Function declarations
+void o1_buf_init(o1_buf_t *buf);
+void o1_buf_free(o1_buf_t *buf);
+void o1_buf_reset(o1_buf_t *buf);
+int o1_buf_reserve(o1_buf_t *buf, size_t extra);
+int o1_buf_append(o1_buf_t *buf, const char *data, size_t len);
+int o1_buf_puts(o1_buf_t *buf, const char *str);
+int o1_buf_printf(o1_buf_t *buf, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+int o1_buf_vprintf(o1_buf_t *buf, const char *fmt, va_list ap);
+
+#endif // O1_BUF_H
@@ -0,0 +1,349 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "o1_candidate.h"
+#include "hex.h"
+
+#define INITIAL_CHANGES 64
+
+struct o1_candidate {
+    o1_datastore_t *running;
+    pthread_rwlock_t lock;
+    o1_ds_change_t *changes;    // in the order interfaces were first edited
+    size_t count;
+    size_t allocated;
+    size_t max_changes;
+    uint32_t *index;            // change + 1 by name hash; 0 marks an empty bucket
+    size_t index_mask;          // at most half the buckets are used
+};
+
+// Returns the change for name, or -1
+static int64_t find_change(const o1_candidate_t *candidate, const char *name, size_t len) {
+    if (!candidate->index) {
+        return -1;
+    }
+    
+    for (size_t i = o1_ds_hash_name(name, len) & candidate->index_mask;;
+         i = (i + 1) & candidate->index_mask) {
+        uint32_t entry = candidate->index[i];
+        if (entry == 0) {
+            return -1;
+        }
+        
+        const o1_ds_change_t *change = &candidate->changes[entry - 1];
+        if (change->name_len == len && memcmp(change->name, name, len) == 0) {
+            return entry - 1;
+        }
+    }
+}
+
+static void index_change(uint32_t *index, size_t mask, const o1_ds_change_t *change, size_t n) {
+    size_t i = o1_ds_hash_name(change->name, change->name_len) & mask;
+    while (index[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    index[i] = (uint32_t)n + 1;
+}
+
+// Room for n more changes, growing the array and rebuilding the index as
+// needed
+static int reserve_changes(o1_candidate_t *candidate, size_t n) {
+    if (candidate->count + n > candidate->allocated) {
+        size_t allocated = candidate->allocated ? candidate->allocated * 2 : INITIAL_CHANGES;
+        while (allocated < candidate->count + n) {
+            allocated *= 2;
+        }
+        o1_ds_change_t *changes = realloc(candidate->changes, allocated * sizeof(*changes));
+        if (!changes) {
+            return -1;
+        }
+        candidate->changes = changes;
+        candidate->allocated = allocated;
+    }
+    
+    if (!candidate->index || (candidate->count + n) * 2 > candidate->index_mask + 1) {
+        size_t buckets = candidate->index ? (candidate->index_mask + 1) * 2 : INITIAL_CHANGES * 2;
+        while (buckets < (candidate->count + n) * 2) {
+            buckets *= 2;
+        }
+        uint32_t *index = calloc(buckets, sizeof(*index));
+        if (!index) {
+            return -1;
+        }
+        for (size_t n = 0; n < candidate->count; n++) {
+            index_change(index, buckets - 1, &candidate->changes[n], n);
+        }
+        free(candidate->index);
+        candidate->index = index;
+        candidate->index_mask = buckets - 1;
+    }
+    return 0;
+}
+
+// Back to running as it is; a large edit does not keep its memory
+static void clear_changes(o1_candidate_t *candidate) {
+    free(candidate->changes);
+    free(candidate->index);
+    candidate->changes = NULL;
+    candidate->index = NULL;
+    candidate->count = 0;
+    candidate->allocated = 0;
+    candidate->index_mask = 0;
+}
+
+// At most max_changes interfaces can be edited between commits
+o1_candidate_t *o1_candidate_create(o1_datastore_t *running, size_t max_changes) {
+    if (!running || max_changes == 0 || max_changes > UINT32_MAX / 2) {
+        errno = EINVAL;
+        return NULL;
+    }
+    
+    o1_candidate_t *candidate = calloc(1, sizeof(*candidate));
+    if (!candidate) {
+        return NULL;
+    }
+    
+    candidate->running = running;
+    candidate->max_changes = max_changes;
+    pthread_rwlock_init(&candidate->lock, NULL);
+    return candidate;
+}
+
+void o1_candidate_destroy(o1_candidate_t *candidate) {
+    if (!candidate) {
+        return;
+    }
+    
+    clear_changes(candidate);
+    pthread_rwlock_destroy(&candidate->lock);
+    free(candidate);
+}
+
+// Merge the leaves present in update into the candidate's copy of the
+// interface, creating it if needed. Returns 0, or -1 with errno EINVAL
+// (bad name or leaf) or ENOSPC (max_changes interfaces already edited).
+int o1_candidate_merge(o1_candidate_t *candidate, const char *name, size_t name_len,
+                       const o1_interface_update_t *update) {
+    if (!candidate || !name || name_len == 0 || name_len > O1_DS_NAME_MAX || !update) {
+        errno = EINVAL;
+        return -1;
+    }
+    
+    // Decode before taking the lock, as for running
+    o1_ds_change_t change;
+    memset(&change, 0, sizeof(change));
+    if ((update->fields & O1_DS_TRACEID) &&
+        hex_decode(change.traceid, update->traceid, sizeof(change.traceid)) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((update->fields & O1_DS_SPANID) &&
+        hex_decode(change.spanid, update->spanid, sizeof(change.spanid)) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy(change.name, name, name_len);
+    change.name_len = (uint8_t)name_len;
+    change.fields = (uint8_t)update->fields;
+    change.status = (uint8_t)update->status;
+    change.timestamp = update->timestamp;
+    return o1_candidate_apply(candidate, &change, 1);
+}
+
+// Merge every change into the candidate, or none: room for the interfaces
+// they add is made before any is applied. Returns 0, or -1 with errno
+// EINVAL (bad name), ENOSPC (over max_changes) or ENOMEM, with the
+// candidate unchanged.
+int o1_candidate_apply(o1_candidate_t *candidate, const o1_ds_change_t *changes, size_t count) {
+    if (!candidate || (!changes && count > 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (changes[i].name_len == 0 || changes[i].name_len > O1_DS_NAME_MAX) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    
+    pthread_rwlock_wrlock(&candidate->lock);
+    
+    size_t added = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (find_change(candidate, changes[i].name, changes[i].name_len) < 0) {
+            added++;
+        }
+    }
+    int err = candidate->count + added > candidate->max_changes ? ENOSPC :
+              added > 0 && reserve_changes(candidate, added) != 0 ? ENOMEM : 0;
+    if (err) {
+        pthread_rwlock_unlock(&candidate->lock);
+        errno = err;
+        return -1;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        const o1_ds_change_t *update = &changes[i];
+        int64_t n = find_change(candidate, update->name, update->name_len);
+        if (n < 0) {
+            n = (int64_t)candidate->count++;
+            o1_ds_change_t *change = &candidate->changes[n];
+            memset(change, 0, sizeof(*change));
+            memcpy(change->name, update->name, update->name_len);
+            change->name_len = update->name_len;
+            index_change(candidate->index, candidate->index_mask, change, (size_t)n);
+        }
+        
+        o1_ds_change_t *change = &candidate->changes[n];
+        if (update->fields & O1_DS_STATUS) {
+            change->status = update->status;
+        }
+        if (update->fields & O1_DS_TRACEID) {
+            memcpy(change->traceid, update->traceid, sizeof(change->traceid));
+        }
+        if (update->fields & O1_DS_SPANID) {
+            memcpy(change->spanid, update->spanid, sizeof(change->spanid));
+        }
+        if (update->fields & O1_DS_TIMESTAMP) {
+            change->timestamp = update->timestamp;
+        }
+        change->fields |= update->fields & (O1_DS_STATUS | O1_DS_TRACEID | O1_DS_SPANID |
+                                            O1_DS_TIMESTAMP);
+    }
+    
+    pthread_rwlock_unlock(&candidate->lock);
+    return 0;
+}
+
+// Make running what the candidate shows and empty the candidate. Returns
+// the number of interfaces committed, or -1 with errno set by
+// o1_datastore_commit; running and the candidate are then both unchanged.
+int o1_candidate_commit(o1_candidate_t *candidate) {
+    pthread_rwlock_wrlock(&candidate->lock);
+    
+    int ret = (int)candidate->count;
+    if (o1_datastore_commit(candidate->running, candidate->changes, candidate->count) != 0) {
+        ret = -1;
+    }
+    int err = errno;
+    if (ret >= 0) {
+        clear_changes(candidate);
+    }
+    
+    pthread_rwlock_unlock(&candidate->lock);
+    errno = err;
+    return ret;
+}
+
+// Drop every edit since the last commit
+void o1_candidate_discard(o1_candidate_t *candidate) {
+    pthread_rwlock_wrlock(&candidate->lock);
+    clear_changes(candidate);
+    pthread_rwlock_unlock(&candidate->lock);
+}
+
+// Interfaces edited since the last commit or discard
+size_t o1_candidate_changes(o1_candidate_t *candidate) {
+    pthread_rwlock_rdlock(&candidate->lock);
+    size_t count = candidate->count;
+    pthread_rwlock_unlock(&candidate->lock);
+    return count;
+}
+
+// Hold the candidate still and pin running for a sequence of reads
+void o1_candidate_view_begin(o1_candidate_t *candidate, o1_ds_view_t *view) {
+    pthread_rwlock_rdlock(&candidate->lock);
+    o1_datastore_view_begin(candidate->running, view);
+}
+
+void o1_candidate_view_end(o1_candidate_t *candidate, o1_ds_view_t *view) {
+    o1_datastore_view_end(view);
+    pthread_rwlock_unlock(&candidate->lock);
+}
+
+// An interface the candidate creates, before its leaves are applied
+static void new_record(const o1_ds_change_t *change, o1_interface_record_t *record) {
+    memset(record, 0, sizeof(*record));
+    memcpy(record->name, change->name, change->name_len);
+    record->name_len = change->name_len;
+    record->status = O1_IF_UP;          // YANG default
+}
+
+static void apply_change(const o1_ds_change_t *change, o1_interface_record_t *record) {
+    if (change->fields & O1_DS_STATUS) {
+        record->status = (o1_if_status_t)change->status;
+    }
+    if (change->fields & O1_DS_TRACEID) {
+        hex_encode(record->traceid, change->traceid, sizeof(change->traceid));
+        record->traceid[32] = '\0';
+    }
+    if (change->fields & O1_DS_SPANID) {
+        hex_encode(record->spanid, change->spanid, sizeof(change->spanid));
+        record->spanid[16] = '\0';
+    }
+    if (change->fields & O1_DS_TIMESTAMP) {
+        record->timestamp = change->timestamp;
+    }
+}
+
+// Upper bound for o1_candidate_read indexes: running's interfaces, then one
+// per change
+size_t o1_candidate_count(const o1_candidate_t *candidate, const o1_ds_view_t *view) {
+    return o1_datastore_view_count(view) + candidate->count;
+}
+
+// Look up an interface by name as the candidate shows it. Returns 0 and
+// fills record, -1 if absent.
+int o1_candidate_get(const o1_candidate_t *candidate, const o1_ds_view_t *view,
+                     const char *name, size_t name_len, o1_interface_record_t *record) {
+    if (!name || !record || name_len > O1_DS_NAME_MAX) {
+        return -1;
+    }
+    
+    int64_t n = find_change(candidate, name, name_len);
+    if (o1_datastore_view_get(view, name, name_len, record) != 0) {
+        if (n < 0) {
+            return -1;
+        }
+        new_record(&candidate->changes[n], record);
+    }
+    if (n >= 0) {
+        apply_change(&candidate->changes[n], record);
+    }
+    return 0;
+}
+
+// Read by index: below running's count, the interface in that slot with
+// the candidate's edits applied; after it, the changes in order, of which
+// only those creating an interface are read. Returns -1 for the others,
+// which were already read at their slot.
+int o1_candidate_read(const o1_candidate_t *candidate, const o1_ds_view_t *view, size_t index,
+                      o1_interface_record_t *record) {
+    size_t running = o1_datastore_view_count(view);
+    if (index < running) {
+        if (o1_datastore_view_read(view, index, record) != 0) {
+            return -1;
+        }
+        int64_t n = candidate->count ? find_change(candidate, record->name, record->name_len) : -1;
+        if (n >= 0) {
+            apply_change(&candidate->changes[n], record);
+        }
+        return 0;
+    }
+    
+    index -= running;
+    if (index >= candidate->count) {
+        return -1;
+    }
+    const o1_ds_change_t *change = &candidate->changes[index];
+    if (o1_datastore_view_get(view, change->name, change->name_len, record) == 0) {
+        return -1;
+    }
+    new_record(change, record);
+    apply_change(change, record);
+    return 0;
+}
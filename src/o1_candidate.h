@@ -0,0 +1,43 @@
+#ifndef O1_CANDIDATE_H
+#define O1_CANDIDATE_H
+
+#include <stddef.h>
+
+#include "o1_datastore.h"
+
+// The candidate configuration datastore (RFC 6241, section 8.3), shared by
+// all sessions.
+//
+// The candidate is an overlay on running: it holds only the interfaces
+// edited since the last commit or discard, each as the leaves that were
+// set, so starting to edit it copies nothing. Reads take an interface from
+// the overlay when it is there and from running otherwise. Commit hands the
+// whole overlay to o1_datastore_commit, which publishes it in running as
+// one version, and empties it; discard-changes just empties it.
+//
+// Edits, commit and discard take the candidate's lock exclusively; reads
+// hold it shared between o1_candidate_view_begin and _end. None of them
+// holds up readers of running.
+
+typedef struct o1_candidate o1_candidate_t;
+
+// Function declarations
+o1_candidate_t *o1_candidate_create(o1_datastore_t *running, size_t max_changes);
+void o1_candidate_destroy(o1_candidate_t *candidate);
+
+int o1_candidate_merge(o1_candidate_t *candidate, const char *name, size_t name_len,
+                       const o1_interface_update_t *update);
+int o1_candidate_apply(o1_candidate_t *candidate, const o1_ds_change_t *changes, size_t count);
+int o1_candidate_commit(o1_candidate_t *candidate);
+void o1_candidate_discard(o1_candidate_t *candidate);
+size_t o1_candidate_changes(o1_candidate_t *candidate);
+
+void o1_candidate_view_begin(o1_candidate_t *candidate, o1_ds_view_t *view);
+void o1_candidate_view_end(o1_candidate_t *candidate, o1_ds_view_t *view);
+size_t o1_candidate_count(const o1_candidate_t *candidate, const o1_ds_view_t *view);
+int o1_candidate_get(const o1_candidate_t *candidate, const o1_ds_view_t *view,
+                     const char *name, size_t name_len, o1_interface_record_t *record);
+int o1_candidate_read(const o1_candidate_t *candidate, const o1_ds_view_t *view, size_t index,
+                      o1_interface_record_t *record);
+
+#endif // O1_CANDIDATE_H
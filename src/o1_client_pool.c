@@ -0,0 +1,436 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <libnetconf2/messages.h>
+
+#include "o1_client_pool.h"
+
+#define KEY_MAX_SIZE 65536
+
+// Sent to idle sessions; an empty subtree filter selects nothing, so the
+// reply is an empty <data/> whatever the server holds
+static const char keepalive_rpc[] =
+    "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"keepalive\">"
+    "<get-config><source><running/></source><filter type=\"subtree\"/></get-config></rpc>";
+
+typedef struct o1_client_target_entry o1_client_target_entry_t;
+
+// A pooled session; stored as the session's data while acquired
+typedef struct o1_client_conn {
+    struct nc_session *session;
+    o1_client_target_entry_t *target;
+    uint64_t idle_since;        // ms, when last released
+    uint64_t last_traffic;      // ms, when last released or pinged
+    struct o1_client_conn *next;
+} o1_client_conn_t;
+
+struct o1_client_target_entry {
+    char host[256];
+    int port;
+    char username[64];
+    char password[64];
+    char key_path[256];         // what connects read: the in-memory copy if there is one
+    int key_fd;                 // in-memory copy of the private key, -1 for none
+    o1_client_conn_t *idle;     // most recently released first
+    int idle_count;
+    int busy;
+    o1_client_target_entry_t *next;
+};
+
+struct o1_client_pool {
+    o1_client_pool_config_t config;
+    pthread_mutex_t lock;
+    pthread_cond_t stop;
+    o1_client_target_entry_t *targets;
+    o1_client_pool_stats_t stats;
+    pthread_t keepalive;
+    int keepalive_started;
+    int running;
+};
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void o1_client_pool_default_config(o1_client_pool_config_t *config) {
+    config->max_idle = O1_CLIENT_POOL_DEFAULT_MAX_IDLE;
+    config->idle_timeout = O1_CLIENT_POOL_DEFAULT_IDLE_TIMEOUT;
+    config->keepalive_interval = O1_CLIENT_POOL_DEFAULT_KEEPALIVE;
+    config->keepalive_timeout = O1_CLIENT_POOL_DEFAULT_KEEPALIVE_TIMEOUT;
+}
+
+// Read the private key once and keep it in an anonymous in-memory file;
+// connects then name that file, so the disk is not touched again. On any
+// failure the path is used as given.
+static void load_key(o1_client_target_entry_t *target, const char *path) {
+    snprintf(target->key_path, sizeof(target->key_path), "%s", path);
+    target->key_fd = -1;
+    
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to read private key %s: %s\n", path, strerror(errno));
+        return;
+    }
+    
+    char *key = malloc(KEY_MAX_SIZE);
+    ssize_t len = key ? read(fd, key, KEY_MAX_SIZE) : -1;
+    close(fd);
+    
+    // Only a PEM or OpenSSH private key is worth keeping
+    if (len <= 0 || len == KEY_MAX_SIZE || !memmem(key, (size_t)len, "PRIVATE KEY", 11)) {
+        fprintf(stderr, "%s is not a private key\n", path);
+        free(key);
+        return;
+    }
+    
+    int mem = memfd_create("o1-client-key", MFD_CLOEXEC);
+    if (mem >= 0 && write(mem, key, (size_t)len) == len) {
+        target->key_fd = mem;
+        snprintf(target->key_path, sizeof(target->key_path), "/proc/self/fd/%d", mem);
+    } else if (mem >= 0) {
+        close(mem);
+    }
+    
+    // The copy in the heap is not needed any more
+    memset(key, 0, (size_t)len);
+    free(key);
+}
+
+// Find or create the entry for target. Called with the lock held.
+static o1_client_target_entry_t *find_target(o1_client_pool_t *pool, const o1_client_target_t *target) {
+    const char *username = target->username ? target->username : "";
+    
+    for (o1_client_target_entry_t *entry = pool->targets; entry; entry = entry->next) {
+        if (entry->port == target->port && strcmp(entry->host, target->host) == 0 &&
+            strcmp(entry->username, username) == 0) {
+            return entry;
+        }
+    }
+    
+    o1_client_target_entry_t *entry = calloc(1, sizeof(*entry));
+    if (!entry) {
+        return NULL;
+    }
+    snprintf(entry->host, sizeof(entry->host), "%s", target->host);
+    entry->port = target->port;
+    snprintf(entry->username, sizeof(entry->username), "%s", username);
+    snprintf(entry->password, sizeof(entry->password), "%s", target->password ? target->password : "");
+    entry->key_fd = -1;
+    if (target->private_key_path) {
+        load_key(entry, target->private_key_path);
+    }
+    
+    entry->next = pool->targets;
+    pool->targets = entry;
+    return entry;
+}
+
+// Closing may send <close-session>, so it is done without the lock
+static void close_conn(o1_client_conn_t *conn) {
+    nc_session_set_data(conn->session, NULL);
+    nc_session_free(conn->session, NULL);
+    free(conn);
+}
+
+// Send the keep-alive and wait for its reply. Any reply, even an
+// <rpc-error>, shows the session is still alive.
+static int ping(o1_client_pool_t *pool, struct nc_session *session) {
+    if (nc_send_rpc(session, keepalive_rpc, 1000, NULL) != NC_MSG_RPC) {
+        return -1;
+    }
+    
+    struct nc_msg *msg = NULL;
+    int ret = nc_recv_reply(session, NULL, pool->config.keepalive_timeout, &msg);
+    nc_msg_free(msg);
+    return ret == NC_MSG_REPLY ? 0 : -1;
+}
+
+// Take the idle sessions that are due for a keep-alive or have expired off
+// their lists. Called with the lock held; returns them chained by next.
+static o1_client_conn_t *collect_due(o1_client_pool_t *pool, o1_client_conn_t **expired) {
+    uint64_t now = now_ms();
+    o1_client_conn_t *due = NULL;
+    
+    for (o1_client_target_entry_t *target = pool->targets; target; target = target->next) {
+        o1_client_conn_t **link = &target->idle;
+        while (*link) {
+            o1_client_conn_t *conn = *link;
+            int expire = pool->config.idle_timeout > 0 &&
+                         now - conn->idle_since >= (uint64_t)pool->config.idle_timeout;
+            int ping_due = pool->config.keepalive_interval > 0 &&
+                           now - conn->last_traffic >= (uint64_t)pool->config.keepalive_interval;
+            if (!expire && !ping_due) {
+                link = &conn->next;
+                continue;
+            }
+            
+            *link = conn->next;
+            target->idle_count--;
+            if (expire) {
+                conn->next = *expired;
+                *expired = conn;
+            } else {
+                conn->next = due;
+                due = conn;
+            }
+        }
+    }
+    return due;
+}
+
+// Put a pinged session back at the end of its idle list, where it keeps
+// its age. Called with the lock held.
+static void return_idle(o1_client_conn_t *conn) {
+    o1_client_target_entry_t *target = conn->target;
+    o1_client_conn_t **link = &target->idle;
+    while (*link && (*link)->idle_since >= conn->idle_since) {
+        link = &(*link)->next;
+    }
+    conn->next = *link;
+    *link = conn;
+    target->idle_count++;
+}
+
+static void *keepalive_main(void *arg) {
+    o1_client_pool_t *pool = arg;
+    int interval = pool->config.keepalive_interval;
+    if (interval <= 0 || (pool->config.idle_timeout > 0 && pool->config.idle_timeout < interval)) {
+        interval = pool->config.idle_timeout;
+    }
+    
+    // Check at a quarter of the shortest period, so a due session waits at
+    // most that long
+    long wait_ms = interval / 4 > 10 ? interval / 4 : 10;
+    
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += wait_ms / 1000;
+        deadline.tv_nsec += (wait_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&pool->stop, &pool->lock, &deadline);
+        if (!pool->running) {
+            break;
+        }
+        
+        o1_client_conn_t *expired = NULL;
+        o1_client_conn_t *due = collect_due(pool, &expired);
+        pthread_mutex_unlock(&pool->lock);
+        
+        // Close and ping without the lock: acquires go on meanwhile
+        o1_client_conn_t *alive = NULL;
+        int closed = 0;
+        while (expired) {
+            o1_client_conn_t *next = expired->next;
+            close_conn(expired);
+            closed++;
+            expired = next;
+        }
+        while (due) {
+            o1_client_conn_t *next = due->next;
+            if (ping(pool, due->session) == 0) {
+                due->last_traffic = now_ms();
+                due->next = alive;
+                alive = due;
+            } else {
+                close_conn(due);
+                closed++;
+            }
+            due = next;
+        }
+        
+        pthread_mutex_lock(&pool->lock);
+        pool->stats.closed += closed;
+        while (alive) {
+            o1_client_conn_t *next = alive->next;
+            pool->stats.keepalives++;
+            return_idle(alive);
+            alive = next;
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    
+    return NULL;
+}
+
+o1_client_pool_t *o1_client_pool_create(const o1_client_pool_config_t *config) {
+    if (!config || config->max_idle < 0 || config->idle_timeout < 0 ||
+        config->keepalive_interval < 0 || config->keepalive_timeout < 0) {
+        return NULL;
+    }
+    
+    o1_client_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool) {
+        return NULL;
+    }
+    
+    pool->config = *config;
+    pool->running = 1;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->stop, NULL);
+    
+    if (config->keepalive_interval > 0 || config->idle_timeout > 0) {
+        if (pthread_create(&pool->keepalive, NULL, keepalive_main, pool) != 0) {
+            fprintf(stderr, "Failed to start keep-alive thread\n");
+            o1_client_pool_destroy(pool);
+            return NULL;
+        }
+        pool->keepalive_started = 1;
+    }
+    
+    return pool;
+}
+
+// Closes every idle session. Sessions still acquired must have been
+// released first.
+void o1_client_pool_destroy(o1_client_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->running = 0;
+    pthread_cond_broadcast(&pool->stop);
+    pthread_mutex_unlock(&pool->lock);
+    if (pool->keepalive_started) {
+        pthread_join(pool->keepalive, NULL);
+    }
+    
+    while (pool->targets) {
+        o1_client_target_entry_t *target = pool->targets;
+        while (target->idle) {
+            o1_client_conn_t *next = target->idle->next;
+            close_conn(target->idle);
+            target->idle = next;
+        }
+        if (target->key_fd >= 0) {
+            close(target->key_fd);
+        }
+        pool->targets = target->next;
+        memset(target->password, 0, sizeof(target->password));
+        free(target);
+    }
+    
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->stop);
+    free(pool);
+}
+
+// A session to target: an idle one if there is one, else a new connection.
+// Returns NULL if the connection fails.
+struct nc_session *o1_client_pool_acquire(o1_client_pool_t *pool, const o1_client_target_t *target) {
+    if (!pool || !target || !target->host) {
+        return NULL;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    o1_client_target_entry_t *entry = find_target(pool, target);
+    if (!entry) {
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+    
+    while (entry->idle) {
+        o1_client_conn_t *conn = entry->idle;
+        entry->idle = conn->next;
+        entry->idle_count--;
+        
+        // The server may have closed it since; drop it and try the next
+        if (nc_session_get_status(conn->session) != NC_STATUS_RUNNING) {
+            pool->stats.closed++;
+            pthread_mutex_unlock(&pool->lock);
+            close_conn(conn);
+            pthread_mutex_lock(&pool->lock);
+            continue;
+        }
+        
+        entry->busy++;
+        pool->stats.hits++;
+        pthread_mutex_unlock(&pool->lock);
+        return conn->session;
+    }
+    
+    entry->busy++;
+    pool->stats.connects++;
+    pthread_mutex_unlock(&pool->lock);
+    
+    // Handshake outside the lock; the entry's fields do not change
+    o1_client_conn_t *conn = calloc(1, sizeof(*conn));
+    struct nc_session *session = NULL;
+    int ret = conn ? nc_connect_ssh(entry->host, entry->port, entry->username, entry->key_path,
+                                    entry->password, &session) : -1;
+    if (ret != NC_MSG_HELLO) {
+        if (conn) {
+            fprintf(stderr, "Failed to connect to %s:%d: %s\n", entry->host, entry->port,
+                    nc_strerror(ret));
+        }
+        free(conn);
+        pthread_mutex_lock(&pool->lock);
+        entry->busy--;
+        pool->stats.connect_failures++;
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+    
+    conn->session = session;
+    conn->target = entry;
+    nc_session_set_data(session, conn);
+    return session;
+}
+
+// Give back a session from o1_client_pool_acquire. reusable is zero if the
+// caller saw it fail or left RPCs unanswered on it; it is closed then.
+void o1_client_pool_release(o1_client_pool_t *pool, struct nc_session *session, int reusable) {
+    if (!pool || !session) {
+        return;
+    }
+    
+    o1_client_conn_t *conn = nc_session_get_data(session);
+    if (!conn) {
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    o1_client_target_entry_t *target = conn->target;
+    target->busy--;
+    if (!reusable || !pool->running || target->idle_count >= pool->config.max_idle ||
+        nc_session_get_status(session) != NC_STATUS_RUNNING) {
+        pool->stats.closed++;
+        pthread_mutex_unlock(&pool->lock);
+        close_conn(conn);
+        return;
+    }
+    
+    conn->idle_since = now_ms();
+    conn->last_traffic = conn->idle_since;
+    conn->next = target->idle;
+    target->idle = conn;
+    target->idle_count++;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void o1_client_pool_stats(o1_client_pool_t *pool, o1_client_pool_stats_t *stats) {
+    pthread_mutex_lock(&pool->lock);
+    *stats = pool->stats;
+    stats->idle = 0;
+    stats->busy = 0;
+    for (o1_client_target_entry_t *target = pool->targets; target; target = target->next) {
+        stats->idle += target->idle_count;
+        stats->busy += target->busy;
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
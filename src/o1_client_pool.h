@@ -0,0 +1,64 @@
+#ifndef O1_CLIENT_POOL_H
+#define O1_CLIENT_POOL_H
+
+#include <stdint.h>
+
+// NETCONF includes
+#include <libnetconf2/netconf.h>
+#include <libnetconf2/session.h>
+
+// Pool of established client sessions, keyed by host, port and user.
+//
+// A caller acquires a session for a target and releases it when done; the
+// next caller for the same target gets the same session back without a
+// new SSH handshake. Each target's private key is read and checked once,
+// then kept in an anonymous in-memory file that every later connect reads
+// instead of the disk. Idle sessions are kept alive by a background thread
+// with a get-config whose empty filter selects nothing, and closed once
+// they have been idle for idle_timeout. The pool is safe to use from any
+// number of threads.
+
+typedef struct o1_client_pool o1_client_pool_t;
+
+// Where to connect and as whom
+typedef struct {
+    const char *host;
+    int port;
+    const char *username;
+    const char *password;
+    const char *private_key_path;
+} o1_client_target_t;
+
+// Pool configuration
+typedef struct {
+    int max_idle;           // idle sessions kept per target
+    int idle_timeout;       // ms an idle session is kept, 0 for no limit
+    int keepalive_interval; // ms of silence before an idle session is pinged, 0 for none
+    int keepalive_timeout;  // ms to wait for the keep-alive reply
+} o1_client_pool_config_t;
+
+#define O1_CLIENT_POOL_DEFAULT_MAX_IDLE 4
+#define O1_CLIENT_POOL_DEFAULT_IDLE_TIMEOUT 300000
+#define O1_CLIENT_POOL_DEFAULT_KEEPALIVE 30000
+#define O1_CLIENT_POOL_DEFAULT_KEEPALIVE_TIMEOUT 5000
+
+typedef struct {
+    uint64_t hits;          // acquires served by an idle session
+    uint64_t connects;      // acquires that needed a handshake
+    uint64_t connect_failures;
+    uint64_t keepalives;
+    uint64_t closed;        // sessions dropped: dead, expired or surplus
+    int idle;               // sessions idle now
+    int busy;               // sessions acquired now
+} o1_client_pool_stats_t;
+
+// Function declarations
+void o1_client_pool_default_config(o1_client_pool_config_t *config);
+o1_client_pool_t *o1_client_pool_create(const o1_client_pool_config_t *config);
+void o1_client_pool_destroy(o1_client_pool_t *pool);
+
+struct nc_session *o1_client_pool_acquire(o1_client_pool_t *pool, const o1_client_target_t *target);
+void o1_client_pool_release(o1_client_pool_t *pool, struct nc_session *session, int reusable);
+void o1_client_pool_stats(o1_client_pool_t *pool, o1_client_pool_stats_t *stats);
+
+#endif // O1_CLIENT_POOL_H
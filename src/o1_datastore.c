@@ -0,0 +1,883 @@
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "o1_datastore.h"
+#include "hex.h"
+
+#define PAGE_MASK (O1_DS_PAGE_SIZE - 1)
+
+// Set in flags once the corresponding tracing leaf has been written; the
+// same bits as in an image's fields
+#define HAS_TRACEID O1_DS_TRACEID
+#define HAS_SPANID  O1_DS_SPANID
+
+// One page of records, struct-of-arrays: a lookup touches the name column,
+// a status read touches a few bytes per interface instead of a whole record
+typedef struct {
+    uint32_t seq[O1_DS_PAGE_SIZE];                  // odd while an edit is in progress
+    char name[O1_DS_PAGE_SIZE][O1_DS_NAME_MAX + 1];
+    uint8_t name_len[O1_DS_PAGE_SIZE];
+    uint8_t status[O1_DS_PAGE_SIZE];
+    uint8_t flags[O1_DS_PAGE_SIZE];
+    unsigned char traceid[O1_DS_PAGE_SIZE][16];     // stored decoded
+    unsigned char spanid[O1_DS_PAGE_SIZE][8];
+    uint64_t timestamp[O1_DS_PAGE_SIZE];
+    uint64_t last_change[O1_DS_PAGE_SIZE];
+} o1_ds_page_t;
+
+// The page table of one committed state of running. Edits change the
+// current version in place under the seqlocks; a commit replaces it whole.
+struct o1_ds_version {
+    size_t count;               // slots visible through this version
+    o1_ds_page_t *pages[];      // num_pages entries, filled on demand
+};
+
+// Readers announce the epoch they started in while they hold a version,
+// one per slot; a slot is padded to its own cache line
+#define READER_SLOTS 256
+
+typedef struct {
+    uint64_t epoch;             // 0 when free
+    char pad[56];
+} reader_slot_t;
+
+struct o1_datastore {
+    size_t capacity;
+    size_t count;               // published slots; readers load it with acquire
+    o1_ds_version_t *version;   // current version, swapped by a commit
+    size_t num_pages;
+    uint64_t *index;            // hash << 32 | (slot + 1); 0 marks an empty bucket
+    size_t index_mask;
+    pthread_mutex_t write_lock;
+    o1_stats_t *stats;          // live statistics by slot, NULL for none
+    o1_datastore_journal_t journal; // append NULL for none
+    uint64_t epoch;             // advanced by every commit, from 1
+    reader_slot_t readers[READER_SLOTS];
+    
+    // Scratch of a commit of several interfaces, reused by the next one so
+    // that commits of a steady size allocate nothing
+    pthread_mutex_t commit_lock;    // one such commit at a time
+    uint32_t *commit_slots;     // where each change lands
+    size_t commit_slots_size;
+    o1_ds_page_t **retired;     // num_pages entries: pages the commit replaced
+    o1_ds_version_t *spare;     // version the last commit replaced
+    o1_ds_page_t **spare_pages; // num_pages entries: pages it replaced
+    size_t num_spare_pages;
+};
+
+// First reader slot this thread tries; spread over threads
+static __thread unsigned reader_hint = READER_SLOTS;
+static unsigned next_reader_hint;
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static o1_ds_page_t *page_of(const o1_ds_version_t *version, uint32_t slot) {
+    return __atomic_load_n(&version->pages[slot >> O1_DS_PAGE_SHIFT], __ATOMIC_ACQUIRE);
+}
+
+// Claim a reader slot and take the current version. Once the slot is
+// stamped, no commit frees what this version uses until it is released.
+// With more readers at once than slots, a thread that finds every slot
+// taken yields before sweeping again, so the holders can run and finish.
+static const o1_ds_version_t *pin_version(o1_datastore_t *ds, unsigned *reader) {
+    if (reader_hint >= READER_SLOTS) {
+        reader_hint = __atomic_fetch_add(&next_reader_hint, 1, __ATOMIC_RELAXED) % READER_SLOTS;
+    }
+    
+    uint64_t epoch = __atomic_load_n(&ds->epoch, __ATOMIC_SEQ_CST);
+    for (unsigned i = reader_hint;;) {
+        uint64_t free_slot = 0;
+        if (__atomic_load_n(&ds->readers[i].epoch, __ATOMIC_RELAXED) == 0 &&
+            __atomic_compare_exchange_n(&ds->readers[i].epoch, &free_slot, epoch, 0,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            *reader = i;
+            return __atomic_load_n(&ds->version, __ATOMIC_SEQ_CST);
+        }
+        
+        i = (i + 1) % READER_SLOTS;
+        if (i == reader_hint) {
+            sched_yield();
+        }
+    }
+}
+
+static void unpin_version(o1_datastore_t *ds, unsigned reader) {
+    __atomic_store_n(&ds->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+}
+
+// Wait until every reader that may still hold a version replaced before
+// this call has released it. Readers that start later see the new one.
+static void wait_for_readers(o1_datastore_t *ds) {
+    uint64_t epoch = __atomic_add_fetch(&ds->epoch, 1, __ATOMIC_SEQ_CST);
+    for (unsigned i = 0; i < READER_SLOTS; i++) {
+        uint64_t started;
+        while ((started = __atomic_load_n(&ds->readers[i].epoch, __ATOMIC_SEQ_CST)) != 0 &&
+               started < epoch) {
+            sched_yield();
+        }
+    }
+}
+
+// Returns the slot holding name in version, or -1. Safe without the write
+// lock: a bucket is published only after its page and name are in place,
+// and names never change afterwards.
+static int64_t find_slot(o1_datastore_t *ds, const o1_ds_version_t *version,
+                         const char *name, size_t len, uint32_t hash) {
+    size_t count = __atomic_load_n(&version->count, __ATOMIC_ACQUIRE);
+    for (size_t i = hash & ds->index_mask;; i = (i + 1) & ds->index_mask) {
+        uint64_t entry = __atomic_load_n(&ds->index[i], __ATOMIC_ACQUIRE);
+        if (entry == 0) {
+            return -1;
+        }
+        if ((uint32_t)(entry >> 32) != hash) {
+            continue;
+        }
+        
+        // Slots past the count belong to a later version or an unfinished insert
+        uint32_t slot = (uint32_t)entry - 1;
+        if (slot >= count) {
+            continue;
+        }
+        o1_ds_page_t *page = page_of(version, slot);
+        uint32_t off = slot & PAGE_MASK;
+        if (page->name_len[off] == len && memcmp(page->name[off], name, len) == 0) {
+            return slot;
+        }
+    }
+}
+
+// Name and defaults of a new slot, written before anything points to it
+static void init_slot(o1_ds_page_t *page, uint32_t off, const char *name, size_t len,
+                      uint64_t now) {
+    memcpy(page->name[off], name, len);
+    page->name[off][len] = '\0';
+    page->name_len[off] = (uint8_t)len;
+    page->status[off] = O1_IF_UP;       // YANG default
+    page->last_change[off] = now;
+}
+
+// Add the index bucket for a new slot; lookups pass over it until the
+// count of their version covers the slot
+static void index_slot(o1_datastore_t *ds, uint32_t slot, uint32_t hash) {
+    size_t i = hash & ds->index_mask;
+    while (ds->index[i] != 0) {
+        i = (i + 1) & ds->index_mask;
+    }
+    __atomic_store_n(&ds->index[i], (uint64_t)hash << 32 | (slot + 1), __ATOMIC_RELEASE);
+}
+
+// Claim the next slot for a new name in the current version. Called with
+// the write lock held.
+static int64_t insert_slot(o1_datastore_t *ds, const char *name, size_t len, uint32_t hash) {
+    if (ds->count >= ds->capacity) {
+        errno = ENOSPC;
+        return -1;
+    }
+    
+    o1_ds_version_t *version = ds->version;
+    uint32_t slot = (uint32_t)ds->count;
+    size_t page_idx = slot >> O1_DS_PAGE_SHIFT;
+    o1_ds_page_t *page = version->pages[page_idx];
+    if (!page) {
+        page = calloc(1, sizeof(*page));
+        if (!page) {
+            return -1;
+        }
+        __atomic_store_n(&version->pages[page_idx], page, __ATOMIC_RELEASE);
+    }
+    
+    init_slot(page, slot & PAGE_MASK, name, len, now_ms());
+    index_slot(ds, slot, hash);
+    __atomic_store_n(&version->count, ds->count + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ds->count, ds->count + 1, __ATOMIC_RELEASE);
+    return slot;
+}
+
+o1_datastore_t *o1_datastore_create(size_t capacity) {
+    if (capacity == 0 || capacity > UINT32_MAX / 2) {
+        errno = EINVAL;
+        return NULL;
+    }
+    
+    o1_datastore_t *ds = calloc(1, sizeof(*ds));
+    if (!ds) {
+        return NULL;
+    }
+    
+    // At most half full, so probe sequences stay short
+    size_t buckets = 1;
+    while (buckets < capacity * 2) {
+        buckets <<= 1;
+    }
+    
+    ds->capacity = capacity;
+    ds->num_pages = (capacity + O1_DS_PAGE_SIZE - 1) / O1_DS_PAGE_SIZE;
+    ds->version = calloc(1, sizeof(*ds->version) + ds->num_pages * sizeof(o1_ds_page_t *));
+    ds->index = calloc(buckets, sizeof(*ds->index));
+    ds->index_mask = buckets - 1;
+    ds->epoch = 1;
+    if (!ds->version || !ds->index) {
+        o1_datastore_destroy(ds);
+        return NULL;
+    }
+    pthread_mutex_init(&ds->write_lock, NULL);
+    pthread_mutex_init(&ds->commit_lock, NULL);
+    
+    return ds;
+}
+
+void o1_datastore_destroy(o1_datastore_t *ds) {
+    if (!ds) {
+        return;
+    }
+    
+    if (ds->version) {
+        for (size_t i = 0; i < ds->num_pages; i++) {
+            free(ds->version->pages[i]);
+        }
+        pthread_mutex_destroy(&ds->write_lock);
+        pthread_mutex_destroy(&ds->commit_lock);
+    }
+    for (size_t i = 0; i < ds->num_spare_pages; i++) {
+        free(ds->spare_pages[i]);
+    }
+    free(ds->spare_pages);
+    free(ds->commit_slots);
+    free(ds->retired);
+    free(ds->spare);
+    free(ds->version);
+    free(ds->index);
+    free(ds);
+}
+
+// Copy a slot's stored fields; called under the write lock or inside a
+// seqlock read
+static void copy_image(const o1_ds_page_t *page, uint32_t off, o1_ds_image_t *image) {
+    memcpy(image->name, page->name[off], sizeof(image->name));
+    image->name_len = page->name_len[off];
+    image->status = page->status[off];
+    image->fields = page->flags[off];
+    memset(image->reserved, 0, sizeof(image->reserved));
+    memcpy(image->traceid, page->traceid[off], sizeof(image->traceid));
+    memcpy(image->spanid, page->spanid[off], sizeof(image->spanid));
+    image->timestamp = page->timestamp[off];
+    image->last_change = page->last_change[off];
+}
+
+// Store the leaves flagged in fields. The caller holds the slot's seqlock
+// or writes a page no reader can reach yet.
+static void set_leaves(o1_ds_page_t *page, uint32_t off, unsigned fields, uint8_t status,
+                       const unsigned char *traceid, const unsigned char *spanid,
+                       uint64_t timestamp) {
+    if ((fields & O1_DS_STATUS) && page->status[off] != status) {
+        page->status[off] = status;
+        page->last_change[off] = now_ms();
+    }
+    if (fields & O1_DS_TRACEID) {
+        memcpy(page->traceid[off], traceid, sizeof(page->traceid[off]));
+        page->flags[off] |= HAS_TRACEID;
+    }
+    if (fields & O1_DS_SPANID) {
+        memcpy(page->spanid[off], spanid, sizeof(page->spanid[off]));
+        page->flags[off] |= HAS_SPANID;
+    }
+    if (fields & O1_DS_TIMESTAMP) {
+        page->timestamp[off] = timestamp;
+    }
+}
+
+// Apply the leaves flagged in a change, all under one seqlock write so a
+// reader sees either none or all of them
+static int apply_change(o1_datastore_t *ds, const o1_ds_change_t *change, int create) {
+    const char *name = change->name;
+    size_t name_len = change->name_len;
+    uint32_t hash = o1_ds_hash_name(name, name_len);
+    
+    pthread_mutex_lock(&ds->write_lock);
+    
+    int64_t slot = find_slot(ds, ds->version, name, name_len, hash);
+    if (slot < 0 && !create) {
+        pthread_mutex_unlock(&ds->write_lock);
+        errno = ENOENT;
+        return -1;
+    }
+    if (slot < 0) {
+        slot = insert_slot(ds, name, name_len, hash);
+        if (slot < 0) {
+            pthread_mutex_unlock(&ds->write_lock);
+            return -1;
+        }
+    }
+    
+    o1_ds_page_t *page = ds->version->pages[slot >> O1_DS_PAGE_SHIFT];
+    uint32_t off = (uint32_t)slot & PAGE_MASK;
+    uint32_t seq = page->seq[off];
+    
+    __atomic_store_n(&page->seq[off], seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    
+    set_leaves(page, off, change->fields, change->status, change->traceid, change->spanid,
+               change->timestamp);
+    
+    __atomic_store_n(&page->seq[off], seq + 2, __ATOMIC_RELEASE);
+    
+    // Under the lock, so the journal sees edits in the order they were made
+    if (ds->journal.append) {
+        o1_ds_image_t image;
+        copy_image(page, off, &image);
+        ds->journal.append(ds->journal.arg, &image);
+    }
+    
+    pthread_mutex_unlock(&ds->write_lock);
+    return 0;
+}
+
+static int apply_update(o1_datastore_t *ds, const char *name, size_t name_len,
+                        const o1_interface_update_t *update, int create) {
+    if (!ds || !name || name_len == 0 || name_len > O1_DS_NAME_MAX || !update) {
+        errno = EINVAL;
+        return -1;
+    }
+    
+    // Decode before taking the lock so a bad ID leaves the record untouched
+    o1_ds_change_t change;
+    change.fields = (uint8_t)update->fields;
+    change.status = (uint8_t)update->status;
+    change.timestamp = update->timestamp;
+    if ((update->fields & O1_DS_TRACEID) &&
+        hex_decode(change.traceid, update->traceid, sizeof(change.traceid)) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((update->fields & O1_DS_SPANID) &&
+        hex_decode(change.spanid, update->spanid, sizeof(change.spanid)) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy(change.name, name, name_len);
+    change.name_len = (uint8_t)name_len;
+    return apply_change(ds, &change, create);
+}
+
+// Create the interface if needed and apply the leaves present in update.
+// Returns 0, or -1 with errno EINVAL (bad name or leaf), ENOSPC (full).
+int o1_datastore_merge(o1_datastore_t *ds, const char *name, size_t name_len,
+                       const o1_interface_update_t *update) {
+    return apply_update(ds, name, name_len, update, 1);
+}
+
+// As o1_datastore_merge, but only for an existing interface: -1 with errno
+// ENOENT otherwise
+int o1_datastore_update(o1_datastore_t *ds, const char *name, size_t name_len,
+                        const o1_interface_update_t *update) {
+    return apply_update(ds, name, name_len, update, 0);
+}
+
+// Copy one slot, retrying while a writer is inside it
+static void read_slot(o1_datastore_t *ds, const o1_ds_version_t *version, uint32_t slot,
+                      o1_interface_record_t *record) {
+    o1_ds_page_t *page = page_of(version, slot);
+    uint32_t off = slot & PAGE_MASK;
+    unsigned char traceid[16], spanid[8];
+    uint8_t flags;
+    uint32_t seq;
+    
+    // The name is immutable once published
+    record->name_len = page->name_len[off];
+    memcpy(record->name, page->name[off], record->name_len + 1);
+    
+    for (;;) {
+        seq = __atomic_load_n(&page->seq[off], __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            continue;
+        }
+        
+        record->status = (o1_if_status_t)page->status[off];
+        flags = page->flags[off];
+        memcpy(traceid, page->traceid[off], sizeof(traceid));
+        memcpy(spanid, page->spanid[off], sizeof(spanid));
+        record->timestamp = page->timestamp[off];
+        record->last_change = page->last_change[off];
+        
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&page->seq[off], __ATOMIC_RELAXED) == seq) {
+            break;
+        }
+    }
+    
+    // Statistics are not part of the edit, so they are read outside it
+    o1_if_counters_t counters;
+    o1_stats_read(ds->stats, slot, &counters);
+    record->packets_in = counters.packets_in;
+    record->packets_out = counters.packets_out;
+    record->bytes_in = counters.bytes_in;
+    record->bytes_out = counters.bytes_out;
+    
+    // Encode outside the retry loop
+    record->traceid[0] = '\0';
+    record->spanid[0] = '\0';
+    if (flags & HAS_TRACEID) {
+        hex_encode(record->traceid, traceid, sizeof(traceid));
+        record->traceid[32] = '\0';
+    }
+    if (flags & HAS_SPANID) {
+        hex_encode(record->spanid, spanid, sizeof(spanid));
+        record->spanid[16] = '\0';
+    }
+}
+
+// Look up an interface by name. Returns 0 and fills record, -1 if absent.
+int o1_datastore_get(o1_datastore_t *ds, const char *name, size_t name_len,
+                     o1_interface_record_t *record) {
+    if (!ds || !name || !record || name_len > O1_DS_NAME_MAX) {
+        return -1;
+    }
+    
+    unsigned reader;
+    const o1_ds_version_t *version = pin_version(ds, &reader);
+    int64_t slot = find_slot(ds, version, name, name_len,
+                             o1_ds_hash_name(name, name_len));
+    if (slot >= 0) {
+        read_slot(ds, version, (uint32_t)slot, record);
+    }
+    unpin_version(ds, reader);
+    return slot >= 0 ? 0 : -1;
+}
+
+// Status of an interface and when it last changed (ms since the epoch),
+// read together. Returns 0, or -1 if absent.
+int o1_datastore_status(o1_datastore_t *ds, const char *name, size_t name_len,
+                        o1_if_status_t *status, uint64_t *last_change) {
+    if (!ds || !name || !status || !last_change || name_len > O1_DS_NAME_MAX) {
+        return -1;
+    }
+    
+    unsigned reader;
+    const o1_ds_version_t *version = pin_version(ds, &reader);
+    int64_t slot = find_slot(ds, version, name, name_len,
+                             o1_ds_hash_name(name, name_len));
+    if (slot < 0) {
+        unpin_version(ds, reader);
+        return -1;
+    }
+    
+    o1_ds_page_t *page = page_of(version, (uint32_t)slot);
+    uint32_t off = (uint32_t)slot & PAGE_MASK;
+    for (;;) {
+        uint32_t seq = __atomic_load_n(&page->seq[off], __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            continue;
+        }
+        
+        *status = (o1_if_status_t)page->status[off];
+        *last_change = page->last_change[off];
+        
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&page->seq[off], __ATOMIC_RELAXED) == seq) {
+            break;
+        }
+    }
+    
+    unpin_version(ds, reader);
+    return 0;
+}
+
+// Index of an interface (as taken by o1_datastore_read) by name. Returns
+// 0, or -1 if absent.
+int o1_datastore_lookup(o1_datastore_t *ds, const char *name, size_t name_len, size_t *index) {
+    if (!ds || !name || !index || name_len > O1_DS_NAME_MAX) {
+        return -1;
+    }
+    
+    unsigned reader;
+    const o1_ds_version_t *version = pin_version(ds, &reader);
+    int64_t slot = find_slot(ds, version, name, name_len,
+                             o1_ds_hash_name(name, name_len));
+    unpin_version(ds, reader);
+    if (slot < 0) {
+        return -1;
+    }
+    
+    *index = (size_t)slot;
+    return 0;
+}
+
+// Serve the statistics leaves from `stats`, indexed like the datastore.
+// Set before sessions start; the datastore does not own it.
+void o1_datastore_set_stats(o1_datastore_t *ds, o1_stats_t *stats) {
+    ds->stats = stats;
+}
+
+// Send every later change to journal (NULL to detach). Set while no edit
+// is in progress; the datastore does not own it.
+void o1_datastore_set_journal(o1_datastore_t *ds, const o1_datastore_journal_t *journal) {
+    if (journal) {
+        ds->journal = *journal;
+    } else {
+        memset(&ds->journal, 0, sizeof(ds->journal));
+    }
+}
+
+// Wait until every change made so far is durable. Returns 0, at once when
+// there is no journal, or -1 if the journal has failed.
+int o1_datastore_sync(o1_datastore_t *ds) {
+    if (!ds || !ds->journal.sync) {
+        return 0;
+    }
+    return ds->journal.sync(ds->journal.arg);
+}
+
+// Image of the interface at index, consistent with respect to edits
+int o1_datastore_export(o1_datastore_t *ds, size_t index, o1_ds_image_t *image) {
+    if (!ds || !image || index >= o1_datastore_count(ds)) {
+        return -1;
+    }
+    
+    unsigned reader;
+    const o1_ds_version_t *version = pin_version(ds, &reader);
+    o1_ds_page_t *page = page_of(version, (uint32_t)index);
+    uint32_t off = (uint32_t)index & PAGE_MASK;
+    for (;;) {
+        uint32_t seq = __atomic_load_n(&page->seq[off], __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            continue;
+        }
+        
+        copy_image(page, off, image);
+        
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&page->seq[off], __ATOMIC_RELAXED) == seq) {
+            break;
+        }
+    }
+    
+    unpin_version(ds, reader);
+    return 0;
+}
+
+// Install images as they are, creating interfaces in array order, without
+// passing them to the journal: for loading a snapshot or replaying a log.
+// Returns 0, or -1 with errno EINVAL (bad image) or ENOSPC (full); images
+// before the bad one stay installed.
+int o1_datastore_restore(o1_datastore_t *ds, const o1_ds_image_t *images, size_t count) {
+    if (!ds || (!images && count > 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    
+    int ret = 0;
+    pthread_mutex_lock(&ds->write_lock);
+    
+    for (size_t i = 0; i < count; i++) {
+        const o1_ds_image_t *image = &images[i];
+        if (image->name_len == 0 || image->name_len > O1_DS_NAME_MAX ||
+            memchr(image->name, '\0', image->name_len) ||
+            !o1_interface_interface_status_to_str(image->status)) {
+            errno = EINVAL;
+            ret = -1;
+            break;
+        }
+        
+        uint32_t hash = o1_ds_hash_name(image->name, image->name_len);
+        int64_t slot = find_slot(ds, ds->version, image->name, image->name_len, hash);
+        if (slot < 0) {
+            slot = insert_slot(ds, image->name, image->name_len, hash);
+            if (slot < 0) {
+                ret = -1;
+                break;
+            }
+        }
+        
+        o1_ds_page_t *page = ds->version->pages[slot >> O1_DS_PAGE_SHIFT];
+        uint32_t off = (uint32_t)slot & PAGE_MASK;
+        uint32_t seq = page->seq[off];
+        
+        __atomic_store_n(&page->seq[off], seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        
+        page->status[off] = image->status;
+        page->flags[off] = image->fields & (HAS_TRACEID | HAS_SPANID);
+        memcpy(page->traceid[off], image->traceid, sizeof(image->traceid));
+        memcpy(page->spanid[off], image->spanid, sizeof(image->spanid));
+        page->timestamp[off] = image->timestamp;
+        page->last_change[off] = image->last_change;
+        
+        __atomic_store_n(&page->seq[off], seq + 2, __ATOMIC_RELEASE);
+    }
+    
+    pthread_mutex_unlock(&ds->write_lock);
+    return ret;
+}
+
+// Read the interface at index (0 .. count-1, in creation order)
+int o1_datastore_read(o1_datastore_t *ds, size_t index, o1_interface_record_t *record) {
+    if (!ds || !record) {
+        return -1;
+    }
+    
+    unsigned reader;
+    const o1_ds_version_t *version = pin_version(ds, &reader);
+    int ret = -1;
+    if (index < __atomic_load_n(&version->count, __ATOMIC_ACQUIRE)) {
+        read_slot(ds, version, (uint32_t)index, record);
+        ret = 0;
+    }
+    unpin_version(ds, reader);
+    return ret;
+}
+
+// Pin the current version for a sequence of reads, such as one get-config.
+// End the view before starting a commit on the same thread.
+void o1_datastore_view_begin(o1_datastore_t *ds, o1_ds_view_t *view) {
+    view->ds = ds;
+    view->version = pin_version(ds, &view->reader);
+}
+
+void o1_datastore_view_end(o1_ds_view_t *view) {
+    unpin_version(view->ds, view->reader);
+    view->version = NULL;
+}
+
+// Interfaces in the view, readable at indexes 0 .. count-1
+size_t o1_datastore_view_count(const o1_ds_view_t *view) {
+    return __atomic_load_n(&view->version->count, __ATOMIC_ACQUIRE);
+}
+
+// As o1_datastore_get and o1_datastore_read, within the view
+int o1_datastore_view_get(const o1_ds_view_t *view, const char *name, size_t name_len,
+                          o1_interface_record_t *record) {
+    if (!name || !record || name_len > O1_DS_NAME_MAX) {
+        return -1;
+    }
+    
+    int64_t slot = find_slot(view->ds, view->version, name, name_len,
+                             o1_ds_hash_name(name, name_len));
+    if (slot < 0) {
+        return -1;
+    }
+    
+    read_slot(view->ds, view->version, (uint32_t)slot, record);
+    return 0;
+}
+
+int o1_datastore_view_read(const o1_ds_view_t *view, size_t index, o1_interface_record_t *record) {
+    if (!record || index >= o1_datastore_view_count(view)) {
+        return -1;
+    }
+    
+    read_slot(view->ds, view->version, (uint32_t)index, record);
+    return 0;
+}
+
+// Make the scratch of a commit of count interfaces. Called with the commit
+// lock held; only grows, so a commit no larger than the last allocates
+// nothing.
+static int commit_scratch(o1_datastore_t *ds, size_t count) {
+    if (count > ds->commit_slots_size) {
+        uint32_t *slots = realloc(ds->commit_slots, count * sizeof(*slots));
+        if (!slots) {
+            return -1;
+        }
+        ds->commit_slots = slots;
+        ds->commit_slots_size = count;
+    }
+    if (!ds->retired) {
+        ds->retired = malloc(ds->num_pages * sizeof(*ds->retired));
+    }
+    if (!ds->spare_pages) {
+        ds->spare_pages = malloc(ds->num_pages * sizeof(*ds->spare_pages));
+    }
+    if (!ds->spare) {
+        ds->spare = malloc(sizeof(*ds->spare) + ds->num_pages * sizeof(o1_ds_page_t *));
+    }
+    return ds->retired && ds->spare_pages && ds->spare ? 0 : -1;
+}
+
+// A page for a commit to fill, from those earlier commits replaced if
+// there are any; zeroed if asked. Called with the commit lock held.
+static o1_ds_page_t *spare_page(o1_datastore_t *ds, int zero) {
+    if (ds->num_spare_pages == 0) {
+        return zero ? calloc(1, sizeof(o1_ds_page_t)) : malloc(sizeof(o1_ds_page_t));
+    }
+    
+    o1_ds_page_t *page = ds->spare_pages[--ds->num_spare_pages];
+    if (zero) {
+        memset(page, 0, sizeof(*page));
+    }
+    return page;
+}
+
+// Apply changes as a single step: build a version in which every page
+// they touch is a private copy, fill it in, and publish it with one
+// pointer swap. Readers keep the version they started with, so none sees
+// part of a commit or waits for it; once the last of them is done, the
+// replaced version and pages are kept for the next commit to fill. Names
+// must be distinct. Returns 0, or -1 with errno EINVAL (bad change),
+// ENOSPC (new interfaces do not fit) or ENOMEM, with nothing applied.
+int o1_datastore_commit(o1_datastore_t *ds, const o1_ds_change_t *changes, size_t count) {
+    if (!ds || (!changes && count > 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const o1_ds_change_t *change = &changes[i];
+        if (change->name_len == 0 || change->name_len > O1_DS_NAME_MAX ||
+            memchr(change->name, '\0', change->name_len) ||
+            ((change->fields & O1_DS_STATUS) &&
+             !o1_interface_interface_status_to_str(change->status))) {
+            errno = EINVAL;
+            return -1;
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+    
+    // One interface is all or nothing under its seqlock already; no new
+    // version is needed
+    if (count == 1) {
+        return apply_change(ds, &changes[0], 1);
+    }
+    
+    pthread_mutex_lock(&ds->commit_lock);
+    if (commit_scratch(ds, count) != 0) {
+        pthread_mutex_unlock(&ds->commit_lock);
+        errno = ENOMEM;
+        return -1;
+    }
+    uint32_t *slots = ds->commit_slots;
+    o1_ds_page_t **retired = ds->retired;
+    o1_ds_version_t *version = ds->spare;
+    ds->spare = NULL;
+    
+    pthread_mutex_lock(&ds->write_lock);
+    
+    // Where each change lands; new names take the slots after the last
+    o1_ds_version_t *old = ds->version;
+    size_t next = old->count;
+    for (size_t i = 0; i < count; i++) {
+        int64_t slot = find_slot(ds, old, changes[i].name, changes[i].name_len,
+                                 o1_ds_hash_name(changes[i].name, changes[i].name_len));
+        slots[i] = slot >= 0 ? (uint32_t)slot : (uint32_t)next++;
+    }
+    if (next > ds->capacity) {
+        pthread_mutex_unlock(&ds->write_lock);
+        ds->spare = version;
+        pthread_mutex_unlock(&ds->commit_lock);
+        errno = ENOSPC;
+        return -1;
+    }
+    
+    // Copy the page table, then every page a change lands in
+    memcpy(version->pages, old->pages, ds->num_pages * sizeof(o1_ds_page_t *));
+    version->count = next;
+    size_t num_retired = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t page_idx = slots[i] >> O1_DS_PAGE_SHIFT;
+        o1_ds_page_t *shared = old->pages[page_idx];
+        if (version->pages[page_idx] != shared) {
+            continue;
+        }
+        
+        o1_ds_page_t *page = spare_page(ds, !shared);
+        if (!page) {
+            for (size_t p = 0; p < ds->num_pages; p++) {
+                if (version->pages[p] != old->pages[p]) {
+                    free(version->pages[p]);
+                }
+            }
+            pthread_mutex_unlock(&ds->write_lock);
+            ds->spare = version;
+            pthread_mutex_unlock(&ds->commit_lock);
+            errno = ENOMEM;
+            return -1;
+        }
+        if (shared) {
+            memcpy(page, shared, sizeof(*page));
+            retired[num_retired++] = shared;
+        }
+        version->pages[page_idx] = page;
+    }
+    
+    // No reader can reach these pages yet, so no seqlock writes are needed
+    uint64_t now = now_ms();
+    for (size_t i = 0; i < count; i++) {
+        const o1_ds_change_t *change = &changes[i];
+        o1_ds_page_t *page = version->pages[slots[i] >> O1_DS_PAGE_SHIFT];
+        uint32_t off = slots[i] & PAGE_MASK;
+        if (slots[i] >= old->count) {
+            init_slot(page, off, change->name, change->name_len, now);
+            index_slot(ds, slots[i], o1_ds_hash_name(change->name, change->name_len));
+        }
+        set_leaves(page, off, change->fields, change->status, change->traceid, change->spanid,
+                   change->timestamp);
+    }
+    
+    __atomic_store_n(&ds->version, version, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&ds->count, next, __ATOMIC_RELEASE);
+    
+    // Journal only once published: a snapshot that starts after a record
+    // is appended must find the commit in the datastore, as it replaces the
+    // segment holding that record
+    if (ds->journal.append) {
+        for (size_t i = 0; i < count; i++) {
+            o1_ds_image_t image;
+            copy_image(version->pages[slots[i] >> O1_DS_PAGE_SHIFT], slots[i] & PAGE_MASK,
+                       &image);
+            ds->journal.append(ds->journal.arg, &image);
+        }
+    }
+    pthread_mutex_unlock(&ds->write_lock);
+    
+    // The pages replaced become the spares, so between commits no more is
+    // held than one commit needs while it runs
+    wait_for_readers(ds);
+    for (size_t i = 0; i < ds->num_spare_pages; i++) {
+        free(ds->spare_pages[i]);
+    }
+    ds->retired = ds->spare_pages;
+    ds->spare_pages = retired;
+    ds->num_spare_pages = num_retired;
+    ds->spare = old;
+    pthread_mutex_unlock(&ds->commit_lock);
+    return 0;
+}
+
+size_t o1_datastore_count(o1_datastore_t *ds) {
+    return ds ? __atomic_load_n(&ds->count, __ATOMIC_ACQUIRE) : 0;
+}
+
+// Bytes currently allocated for pages and index
+size_t o1_datastore_memory(o1_datastore_t *ds) {
+    if (!ds) {
+        return 0;
+    }
+    
+    size_t pages = (o1_datastore_count(ds) + O1_DS_PAGE_SIZE - 1) / O1_DS_PAGE_SIZE;
+    return sizeof(*ds) + sizeof(*ds->version) + ds->num_pages * sizeof(o1_ds_page_t *) +
+           (ds->index_mask + 1) * sizeof(*ds->index) +
+           (pages + ds->num_spare_pages) * sizeof(o1_ds_page_t);
+}
+
+// Mapping generated from the status enumeration in o1-interface.yang
+int o1_if_status_parse(const char *str, size_t len, o1_if_status_t *status) {
+    int value = o1_interface_interface_status_from_str(str, len);
+    if (value < 0) {
+        return -1;
+    }
+    *status = (o1_if_status_t)value;
+    return 0;
+}
+
+const char *o1_if_status_name(o1_if_status_t status) {
+    const char *name = o1_interface_interface_status_to_str(status);
+    return name ? name : "error";
+}
@@ -0,0 +1,161 @@
+#ifndef O1_DATASTORE_H
+#define O1_DATASTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "o1_stats.h"
+#include "o1_yang.h"
+
+// Running datastore for the o1-interface list, keyed by interface name.
+//
+// Records live in fixed-size pages laid out as struct-of-arrays, so a
+// capacity of N interfaces costs at most N * 111 bytes of pages plus a
+// hash index of 2 * N 8-byte buckets allocated up front: about 128 bytes
+// per interface when full, as bench_o1_datastore reports. Writers are
+// serialized by a mutex; readers never take it. Lookups probe the index
+// lock-free and copy a record under its per-slot seqlock, retrying only
+// if an edit of that same interface raced with them. The statistics
+// leaves come from an attached o1_stats_t, summed when a record is read.
+// An attached journal receives every change and makes it durable.
+//
+// Readers resolve slots through the current version, a page table that
+// a commit replaces as a whole: the pages a commit changes are copied,
+// edited and published with one pointer swap, so a reader sees all of a
+// commit or none of it. Single edits still change the current version in
+// place. A view pins one version across many reads.
+
+#define O1_DS_NAME_MAX 63               // longest interface name in bytes
+#define O1_DS_DEFAULT_CAPACITY (1 << 20)
+#define O1_DS_PAGE_SHIFT 8              // 256 interfaces per page
+#define O1_DS_PAGE_SIZE (1u << O1_DS_PAGE_SHIFT)
+
+// Values of the generated status enumeration
+typedef enum {
+    O1_IF_UP = O1_INTERFACE_INTERFACE_STATUS_UP,
+    O1_IF_DOWN = O1_INTERFACE_INTERFACE_STATUS_DOWN,
+    O1_IF_ERROR = O1_INTERFACE_INTERFACE_STATUS_ERROR
+} o1_if_status_t;
+
+// Leaves carried by an edit; only those flagged in `fields` are changed
+#define O1_DS_STATUS      0x01u
+#define O1_DS_TRACEID     0x02u
+#define O1_DS_SPANID      0x04u
+#define O1_DS_TIMESTAMP   0x08u
+
+typedef struct {
+    unsigned fields;
+    o1_if_status_t status;
+    const char *traceid;    // 32 hex characters
+    const char *spanid;     // 16 hex characters
+    uint64_t timestamp;
+} o1_interface_update_t;
+
+// A consistent copy of one interface
+typedef struct {
+    char name[O1_DS_NAME_MAX + 1];
+    size_t name_len;
+    o1_if_status_t status;
+    char traceid[33];       // empty when unset
+    char spanid[17];        // empty when unset
+    uint64_t timestamp;
+    uint64_t last_change;   // ms since the epoch of the last status change
+    uint64_t packets_in;
+    uint64_t packets_out;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+} o1_interface_record_t;
+
+// Stored form of one interface, as kept by a journal and in snapshots:
+// fixed size, IDs decoded, no pointers
+typedef struct {
+    char name[O1_DS_NAME_MAX + 1];  // NUL-padded
+    uint8_t name_len;
+    uint8_t status;
+    uint8_t fields;         // O1_DS_TRACEID and O1_DS_SPANID once written
+    uint8_t reserved[5];
+    unsigned char traceid[16];
+    unsigned char spanid[8];
+    uint64_t timestamp;
+    uint64_t last_change;
+} o1_ds_image_t;
+
+// Durable log of changes. append is called under the write lock with the
+// image of each interface an edit changed, in the order of the edits, and
+// only once readers can see the edit; sync returns 0 once everything
+// appended so far is on stable storage.
+typedef struct {
+    void (*append)(void *arg, const o1_ds_image_t *image);
+    int (*sync)(void *arg);
+    void *arg;
+} o1_datastore_journal_t;
+
+// One interface's part of a commit: the leaves flagged in fields, IDs
+// decoded
+typedef struct {
+    char name[O1_DS_NAME_MAX + 1];
+    uint8_t name_len;
+    uint8_t fields;         // O1_DS_* leaves to set
+    uint8_t status;
+    uint8_t reserved[5];
+    unsigned char traceid[16];
+    unsigned char spanid[8];
+    uint64_t timestamp;
+} o1_ds_change_t;
+
+typedef struct o1_datastore o1_datastore_t;
+typedef struct o1_ds_version o1_ds_version_t;
+
+// Reads through a view see one version. Held for about one RPC: the pages
+// a commit replaces are freed only when no view uses them any more.
+typedef struct {
+    o1_datastore_t *ds;
+    const o1_ds_version_t *version;
+    unsigned reader;
+} o1_ds_view_t;
+
+// Function declarations
+o1_datastore_t *o1_datastore_create(size_t capacity);
+void o1_datastore_destroy(o1_datastore_t *ds);
+
+int o1_datastore_merge(o1_datastore_t *ds, const char *name, size_t name_len,
+                       const o1_interface_update_t *update);
+int o1_datastore_update(o1_datastore_t *ds, const char *name, size_t name_len,
+                        const o1_interface_update_t *update);
+int o1_datastore_get(o1_datastore_t *ds, const char *name, size_t name_len,
+                     o1_interface_record_t *record);
+int o1_datastore_status(o1_datastore_t *ds, const char *name, size_t name_len,
+                        o1_if_status_t *status, uint64_t *last_change);
+int o1_datastore_lookup(o1_datastore_t *ds, const char *name, size_t name_len, size_t *index);
+int o1_datastore_read(o1_datastore_t *ds, size_t index, o1_interface_record_t *record);
+void o1_datastore_set_stats(o1_datastore_t *ds, o1_stats_t *stats);
+void o1_datastore_set_journal(o1_datastore_t *ds, const o1_datastore_journal_t *journal);
+int o1_datastore_sync(o1_datastore_t *ds);
+int o1_datastore_export(o1_datastore_t *ds, size_t index, o1_ds_image_t *image);
+int o1_datastore_restore(o1_datastore_t *ds, const o1_ds_image_t *images, size_t count);
+int o1_datastore_commit(o1_datastore_t *ds, const o1_ds_change_t *changes, size_t count);
+void o1_datastore_view_begin(o1_datastore_t *ds, o1_ds_view_t *view);
+void o1_datastore_view_end(o1_ds_view_t *view);
+size_t o1_datastore_view_count(const o1_ds_view_t *view);
+int o1_datastore_view_get(const o1_ds_view_t *view, const char *name, size_t name_len,
+                          o1_interface_record_t *record);
+int o1_datastore_view_read(const o1_ds_view_t *view, size_t index, o1_interface_record_t *record);
+size_t o1_datastore_count(o1_datastore_t *ds);
+size_t o1_datastore_memory(o1_datastore_t *ds);
+
+int o1_if_status_parse(const char *str, size_t len, o1_if_status_t *status);
+const char *o1_if_status_name(o1_if_status_t status);
+
+// FNV-1a of an interface name; interface names are short, so this beats
+// anything fancier. Every index keyed by name uses it: the datastore's,
+// the candidate's and that of a large edit-config.
+static inline uint32_t o1_ds_hash_name(const char *name, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+#endif // O1_DATASTORE_H
@@ -0,0 +1,447 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "o1_buf.h"
+#include "o1_fanout.h"
+
+#define IDLE_SLEEP_NS 200000    // a loop pass that moved nothing sleeps this long
+
+struct o1_fanout {
+    o1_fanout_config_t config;
+    o1_client_pool_t *pool;
+    volatile sig_atomic_t stopping;
+};
+
+typedef struct fanout_run fanout_run_t;
+typedef struct fanout_loop fanout_loop_t;
+
+// A target with a session checked out, driven by one loop thread
+typedef struct {
+    o1_fanout_result_t *result;
+    fanout_loop_t *loop;
+    struct nc_session *session;
+    o1_rpc_pipeline_t *pipeline;
+    int broken;             // session lost or a send failed
+    size_t next_op;         // next operation to send
+    uint64_t start_ns;      // when acquiring the session started
+    uint64_t sent_ns[];     // send times, indexed by window slot
+} fanout_job_t;
+
+struct fanout_loop {
+    fanout_run_t *run;
+    pthread_t thread;
+    fanout_job_t **inbox;   // handed over by connect threads, under run->lock
+    int inbox_len;
+    fanout_job_t **jobs;    // owned by the loop thread
+    int num_jobs;
+    o1_hist_t rpc_latency;
+    o1_hist_t target_latency;
+};
+
+struct fanout_run {
+    o1_fanout_t *fanout;
+    o1_fanout_result_t *results;
+    size_t count;
+    const char *const *operations;
+    size_t num_operations;
+    fanout_loop_t *loops;
+    int num_loops;
+    pthread_mutex_t lock;
+    pthread_cond_t changed; // a job handed over, a target done, or connecting ended
+    size_t next_target;     // next target to connect
+    size_t done;            // targets finished, connected or not
+    int active;             // targets connecting or with a session
+};
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void o1_fanout_default_config(o1_fanout_config_t *config) {
+    config->loop_threads = O1_FANOUT_DEFAULT_LOOP_THREADS;
+    config->connect_threads = O1_FANOUT_DEFAULT_CONNECT_THREADS;
+    config->max_active = O1_FANOUT_DEFAULT_MAX_ACTIVE;
+    config->per_target = O1_FANOUT_DEFAULT_PER_TARGET;
+}
+
+o1_fanout_t *o1_fanout_create(const o1_fanout_config_t *config, o1_client_pool_t *pool) {
+    if (!config || !pool || config->loop_threads < 1 || config->connect_threads < 1 ||
+        config->max_active < 1 || config->per_target < 1) {
+        return NULL;
+    }
+    
+    o1_fanout_t *fanout = calloc(1, sizeof(*fanout));
+    if (!fanout) {
+        return NULL;
+    }
+    fanout->config = *config;
+    fanout->pool = pool;
+    return fanout;
+}
+
+void o1_fanout_destroy(o1_fanout_t *fanout) {
+    free(fanout);
+}
+
+// Stop the current run and any later one: nothing more is connected or
+// sent, and RPCs already in flight are waited for. Safe in a signal handler.
+void o1_fanout_stop(o1_fanout_t *fanout) {
+    fanout->stopping = 1;
+}
+
+// Nothing more will be handed to the loops; called under run->lock
+static int run_finished(const fanout_run_t *run) {
+    return run->done == run->next_target &&
+           (run->next_target == run->count || run->fanout->stopping);
+}
+
+static void handle_reply(const o1_rpc_result_t *reply, void *arg) {
+    fanout_job_t *job = arg;
+    o1_fanout_result_t *result = job->result;
+    
+    switch (reply->status) {
+    case O1_RPC_OK:
+        result->ok++;
+        break;
+    case O1_RPC_ERROR:
+        result->errors++;
+        break;
+    default:
+        result->failed++;
+        return;
+    }
+    
+    uint64_t latency = now_ns() - job->sent_ns[reply->slot];
+    o1_hist_record(&job->loop->rpc_latency, latency);
+    if (latency > result->max_rpc_ns) {
+        result->max_rpc_ns = latency;
+    }
+}
+
+// Check out a session for the target; on failure every operation of the
+// target counts as failed
+static fanout_job_t *start_job(fanout_run_t *run, o1_fanout_result_t *result) {
+    o1_fanout_t *fanout = run->fanout;
+    int window = fanout->config.per_target;
+    
+    uint64_t start = now_ns();
+    struct nc_session *session = o1_client_pool_acquire(fanout->pool, &result->target);
+    result->connect_ns = now_ns() - start;
+    if (!session) {
+        fprintf(stderr, "Failed to connect to %s:%d\n", result->target.host, result->target.port);
+        result->failed = (int)run->num_operations;
+        return NULL;
+    }
+    
+    fanout_job_t *job = calloc(1, sizeof(*job) + window * sizeof(job->sent_ns[0]));
+    if (job) {
+        job->pipeline = o1_rpc_pipeline_create(session, window);
+    }
+    if (!job || !job->pipeline) {
+        free(job);
+        o1_client_pool_release(fanout->pool, session, 1);
+        result->failed = (int)run->num_operations;
+        return NULL;
+    }
+    
+    job->result = result;
+    job->session = session;
+    job->start_ns = start;
+    return job;
+}
+
+static void *connect_thread(void *arg) {
+    fanout_run_t *run = arg;
+    o1_fanout_t *fanout = run->fanout;
+    
+    pthread_mutex_lock(&run->lock);
+    for (;;) {
+        while (run->active >= fanout->config.max_active && !fanout->stopping) {
+            pthread_cond_wait(&run->changed, &run->lock);
+        }
+        if (run->next_target >= run->count || fanout->stopping) {
+            break;
+        }
+        size_t index = run->next_target++;
+        run->active++;
+        pthread_mutex_unlock(&run->lock);
+        
+        // The handshake runs without the lock
+        fanout_job_t *job = start_job(run, &run->results[index]);
+        
+        pthread_mutex_lock(&run->lock);
+        if (job) {
+            fanout_loop_t *loop = &run->loops[index % run->num_loops];
+            job->loop = loop;
+            loop->inbox[loop->inbox_len++] = job;
+        } else {
+            run->active--;
+            run->done++;
+        }
+        pthread_cond_broadcast(&run->changed);
+    }
+    
+    // Loops waiting for work re-check whether any more can come
+    pthread_cond_broadcast(&run->changed);
+    pthread_mutex_unlock(&run->lock);
+    return NULL;
+}
+
+// Send what the target's window allows and complete the replies that have
+// arrived, without waiting. Returns the number of RPCs sent or completed.
+static int drive_job(fanout_run_t *run, fanout_job_t *job) {
+    int progress = 0;
+    
+    while (!job->broken && !run->fanout->stopping && job->next_op < run->num_operations &&
+           o1_rpc_pipeline_ready(job->pipeline)) {
+        uint64_t message_id;
+        uint64_t sent = now_ns();
+        if (o1_rpc_pipeline_submit(job->pipeline, run->operations[job->next_op],
+                                   handle_reply, job, &message_id) != 0) {
+            job->broken = 1;
+            break;
+        }
+        job->sent_ns[o1_rpc_pipeline_slot(job->pipeline, message_id)] = sent;
+        job->next_op++;
+        progress++;
+    }
+    
+    int ret;
+    while ((ret = o1_rpc_pipeline_poll(job->pipeline, 0)) > 0) {
+        progress++;
+    }
+    if (ret < 0) {
+        job->broken = 1;
+    }
+    
+    return progress;
+}
+
+static int job_finished(const fanout_run_t *run, const fanout_job_t *job) {
+    if (o1_rpc_pipeline_outstanding(job->pipeline) > 0) {
+        return 0;
+    }
+    return job->broken || run->fanout->stopping || job->next_op == run->num_operations;
+}
+
+static void finish_job(fanout_run_t *run, fanout_job_t *job) {
+    o1_fanout_result_t *result = job->result;
+    
+    // Operations never sent count as failed
+    result->failed += (int)(run->num_operations - job->next_op);
+    result->latency_ns = now_ns() - job->start_ns;
+    o1_hist_record(&job->loop->target_latency, result->latency_ns);
+    
+    o1_rpc_pipeline_destroy(job->pipeline);
+    o1_client_pool_release(run->fanout->pool, job->session, !job->broken && result->failed == 0);
+    free(job);
+    
+    pthread_mutex_lock(&run->lock);
+    run->active--;
+    run->done++;
+    pthread_cond_broadcast(&run->changed);
+    pthread_mutex_unlock(&run->lock);
+}
+
+// Event loop: one pass over every session of this loop sends and collects
+// without blocking, so a slow target never holds up the others
+static void *loop_thread(void *arg) {
+    fanout_loop_t *loop = arg;
+    fanout_run_t *run = loop->run;
+    const struct timespec idle = {0, IDLE_SLEEP_NS};
+    
+    for (;;) {
+        pthread_mutex_lock(&run->lock);
+        while (loop->num_jobs == 0 && loop->inbox_len == 0 && !run_finished(run)) {
+            pthread_cond_wait(&run->changed, &run->lock);
+        }
+        if (loop->num_jobs == 0 && loop->inbox_len == 0) {
+            pthread_mutex_unlock(&run->lock);
+            break;
+        }
+        memcpy(loop->jobs + loop->num_jobs, loop->inbox, loop->inbox_len * sizeof(*loop->jobs));
+        loop->num_jobs += loop->inbox_len;
+        loop->inbox_len = 0;
+        pthread_mutex_unlock(&run->lock);
+        
+        int progress = 0;
+        for (int i = 0; i < loop->num_jobs;) {
+            fanout_job_t *job = loop->jobs[i];
+            progress += drive_job(run, job);
+            if (job_finished(run, job)) {
+                finish_job(run, job);
+                loop->jobs[i] = loop->jobs[--loop->num_jobs];
+                progress++;
+            } else {
+                i++;
+            }
+        }
+        
+        if (progress == 0) {
+            nanosleep(&idle, NULL);
+        }
+    }
+    
+    return NULL;
+}
+
+static void fill_report(const fanout_run_t *run, uint64_t start_ns, o1_fanout_report_t *report) {
+    report->targets = run->count;
+    report->targets_ok = 0;
+    report->ok = report->errors = report->failed = 0;
+    o1_hist_init(&report->rpc_latency);
+    o1_hist_init(&report->target_latency);
+    
+    for (size_t i = 0; i < run->count; i++) {
+        const o1_fanout_result_t *result = &run->results[i];
+        report->ok += result->ok;
+        report->errors += result->errors;
+        report->failed += result->failed;
+        if (result->ok == (int)run->num_operations) {
+            report->targets_ok++;
+        }
+    }
+    for (int i = 0; i < run->num_loops; i++) {
+        o1_hist_merge(&report->rpc_latency, &run->loops[i].rpc_latency);
+        o1_hist_merge(&report->target_latency, &run->loops[i].target_latency);
+    }
+    
+    report->seconds = (now_ns() - start_ns) / 1e9;
+    report->rpcs_per_second = report->seconds > 0 ?
+        (report->ok + report->errors) / report->seconds : 0;
+}
+
+// Send every operation, in order, to every target and wait for the
+// replies. Per-target outcomes land in results, totals in report. Returns
+// 0 once the run is over, whatever its RPCs returned; -1 if it could not
+// start.
+int o1_fanout_run(o1_fanout_t *fanout, o1_fanout_result_t *results, size_t count,
+                  const char *const *operations, size_t num_operations,
+                  o1_fanout_report_t *report) {
+    if (!fanout || (!results && count > 0) || !operations || num_operations == 0 || !report) {
+        return -1;
+    }
+    
+    const o1_fanout_config_t *config = &fanout->config;
+    fanout_run_t run;
+    memset(&run, 0, sizeof(run));
+    run.fanout = fanout;
+    run.results = results;
+    run.count = count;
+    run.operations = operations;
+    run.num_operations = num_operations;
+    run.num_loops = config->loop_threads;
+    
+    for (size_t i = 0; i < count; i++) {
+        results[i].ok = results[i].errors = results[i].failed = 0;
+        results[i].connect_ns = results[i].latency_ns = results[i].max_rpc_ns = 0;
+    }
+    
+    // Each loop can hold at most max_active jobs between its inbox and its list
+    run.loops = calloc(run.num_loops, sizeof(*run.loops));
+    fanout_job_t **slots = calloc(2 * (size_t)run.num_loops * config->max_active, sizeof(*slots));
+    pthread_t *connectors = calloc(config->connect_threads, sizeof(*connectors));
+    if (!run.loops || !slots || !connectors) {
+        free(run.loops);
+        free(slots);
+        free(connectors);
+        return -1;
+    }
+    pthread_mutex_init(&run.lock, NULL);
+    pthread_cond_init(&run.changed, NULL);
+    
+    uint64_t start = now_ns();
+    int loops_started = 0;
+    int connectors_started = 0;
+    
+    for (int i = 0; i < run.num_loops; i++) {
+        fanout_loop_t *loop = &run.loops[i];
+        loop->run = &run;
+        loop->inbox = slots + 2 * (size_t)i * config->max_active;
+        loop->jobs = loop->inbox + config->max_active;
+        o1_hist_init(&loop->rpc_latency);
+        o1_hist_init(&loop->target_latency);
+    }
+    for (int i = 0; i < run.num_loops; i++) {
+        if (pthread_create(&run.loops[i].thread, NULL, loop_thread, &run.loops[i]) != 0) {
+            break;
+        }
+        loops_started++;
+    }
+    if (loops_started == run.num_loops) {
+        for (int i = 0; i < config->connect_threads && (size_t)i < count; i++) {
+            if (pthread_create(&connectors[i], NULL, connect_thread, &run) != 0) {
+                break;
+            }
+            connectors_started++;
+        }
+    }
+    
+    int ret = 0;
+    if (loops_started < run.num_loops || (connectors_started == 0 && count > 0)) {
+        // Nothing was handed out yet: end the run before any target starts
+        fprintf(stderr, "Failed to start fan-out threads\n");
+        pthread_mutex_lock(&run.lock);
+        run.count = run.next_target;
+        pthread_cond_broadcast(&run.changed);
+        pthread_mutex_unlock(&run.lock);
+        ret = -1;
+    }
+    
+    for (int i = 0; i < connectors_started; i++) {
+        pthread_join(connectors[i], NULL);
+    }
+    for (int i = 0; i < loops_started; i++) {
+        pthread_join(run.loops[i].thread, NULL);
+    }
+    
+    // Targets a stop kept from starting
+    run.count = count;
+    for (size_t i = run.next_target; i < count; i++) {
+        results[i].failed = (int)num_operations;
+    }
+    fill_report(&run, start, report);
+    
+    pthread_cond_destroy(&run.changed);
+    pthread_mutex_destroy(&run.lock);
+    free(connectors);
+    free(slots);
+    free(run.loops);
+    return ret;
+}
+
+// The common case: one edit-config of the running datastore, with config
+// as the content of its <config> element, applied to every target
+int o1_fanout_edit_config(o1_fanout_t *fanout, o1_fanout_result_t *results, size_t count,
+                          const char *config, o1_fanout_report_t *report) {
+    if (!config) {
+        return -1;
+    }
+    
+    o1_buf_t buf;
+    o1_buf_init(&buf);
+    if (o1_buf_printf(&buf,
+            "  <edit-config>\n"
+            "    <target>\n"
+            "      <running/>\n"
+            "    </target>\n"
+            "    <config>\n"
+            "%s"
+            "    </config>\n"
+            "  </edit-config>\n", config) != 0) {
+        o1_buf_free(&buf);
+        return -1;
+    }
+    
+    const char *operation = buf.data;
+    int ret = o1_fanout_run(fanout, results, count, &operation, 1, report);
+    o1_buf_free(&buf);
+    return ret;
+}
@@ -0,0 +1,70 @@
+#ifndef O1_FANOUT_H
+#define O1_FANOUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "o1_client_pool.h"
+#include "o1_hist.h"
+#include "o1_rpc_pipeline.h"
+
+// Fan-out of the same RPCs to many NETCONF servers from one process.
+//
+// Sessions come from an o1_client_pool, so a target seen in an earlier run
+// is reached without a new handshake. A few connect threads do the SSH
+// handshakes; established sessions are handed to a small set of event-loop
+// threads, each of which drives all of its targets' RPC pipelines without
+// blocking on any one of them. At most max_active targets have a session
+// checked out at once and at most per_target RPCs are in flight to any one
+// target. Nothing is global: several fan-outs may run side by side.
+
+typedef struct o1_fanout o1_fanout_t;
+
+typedef struct {
+    int loop_threads;       // event-loop threads the targets are spread over
+    int connect_threads;    // SSH handshakes in progress at once
+    int max_active;         // targets with a session checked out at once
+    int per_target;         // RPCs in flight per target
+} o1_fanout_config_t;
+
+#define O1_FANOUT_DEFAULT_LOOP_THREADS 2
+#define O1_FANOUT_DEFAULT_CONNECT_THREADS 16
+#define O1_FANOUT_DEFAULT_MAX_ACTIVE 256
+#define O1_FANOUT_DEFAULT_PER_TARGET 4
+
+// One target of a run: the caller fills in target, the run the rest
+typedef struct {
+    o1_client_target_t target;
+    int ok;                 // RPCs answered without <rpc-error>
+    int errors;             // RPCs answered with <rpc-error>
+    int failed;             // not sent, timed out, or no session
+    uint64_t connect_ns;    // acquiring the session; small when it was pooled
+    uint64_t latency_ns;    // acquire start to the last reply
+    uint64_t max_rpc_ns;    // slowest RPC
+} o1_fanout_result_t;
+
+typedef struct {
+    size_t targets;
+    size_t targets_ok;      // every RPC answered without <rpc-error>
+    uint64_t ok;
+    uint64_t errors;
+    uint64_t failed;
+    double seconds;         // wall time of the run
+    double rpcs_per_second; // answered RPCs over the wall time
+    o1_hist_t rpc_latency;  // per RPC, send to reply, ns
+    o1_hist_t target_latency; // per connected target, latency_ns
+} o1_fanout_report_t;
+
+// Function declarations
+void o1_fanout_default_config(o1_fanout_config_t *config);
+o1_fanout_t *o1_fanout_create(const o1_fanout_config_t *config, o1_client_pool_t *pool);
+void o1_fanout_destroy(o1_fanout_t *fanout);
+void o1_fanout_stop(o1_fanout_t *fanout);
+
+int o1_fanout_run(o1_fanout_t *fanout, o1_fanout_result_t *results, size_t count,
+                  const char *const *operations, size_t num_operations,
+                  o1_fanout_report_t *report);
+int o1_fanout_edit_config(o1_fanout_t *fanout, o1_fanout_result_t *results, size_t count,
+                          const char *config, o1_fanout_report_t *report);
+
+#endif // O1_FANOUT_H
@@ -0,0 +1,474 @@
+#include <string.h>
+
+#include "o1_filter.h"
+
+// Where a leaf sits below the interface entry
+typedef enum {
+    GROUP_ENTRY,
+    GROUP_TRACING,
+    GROUP_STATISTICS,
+    GROUP_COUNT
+} leaf_group_t;
+
+#define LEAF(name, group) { name, O1_REPLY_TAG(name), group }
+
+static const struct {
+    const char *name;
+    o1_reply_tag_t tag;
+    leaf_group_t group;
+} leaf_table[O1_LEAF_COUNT] = {
+    LEAF("name",        GROUP_ENTRY),
+    LEAF("status",      GROUP_ENTRY),
+    LEAF("traceid",     GROUP_TRACING),
+    LEAF("spanid",      GROUP_TRACING),
+    LEAF("timestamp",   GROUP_TRACING),
+    LEAF("packets-in",  GROUP_STATISTICS),
+    LEAF("packets-out", GROUP_STATISTICS),
+    LEAF("bytes-in",    GROUP_STATISTICS),
+    LEAF("bytes-out",   GROUP_STATISTICS),
+};
+
+static const char *group_names[GROUP_COUNT] = { NULL, "tracing", "statistics" };
+static const o1_reply_tag_t group_tags[GROUP_COUNT] = {
+    { 0 }, O1_REPLY_TAG("tracing"), O1_REPLY_TAG("statistics")
+};
+
+static const o1_reply_tag_t tag_data = O1_REPLY_TAG("data");
+static const o1_reply_tag_t tag_o1_interface = O1_REPLY_TAG_NS("o1-interface", O1_NS_INTERFACE);
+static const o1_reply_tag_t tag_interface = O1_REPLY_TAG("interface");
+
+static int find_leaf(o1_str_t name, leaf_group_t group) {
+    for (int i = 0; i < O1_LEAF_COUNT; i++) {
+        if (leaf_table[i].group == group && o1_str_eq(name, leaf_table[i].name)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int find_group(o1_str_t name) {
+    for (int g = GROUP_ENTRY + 1; g < GROUP_COUNT; g++) {
+        if (o1_str_eq(name, group_names[g])) {
+            return g;
+        }
+    }
+    return -1;
+}
+
+static unsigned group_bits(int group) {
+    unsigned bits = 0;
+    for (int i = 0; i < O1_LEAF_COUNT; i++) {
+        if ((int)leaf_table[i].group == group) {
+            bits |= O1_LEAF_BIT(i);
+        }
+    }
+    return bits;
+}
+
+// An entry with only content match nodes returns everything; otherwise
+// the selected leaves, the matched leaves and the key
+static void finish_entry(o1_filter_entry_t *entry) {
+    if (entry->select == 0) {
+        entry->select = O1_LEAF_ALL;
+    } else {
+        entry->select |= entry->match | O1_LEAF_BIT(O1_LEAF_NAME);
+    }
+}
+
+// Compile the <filter> of a get-config or get. Without a filter everything
+// is selected. Returns 0, or -1 for malformed XML, a non-subtree filter or
+// more than O1_FILTER_MAX_ENTRIES entries.
+int o1_filter_parse(const char *xml, size_t len, o1_filter_t *filter) {
+    o1_xml_reader_t reader;
+    o1_xml_token_t token;
+    o1_filter_entry_t *entry = NULL;
+    int filter_depth = -1;
+    int o1_depth = -1;
+    int o1_children = 0;
+    int entry_depth = -1;
+    int group = -1;
+    int group_depth = -1;
+    int group_children = 0;
+    int leaf = -1;
+    int leaf_depth = -1;
+    int leaf_text = 0;
+    int skip_depth = -1;
+    int select_all = 0;
+    
+    if (!xml || !filter) {
+        return -1;
+    }
+    
+    filter->scope = O1_FILTER_ALL;
+    filter->count = 0;
+    
+    o1_xml_reader_init(&reader, xml, len);
+    while (o1_xml_next(&reader, &token) != O1_XML_EOF) {
+        if (token.type == O1_XML_ERROR) {
+            return -1;
+        }
+        
+        // Subtrees the filter does not understand select nothing
+        if (skip_depth >= 0) {
+            if (token.type == O1_XML_END && token.depth == skip_depth) {
+                skip_depth = -1;
+            }
+            continue;
+        }
+        
+        switch (token.type) {
+        case O1_XML_START:
+        case O1_XML_EMPTY: {
+            int empty = token.type == O1_XML_EMPTY;
+            
+            if (filter_depth < 0) {
+                // rpc / get-config / filter
+                if (token.depth == 2 && o1_xml_is(&token, O1_NS_NETCONF, "filter")) {
+                    o1_str_t type;
+                    if (o1_xml_attr(&token, "type", &type) == 0 && !o1_str_eq(type, "subtree")) {
+                        return -1;
+                    }
+                    if (empty) {
+                        filter->scope = O1_FILTER_NONE;
+                        return 0;
+                    }
+                    filter_depth = token.depth;
+                }
+                break;
+            }
+            
+            if (token.depth == filter_depth + 1) {
+                if (!o1_xml_is(&token, O1_NS_INTERFACE, "o1-interface")) {
+                    skip_depth = empty ? -1 : token.depth;
+                } else if (empty) {
+                    select_all = 1;
+                } else {
+                    o1_depth = token.depth;
+                    o1_children = 0;
+                }
+                break;
+            }
+            
+            if (o1_depth >= 0 && token.depth == o1_depth + 1) {
+                o1_children++;
+                if (!o1_str_eq(token.ns, O1_NS_INTERFACE)) {
+                    skip_depth = empty ? -1 : token.depth;
+                    break;
+                }
+                if (o1_str_eq(token.name, "interface")) {
+                    if (empty) {
+                        select_all = 1;
+                        break;
+                    }
+                    if (filter->count == O1_FILTER_MAX_ENTRIES) {
+                        return -1;
+                    }
+                    entry = &filter->entries[filter->count++];
+                    memset(entry, 0, sizeof(*entry));
+                    entry_depth = token.depth;
+                    break;
+                }
+                
+                // Leaves directly under o1-interface: the single-entry form
+                // older clients send; o1-interface itself is the entry
+                if (entry_depth != o1_depth) {
+                    if (filter->count == O1_FILTER_MAX_ENTRIES) {
+                        return -1;
+                    }
+                    entry = &filter->entries[filter->count++];
+                    memset(entry, 0, sizeof(*entry));
+                    entry_depth = o1_depth;
+                }
+            }
+            
+            int idx = -1;
+            if (entry && token.depth == entry_depth + 1) {
+                idx = find_leaf(token.name, GROUP_ENTRY);
+                if (idx < 0) {
+                    int g = find_group(token.name);
+                    if (g < 0) {
+                        skip_depth = empty ? -1 : token.depth;
+                    } else if (empty) {
+                        entry->select |= group_bits(g);
+                    } else {
+                        group = g;
+                        group_depth = token.depth;
+                        group_children = 0;
+                    }
+                    break;
+                }
+            } else if (entry && group_depth >= 0 && token.depth == group_depth + 1) {
+                group_children++;
+                idx = find_leaf(token.name, group);
+                if (idx < 0) {
+                    skip_depth = empty ? -1 : token.depth;
+                    break;
+                }
+            } else {
+                skip_depth = empty ? -1 : token.depth;
+                break;
+            }
+            
+            // An empty leaf is a selection node; one with text a content match
+            if (empty) {
+                entry->select |= O1_LEAF_BIT(idx);
+            } else {
+                leaf = idx;
+                leaf_depth = token.depth;
+                leaf_text = 0;
+            }
+            break;
+        }
+        
+        case O1_XML_TEXT:
+            if (leaf >= 0 && token.depth == leaf_depth + 1) {
+                entry->match |= O1_LEAF_BIT(leaf);
+                entry->value[leaf] = token.text;
+                leaf_text = 1;
+            }
+            break;
+        
+        case O1_XML_END:
+            if (leaf >= 0 && token.depth == leaf_depth) {
+                if (!leaf_text) {
+                    entry->select |= O1_LEAF_BIT(leaf);
+                }
+                leaf = -1;
+                break;
+            }
+            if (group_depth >= 0 && token.depth == group_depth) {
+                if (!group_children) {
+                    entry->select |= group_bits(group);
+                }
+                group_depth = -1;
+                break;
+            }
+            if (entry && token.depth == entry_depth) {
+                finish_entry(entry);
+                entry = NULL;
+                entry_depth = -1;
+            }
+            if (token.depth == o1_depth) {
+                // <o1-interface></o1-interface> is a selection node too
+                if (!o1_children) {
+                    select_all = 1;
+                }
+                o1_depth = -1;
+            }
+            if (token.depth == filter_depth) {
+                filter->scope = select_all ? O1_FILTER_ALL :
+                                filter->count ? O1_FILTER_ENTRIES : O1_FILTER_NONE;
+                return 0;
+            }
+            break;
+        
+        default:
+            break;
+        }
+    }
+    
+    // A <filter> that never closed is malformed
+    return filter_depth >= 0 ? -1 : 0;
+}
+
+// Value of a numeric leaf: the timestamp and the statistics counters
+static uint64_t leaf_number(const o1_interface_record_t *record, int leaf) {
+    switch (leaf) {
+    case O1_LEAF_TIMESTAMP:
+        return record->timestamp;
+    case O1_LEAF_PACKETS_IN:
+        return record->packets_in;
+    case O1_LEAF_PACKETS_OUT:
+        return record->packets_out;
+    case O1_LEAF_BYTES_IN:
+        return record->bytes_in;
+    default:
+        return record->bytes_out;
+    }
+}
+
+// Text of a leaf, formatted into scratch when numeric. Returns -1 for a
+// leaf that has no value (tracing IDs never written).
+static int leaf_value(const o1_interface_record_t *record, int leaf, char *scratch, size_t size,
+                      o1_str_t *value) {
+    switch (leaf) {
+    case O1_LEAF_NAME:
+        value->ptr = record->name;
+        value->len = record->name_len;
+        return 0;
+    case O1_LEAF_STATUS:
+        value->ptr = o1_if_status_name(record->status);
+        value->len = strlen(value->ptr);
+        return 0;
+    case O1_LEAF_TRACEID:
+    case O1_LEAF_SPANID:
+        value->ptr = leaf == O1_LEAF_TRACEID ? record->traceid : record->spanid;
+        value->len = strlen(value->ptr);
+        return value->len ? 0 : -1;
+    default:
+        break;
+    }
+    
+    // Digits written backwards from the end of scratch
+    uint64_t number = leaf_number(record, leaf);
+    char *p = scratch + size;
+    do {
+        *--p = (char)('0' + number % 10);
+        number /= 10;
+    } while (number);
+    
+    value->ptr = p;
+    value->len = (size_t)(scratch + size - p);
+    return 0;
+}
+
+static int entry_matches(const o1_filter_entry_t *entry, const o1_interface_record_t *record) {
+    char scratch[24];
+    o1_str_t value;
+    
+    for (int i = 0; i < O1_LEAF_COUNT; i++) {
+        if (!(entry->match & O1_LEAF_BIT(i))) {
+            continue;
+        }
+        if (leaf_value(record, i, scratch, sizeof(scratch), &value) != 0 ||
+            value.len != entry->value[i].len ||
+            memcmp(value.ptr, entry->value[i].ptr, value.len) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Union of what every matching filter entry selects
+static unsigned record_selection(const o1_filter_t *filter, const o1_interface_record_t *record) {
+    unsigned select = 0;
+    
+    for (size_t i = 0; i < filter->count; i++) {
+        if (entry_matches(&filter->entries[i], record)) {
+            select |= filter->entries[i].select;
+        }
+    }
+    return select;
+}
+
+static int render_record(o1_reply_t *out, const o1_interface_record_t *record, unsigned select) {
+    char scratch[24];
+    o1_str_t value;
+    int ret = o1_reply_open(out, &tag_interface);
+    
+    for (int g = GROUP_ENTRY; g < GROUP_COUNT && ret == 0; g++) {
+        if (!(select & group_bits(g))) {
+            continue;
+        }
+        
+        if (g != GROUP_ENTRY) {
+            ret = o1_reply_open(out, &group_tags[g]);
+        }
+        for (int i = 0; i < O1_LEAF_COUNT && ret == 0; i++) {
+            if ((int)leaf_table[i].group != g || !(select & O1_LEAF_BIT(i))) {
+                continue;
+            }
+            if (i >= O1_LEAF_TIMESTAMP) {
+                // Numbers are converted straight into the reply
+                ret = o1_reply_leaf_u64(out, &leaf_table[i].tag, leaf_number(record, i));
+            } else if (leaf_value(record, i, scratch, sizeof(scratch), &value) == 0) {
+                ret = o1_reply_leaf(out, &leaf_table[i].tag, value.ptr, value.len);
+            }
+        }
+        if (g != GROUP_ENTRY && ret == 0) {
+            ret = o1_reply_close(out, &group_tags[g]);
+        }
+    }
+    
+    if (ret == 0) {
+        ret = o1_reply_close(out, &tag_interface);
+    }
+    return ret;
+}
+
+// Emit one selected record, opening <data> on the first
+static int emit(o1_reply_t *out, const o1_interface_record_t *record, unsigned select,
+                size_t *emitted) {
+    if (*emitted == 0 &&
+        (o1_reply_open(out, &tag_data) != 0 || o1_reply_open(out, &tag_o1_interface) != 0)) {
+        return -1;
+    }
+    (*emitted)++;
+    return render_record(out, record, select);
+}
+
+// Reads from the datastore being answered: running through the view, or
+// the candidate over it
+static int source_get(const o1_ds_view_t *view, const o1_candidate_t *candidate,
+                      const o1_str_t *name, o1_interface_record_t *record) {
+    return candidate ? o1_candidate_get(candidate, view, name->ptr, name->len, record) :
+                       o1_datastore_view_get(view, name->ptr, name->len, record);
+}
+
+static size_t source_count(const o1_ds_view_t *view, const o1_candidate_t *candidate) {
+    return candidate ? o1_candidate_count(candidate, view) : o1_datastore_view_count(view);
+}
+
+static int source_read(const o1_ds_view_t *view, const o1_candidate_t *candidate, size_t index,
+                       o1_interface_record_t *record) {
+    return candidate ? o1_candidate_read(candidate, view, index, record) :
+                       o1_datastore_view_read(view, index, record);
+}
+
+// Add the <data> element answering filter to the reply, reading running
+// through view, or the candidate when one is given. Returns the number of
+// interfaces included, or -1 if the reply could not grow.
+int o1_filter_render(const o1_filter_t *filter, const o1_ds_view_t *view,
+                     const o1_candidate_t *candidate, o1_reply_t *out) {
+    o1_interface_record_t record;
+    size_t emitted = 0;
+    int keyed = filter->scope == O1_FILTER_ENTRIES;
+    
+    for (size_t i = 0; i < filter->count && keyed; i++) {
+        keyed = (filter->entries[i].match & O1_LEAF_BIT(O1_LEAF_NAME)) != 0;
+    }
+    
+    if (keyed) {
+        // Every entry names its interface: one index lookup each
+        for (size_t i = 0; i < filter->count; i++) {
+            const o1_str_t *key = &filter->entries[i].value[O1_LEAF_NAME];
+            if (source_get(view, candidate, key, &record) != 0) {
+                continue;
+            }
+            
+            // Already emitted for an earlier entry naming the same interface
+            int seen = 0;
+            for (size_t j = 0; j < i && !seen; j++) {
+                seen = entry_matches(&filter->entries[j], &record);
+            }
+            unsigned select = seen ? 0 : record_selection(filter, &record);
+            if (select && emit(out, &record, select, &emitted) != 0) {
+                return -1;
+            }
+        }
+    } else if (filter->scope != O1_FILTER_NONE) {
+        // Indexes the candidate has nothing at are skipped
+        size_t count = source_count(view, candidate);
+        for (size_t i = 0; i < count; i++) {
+            if (source_read(view, candidate, i, &record) != 0) {
+                continue;
+            }
+            unsigned select = filter->scope == O1_FILTER_ALL ? O1_LEAF_ALL :
+                              record_selection(filter, &record);
+            if (select && emit(out, &record, select, &emitted) != 0) {
+                return -1;
+            }
+        }
+    }
+    
+    int ret = 0;
+    if (emitted) {
+        ret = o1_reply_close(out, &tag_o1_interface);
+        if (ret == 0) {
+            ret = o1_reply_close(out, &tag_data);
+        }
+    } else {
+        ret = o1_reply_empty(out, &tag_data);
+    }
+    return ret == 0 ? (int)emitted : -1;
+}
@@ -0,0 +1,62 @@
+#ifndef O1_FILTER_H
+#define O1_FILTER_H
+
+#include <stddef.h>
+
+#include "o1_candidate.h"
+#include "o1_datastore.h"
+#include "o1_reply.h"
+#include "o1_xml.h"
+
+// NETCONF subtree filtering (RFC 6241, section 6) of the o1-interface
+// list. A <filter> is compiled once into per-entry match/select masks and
+// then evaluated against running, or the candidate over it, through one
+// pinned view, so a commit never lands halfway through a reply. Entries
+// with a <name> key match are answered through the datastore's hash
+// index, so their cost does not depend on how many interfaces are stored.
+// Only entries without a key fall back to a scan.
+
+#define O1_FILTER_MAX_ENTRIES 64
+
+// Leaves of a list entry, in schema order
+typedef enum {
+    O1_LEAF_NAME,
+    O1_LEAF_STATUS,
+    O1_LEAF_TRACEID,
+    O1_LEAF_SPANID,
+    O1_LEAF_TIMESTAMP,
+    O1_LEAF_PACKETS_IN,
+    O1_LEAF_PACKETS_OUT,
+    O1_LEAF_BYTES_IN,
+    O1_LEAF_BYTES_OUT,
+    O1_LEAF_COUNT
+} o1_leaf_t;
+
+#define O1_LEAF_BIT(leaf) (1u << (leaf))
+#define O1_LEAF_ALL ((1u << O1_LEAF_COUNT) - 1)
+
+typedef enum {
+    O1_FILTER_NONE,     // the filter selects nothing from o1-interface
+    O1_FILTER_ALL,      // no filter, or o1-interface/interface as a selection node
+    O1_FILTER_ENTRIES   // one or more interface entry filters
+} o1_filter_scope_t;
+
+// One <interface> node of the filter
+typedef struct {
+    unsigned match;                 // leaves that are content match nodes
+    unsigned select;                // leaves to return for matching entries
+    o1_str_t value[O1_LEAF_COUNT];  // content match values, views into the request
+} o1_filter_entry_t;
+
+typedef struct {
+    o1_filter_scope_t scope;
+    size_t count;
+    o1_filter_entry_t entries[O1_FILTER_MAX_ENTRIES];
+} o1_filter_t;
+
+// Function declarations
+int o1_filter_parse(const char *xml, size_t len, o1_filter_t *filter);
+int o1_filter_render(const o1_filter_t *filter, const o1_ds_view_t *view,
+                     const o1_candidate_t *candidate, o1_reply_t *out);
+
+#endif // O1_FILTER_H
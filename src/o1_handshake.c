@@ -0,0 +1,194 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "o1_handshake.h"
+#include "o1_metrics.h"
+
+// An accepted socket and when it was queued
+typedef struct {
+    int fd;
+    uint64_t queued_at;
+} o1_handshake_entry_t;
+
+struct o1_handshake_pool {
+    o1_handshake_config_t config;
+    o1_handshake_done_t done;
+    void *arg;
+    
+    // Bounded queue of sockets, protected by lock
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    o1_handshake_entry_t *queue;
+    int head;
+    int queued;
+    int in_progress;
+    volatile int running;
+    
+    pthread_t *threads;
+    int started;
+};
+
+void o1_handshake_default_config(o1_handshake_config_t *config) {
+    config->num_threads = O1_HANDSHAKE_DEFAULT_THREADS;
+    config->queue_size = O1_HANDSHAKE_DEFAULT_QUEUE_SIZE;
+    config->max_wait = O1_HANDSHAKE_DEFAULT_MAX_WAIT;
+}
+
+// Run one handshake to completion and pass the session on
+static void handshake(o1_handshake_pool_t *pool, int fd) {
+    struct nc_session *session = NULL;
+    uint64_t start = o1_metrics_now();
+    
+    int ret = nc_accept_ssh(fd, NULL, NULL, &session);
+    o1_metrics_handshake(o1_metrics_now() - start, ret != NC_MSG_HELLO);
+    if (ret != NC_MSG_HELLO) {
+        log_warn("Failed to accept NETCONF session: %s", nc_strerror(ret));
+        o1_metrics_add(O1_METRIC_SESSIONS_REJECTED, 1);
+        close(fd);
+        return;
+    }
+    
+    log_info("NETCONF session established with client");
+    if (pool->done(session, fd, pool->arg) != 0) {
+        nc_session_free(session, NULL);
+        close(fd);
+    }
+}
+
+static void *handshake_thread_main(void *arg) {
+    o1_handshake_pool_t *pool = arg;
+    uint64_t max_wait_ns = (uint64_t)pool->config.max_wait * 1000000ULL;
+    
+    pthread_mutex_lock(&pool->lock);
+    while (pool->running) {
+        if (pool->queued == 0) {
+            pthread_cond_wait(&pool->not_empty, &pool->lock);
+            continue;
+        }
+        
+        o1_handshake_entry_t entry = pool->queue[pool->head];
+        pool->head = (pool->head + 1) % pool->config.queue_size;
+        pool->queued--;
+        pool->in_progress++;
+        pthread_mutex_unlock(&pool->lock);
+        
+        o1_metrics_add(O1_METRIC_HANDSHAKES_DEQUEUED, 1);
+        if (max_wait_ns > 0 && o1_metrics_now() - entry.queued_at > max_wait_ns) {
+            log_warn("Dropping connection after %d ms in the handshake queue", pool->config.max_wait);
+            o1_metrics_add(O1_METRIC_HANDSHAKES_SHED, 1);
+            close(entry.fd);
+        } else {
+            handshake(pool, entry.fd);
+        }
+        
+        pthread_mutex_lock(&pool->lock);
+        pool->in_progress--;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    
+    return NULL;
+}
+
+o1_handshake_pool_t *o1_handshake_pool_create(const o1_handshake_config_t *config,
+                                              o1_handshake_done_t done, void *arg) {
+    if (!config || !done || config->num_threads < 1 || config->queue_size < 1 ||
+        config->max_wait < 0) {
+        return NULL;
+    }
+    
+    o1_handshake_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool) {
+        return NULL;
+    }
+    
+    pool->config = *config;
+    pool->done = done;
+    pool->arg = arg;
+    pool->running = 1;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->not_empty, NULL);
+    
+    pool->queue = calloc(config->queue_size, sizeof(*pool->queue));
+    pool->threads = calloc(config->num_threads, sizeof(*pool->threads));
+    if (!pool->queue || !pool->threads) {
+        o1_handshake_pool_destroy(pool);
+        return NULL;
+    }
+    
+    for (int i = 0; i < config->num_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, handshake_thread_main, pool) != 0) {
+            fprintf(stderr, "Failed to start handshake thread %d\n", i);
+            o1_handshake_pool_destroy(pool);
+            return NULL;
+        }
+        pool->started++;
+    }
+    
+    printf("Handshake pool started: %d threads, queue %d, max wait %d ms\n",
+           config->num_threads, config->queue_size, config->max_wait);
+    return pool;
+}
+
+// Queue an accepted socket for its handshake. Fails when the queue is full;
+// the caller keeps the socket in that case.
+int o1_handshake_submit(o1_handshake_pool_t *pool, int fd) {
+    if (!pool || fd < 0) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    if (!pool->running || pool->queued == pool->config.queue_size) {
+        pthread_mutex_unlock(&pool->lock);
+        o1_metrics_add(O1_METRIC_HANDSHAKES_SHED, 1);
+        return -1;
+    }
+    
+    int tail = (pool->head + pool->queued) % pool->config.queue_size;
+    pool->queue[tail].fd = fd;
+    pool->queue[tail].queued_at = o1_metrics_now();
+    pool->queued++;
+    pthread_cond_signal(&pool->not_empty);
+    pthread_mutex_unlock(&pool->lock);
+    
+    o1_metrics_add(O1_METRIC_HANDSHAKES_QUEUED, 1);
+    return 0;
+}
+
+// Connections queued or in their handshake
+int o1_handshake_pending(o1_handshake_pool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+    int pending = pool->queued + pool->in_progress;
+    pthread_mutex_unlock(&pool->lock);
+    return pending;
+}
+
+// Waits for handshakes in progress; sockets still queued are closed
+void o1_handshake_pool_destroy(o1_handshake_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->running = 0;
+    pthread_cond_broadcast(&pool->not_empty);
+    pthread_mutex_unlock(&pool->lock);
+    
+    for (int i = 0; i < pool->started; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    
+    while (pool->queued > 0) {
+        close(pool->queue[pool->head].fd);
+        pool->head = (pool->head + 1) % pool->config.queue_size;
+        pool->queued--;
+    }
+    
+    free(pool->threads);
+    free(pool->queue);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->not_empty);
+    free(pool);
+}
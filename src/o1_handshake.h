@@ -0,0 +1,44 @@
+#ifndef O1_HANDSHAKE_H
+#define O1_HANDSHAKE_H
+
+// NETCONF includes
+#include <libnetconf2/netconf.h>
+#include <libnetconf2/session.h>
+
+// SSH handshakes off the accept and RPC threads.
+//
+// The acceptor only queues the new socket. A small, fixed set of handshake
+// threads runs the key exchange, authentication and <hello> for each one
+// and hands the established session on through a callback, so session
+// workers never see a connection before it is ready and a burst of
+// reconnects cannot stall RPCs on sessions already open. Admission is
+// bounded: a connection is refused when the queue is full, and one that
+// has waited longer than max_wait is dropped without a handshake, since its
+// client has most likely given up already.
+
+// Called on a handshake thread with an established session. Returns 0 once
+// it has taken the session and socket; otherwise the pool frees both.
+typedef int (*o1_handshake_done_t)(struct nc_session *session, int fd, void *arg);
+
+typedef struct o1_handshake_pool o1_handshake_pool_t;
+
+// Pool configuration
+typedef struct {
+    int num_threads;    // concurrent handshakes
+    int queue_size;     // accepted sockets waiting for a thread
+    int max_wait;       // ms a socket may wait in the queue, 0 for no limit
+} o1_handshake_config_t;
+
+#define O1_HANDSHAKE_DEFAULT_THREADS 2
+#define O1_HANDSHAKE_DEFAULT_QUEUE_SIZE 128
+#define O1_HANDSHAKE_DEFAULT_MAX_WAIT 5000
+
+// Function declarations
+void o1_handshake_default_config(o1_handshake_config_t *config);
+o1_handshake_pool_t *o1_handshake_pool_create(const o1_handshake_config_t *config,
+                                              o1_handshake_done_t done, void *arg);
+int o1_handshake_submit(o1_handshake_pool_t *pool, int fd);
+int o1_handshake_pending(o1_handshake_pool_t *pool);
+void o1_handshake_pool_destroy(o1_handshake_pool_t *pool);
+
+#endif // O1_HANDSHAKE_H
@@ -0,0 +1,146 @@
+#include <math.h>
+#include <string.h>
+
+#include "o1_hist.h"
+
+// Bucket of a value: below 2^(SUB_BITS + 1) every value has its own
+// bucket; above, the value is shifted right until SUB_BITS + 1 bits are
+// left and the shift picks the group of 128
+static int bucket_index(uint64_t value) {
+    int msb = 63 - __builtin_clzll(value | 1);
+    int shift = msb > O1_HIST_SUB_BITS ? msb - O1_HIST_SUB_BITS : 0;
+    return (shift << O1_HIST_SUB_BITS) + (int)(value >> shift);
+}
+
+// Largest value that lands in a bucket
+static uint64_t bucket_value(int index) {
+    int shift = index < (2 << O1_HIST_SUB_BITS) ? 0 : (index >> O1_HIST_SUB_BITS) - 1;
+    uint64_t sub = (uint64_t)(index - (shift << O1_HIST_SUB_BITS));
+    return ((sub + 1) << shift) - 1;
+}
+
+void o1_hist_init(o1_hist_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+    hist->min = UINT64_MAX;
+}
+
+void o1_hist_record(o1_hist_t *hist, uint64_t value) {
+    if (value > O1_HIST_MAX) {
+        value = O1_HIST_MAX;
+    }
+    
+    hist->counts[bucket_index(value)]++;
+    hist->total++;
+    if (value < hist->min) {
+        hist->min = value;
+    }
+    if (value > hist->max) {
+        hist->max = value;
+    }
+    hist->sum += (double)value;
+    hist->sum_squares += (double)value * (double)value;
+}
+
+void o1_hist_merge(o1_hist_t *dst, const o1_hist_t *src) {
+    for (int i = 0; i < O1_HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+    if (src->min < dst->min) {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+    dst->sum += src->sum;
+    dst->sum_squares += src->sum_squares;
+}
+
+// Smallest recorded value (to bucket precision) that `percentile` percent
+// of the values do not exceed; the exact maximum for 100
+uint64_t o1_hist_percentile(const o1_hist_t *hist, double percentile) {
+    if (hist->total == 0) {
+        return 0;
+    }
+    if (percentile >= 100.0) {
+        return hist->max;
+    }
+    
+    uint64_t rank = (uint64_t)ceil(percentile / 100.0 * (double)hist->total);
+    if (rank == 0) {
+        rank = 1;
+    }
+    
+    uint64_t seen = 0;
+    for (int i = 0; i < O1_HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            uint64_t value = bucket_value(i);
+            return value < hist->max ? value : hist->max;
+        }
+    }
+    return hist->max;
+}
+
+double o1_hist_mean(const o1_hist_t *hist) {
+    return hist->total ? hist->sum / (double)hist->total : 0.0;
+}
+
+double o1_hist_stddev(const o1_hist_t *hist) {
+    if (hist->total == 0) {
+        return 0.0;
+    }
+    double mean = o1_hist_mean(hist);
+    double variance = hist->sum_squares / (double)hist->total - mean * mean;
+    return variance > 0 ? sqrt(variance) : 0.0;
+}
+
+// Percentile distribution in HdrHistogram's .hgrm text format, readable by
+// its plotting tools. Values are divided by `unit` (1e3 for microseconds).
+// Percentiles are reported 5 times per halving of the distance to 100%.
+int o1_hist_write_hgrm(const o1_hist_t *hist, FILE *out, double unit) {
+    fprintf(out, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+    
+    if (hist->total > 0) {
+        uint64_t seen = 0;
+        int bucket = 0;
+        
+        for (int half = 0; half < 64; half++) {
+            double base = 1.0 - ldexp(1.0, -half);
+            double step = ldexp(1.0, -half - 1) / 5;
+            int done = 0;
+            
+            for (int tick = 0; tick < 5 && !done; tick++) {
+                double level = base + step * tick;
+                uint64_t rank = (uint64_t)ceil(level * (double)hist->total);
+                if (rank == 0) {
+                    rank = 1;
+                }
+                while (seen < rank && bucket < O1_HIST_BUCKETS) {
+                    seen += hist->counts[bucket++];
+                }
+                uint64_t value = bucket > 0 ? bucket_value(bucket - 1) : 0;
+                if (value > hist->max) {
+                    value = hist->max;
+                }
+                
+                fprintf(out, "%12.3f %2.12f %10llu %14.2f\n", (double)value / unit, level,
+                        (unsigned long long)seen, 1.0 / (1.0 - level));
+                done = seen >= hist->total;
+            }
+            if (done) {
+                break;
+            }
+        }
+        fprintf(out, "%12.3f %2.12f %10llu\n", (double)hist->max / unit, 1.0,
+                (unsigned long long)hist->total);
+    }
+    
+    fprintf(out, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n",
+            o1_hist_mean(hist) / unit, o1_hist_stddev(hist) / unit);
+    fprintf(out, "#[Max     = %12.3f, Total count    = %12llu]\n",
+            (double)hist->max / unit, (unsigned long long)hist->total);
+    fprintf(out, "#[Buckets = %12d, SubBuckets     = %12d]\n",
+            O1_HIST_BUCKETS >> O1_HIST_SUB_BITS, 1 << (O1_HIST_SUB_BITS + 1));
+    return ferror(out) ? -1 : 0;
+}
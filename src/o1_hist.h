@@ -0,0 +1,41 @@
+#ifndef O1_HIST_H
+#define O1_HIST_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Latency histogram in the style of HdrHistogram: log-linear buckets, each
+// power of two split into 128 linear sub-buckets, so every recorded value
+// is kept to within 1/128 (0.8%) of its true value. Recording is an index
+// computation and an increment. Values are nanoseconds from 0 to
+// O1_HIST_MAX (about 18 minutes); larger ones are clamped.
+//
+// Not thread-safe: each thread records into its own histogram and the
+// results are merged with o1_hist_merge().
+
+#define O1_HIST_SUB_BITS 7
+#define O1_HIST_MAX_BITS 40
+#define O1_HIST_BUCKETS ((2 + O1_HIST_MAX_BITS - O1_HIST_SUB_BITS - 1) << O1_HIST_SUB_BITS)
+#define O1_HIST_MAX ((1ULL << O1_HIST_MAX_BITS) - 1)
+
+typedef struct {
+    uint64_t counts[O1_HIST_BUCKETS];
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+    double sum_squares;
+} o1_hist_t;
+
+// Function declarations
+void o1_hist_init(o1_hist_t *hist);
+void o1_hist_record(o1_hist_t *hist, uint64_t value);
+void o1_hist_merge(o1_hist_t *dst, const o1_hist_t *src);
+
+uint64_t o1_hist_percentile(const o1_hist_t *hist, double percentile);
+double o1_hist_mean(const o1_hist_t *hist);
+double o1_hist_stddev(const o1_hist_t *hist);
+
+int o1_hist_write_hgrm(const o1_hist_t *hist, FILE *out, double unit);
+
+#endif // O1_HIST_H
@@ -0,0 +1,538 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// NETCONF includes
+#include <libnetconf2/netconf.h>
+#include <libnetconf2/session.h>
+#include <libnetconf2/messages.h>
+#include <libnetconf2/log.h>
+
+#include "o1_hist.h"
+#include "o1_rpc_pipeline.h"
+#include "trace_id.h"
+
+// Load generator for the O1 NETCONF server. Opens a number of sessions,
+// each driven by its own thread through an RPC pipeline, and sends a
+// weighted mix of get-config, edit-config, get-interface-status and
+// set-interface-status for a fixed time.
+//
+// With a target rate the load is open loop: every session has a send
+// schedule, and the latency of an RPC is measured from the time it was
+// scheduled to go out, not from when the window let it go. A server that
+// stalls is then charged for the requests queued behind the stall instead
+// of hiding them (coordinated omission). Without a rate every session
+// keeps its window full (closed loop) and reports the capacity.
+
+#define DEFAULT_SESSIONS 4
+#define DEFAULT_DURATION 10
+#define DEFAULT_WINDOW 16
+#define DEFAULT_INTERFACES 1000
+#define DEFAULT_MIX "get=60,edit=30,get-status=5,set-status=5"
+
+typedef enum {
+    OP_GET_CONFIG,
+    OP_EDIT_CONFIG,
+    OP_GET_STATUS,
+    OP_SET_STATUS,
+    OP_COUNT
+} op_type_t;
+
+static const char *op_names[OP_COUNT] = { "get", "edit", "get-status", "set-status" };
+
+typedef struct {
+    char host[256];
+    int port;
+    char username[64];
+    char password[64];
+    char private_key_path[256];
+} o1_config_t;
+
+// Results of one operation type
+typedef struct {
+    o1_hist_t latency;     // ok and rpc-error replies, ns
+    uint64_t ok;
+    uint64_t errors;
+    uint64_t failed;
+} op_stats_t;
+
+// One session and the thread that drives it
+typedef struct {
+    int index;
+    struct nc_session *session;
+    o1_rpc_pipeline_t *pipeline;
+    pthread_t thread;
+    uint64_t rng;
+    uint64_t *scheduled;   // scheduled send time by window slot
+    op_type_t *ops;        // operation by window slot
+    op_stats_t stats[OP_COUNT];
+} loadgen_session_t;
+
+// Global variables
+static volatile int running = 1;
+static int num_sessions = DEFAULT_SESSIONS;
+static double rate = 0;
+static int duration = DEFAULT_DURATION;
+static int window = DEFAULT_WINDOW;
+static int num_interfaces = DEFAULT_INTERFACES;
+static int mix[OP_COUNT];
+static int mix_total;
+static uint64_t start_ns;
+
+void signal_handler(int sig) {
+    (void)sig;
+    // Sessions stop sending and wait for what is in flight
+    running = 0;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns) {
+    struct timespec ts = { (time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL) };
+    nanosleep(&ts, NULL);
+}
+
+static uint64_t xorshift(uint64_t *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+// "get=60,edit=30,..." into weights per operation type
+static int parse_mix(const char *spec) {
+    char copy[256];
+    snprintf(copy, sizeof(copy), "%s", spec);
+    memset(mix, 0, sizeof(mix));
+    mix_total = 0;
+    
+    char *save = NULL;
+    for (char *item = strtok_r(copy, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(item, '=');
+        if (!eq) {
+            fprintf(stderr, "Bad mix entry '%s', expected name=weight\n", item);
+            return -1;
+        }
+        *eq = '\0';
+        
+        int op = 0;
+        while (op < OP_COUNT && strcmp(item, op_names[op]) != 0) {
+            op++;
+        }
+        int weight = atoi(eq + 1);
+        if (op == OP_COUNT || weight < 0) {
+            fprintf(stderr, "Bad mix entry '%s=%s'\n", item, eq + 1);
+            return -1;
+        }
+        mix[op] = weight;
+        mix_total += weight;
+    }
+    
+    if (mix_total == 0) {
+        fprintf(stderr, "Mix '%s' has no weight\n", spec);
+        return -1;
+    }
+    return 0;
+}
+
+static op_type_t pick_op(loadgen_session_t *ls) {
+    int value = (int)(xorshift(&ls->rng) % (uint64_t)mix_total);
+    op_type_t op = 0;
+    while (value >= mix[op]) {
+        value -= mix[op];
+        op++;
+    }
+    return op;
+}
+
+static void handle_reply(const o1_rpc_result_t *result, void *arg) {
+    loadgen_session_t *ls = arg;
+    op_stats_t *stats = &ls->stats[ls->ops[result->slot]];
+    
+    switch (result->status) {
+    case O1_RPC_OK:
+        stats->ok++;
+        break;
+    case O1_RPC_ERROR:
+        stats->errors++;
+        break;
+    default:
+        stats->failed++;
+        return;
+    }
+    
+    uint64_t now = now_ns();
+    uint64_t scheduled = ls->scheduled[result->slot];
+    o1_hist_record(&stats->latency, now > scheduled ? now - scheduled : 0);
+}
+
+// Build and send one RPC of type `op` on an interface picked at random
+static int send_rpc(loadgen_session_t *ls, op_type_t op, uint64_t scheduled) {
+    char name[32];
+    snprintf(name, sizeof(name), "eth%d", (int)(xorshift(&ls->rng) % (uint64_t)num_interfaces));
+    
+    o1_buf_t *xml_msg = o1_rpc_pipeline_begin(ls->pipeline);
+    if (!xml_msg) {
+        return -1;
+    }
+    
+    int ret = 0;
+    char traceid[33], spanid[17];
+    const char *status = xorshift(&ls->rng) & 1 ? "up" : "down";
+    if (op == OP_EDIT_CONFIG || op == OP_SET_STATUS) {
+        ret = trace_id_fill(traceid, spanid);
+    }
+    
+    switch (op) {
+    case OP_GET_CONFIG:
+        ret = o1_buf_printf(xml_msg,
+            "  <get-config>\n"
+            "    <source>\n"
+            "      <running/>\n"
+            "    </source>\n"
+            "    <filter type=\"subtree\">\n"
+            "      <o1-interface xmlns=\"urn:example:o1-interface\">\n"
+            "        <interface>\n"
+            "          <name>%s</name>\n"
+            "        </interface>\n"
+            "      </o1-interface>\n"
+            "    </filter>\n"
+            "  </get-config>\n",
+            name);
+        break;
+    case OP_EDIT_CONFIG:
+        ret = ret != 0 ? ret : o1_buf_printf(xml_msg,
+            "  <edit-config>\n"
+            "    <target>\n"
+            "      <running/>\n"
+            "    </target>\n"
+            "    <config>\n"
+            "      <o1-interface xmlns=\"urn:example:o1-interface\">\n"
+            "        <interface>\n"
+            "          <name>%s</name>\n"
+            "          <status>%s</status>\n"
+            "          <tracing>\n"
+            "            <traceid>%s</traceid>\n"
+            "            <spanid>%s</spanid>\n"
+            "          </tracing>\n"
+            "        </interface>\n"
+            "      </o1-interface>\n"
+            "    </config>\n"
+            "  </edit-config>\n",
+            name, status, traceid, spanid);
+        break;
+    case OP_GET_STATUS:
+        ret = o1_buf_printf(xml_msg,
+            "  <get-interface-status xmlns=\"urn:example:o1-interface\">\n"
+            "    <interface-name>%s</interface-name>\n"
+            "  </get-interface-status>\n",
+            name);
+        break;
+    default:
+        ret = ret != 0 ? ret : o1_buf_printf(xml_msg,
+            "  <set-interface-status xmlns=\"urn:example:o1-interface\">\n"
+            "    <interface-name>%s</interface-name>\n"
+            "    <status>%s</status>\n"
+            "    <tracing>\n"
+            "      <traceid>%s</traceid>\n"
+            "      <spanid>%s</spanid>\n"
+            "    </tracing>\n"
+            "  </set-interface-status>\n",
+            name, status, traceid, spanid);
+        break;
+    }
+    if (ret != 0) {
+        o1_rpc_pipeline_cancel(ls->pipeline);
+        return -1;
+    }
+    
+    uint64_t message_id;
+    if (o1_rpc_pipeline_commit(ls->pipeline, handle_reply, ls, &message_id) != 0) {
+        ls->stats[op].failed++;
+        return -1;
+    }
+    int slot = o1_rpc_pipeline_slot(ls->pipeline, message_id);
+    ls->scheduled[slot] = scheduled;
+    ls->ops[slot] = op;
+    return 0;
+}
+
+static void *session_thread(void *arg) {
+    loadgen_session_t *ls = arg;
+    uint64_t end = start_ns + (uint64_t)duration * 1000000000ULL;
+    
+    // Each session sends every `interval`; the sessions' schedules are
+    // staggered so that together they are evenly spaced
+    uint64_t interval = rate > 0 ? (uint64_t)(1e9 * num_sessions / rate) : 0;
+    uint64_t next = start_ns + interval * ls->index / num_sessions;
+    
+    while (running) {
+        uint64_t now = now_ns();
+        if (now >= end) {
+            break;
+        }
+        
+        // Everything that is due goes out while the window has room; when
+        // it is full the schedule keeps running and the backlog is charged
+        // to the latency of the RPCs that wait
+        if (now >= next && o1_rpc_pipeline_outstanding(ls->pipeline) < window) {
+            if (send_rpc(ls, pick_op(ls), rate > 0 ? next : now) != 0) {
+                fprintf(stderr, "Session %d: failed to send RPC\n", ls->index);
+                break;
+            }
+            next += interval;
+            continue;
+        }
+        
+        uint64_t wait = now >= next ? 100000000ULL : next - now;
+        if (wait > end - now) {
+            wait = end - now;
+        }
+        int polled = 0;
+        if (o1_rpc_pipeline_outstanding(ls->pipeline) > 0) {
+            // Replies are waited for in whole ms; under 1 ms only those
+            // already received are taken
+            polled = o1_rpc_pipeline_poll(ls->pipeline, (int)(wait / 1000000));
+            if (polled < 0) {
+                fprintf(stderr, "Session %d: connection lost\n", ls->index);
+                return NULL;
+            }
+        }
+        if (polled == 0 && (wait < 1000000 || o1_rpc_pipeline_outstanding(ls->pipeline) == 0)) {
+            sleep_ns(wait);
+        }
+    }
+    
+    o1_rpc_pipeline_drain(ls->pipeline);
+    return NULL;
+}
+
+static int connect_session(loadgen_session_t *ls, const o1_config_t *config) {
+    int ret = nc_connect_ssh(config->host, config->port, config->username,
+                             config->private_key_path, config->password, &ls->session);
+    if (ret != NC_MSG_HELLO) {
+        fprintf(stderr, "Failed to connect session %d: %s\n", ls->index, nc_strerror(ret));
+        return -1;
+    }
+    
+    ls->pipeline = o1_rpc_pipeline_create(ls->session, window);
+    ls->scheduled = calloc(window, sizeof(*ls->scheduled));
+    ls->ops = calloc(window, sizeof(*ls->ops));
+    if (!ls->pipeline || !ls->scheduled || !ls->ops) {
+        fprintf(stderr, "Failed to set up session %d\n", ls->index);
+        return -1;
+    }
+    
+    ls->rng = 0x9e3779b97f4a7c15ULL * (uint64_t)(ls->index + 1) ^ now_ns();
+    for (int op = 0; op < OP_COUNT; op++) {
+        o1_hist_init(&ls->stats[op].latency);
+    }
+    return 0;
+}
+
+static void free_session(loadgen_session_t *ls) {
+    o1_rpc_pipeline_destroy(ls->pipeline);
+    if (ls->session) {
+        nc_session_free(ls->session, NULL);
+    }
+    free(ls->scheduled);
+    free(ls->ops);
+}
+
+static void print_stats(const char *name, const op_stats_t *stats) {
+    const o1_hist_t *h = &stats->latency;
+    printf("%-12s %9llu %9llu %9llu %7llu %9.1f %9.1f %9.1f %9.1f %9.1f\n", name,
+           (unsigned long long)(stats->ok + stats->errors + stats->failed),
+           (unsigned long long)stats->ok, (unsigned long long)stats->errors,
+           (unsigned long long)stats->failed, o1_hist_mean(h) / 1e3,
+           o1_hist_percentile(h, 50.0) / 1e3, o1_hist_percentile(h, 99.0) / 1e3,
+           o1_hist_percentile(h, 99.9) / 1e3, o1_hist_percentile(h, 100.0) / 1e3);
+}
+
+void print_usage(const char *prog) {
+    printf("Usage: %s [-s sessions] [-r rate] [-d seconds] [-w window] [-m mix] [-n interfaces]\n"
+           "          [-H histogram.hgrm] [host] [port] [username] [password]\n"
+           "  -r  total RPCs per second over all sessions, open loop (default: closed loop)\n"
+           "  -m  operation weights (default: %s)\n", prog, DEFAULT_MIX);
+}
+
+int main(int argc, char *argv[]) {
+    o1_config_t config;
+    const char *hgrm_path = NULL;
+    const char *mix_spec = DEFAULT_MIX;
+    
+    // Set default configuration
+    strcpy(config.host, "127.0.0.1");
+    config.port = 830;
+    strcpy(config.username, "admin");
+    strcpy(config.password, "admin123");
+    strcpy(config.private_key_path, "config/id_rsa");
+    
+    // Parse command line arguments
+    int opt;
+    while ((opt = getopt(argc, argv, "s:r:d:w:m:n:H:h")) != -1) {
+        switch (opt) {
+        case 's':
+            num_sessions = atoi(optarg);
+            break;
+        case 'r':
+            rate = atof(optarg);
+            break;
+        case 'd':
+            duration = atoi(optarg);
+            break;
+        case 'w':
+            window = atoi(optarg);
+            break;
+        case 'm':
+            mix_spec = optarg;
+            break;
+        case 'n':
+            num_interfaces = atoi(optarg);
+            break;
+        case 'H':
+            hgrm_path = optarg;
+            break;
+        default:
+            print_usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (num_sessions < 1 || rate < 0 || duration < 1 || window < 1 || num_interfaces < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (parse_mix(mix_spec) != 0) {
+        return 1;
+    }
+    
+    int pos = optind;
+    if (argc > pos) {
+        snprintf(config.host, sizeof(config.host), "%s", argv[pos]);
+    }
+    if (argc > pos + 1) {
+        config.port = atoi(argv[pos + 1]);
+    }
+    if (argc > pos + 2) {
+        snprintf(config.username, sizeof(config.username), "%s", argv[pos + 2]);
+    }
+    if (argc > pos + 3) {
+        snprintf(config.password, sizeof(config.password), "%s", argv[pos + 3]);
+    }
+    
+    // Set up signal handler
+    signal(SIGINT, signal_handler);
+    signal(SIGTERM, signal_handler);
+    
+    if (nc_init() != 0) {
+        fprintf(stderr, "Failed to initialize libnetconf2\n");
+        return 1;
+    }
+    nc_verbosity(NC_VERB_ERROR);
+    
+    loadgen_session_t *sessions = calloc(num_sessions, sizeof(*sessions));
+    if (!sessions) {
+        fprintf(stderr, "Failed to allocate sessions\n");
+        return 1;
+    }
+    
+    // Connect every session before the clock starts
+    printf("Connecting %d session(s) to %s:%d as %s\n", num_sessions, config.host, config.port,
+           config.username);
+    int connected = 0;
+    while (connected < num_sessions) {
+        sessions[connected].index = connected;
+        if (connect_session(&sessions[connected], &config) != 0) {
+            break;
+        }
+        connected++;
+    }
+    
+    int status = connected == num_sessions ? 0 : 1;
+    int started = 0;
+    if (status == 0) {
+        if (rate > 0) {
+            printf("Open loop at %.0f RPCs/s, window %d per session, for %d s\n", rate, window, duration);
+        } else {
+            printf("Closed loop, window %d per session, for %d s\n", window, duration);
+        }
+        
+        start_ns = now_ns();
+        while (started < num_sessions) {
+            if (pthread_create(&sessions[started].thread, NULL, session_thread, &sessions[started]) != 0) {
+                fprintf(stderr, "Failed to start session thread\n");
+                running = 0;
+                status = 1;
+                break;
+            }
+            started++;
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(sessions[i].thread, NULL);
+    }
+    double seconds = (now_ns() - start_ns) / 1e9;
+    
+    if (started > 0) {
+        op_stats_t total;
+        memset(&total, 0, sizeof(total));
+        o1_hist_init(&total.latency);
+        
+        printf("\n%-12s %9s %9s %9s %7s %9s %9s %9s %9s %9s\n", "operation", "count", "ok",
+               "rpc-error", "failed", "mean us", "p50 us", "p99 us", "p99.9 us", "max us");
+        for (int op = 0; op < OP_COUNT; op++) {
+            op_stats_t merged;
+            memset(&merged, 0, sizeof(merged));
+            o1_hist_init(&merged.latency);
+            for (int i = 0; i < started; i++) {
+                const op_stats_t *stats = &sessions[i].stats[op];
+                o1_hist_merge(&merged.latency, &stats->latency);
+                merged.ok += stats->ok;
+                merged.errors += stats->errors;
+                merged.failed += stats->failed;
+            }
+            if (mix[op] > 0) {
+                print_stats(op_names[op], &merged);
+            }
+            o1_hist_merge(&total.latency, &merged.latency);
+            total.ok += merged.ok;
+            total.errors += merged.errors;
+            total.failed += merged.failed;
+        }
+        print_stats("total", &total);
+        printf("\nCompleted %llu RPCs in %.3f s (%.0f RPCs/s)\n",
+               (unsigned long long)(total.ok + total.errors), seconds,
+               (total.ok + total.errors) / seconds);
+        
+        if (hgrm_path) {
+            FILE *out = fopen(hgrm_path, "w");
+            if (!out || o1_hist_write_hgrm(&total.latency, out, 1e3) != 0) {
+                perror(hgrm_path);
+                status = 1;
+            }
+            if (out) {
+                fclose(out);
+            }
+        }
+        if (total.failed > 0) {
+            status = 1;
+        }
+    }
+    
+    // Includes the session whose connection failed part way
+    for (int i = 0; i <= connected && i < num_sessions; i++) {
+        free_session(&sessions[i]);
+    }
+    free(sessions);
+    return status;
+}
@@ -0,0 +1,461 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "o1_metrics.h"
+
+#define METRICS_REQUEST_SIZE 4096
+#define METRICS_POLL_TIMEOUT 200    // ms between checks for shutdown
+
+typedef struct {
+    uint64_t buckets[O1_METRICS_HIST_BUCKETS];
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t errors;
+} metrics_hist_t;
+
+// One thread's metrics. Only the owning thread writes; scrapes read with
+// relaxed loads, so a scrape may see one RPC's count without its sum.
+typedef struct metrics_shard {
+    uint64_t counters[O1_METRIC_COUNT];
+    metrics_hist_t rpcs[O1_METRICS_MAX_RPCS];
+    metrics_hist_t handshake;
+    struct metrics_shard *next;         // every shard, for scrapes
+    struct metrics_shard *next_free;    // shards of exited threads
+} metrics_shard_t;
+
+static const struct {
+    const char *name;
+    const char *help;
+} counter_info[O1_METRIC_COUNT] = {
+    { "o1_sessions_accepted_total", "NETCONF sessions established and handed to a worker" },
+    { "o1_sessions_rejected_total", "Connections refused: failed hello or session limit reached" },
+    { "o1_sessions_closed_total", "NETCONF sessions closed" },
+    { "o1_parse_failures_total", "Messages that were not a well-formed RPC" },
+    { "o1_send_failures_total", "Replies that could not be sent" },
+    { "o1_reply_bytes_total", "Bytes of rpc-reply sent" },
+    { "o1_handshakes_queued_total", "Connections admitted to the SSH handshake queue" },
+    { "o1_handshakes_dequeued_total", "Connections taken off the SSH handshake queue" },
+    { "o1_handshakes_shed_total", "Connections refused before their SSH handshake" },
+};
+
+static struct {
+    pthread_mutex_t lock;           // shard lists
+    pthread_once_t once;
+    pthread_key_t key;
+    metrics_shard_t *shards;
+    metrics_shard_t *free_shards;
+    const char *const *rpc_names;
+    int rpc_count;
+    int listen_fd;
+    pthread_t listener;
+    int listening;
+    volatile int running;
+} metrics = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .once = PTHREAD_ONCE_INIT,
+    .listen_fd = -1,
+};
+
+static __thread metrics_shard_t *thread_shard;
+
+// The shard outlives its thread; the next new thread takes it over and
+// keeps adding to its totals
+static void shard_release(void *arg) {
+    metrics_shard_t *shard = arg;
+    pthread_mutex_lock(&metrics.lock);
+    shard->next_free = metrics.free_shards;
+    metrics.free_shards = shard;
+    pthread_mutex_unlock(&metrics.lock);
+}
+
+static void create_key(void) {
+    pthread_key_create(&metrics.key, shard_release);
+}
+
+// Slow path of the first record on a thread
+static metrics_shard_t *shard_register(void) {
+    pthread_once(&metrics.once, create_key);
+    
+    pthread_mutex_lock(&metrics.lock);
+    metrics_shard_t *shard = metrics.free_shards;
+    if (shard) {
+        metrics.free_shards = shard->next_free;
+    } else {
+        // Cache-line aligned so no two threads' counters share a line
+        void *mem = NULL;
+        if (posix_memalign(&mem, 64, sizeof(metrics_shard_t)) == 0) {
+            shard = memset(mem, 0, sizeof(metrics_shard_t));
+            shard->next = metrics.shards;
+            metrics.shards = shard;
+        }
+    }
+    pthread_mutex_unlock(&metrics.lock);
+    
+    if (shard) {
+        pthread_setspecific(metrics.key, shard);
+    }
+    thread_shard = shard;
+    return shard;
+}
+
+static inline metrics_shard_t *shard_get(void) {
+    metrics_shard_t *shard = thread_shard;
+    return shard ? shard : shard_register();
+}
+
+// Single writer: a relaxed load and store, no locked instruction
+static inline void shard_add(uint64_t *value, uint64_t delta) {
+    __atomic_store_n(value, __atomic_load_n(value, __ATOMIC_RELAXED) + delta, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t shard_read(const uint64_t *value) {
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+
+static inline int bucket_index(uint64_t ns) {
+    int msb = 63 - __builtin_clzll(ns | 1);
+    int shift = msb > O1_METRICS_HIST_SUB_BITS ? msb - O1_METRICS_HIST_SUB_BITS : 0;
+    return (shift << O1_METRICS_HIST_SUB_BITS) + (int)(ns >> shift);
+}
+
+// Exclusive upper bound of a bucket in nanoseconds
+static uint64_t bucket_bound(int index) {
+    int shift = index < (2 << O1_METRICS_HIST_SUB_BITS) ? 0 :
+                (index >> O1_METRICS_HIST_SUB_BITS) - 1;
+    uint64_t sub = (uint64_t)(index - (shift << O1_METRICS_HIST_SUB_BITS));
+    return (sub + 1) << shift;
+}
+
+void o1_metrics_add(o1_metric_t metric, uint64_t value) {
+    metrics_shard_t *shard = shard_get();
+    if (shard && (unsigned)metric < O1_METRIC_COUNT) {
+        shard_add(&shard->counters[metric], value);
+    }
+}
+
+static void hist_record(metrics_hist_t *hist, uint64_t latency_ns, int error) {
+    if (latency_ns < (1ULL << O1_METRICS_HIST_MAX_BITS)) {
+        shard_add(&hist->buckets[bucket_index(latency_ns)], 1);
+    }
+    shard_add(&hist->count, 1);
+    shard_add(&hist->sum_ns, latency_ns);
+    if (error) {
+        shard_add(&hist->errors, 1);
+    }
+}
+
+// One completed RPC of type `rpc`; error is non-zero when it was answered
+// with <rpc-error>
+void o1_metrics_rpc(int rpc, uint64_t latency_ns, int error) {
+    metrics_shard_t *shard = shard_get();
+    if (shard && rpc >= 0 && rpc < O1_METRICS_MAX_RPCS) {
+        hist_record(&shard->rpcs[rpc], latency_ns, error);
+    }
+}
+
+// One SSH handshake, from leaving the queue to an established session or
+// its failure (error non-zero)
+void o1_metrics_handshake(uint64_t latency_ns, int error) {
+    metrics_shard_t *shard = shard_get();
+    if (shard) {
+        hist_record(&shard->handshake, latency_ns, error);
+    }
+}
+
+uint64_t o1_metrics_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Names of the RPC types recorded with o1_metrics_rpc(), used as the `rpc`
+// label; the array must outlive the metrics
+int o1_metrics_init(const char *const *rpc_names, int rpc_count) {
+    if (rpc_count < 0 || rpc_count > O1_METRICS_MAX_RPCS || (rpc_count > 0 && !rpc_names)) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&metrics.lock);
+    metrics.rpc_names = rpc_names;
+    metrics.rpc_count = rpc_count;
+    pthread_mutex_unlock(&metrics.lock);
+    return 0;
+}
+
+static void sum_counters(uint64_t *counters) {
+    memset(counters, 0, O1_METRIC_COUNT * sizeof(*counters));
+    for (metrics_shard_t *shard = metrics.shards; shard; shard = shard->next) {
+        for (int i = 0; i < O1_METRIC_COUNT; i++) {
+            counters[i] += shard_read(&shard->counters[i]);
+        }
+    }
+}
+
+// Sum one histogram across shards; `offset` locates it within a shard
+static void sum_hist(size_t offset, metrics_hist_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+    for (metrics_shard_t *shard = metrics.shards; shard; shard = shard->next) {
+        const metrics_hist_t *src = (const metrics_hist_t *)((const char *)shard + offset);
+        for (int i = 0; i < O1_METRICS_HIST_BUCKETS; i++) {
+            hist->buckets[i] += shard_read(&src->buckets[i]);
+        }
+        hist->count += shard_read(&src->count);
+        hist->sum_ns += shard_read(&src->sum_ns);
+        hist->errors += shard_read(&src->errors);
+    }
+}
+
+#define RPC_HIST(rpc) (offsetof(metrics_shard_t, rpcs) + (size_t)(rpc) * sizeof(metrics_hist_t))
+#define HANDSHAKE_HIST offsetof(metrics_shard_t, handshake)
+
+// Buckets, sum and count of one histogram series; `labels` is empty or
+// a list such as `rpc="get-config",`
+static int render_hist(o1_buf_t *out, const char *name, const char *labels,
+                       const metrics_hist_t *hist) {
+    uint64_t cumulative = 0;
+    int ret = 0;
+    
+    for (int i = 0; i < O1_METRICS_HIST_BUCKETS && ret == 0; i++) {
+        cumulative += hist->buckets[i];
+        uint64_t bound = bucket_bound(i);
+        if (bound >= (1ULL << O1_METRICS_HIST_MIN_BITS)) {
+            ret = o1_buf_printf(out, "%s_bucket{%sle=\"%.9g\"} %llu\n",
+                                name, labels, bound / 1e9, (unsigned long long)cumulative);
+        }
+    }
+    if (ret == 0) {
+        // The same labels without the trailing comma, braced, or nothing
+        char plain[80] = "";
+        size_t len = strlen(labels);
+        if (len > 0) {
+            snprintf(plain, sizeof(plain), "{%.*s}", (int)len - 1, labels);
+        }
+        ret = o1_buf_printf(out,
+            "%s_bucket{%sle=\"+Inf\"} %llu\n"
+            "%s_sum%s %.9f\n"
+            "%s_count%s %llu\n",
+            name, labels, (unsigned long long)hist->count, name, plain, hist->sum_ns / 1e9,
+            name, plain, (unsigned long long)hist->count);
+    }
+    return ret;
+}
+
+// Append the Prometheus text exposition of every metric to `out`
+int o1_metrics_render(o1_buf_t *out) {
+    uint64_t counters[O1_METRIC_COUNT];
+    metrics_hist_t hist;
+    int ret = 0;
+    
+    pthread_mutex_lock(&metrics.lock);
+    
+    sum_counters(counters);
+    for (int i = 0; i < O1_METRIC_COUNT && ret == 0; i++) {
+        ret = o1_buf_printf(out, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+                            counter_info[i].name, counter_info[i].help, counter_info[i].name,
+                            counter_info[i].name, (unsigned long long)counters[i]);
+    }
+    if (ret == 0) {
+        // A session may be closed by its worker before the acceptor counts it
+        uint64_t accepted = counters[O1_METRIC_SESSIONS_ACCEPTED];
+        uint64_t closed = counters[O1_METRIC_SESSIONS_CLOSED];
+        uint64_t open = accepted > closed ? accepted - closed : 0;
+        ret = o1_buf_printf(out, "# HELP o1_sessions_active NETCONF sessions open\n"
+                            "# TYPE o1_sessions_active gauge\no1_sessions_active %llu\n",
+                            (unsigned long long)open);
+    }
+    
+    if (ret == 0) {
+        ret = o1_buf_puts(out,
+            "# HELP o1_rpc_errors_total RPCs answered with rpc-error\n"
+            "# TYPE o1_rpc_errors_total counter\n");
+    }
+    for (int rpc = 0; rpc < metrics.rpc_count && ret == 0; rpc++) {
+        sum_hist(RPC_HIST(rpc), &hist);
+        ret = o1_buf_printf(out, "o1_rpc_errors_total{rpc=\"%s\"} %llu\n",
+                            metrics.rpc_names[rpc], (unsigned long long)hist.errors);
+    }
+    
+    if (ret == 0) {
+        ret = o1_buf_puts(out,
+            "# HELP o1_rpc_duration_seconds Time from receiving an RPC to sending its reply\n"
+            "# TYPE o1_rpc_duration_seconds histogram\n");
+    }
+    for (int rpc = 0; rpc < metrics.rpc_count && ret == 0; rpc++) {
+        char labels[64];
+        snprintf(labels, sizeof(labels), "rpc=\"%s\",", metrics.rpc_names[rpc]);
+        sum_hist(RPC_HIST(rpc), &hist);
+        ret = render_hist(out, "o1_rpc_duration_seconds", labels, &hist);
+    }
+    
+    if (ret == 0) {
+        // Admitted connections still waiting for a handshake thread
+        uint64_t queued = counters[O1_METRIC_HANDSHAKES_QUEUED];
+        uint64_t dequeued = counters[O1_METRIC_HANDSHAKES_DEQUEUED];
+        ret = o1_buf_printf(out, "# HELP o1_handshake_queue_depth Connections waiting for an SSH handshake\n"
+                            "# TYPE o1_handshake_queue_depth gauge\no1_handshake_queue_depth %llu\n",
+                            (unsigned long long)(queued > dequeued ? queued - dequeued : 0));
+    }
+    if (ret == 0) {
+        sum_hist(HANDSHAKE_HIST, &hist);
+        ret = o1_buf_printf(out,
+            "# HELP o1_handshake_failures_total SSH handshakes that did not establish a session\n"
+            "# TYPE o1_handshake_failures_total counter\no1_handshake_failures_total %llu\n"
+            "# HELP o1_handshake_duration_seconds Time from leaving the queue to an established session\n"
+            "# TYPE o1_handshake_duration_seconds histogram\n",
+            (unsigned long long)hist.errors);
+    }
+    if (ret == 0) {
+        ret = render_hist(out, "o1_handshake_duration_seconds", "", &hist);
+    }
+    
+    pthread_mutex_unlock(&metrics.lock);
+    return ret;
+}
+
+static int write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Answer one HTTP request: GET /metrics, anything else is 404
+static void serve_scrape(int fd, o1_buf_t *body) {
+    char request[METRICS_REQUEST_SIZE];
+    char header[256];
+    size_t len = 0;
+    
+    // Only the request line matters; read until the header ends
+    while (len < sizeof(request) - 1) {
+        ssize_t n = recv(fd, request + len, sizeof(request) - 1 - len, 0);
+        if (n <= 0) {
+            return;
+        }
+        len += (size_t)n;
+        request[len] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) {
+            break;
+        }
+    }
+    request[len] = '\0';
+    
+    o1_buf_reset(body);
+    const char *status = "200 OK";
+    if (strncmp(request, "GET /metrics ", 13) != 0 && strncmp(request, "GET /metrics?", 13) != 0) {
+        status = "404 Not Found";
+        o1_buf_puts(body, "Not found; metrics are at /metrics\n");
+    } else if (o1_metrics_render(body) != 0) {
+        status = "500 Internal Server Error";
+        o1_buf_reset(body);
+    }
+    
+    int header_len = snprintf(header, sizeof(header),
+        "HTTP/1.1 %s\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: %zu\r\n"
+        "Connection: close\r\n\r\n",
+        status, body->len);
+    if (write_all(fd, header, (size_t)header_len) == 0 && body->len > 0) {
+        write_all(fd, body->data, body->len);
+    }
+}
+
+static void *listener_main(void *arg) {
+    (void)arg;
+    o1_buf_t body;
+    o1_buf_init(&body);
+    
+    struct pollfd pfd = { .fd = metrics.listen_fd, .events = POLLIN };
+    while (metrics.running) {
+        if (poll(&pfd, 1, METRICS_POLL_TIMEOUT) <= 0) {
+            continue;
+        }
+        int fd = accept(metrics.listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        
+        // A stalled scraper must not hold up the next one for long
+        struct timeval timeout = { 1, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        serve_scrape(fd, &body);
+        close(fd);
+    }
+    
+    o1_buf_free(&body);
+    return NULL;
+}
+
+// Serve GET /metrics on `port` from a background thread
+int o1_metrics_listen(int port) {
+    if (metrics.listening) {
+        return -1;
+    }
+    
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        perror("Failed to create metrics socket");
+        return -1;
+    }
+    
+    int opt = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, 16) < 0) {
+        perror("Failed to listen for metrics scrapes");
+        close(sock);
+        return -1;
+    }
+    
+    metrics.listen_fd = sock;
+    metrics.running = 1;
+    if (pthread_create(&metrics.listener, NULL, listener_main, NULL) != 0) {
+        fprintf(stderr, "Failed to start metrics listener\n");
+        metrics.running = 0;
+        close(sock);
+        metrics.listen_fd = -1;
+        return -1;
+    }
+    
+    metrics.listening = 1;
+    return 0;
+}
+
+// Stop the listener. Shards stay allocated: threads still running may
+// record after this.
+void o1_metrics_shutdown(void) {
+    if (!metrics.listening) {
+        return;
+    }
+    
+    metrics.running = 0;
+    pthread_join(metrics.listener, NULL);
+    close(metrics.listen_fd);
+    metrics.listen_fd = -1;
+    metrics.listening = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef O1_METRICS_H
+#define O1_METRICS_H
+
+#include <stdint.h>
+
+#include "o1_buf.h"
+
+// Server metrics: counters and per-RPC latency histograms, exposed in the
+// Prometheus text format over HTTP on a side port.
+//
+// Every thread that records gets its own shard, allocated on its first
+// record and kept (and reused by a later thread) when it exits. Recording
+// is a thread-local lookup and relaxed atomic adds to memory no other
+// thread writes: no locks, no allocation, no shared cache lines. A scrape
+// sums the shards.
+//
+// Latencies go into log-linear histograms: each power of two of
+// nanoseconds is split in two, so bucket bounds run 1, 1.5, 2, 3, 4, 6, ...
+// and every latency is kept to within 50%. The exposition reports the
+// bounds from 2^O1_METRICS_HIST_MIN_BITS to 2^O1_METRICS_HIST_MAX_BITS ns;
+// longer latencies count only towards +Inf.
+
+#define O1_METRICS_MAX_RPCS 16
+#define O1_METRICS_HIST_SUB_BITS 1
+#define O1_METRICS_HIST_MIN_BITS 12     // first bound reported: 4.1 us
+#define O1_METRICS_HIST_MAX_BITS 35     // last bound: 34 s
+#define O1_METRICS_HIST_BUCKETS \
+    ((1 + O1_METRICS_HIST_MAX_BITS - O1_METRICS_HIST_SUB_BITS) << O1_METRICS_HIST_SUB_BITS)
+
+typedef enum {
+    O1_METRIC_SESSIONS_ACCEPTED,    // established and handed to a worker
+    O1_METRIC_SESSIONS_REJECTED,    // failed hello or over the session limit
+    O1_METRIC_SESSIONS_CLOSED,
+    O1_METRIC_PARSE_FAILURES,       // messages that were not a well-formed RPC
+    O1_METRIC_SEND_FAILURES,        // replies that could not be sent
+    O1_METRIC_REPLY_BYTES,
+    O1_METRIC_HANDSHAKES_QUEUED,    // connections admitted to the handshake queue
+    O1_METRIC_HANDSHAKES_DEQUEUED,  // taken off it by a handshake thread
+    O1_METRIC_HANDSHAKES_SHED,      // refused at admission or expired in the queue
+    O1_METRIC_COUNT
+} o1_metric_t;
+
+// Function declarations
+int o1_metrics_init(const char *const *rpc_names, int rpc_count);
+int o1_metrics_listen(int port);
+void o1_metrics_shutdown(void);
+
+void o1_metrics_add(o1_metric_t metric, uint64_t value);
+void o1_metrics_rpc(int rpc, uint64_t latency_ns, int error);
+void o1_metrics_handshake(uint64_t latency_ns, int error);
+uint64_t o1_metrics_now(void);
+
+int o1_metrics_render(o1_buf_t *out);
+
+#endif // O1_METRICS_H
@@ -12,6 +12,11 @@
 #include <libnetconf2/log.h>
 #include <libyang/libyang.h>
 
+#include "o1_client_pool.h"
+#include "o1_fanout.h"
+#include "o1_rpc_pipeline.h"
+#include "trace_id.h"
+
 // O1 interface structures
 typedef struct {
     char traceid[33];      // 32 hex chars + null terminator
@@ -29,15 +34,33 @@ typedef struct {
     char private_key_path[256];
 } o1_config_t;
 
+// Completion counters updated by the RPC callback
+typedef struct {
+    int ok;
+    int errors;
+    int failed;
+} o1_rpc_stats_t;
+
+// A session checked out of the pool and the RPCs in flight on it
+typedef struct {
+    struct nc_session *session;
+    o1_rpc_pipeline_t *pipeline;
+    o1_rpc_stats_t stats;
+} o1_client_t;
+
 // Global variables
 static volatile int running = 1;
-static struct nc_session *session = NULL;
+static o1_client_pool_t *client_pool = NULL;
+static o1_fanout_t *fanout = NULL;
+static int verbose = 1;
+static const char *edit_target = "running";    // candidate with -C
 
 void signal_handler(int sig) {
-    printf("\nReceived signal %d, shutting down...\n", sig);
+    (void)sig;
+    // The main loop stops submitting; each round releases its own session
     running = 0;
-    if (session) {
-        nc_session_free(session, NULL);
+    if (fanout) {
+        o1_fanout_stop(fanout);
     }
 }
 
@@ -52,13 +75,36 @@ void init_netconf() {
     // Set logging level
     nc_verbosity(NC_VERB_VERBOSE);
     
+    // Sessions and keys are kept across rounds
+    o1_client_pool_config_t pool_config;
+    o1_client_pool_default_config(&pool_config);
+    client_pool = o1_client_pool_create(&pool_config);
+    if (!client_pool) {
+        fprintf(stderr, "Failed to create session pool\n");
+        exit(1);
+    }
+    
     printf("NETCONF initialized for O1 interface\n");
 }
 
-void cleanup_netconf() {
-    if (session) {
-        nc_session_free(session, NULL);
+// Finish with the client's session: back to the pool if it is still good
+void release_netconf_session(o1_client_t *client) {
+    // Outstanding RPCs complete as failed before the session goes away
+    int clean = client->pipeline && o1_rpc_pipeline_outstanding(client->pipeline) == 0 &&
+                client->stats.failed == 0;
+    o1_rpc_pipeline_destroy(client->pipeline);
+    client->pipeline = NULL;
+    if (client->session) {
+        o1_client_pool_release(client_pool, client->session, clean && running);
+        client->session = NULL;
     }
+}
+
+void cleanup_netconf() {
+    o1_fanout_destroy(fanout);
+    fanout = NULL;
+    o1_client_pool_destroy(client_pool);
+    client_pool = NULL;
     printf("NETCONF cleaned up\n");
 }
 
@@ -67,30 +113,11 @@ int generate_tracing_data(o1_interface_data_t *o1_data) {
         return -1;
     }
     
-    // Generate random traceid (32 hex characters)
-    unsigned char traceid_bytes[16];
-    if (RAND_bytes(traceid_bytes, 16) != 1) {
-        fprintf(stderr, "Failed to generate random traceid\n");
-        return -1;
-    }
-    
-    for (int i = 0; i < 16; i++) {
-        sprintf(&o1_data->traceid[i * 2], "%02x", traceid_bytes[i]);
-    }
-    o1_data->traceid[32] = '\0';
-    
-    // Generate random spanid (16 hex characters)
-    unsigned char spanid_bytes[8];
-    if (RAND_bytes(spanid_bytes, 8) != 1) {
-        fprintf(stderr, "Failed to generate random spanid\n");
+    // Random traceid (32 hex characters) and spanid (16 hex characters)
+    if (trace_id_fill(o1_data->traceid, o1_data->spanid) != 0) {
+        fprintf(stderr, "Failed to generate tracing data\n");
         return -1;
-    }
-    
-    for (int i = 0; i < 8; i++) {
-        sprintf(&o1_data->spanid[i * 2], "%02x", spanid_bytes[i]);
-    }
-    o1_data->spanid[16] = '\0';
-    
+    }    
     // Set default O1 interface data
     strcpy(o1_data->interface_name, "eth0");
     strcpy(o1_data->operation, "get");
@@ -113,18 +140,18 @@ void print_o1_data(const o1_interface_data_t *o1_data) {
     printf("  Status:        %s\n", o1_data->status);
 }
 
-int create_netconf_session(const o1_config_t *config) {
-    if (!config) {
+int create_netconf_session(o1_client_t *client, const o1_config_t *config) {
+    if (!client || !config) {
         return -1;
     }
     
-    int ret;
-    
-    // Create SSH session
-    ret = nc_connect_ssh(config->host, config->port, config->username, 
-                        config->private_key_path, config->password, &session);
-    if (ret != NC_MSG_HELLO) {
-        fprintf(stderr, "Failed to connect to NETCONF server: %s\n", nc_strerror(ret));
+    // A pooled session if one is idle, else a new SSH session
+    o1_client_target_t target = {
+        config->host, config->port, config->username, config->password, config->private_key_path
+    };
+    client->session = o1_client_pool_acquire(client_pool, &target);
+    if (!client->session) {
+        fprintf(stderr, "Failed to connect to NETCONF server\n");
         return -1;
     }
     
@@ -132,105 +159,463 @@ int create_netconf_session(const o1_config_t *config) {
     return 0;
 }
 
-int send_o1_get_config(const o1_interface_data_t *o1_data) {
-    if (!session || !o1_data) {
+void handle_netconf_response(const o1_rpc_result_t *result, void *arg) {
+    o1_rpc_stats_t *stats = arg;
+    
+    switch (result->status) {
+    case O1_RPC_OK:
+        stats->ok++;
+        break;
+    case O1_RPC_ERROR:
+        stats->errors++;
+        fprintf(stderr, "rpc-error for message-id %llu:\n%.*s\n",
+                (unsigned long long)result->message_id, (int)result->reply_len, result->reply);
+        return;
+    default:
+        stats->failed++;
+        return;
+    }
+    
+    if (verbose) {
+        printf("Received NETCONF response for message-id %llu\n",
+               (unsigned long long)result->message_id);
+    }
+}
+
+int send_o1_get_config(o1_client_t *client, const o1_interface_data_t *o1_data) {
+    if (!client->pipeline || !o1_data) {
         return -1;
     }
     
-    // Create NETCONF get-config message
-    char xml_msg[2048];
-    snprintf(xml_msg, sizeof(xml_msg),
-        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
-        "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"1\">\n"
-        "  <get-config>\n"
-        "    <source>\n"
-        "      <running/>\n"
-        "    </source>\n"
-        "    <filter type=\"subtree\">\n"
-        "      <o1-interface xmlns=\"urn:example:o1-interface\">\n"
-        "        <name>%s</name>\n"
-        "      </o1-interface>\n"
-        "    </filter>\n"
-        "  </get-config>\n"
-        "</rpc>\n",
-        o1_data->interface_name);
+    // Create NETCONF get-config operation inside the pipeline's <rpc> envelope
+    o1_buf_t *xml_msg = o1_rpc_pipeline_begin(client->pipeline);
+    if (!xml_msg) {
+        fprintf(stderr, "Failed to send get-config\n");
+        return -1;
+    }
+    if (o1_buf_printf(xml_msg,
+            "  <get-config>\n"
+            "    <source>\n"
+            "      <running/>\n"
+            "    </source>\n"
+            "    <filter type=\"subtree\">\n"
+            "      <o1-interface xmlns=\"urn:example:o1-interface\">\n"
+            "        <interface>\n"
+            "          <name>%s</name>\n"
+            "        </interface>\n"
+            "      </o1-interface>\n"
+            "    </filter>\n"
+            "  </get-config>\n",
+            o1_data->interface_name) != 0) {
+        o1_rpc_pipeline_cancel(client->pipeline);
+        fprintf(stderr, "Failed to build get-config\n");
+        return -1;
+    }
     
     // Send the message
-    int ret = nc_send_rpc(session, xml_msg, 1000, NULL);
-    if (ret != NC_MSG_RPC) {
-        fprintf(stderr, "Failed to send get-config: %s\n", nc_strerror(ret));
+    uint64_t message_id;
+    if (o1_rpc_pipeline_commit(client->pipeline, handle_netconf_response, &client->stats,
+                               &message_id) != 0) {
+        fprintf(stderr, "Failed to send get-config\n");
         return -1;
     }
     
-    printf("O1 get-config sent for interface %s\n", o1_data->interface_name);
+    if (verbose) {
+        printf("O1 get-config sent for interface %s (message-id %llu)\n",
+               o1_data->interface_name, (unsigned long long)message_id);
+    }
     return 0;
 }
 
-int send_o1_edit_config(const o1_interface_data_t *o1_data) {
-    if (!session || !o1_data) {
+// The <o1-interface> container with a list entry per interface
+int append_o1_interfaces(o1_buf_t *xml_msg, const o1_interface_data_t *items, size_t count) {
+    int ret = o1_buf_puts(xml_msg, "      <o1-interface xmlns=\"urn:example:o1-interface\">\n");
+    for (size_t i = 0; i < count && ret == 0; i++) {
+        ret = o1_buf_printf(xml_msg,
+            "        <interface>\n"
+            "          <name>%s</name>\n"
+            "          <status>%s</status>\n"
+            "          <tracing>\n"
+            "            <traceid>%s</traceid>\n"
+            "            <spanid>%s</spanid>\n"
+            "          </tracing>\n"
+            "        </interface>\n",
+            items[i].interface_name, items[i].status,
+            items[i].traceid, items[i].spanid);
+    }
+    if (ret == 0) {
+        ret = o1_buf_puts(xml_msg, "      </o1-interface>\n");
+    }
+    return ret;
+}
+
+// An edit-config of edit_target carrying a list entry per interface
+int append_o1_edit_config(o1_buf_t *xml_msg, const o1_interface_data_t *items, size_t count) {
+    // Roughly 250 bytes per entry; reserving up front avoids regrowing
+    int ret = o1_buf_reserve(xml_msg, 256 + count * 256);
+    if (ret == 0) {
+        ret = o1_buf_printf(xml_msg,
+            "  <edit-config>\n"
+            "    <target>\n"
+            "      <%s/>\n"
+            "    </target>\n"
+            "    <config>\n", edit_target);
+    }
+    if (ret == 0) {
+        ret = append_o1_interfaces(xml_msg, items, count);
+    }
+    if (ret == 0) {
+        ret = o1_buf_puts(xml_msg,
+            "    </config>\n"
+            "  </edit-config>\n");
+    }
+    return ret;
+}
+
+// One edit-config carrying a list entry per interface. Entries are written
+// straight into the RPC send buffer, so the size of the batch is bounded
+// only by memory.
+int send_o1_edit_config_bulk(o1_client_t *client, const o1_interface_data_t *items, size_t count) {
+    if (!client->pipeline || !items || count == 0) {
         return -1;
     }
     
-    // Create NETCONF edit-config message
-    char xml_msg[2048];
-    snprintf(xml_msg, sizeof(xml_msg),
-        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
-        "<rpc xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"2\">\n"
-        "  <edit-config>\n"
-        "    <target>\n"
-        "      <running/>\n"
-        "    </target>\n"
-        "    <config>\n"
-        "      <o1-interface xmlns=\"urn:example:o1-interface\">\n"
-        "        <name>%s</name>\n"
-        "        <status>%s</status>\n"
-        "        <tracing>\n"
-        "          <traceid>%s</traceid>\n"
-        "          <spanid>%s</spanid>\n"
-        "        </tracing>\n"
-        "      </o1-interface>\n"
-        "    </config>\n"
-        "  </edit-config>\n"
-        "</rpc>\n",
-        o1_data->interface_name, o1_data->status, 
-        o1_data->traceid, o1_data->spanid);
+    o1_buf_t *xml_msg = o1_rpc_pipeline_begin(client->pipeline);
+    if (!xml_msg) {
+        fprintf(stderr, "Failed to send edit-config\n");
+        return -1;
+    }
+    if (append_o1_edit_config(xml_msg, items, count) != 0) {
+        o1_rpc_pipeline_cancel(client->pipeline);
+        fprintf(stderr, "Failed to build edit-config\n");
+        return -1;
+    }
     
     // Send the message
-    int ret = nc_send_rpc(session, xml_msg, 1000, NULL);
-    if (ret != NC_MSG_RPC) {
-        fprintf(stderr, "Failed to send edit-config: %s\n", nc_strerror(ret));
+    uint64_t message_id;
+    if (o1_rpc_pipeline_commit(client->pipeline, handle_netconf_response, &client->stats,
+                               &message_id) != 0) {
+        fprintf(stderr, "Failed to send edit-config\n");
+        return -1;
+    }
+    
+    if (verbose) {
+        printf("O1 edit-config sent for %zu interface(s) starting at %s (message-id %llu)\n",
+               count, items[0].interface_name, (unsigned long long)message_id);
+    }
+    return 0;
+}
+
+int send_o1_edit_config(o1_client_t *client, const o1_interface_data_t *o1_data) {
+    return send_o1_edit_config_bulk(client, o1_data, 1);
+}
+
+// An operation without parameters, such as commit or discard-changes
+int send_o1_operation(o1_client_t *client, const char *operation) {
+    o1_buf_t *xml_msg = o1_rpc_pipeline_begin(client->pipeline);
+    if (!xml_msg || o1_buf_printf(xml_msg, "  <%s/>\n", operation) != 0) {
+        if (xml_msg) {
+            o1_rpc_pipeline_cancel(client->pipeline);
+        }
+        fprintf(stderr, "Failed to build %s\n", operation);
         return -1;
     }
     
-    printf("O1 edit-config sent for interface %s\n", o1_data->interface_name);
+    uint64_t message_id;
+    if (o1_rpc_pipeline_commit(client->pipeline, handle_netconf_response, &client->stats,
+                               &message_id) != 0) {
+        fprintf(stderr, "Failed to send %s\n", operation);
+        return -1;
+    }
+    
+    if (verbose) {
+        printf("O1 %s sent (message-id %llu)\n", operation, (unsigned long long)message_id);
+    }
     return 0;
 }
 
-int receive_netconf_response() {
-    if (!session) {
+void print_usage(const char *prog) {
+    printf("Usage: %s [-n interfaces] [-w window] [-b batch] [-R rounds] [-f hosts] [-c targets]\n"
+           "          [-C] [host] [port] [username] [password]\n"
+           "  -C  edit the candidate datastore and commit once all edits are in\n", prog);
+}
+
+double elapsed_seconds(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// One pass of the operations on a session from the pool; the session goes
+// back to the pool afterwards for the next round
+int run_round(const o1_config_t *config, o1_interface_data_t o1_data, int num_interfaces,
+              int window, int batch) {
+    o1_client_t client;
+    memset(&client, 0, sizeof(client));
+    
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (create_netconf_session(&client, config) != 0) {
         return -1;
     }
+    printf("Session ready in %.3f ms\n", elapsed_seconds(&start) * 1e3);
+    
+    client.pipeline = o1_rpc_pipeline_create(client.session, window);
+    if (!client.pipeline) {
+        fprintf(stderr, "Failed to create RPC pipeline\n");
+        release_netconf_session(&client);
+        return -1;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int expected;
+    
+    if (batch > 0) {
+        // Bulk mode: one edit-config per `batch` interfaces, pipelined
+        o1_interface_data_t *items = calloc(batch, sizeof(*items));
+        if (!items) {
+            fprintf(stderr, "Failed to allocate edit-config batch\n");
+            release_netconf_session(&client);
+            return -1;
+        }
+        
+        for (int i = 0; i < num_interfaces && running; i += batch) {
+            int count = num_interfaces - i < batch ? num_interfaces - i : batch;
+            int ok = 1;
+            for (int j = 0; j < count && ok; j++) {
+                items[j] = o1_data;
+                snprintf(items[j].interface_name, sizeof(items[j].interface_name), "eth%d", i + j);
+                ok = trace_id_fill(items[j].traceid, items[j].spanid) == 0;
+            }
+            if (!ok || send_o1_edit_config_bulk(&client, items, count) != 0) {
+                break;
+            }
+        }
+        free(items);
+        expected = (num_interfaces + batch - 1) / batch;
+    } else {
+        // Issue a get-config and an edit-config per interface without waiting
+        // for replies; up to `window` RPCs stay in flight
+        for (int i = 0; i < num_interfaces && running; i++) {
+            if (num_interfaces > 1) {
+                snprintf(o1_data.interface_name, sizeof(o1_data.interface_name), "eth%d", i);
+                if (trace_id_fill(o1_data.traceid, o1_data.spanid) != 0) {
+                    break;
+                }
+            }
+            
+            // Send O1 get-config operation
+            if (send_o1_get_config(&client, &o1_data) != 0) {
+                break;
+            }
+            
+            // Send O1 edit-config operation
+            if (send_o1_edit_config(&client, &o1_data) != 0) {
+                break;
+            }
+        }
+        expected = 2 * num_interfaces;
+    }
+    
+    // Wait for the remaining responses
+    o1_rpc_pipeline_drain(client.pipeline);
+    
+    // Candidate: running takes every edit at once, or none if any failed
+    if (strcmp(edit_target, "candidate") == 0) {
+        int clean = client.stats.errors == 0 && client.stats.failed == 0 && running;
+        if (send_o1_operation(&client, clean ? "commit" : "discard-changes") == 0) {
+            o1_rpc_pipeline_drain(client.pipeline);
+        }
+        expected++;
+    }
+    double seconds = elapsed_seconds(&start);
+    o1_rpc_stats_t *stats = &client.stats;
     
-    // Receive response
-    struct nc_msg *msg = NULL;
-    int ret = nc_recv_reply(session, NULL, 1000, &msg);
-    if (ret != NC_MSG_REPLY) {
-        fprintf(stderr, "Failed to receive response: %s\n", nc_strerror(ret));
+    printf("Completed %d/%d RPCs in %.3f s (%.0f RPCs/s): %d ok, %d rpc-error, %d failed\n",
+           stats->ok + stats->errors + stats->failed, expected, seconds,
+           (stats->ok + stats->errors) / seconds, stats->ok, stats->errors, stats->failed);
+    
+    int ok = stats->ok == expected;
+    release_netconf_session(&client);
+    return ok ? 0 : -1;
+}
+
+void free_targets(o1_fanout_result_t *targets, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free((char *)targets[i].target.host);
+    }
+    free(targets);
+}
+
+// Read a hosts file, one host or host:port per line; blank lines and lines
+// starting with # are skipped. Every target shares the login of config.
+int load_targets(const char *path, const o1_config_t *config, o1_fanout_result_t **targets,
+                 size_t *count) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror(path);
         return -1;
     }
     
-    printf("Received NETCONF response\n");
+    o1_fanout_result_t *list = NULL;
+    size_t len = 0, capacity = 0;
+    char line[512];
+    int ret = 0;
+    
+    while (fgets(line, sizeof(line), file)) {
+        char *host = line + strspn(line, " \t");
+        host[strcspn(host, " \t\r\n#")] = '\0';
+        if (host[0] == '\0') {
+            continue;
+        }
+        
+        int port = config->port;
+        char *colon = strrchr(host, ':');
+        if (colon) {
+            *colon = '\0';
+            port = atoi(colon + 1);
+        }
+        
+        if (len == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            o1_fanout_result_t *grown = realloc(list, capacity * sizeof(*list));
+            if (!grown) {
+                ret = -1;
+                break;
+            }
+            list = grown;
+        }
+        
+        o1_fanout_result_t *target = &list[len];
+        memset(target, 0, sizeof(*target));
+        target->target.host = strdup(host);
+        target->target.port = port;
+        target->target.username = config->username;
+        target->target.password = config->password;
+        target->target.private_key_path = config->private_key_path;
+        if (!target->target.host || port <= 0) {
+            fprintf(stderr, "%s: bad target '%s'\n", path, host);
+            free((char *)target->target.host);
+            ret = -1;
+            break;
+        }
+        len++;
+    }
+    fclose(file);
     
-    // In a real implementation, you would parse the XML response
-    // to extract the O1 interface data
+    if (ret == 0 && len == 0) {
+        fprintf(stderr, "%s: no targets\n", path);
+        ret = -1;
+    }
+    if (ret != 0) {
+        free_targets(list, len);
+        return -1;
+    }
     
-    nc_msg_free(msg);
+    *targets = list;
+    *count = len;
     return 0;
 }
 
+// One pass of the fan-out: the interfaces' edit-config goes to every target,
+// as a single RPC or, with a batch size, as one RPC per batch with up to
+// `window` of them in flight per target. With -C the edits go to each
+// target's candidate and a commit follows them; a target answers it only
+// after the edits, so running there changes once, with every batch that
+// was accepted.
+int run_fanout_round(o1_fanout_result_t *targets, size_t count, o1_interface_data_t o1_data,
+                     int num_interfaces, int batch) {
+    int commit = strcmp(edit_target, "candidate") == 0;
+    if (commit && batch <= 0) {
+        batch = num_interfaces;
+    }
+    o1_interface_data_t *items = calloc(num_interfaces, sizeof(*items));
+    int num_edits = batch > 0 ? (num_interfaces + batch - 1) / batch : 1;
+    int num_operations = num_edits + commit;
+    o1_buf_t *bufs = calloc(num_operations, sizeof(*bufs));
+    const char **operations = calloc(num_operations, sizeof(*operations));
+    o1_fanout_report_t *report = malloc(sizeof(*report));
+    int ret = items && bufs && operations && report ? 0 : -1;
+    
+    for (int i = 0; i < num_interfaces && ret == 0; i++) {
+        items[i] = o1_data;
+        if (num_interfaces > 1) {
+            snprintf(items[i].interface_name, sizeof(items[i].interface_name), "eth%d", i);
+            ret = trace_id_fill(items[i].traceid, items[i].spanid);
+        }
+    }
+    
+    if (ret == 0 && batch > 0) {
+        for (int i = 0; i < num_edits && ret == 0; i++) {
+            int first = i * batch;
+            int n = num_interfaces - first < batch ? num_interfaces - first : batch;
+            o1_buf_init(&bufs[i]);
+            ret = append_o1_edit_config(&bufs[i], &items[first], n);
+            operations[i] = bufs[i].data;
+        }
+        if (commit) {
+            operations[num_edits] = "  <commit/>\n";
+        }
+        if (ret == 0) {
+            ret = o1_fanout_run(fanout, targets, count, operations, num_operations, report);
+        }
+    } else if (ret == 0) {
+        o1_buf_init(&bufs[0]);
+        ret = append_o1_interfaces(&bufs[0], items, num_interfaces);
+        if (ret == 0) {
+            ret = o1_fanout_edit_config(fanout, targets, count, bufs[0].data, report);
+        }
+    }
+    
+    if (ret != 0) {
+        fprintf(stderr, "Failed to run fan-out\n");
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            const o1_fanout_result_t *target = &targets[i];
+            if (target->ok != num_operations) {
+                printf("  %s:%d: %d ok, %d rpc-error, %d failed in %.3f ms (connect %.3f ms)\n",
+                       target->target.host, target->target.port, target->ok, target->errors,
+                       target->failed, target->latency_ns / 1e6, target->connect_ns / 1e6);
+            }
+        }
+        
+        const o1_hist_t *per_target = &report->target_latency;
+        const o1_hist_t *per_rpc = &report->rpc_latency;
+        printf("Fan-out to %zu targets: %zu ok, %zu not ok in %.3f s (%.0f RPCs/s): "
+               "%llu ok, %llu rpc-error, %llu failed\n",
+               report->targets, report->targets_ok, report->targets - report->targets_ok,
+               report->seconds, report->rpcs_per_second, (unsigned long long)report->ok,
+               (unsigned long long)report->errors, (unsigned long long)report->failed);
+        printf("Target latency ms: p50 %.3f p99 %.3f max %.3f\n",
+               o1_hist_percentile(per_target, 50.0) / 1e6,
+               o1_hist_percentile(per_target, 99.0) / 1e6,
+               o1_hist_percentile(per_target, 100.0) / 1e6);
+        printf("RPC latency ms:    p50 %.3f p99 %.3f max %.3f\n",
+               o1_hist_percentile(per_rpc, 50.0) / 1e6,
+               o1_hist_percentile(per_rpc, 99.0) / 1e6,
+               o1_hist_percentile(per_rpc, 100.0) / 1e6);
+        ret = report->targets_ok == report->targets ? 0 : -1;
+    }
+    
+    for (int i = 0; bufs && i < num_edits; i++) {
+        o1_buf_free(&bufs[i]);
+    }
+    free(report);
+    free(operations);
+    free(bufs);
+    free(items);
+    return ret;
+}
+
 int main(int argc, char *argv[]) {
     o1_config_t config;
     o1_interface_data_t o1_data;
+    int num_interfaces = 1;
+    int window = O1_PIPELINE_DEFAULT_WINDOW;
+    int batch = 0;
+    int rounds = 1;
+    const char *hosts_path = NULL;
+    int max_active = O1_FANOUT_DEFAULT_MAX_ACTIVE;
     
     // Set default configuration
     strcpy(config.host, "127.0.0.1");
@@ -240,21 +625,73 @@ int main(int argc, char *argv[]) {
     strcpy(config.private_key_path, "config/id_rsa");
     
     // Parse command line arguments
-    if (argc > 1) {
-        strcpy(config.host, argv[1]);
+    int opt;
+    while ((opt = getopt(argc, argv, "n:w:b:R:f:c:Ch")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_interfaces = atoi(optarg);
+            break;
+        case 'w':
+            window = atoi(optarg);
+            break;
+        case 'b':
+            batch = atoi(optarg);
+            if (batch < 1) {
+                print_usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'R':
+            rounds = atoi(optarg);
+            break;
+        case 'f':
+            hosts_path = optarg;
+            break;
+        case 'c':
+            max_active = atoi(optarg);
+            break;
+        case 'C':
+            edit_target = "candidate";
+            break;
+        default:
+            print_usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (num_interfaces < 1 || window < 1 || rounds < 1 || max_active < 1) {
+        print_usage(argv[0]);
+        return 1;
     }
-    if (argc > 2) {
-        config.port = atoi(argv[2]);
+    
+    int pos = optind;
+    if (argc > pos) {
+        snprintf(config.host, sizeof(config.host), "%s", argv[pos]);
+    }
+    if (argc > pos + 1) {
+        config.port = atoi(argv[pos + 1]);
     }
-    if (argc > 3) {
-        strcpy(config.username, argv[3]);
+    if (argc > pos + 2) {
+        snprintf(config.username, sizeof(config.username), "%s", argv[pos + 2]);
     }
-    if (argc > 4) {
-        strcpy(config.password, argv[4]);
+    if (argc > pos + 3) {
+        snprintf(config.password, sizeof(config.password), "%s", argv[pos + 3]);
+    }
+    verbose = num_interfaces == 1 && !hosts_path;
+    
+    // Fan-out mode: the same edit-config to every host in the file
+    o1_fanout_result_t *targets = NULL;
+    size_t num_targets = 0;
+    if (hosts_path && load_targets(hosts_path, &config, &targets, &num_targets) != 0) {
+        return 1;
     }
     
     printf("O1 Interface NETCONF Client\n");
-    printf("Connecting to %s:%d as %s\n", config.host, config.port, config.username);
+    if (targets) {
+        printf("Fanning out to %zu targets from %s as %s, %d at a time\n",
+               num_targets, hosts_path, config.username, max_active);
+    } else {
+        printf("Connecting to %s:%d as %s\n", config.host, config.port, config.username);
+    }
     
     // Set up signal handler
     signal(SIGINT, signal_handler);
@@ -263,9 +700,24 @@ int main(int argc, char *argv[]) {
     // Initialize NETCONF
     init_netconf();
     
+    if (targets) {
+        o1_fanout_config_t fanout_config;
+        o1_fanout_default_config(&fanout_config);
+        fanout_config.max_active = max_active;
+        fanout_config.per_target = window;
+        fanout = o1_fanout_create(&fanout_config, client_pool);
+        if (!fanout) {
+            fprintf(stderr, "Failed to create fan-out\n");
+            free_targets(targets, num_targets);
+            cleanup_netconf();
+            return 1;
+        }
+    }
+    
     // Generate O1 interface data
     if (generate_tracing_data(&o1_data) != 0) {
         fprintf(stderr, "Failed to generate O1 data\n");
+        free_targets(targets, num_targets);
         cleanup_netconf();
         return 1;
     }
@@ -273,40 +725,23 @@ int main(int argc, char *argv[]) {
     printf("Generated O1 interface data:\n");
     print_o1_data(&o1_data);
     
-    // Create NETCONF session
-    if (create_netconf_session(&config) != 0) {
-        fprintf(stderr, "Failed to create NETCONF session\n");
-        cleanup_netconf();
-        return 1;
-    }
-    
-    // Send O1 get-config operation
-    if (send_o1_get_config(&o1_data) != 0) {
-        fprintf(stderr, "Failed to send get-config\n");
-        cleanup_netconf();
-        return 1;
-    }
-    
-    // Receive response
-    if (receive_netconf_response() != 0) {
-        fprintf(stderr, "Failed to receive get-config response\n");
-        cleanup_netconf();
-        return 1;
-    }
-    
-    // Send O1 edit-config operation
-    if (send_o1_edit_config(&o1_data) != 0) {
-        fprintf(stderr, "Failed to send edit-config\n");
-        cleanup_netconf();
-        return 1;
+    for (int round = 1; round <= rounds && running; round++) {
+        int ret = targets ?
+            run_fanout_round(targets, num_targets, o1_data, num_interfaces, batch) :
+            run_round(&config, o1_data, num_interfaces, window, batch);
+        if (ret != 0) {
+            fprintf(stderr, "Failed to complete O1 interface operations\n");
+            free_targets(targets, num_targets);
+            cleanup_netconf();
+            return 1;
+        }
     }
+    free_targets(targets, num_targets);
     
-    // Receive response
-    if (receive_netconf_response() != 0) {
-        fprintf(stderr, "Failed to receive edit-config response\n");
-        cleanup_netconf();
-        return 1;
-    }
+    o1_client_pool_stats_t pool_stats;
+    o1_client_pool_stats(client_pool, &pool_stats);
+    printf("Sessions: %llu connected, %llu reused\n",
+           (unsigned long long)pool_stats.connects, (unsigned long long)pool_stats.hits);
     
     printf("Successfully completed O1 interface operations via NETCONF\n");
     
@@ -315,4 +750,4 @@ int main(int argc, char *argv[]) {
     
     printf("O1 NETCONF client completed successfully\n");
     return 0;
-} 
\ No newline at end of file
+}
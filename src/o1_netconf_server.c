@@ -1,3 +1,4 @@
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,17 +16,28 @@
 #include <libnetconf2/log.h>
 #include <libyang/libyang.h>
 
-// O1 interface structures
-typedef struct {
-    char traceid[33];      // 32 hex chars + null terminator
-    char spanid[17];       // 16 hex chars + null terminator
-    char interface_name[64];
-    char operation[32];    // "get", "set", "delete"
-    char status[32];       // "up", "down", "error"
-} o1_interface_data_t;
+#include "log.h"
+#include "o1_candidate.h"
+#include "o1_datastore.h"
+#include "o1_handshake.h"
+#include "o1_metrics.h"
+#include "o1_reply.h"
+#include "o1_rpc.h"
+#include "o1_session_pool.h"
+#include "o1_stats_feed.h"
+#include "o1_wal.h"
+#include "o1_yang_ctx.h"
 
 static volatile int running = 1;
 static int server_socket = -1;
+static o1_session_pool_t *session_pool = NULL;
+static o1_handshake_pool_t *handshake_pool = NULL;
+static o1_datastore_t *datastore = NULL;
+static o1_candidate_t *candidate = NULL;
+static o1_wal_t *wal = NULL;
+static o1_stats_t *stats = NULL;
+static o1_stats_feed_t *stats_feed = NULL;
+static int pretty_replies = 0;
 
 void signal_handler(int sig) {
     printf("\nReceived signal %d, shutting down...\n", sig);
@@ -35,7 +47,28 @@ void signal_handler(int sig) {
     }
 }
 
-void init_netconf() {
+// libnetconf2 messages go through the same asynchronous log
+static void log_libnetconf2(NC_VERB_LEVEL level, const char *msg) {
+    switch (level) {
+    case NC_VERB_ERROR:
+        log_error("libnetconf2: %s", msg);
+        break;
+    case NC_VERB_WARNING:
+        log_warn("libnetconf2: %s", msg);
+        break;
+    default:
+        log_debug("libnetconf2: %s", msg);
+        break;
+    }
+}
+
+void init_netconf(const char *yang_dir, const char *yang_cache, log_level_t log_level) {
+    // Build the schema context once; every session thread shares it read-only
+    if (o1_yang_ctx_init(yang_dir, yang_cache) != 0) {
+        fprintf(stderr, "Failed to load O1 YANG modules from %s\n", yang_dir);
+        exit(1);
+    }
+    
     // Initialize libnetconf2
     int ret = nc_init();
     if (ret != 0) {
@@ -43,13 +76,25 @@ void init_netconf() {
         exit(1);
     }
     
-    // Set logging level
-    nc_verbosity(NC_VERB_VERBOSE);
+    // Sessions accepted from here on are created on the shared context
+    // instead of each building its own
+    ret = nc_server_init(o1_yang_ctx_get());
+    if (ret != 0) {
+        fprintf(stderr, "Failed to initialize the NETCONF server\n");
+        exit(1);
+    }
+    
+    // Verbose libnetconf2 output only when debugging
+    nc_set_print_clb(log_libnetconf2);
+    nc_verbosity(log_level >= LOG_LEVEL_DEBUG ? NC_VERB_VERBOSE :
+                 log_level >= LOG_LEVEL_WARN ? NC_VERB_WARNING : NC_VERB_ERROR);
     
     printf("NETCONF initialized for O1 interface server\n");
 }
 
 void cleanup_netconf() {
+    nc_server_destroy();
+    o1_yang_ctx_cleanup();
     printf("NETCONF cleaned up\n");
 }
 
@@ -80,7 +125,7 @@ int setup_server_socket(int port) {
         return -1;
     }
     
-    if (listen(sock, 5) < 0) {
+    if (listen(sock, SOMAXCONN) < 0) {
         perror("Listen failed");
         close(sock);
         return -1;
@@ -89,265 +134,340 @@ int setup_server_socket(int port) {
     return sock;
 }
 
-void print_o1_data(const o1_interface_data_t *o1_data) {
-    if (!o1_data) {
-        printf("O1 data: NULL\n");
-        return;
-    }
-    
-    printf("O1 Interface Data:\n");
-    printf("  TraceID:       %s\n", o1_data->traceid);
-    printf("  SpanID:        %s\n", o1_data->spanid);
-    printf("  Interface:     %s\n", o1_data->interface_name);
-    printf("  Operation:     %s\n", o1_data->operation);
-    printf("  Status:        %s\n", o1_data->status);
-}
-
-int parse_o1_get_config(const char *xml_data, o1_interface_data_t *o1_data) {
-    if (!xml_data || !o1_data) {
+// Send the reply left in the session's builder. libnetconf2 takes the
+// reply as one string, so this is the single place its segments are
+// gathered, into the builder's own flat buffer.
+static int send_reply(struct nc_session *session, o1_reply_t *reply) {
+    const char *xml = o1_reply_flatten(reply);
+    if (!xml) {
+        log_error("Failed to build reply");
+        o1_metrics_add(O1_METRIC_SEND_FAILURES, 1);
         return -1;
     }
     
-    // Simple XML parsing for get-config
-    char *interface_start = strstr(xml_data, "<name>");
-    if (interface_start) {
-        interface_start += 6; // Skip "<name>"
-        char *interface_end = strstr(interface_start, "</name>");
-        if (interface_end) {
-            int len = interface_end - interface_start;
-            if (len < sizeof(o1_data->interface_name)) {
-                strncpy(o1_data->interface_name, interface_start, len);
-                o1_data->interface_name[len] = '\0';
-                strcpy(o1_data->operation, "get");
-                return 0;
-            }
-        }
+    int ret = nc_send_reply(session, xml, 1000);
+    if (ret != NC_MSG_REPLY) {
+        log_error("Failed to send reply: %s", nc_strerror(ret));
+        o1_metrics_add(O1_METRIC_SEND_FAILURES, 1);
+        return -1;
     }
     
-    return -1;
+    o1_metrics_add(O1_METRIC_REPLY_BYTES, o1_reply_length(reply));
+    return 0;
 }
 
-int parse_o1_edit_config(const char *xml_data, o1_interface_data_t *o1_data) {
-    if (!xml_data || !o1_data) {
+int handle_rpc_message(struct nc_session *session, struct nc_msg *msg) {
+    uint64_t start = o1_metrics_now();
+    
+    // Handle RPC message
+    log_debug("Received RPC message from client");
+    
+    // Raw RPC text as received; the parsers return views into this buffer
+    size_t xml_len = 0;
+    const char *xml_data = nc_msg_get_data(msg, &xml_len);
+    if (!xml_data) {
+        log_error("Received RPC message without data");
         return -1;
     }
     
-    // Simple XML parsing for edit-config
-    char *interface_start = strstr(xml_data, "<name>");
-    char *status_start = strstr(xml_data, "<status>");
-    char *traceid_start = strstr(xml_data, "<traceid>");
-    char *spanid_start = strstr(xml_data, "<spanid>");
-    
-    if (interface_start && status_start && traceid_start && spanid_start) {
-        // Parse interface name
-        interface_start += 6;
-        char *interface_end = strstr(interface_start, "</name>");
-        if (interface_end) {
-            int len = interface_end - interface_start;
-            if (len < sizeof(o1_data->interface_name)) {
-                strncpy(o1_data->interface_name, interface_start, len);
-                o1_data->interface_name[len] = '\0';
-            }
-        }
-        
-        // Parse status
-        status_start += 8;
-        char *status_end = strstr(status_start, "</status>");
-        if (status_end) {
-            int len = status_end - status_start;
-            if (len < sizeof(o1_data->status)) {
-                strncpy(o1_data->status, status_start, len);
-                o1_data->status[len] = '\0';
-            }
-        }
-        
-        // Parse traceid
-        traceid_start += 9;
-        char *traceid_end = strstr(traceid_start, "</traceid>");
-        if (traceid_end) {
-            int len = traceid_end - traceid_start;
-            if (len < sizeof(o1_data->traceid)) {
-                strncpy(o1_data->traceid, traceid_start, len);
-                o1_data->traceid[len] = '\0';
-            }
-        }
-        
-        // Parse spanid
-        spanid_start += 8;
-        char *spanid_end = strstr(spanid_start, "</spanid>");
-        if (spanid_end) {
-            int len = spanid_end - spanid_start;
-            if (len < sizeof(o1_data->spanid)) {
-                strncpy(o1_data->spanid, spanid_start, len);
-                o1_data->spanid[len] = '\0';
-            }
-        }
-        
-        strcpy(o1_data->operation, "edit");
-        return 0;
+    log_debug("Processing NETCONF RPC message");
+    
+    // Decode, dispatch and build the reply in the session's own memory
+    o1_rpc_session_t *rpc = nc_session_get_data(session);
+    if (!rpc || o1_rpc_handle(rpc, xml_data, xml_len) != 0) {
+        log_error("Failed to build reply");
+        o1_metrics_add(O1_METRIC_SEND_FAILURES, 1);
+        return -1;
+    }
+    if (rpc->malformed) {
+        o1_metrics_add(O1_METRIC_PARSE_FAILURES, 1);
     }
     
-    return -1;
+    int ret = send_reply(session, &rpc->reply);
+    o1_metrics_rpc(rpc->op, o1_metrics_now() - start, rpc->error);
+    return ret;
 }
 
-int handle_netconf_message(struct nc_session *session, const char *xml_data) {
-    if (!session || !xml_data) {
+// Called on a handshake thread once a session is established
+static int handle_established_session(struct nc_session *session, int client_socket, void *arg) {
+    (void)arg;
+    
+    // Per-session RPC state, released by the pool together with the session
+    o1_rpc_session_t *rpc = o1_rpc_session_create(datastore, candidate, pretty_replies);
+    if (!rpc) {
+        log_error("Failed to allocate session state");
         return -1;
     }
+    nc_session_set_data(session, rpc);
     
-    o1_interface_data_t o1_data;
-    memset(&o1_data, 0, sizeof(o1_data));
-    
-    // Determine message type and parse accordingly
-    if (strstr(xml_data, "<get-config>")) {
-        printf("Received get-config request\n");
-        if (parse_o1_get_config(xml_data, &o1_data) == 0) {
-            print_o1_data(&o1_data);
-            
-            // Send get-config response
-            char response[2048];
-            snprintf(response, sizeof(response),
-                "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
-                "<rpc-reply xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"1\">\n"
-                "  <data>\n"
-                "    <o1-interface xmlns=\"urn:example:o1-interface\">\n"
-                "      <name>%s</name>\n"
-                "      <status>up</status>\n"
-                "      <tracing>\n"
-                "        <traceid>%s</traceid>\n"
-                "        <spanid>%s</spanid>\n"
-                "      </tracing>\n"
-                "    </o1-interface>\n"
-                "  </data>\n"
-                "</rpc-reply>\n",
-                o1_data.interface_name, o1_data.traceid, o1_data.spanid);
-            
-            int ret = nc_send_reply(session, response, 1000);
-            if (ret != NC_MSG_REPLY) {
-                fprintf(stderr, "Failed to send get-config response: %s\n", nc_strerror(ret));
-                return -1;
-            }
-            
-            printf("Sent get-config response\n");
-        }
-        
-    } else if (strstr(xml_data, "<edit-config>")) {
-        printf("Received edit-config request\n");
-        if (parse_o1_edit_config(xml_data, &o1_data) == 0) {
-            print_o1_data(&o1_data);
-            
-            // Process the O1 interface configuration
-            printf("Processing O1 interface configuration for %s\n", o1_data.interface_name);
-            
-            // Send edit-config response
-            char response[512];
-            snprintf(response, sizeof(response),
-                "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
-                "<rpc-reply xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\" message-id=\"2\">\n"
-                "  <ok/>\n"
-                "</rpc-reply>\n");
-            
-            int ret = nc_send_reply(session, response, 1000);
-            if (ret != NC_MSG_REPLY) {
-                fprintf(stderr, "Failed to send edit-config response: %s\n", nc_strerror(ret));
-                return -1;
-            }
-            
-            printf("Sent edit-config response\n");
-        }
-        
-    } else {
-        printf("Unknown NETCONF message type\n");
+    // Only established sessions reach the session workers
+    if (o1_session_pool_submit(session_pool, session, client_socket) != 0) {
+        log_warn("Session limit reached, rejecting client");
+        o1_metrics_add(O1_METRIC_SESSIONS_REJECTED, 1);
+        nc_session_set_data(session, NULL);
+        o1_rpc_session_destroy(rpc);
         return -1;
     }
     
+    o1_metrics_add(O1_METRIC_SESSIONS_ACCEPTED, 1);
     return 0;
 }
 
-int handle_client_connection(int client_socket) {
-    printf("New client connected\n");
-    
-    // Initialize NETCONF session for this client
-    struct nc_session *session = NULL;
-    int ret = nc_accept_ssh(client_socket, NULL, NULL, &session);
-    if (ret != NC_MSG_HELLO) {
-        fprintf(stderr, "Failed to accept NETCONF session: %s\n", nc_strerror(ret));
+int handle_client_connection(int client_socket, int max_sessions) {
+    log_debug("New client connected");
+    
+    // Refuse before the key exchange if the session could not be served
+    // anyway, so a reconnect storm costs no handshake work beyond the limit
+    if (o1_session_pool_active(session_pool) + o1_handshake_pending(handshake_pool) >= max_sessions) {
+        log_warn("Session limit reached, rejecting client");
+        o1_metrics_add(O1_METRIC_HANDSHAKES_SHED, 1);
         close(client_socket);
         return -1;
     }
     
-    printf("NETCONF session established with client\n");
-    
-    // Handle NETCONF messages
-    while (running) {
-        struct nc_msg *msg = NULL;
-        ret = nc_recv_msg(session, 1000, &msg);
-        
-        if (ret == NC_MSG_RPC) {
-            // Handle RPC message
-            printf("Received RPC message from client\n");
-            
-            // Extract XML data from the message
-            // In a real implementation, you would use proper XML parsing
-            char xml_data[4096];
-            // This is a simplified approach - in production, use proper XML parsing
-            printf("Processing NETCONF RPC message\n");
-            
-            // Handle the message
-            handle_netconf_message(session, xml_data);
-            
-        } else if (ret == NC_MSG_CLOSE) {
-            printf("Client closed connection\n");
-            break;
-        } else if (ret == NC_MSG_ERROR) {
-            fprintf(stderr, "Received error message from client\n");
-            break;
-        } else if (ret == NC_MSG_WOULDBLOCK) {
-            // Timeout, continue
-            continue;
-        } else {
-            fprintf(stderr, "Unexpected message type: %d\n", ret);
-            break;
-        }
-        
-        nc_msg_free(msg);
-    }
-    
-    // Cleanup
-    if (session) {
-        nc_session_free(session, NULL);
+    // The handshake runs on the handshake pool; the accept loop moves on immediately
+    if (o1_handshake_submit(handshake_pool, client_socket) != 0) {
+        log_warn("Handshake queue full, rejecting client");
+        close(client_socket);
+        return -1;
     }
-    close(client_socket);
     
     return 0;
 }
 
+void print_usage(const char *prog) {
+    printf("Usage: %s [-w workers] [-q queue-size] [-m max-sessions] [-H handshake-threads]\n"
+           "       [-Q handshake-queue] [-T handshake-wait-ms] [-c capacity] [-y yang-dir] [-Y yang-cache] [-i]\n"
+           "       [-l error|warn|info|debug] [-L log-file] [-B] [-r log-rate] [-M metrics-port]\n"
+           "       [-S stats-socket] [-D data-dir] [-P snapshot-ms] [port]\n", prog);
+}
+
 int main(int argc, char *argv[]) {
     int port = 830;
+    int metrics_port = 0;
+    const char *stats_socket = NULL;
+    long capacity = O1_DS_DEFAULT_CAPACITY;
+    const char *yang_dir = O1_YANG_DEFAULT_DIR;
+    const char *yang_cache = NULL;
+    o1_session_pool_config_t pool_config;
+    o1_session_pool_default_config(&pool_config);
+    pool_config.session_data_free = o1_rpc_session_destroy;
+    o1_handshake_config_t handshake_config;
+    o1_handshake_default_config(&handshake_config);
+    o1_wal_config_t wal_config;
+    o1_wal_default_config(&wal_config);
+    log_config_t log_config;
+    log_default_config(&log_config);
     
     // Parse command line arguments
-    if (argc > 1) {
-        port = atoi(argv[1]);
+    int opt;
+    while ((opt = getopt(argc, argv, "w:q:m:H:Q:T:c:y:Y:il:L:Br:M:S:D:P:h")) != -1) {
+        switch (opt) {
+        case 'w':
+            pool_config.num_workers = atoi(optarg);
+            break;
+        case 'q':
+            pool_config.queue_size = atoi(optarg);
+            break;
+        case 'm':
+            pool_config.max_sessions = atoi(optarg);
+            break;
+        case 'H':
+            handshake_config.num_threads = atoi(optarg);
+            break;
+        case 'Q':
+            handshake_config.queue_size = atoi(optarg);
+            break;
+        case 'T':
+            handshake_config.max_wait = atoi(optarg);
+            break;
+        case 'c':
+            capacity = atol(optarg);
+            break;
+        case 'y':
+            yang_dir = optarg;
+            break;
+        case 'Y':
+            yang_cache = optarg;
+            break;
+        case 'i':
+            pretty_replies = 1;
+            break;
+        case 'l':
+            if (log_parse_level(optarg, &log_config.level) != 0) {
+                fprintf(stderr, "Unknown log level %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'L':
+            log_config.path = optarg;
+            break;
+        case 'B':
+            log_config.binary = 1;
+            break;
+        case 'r':
+            log_config.rate_limit = (unsigned)atoi(optarg);
+            break;
+        case 'M':
+            metrics_port = atoi(optarg);
+            break;
+        case 'S':
+            stats_socket = optarg;
+            break;
+        case 'D':
+            wal_config.dir = optarg;
+            break;
+        case 'P':
+            wal_config.snapshot_interval = atoi(optarg);
+            break;
+        default:
+            print_usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (optind < argc) {
+        port = atoi(argv[optind]);
     }
     
     printf("O1 Interface NETCONF Server\n");
     printf("Starting server on port %d\n", port);
     
+    // Binary records need a file; they are unreadable on a terminal
+    if (log_config.binary && !log_config.path) {
+        fprintf(stderr, "-B needs a log file (-L)\n");
+        return 1;
+    }
+    if (log_init(&log_config) != 0) {
+        return 1;
+    }
+    
     // Initialize NETCONF
-    init_netconf();
+    init_netconf(yang_dir, yang_cache, log_config.level);
     
     // Set up signal handler
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
     
+    // Metrics are always recorded; -M serves them for scraping
+    o1_metrics_init(o1_rpc_op_names, O1_RPC_OP_COUNT);
+    if (metrics_port > 0) {
+        if (o1_metrics_listen(metrics_port) != 0) {
+            cleanup_netconf();
+            log_shutdown();
+            return 1;
+        }
+        printf("Metrics at http://0.0.0.0:%d/metrics\n", metrics_port);
+    }
+    
+    // Running datastore, shared by every session worker
+    datastore = capacity > 0 ? o1_datastore_create((size_t)capacity) : NULL;
+    if (!datastore) {
+        fprintf(stderr, "Failed to create datastore for %ld interfaces\n", capacity);
+        o1_metrics_shutdown();
+        cleanup_netconf();
+        log_shutdown();
+        return 1;
+    }
+    printf("Running datastore holds up to %ld interfaces\n", capacity);
+    
+    // Candidate datastore: edits held over running until a commit
+    candidate = o1_candidate_create(datastore, (size_t)capacity);
+    if (!candidate) {
+        fprintf(stderr, "Failed to create candidate datastore\n");
+        o1_metrics_shutdown();
+        o1_datastore_destroy(datastore);
+        cleanup_netconf();
+        log_shutdown();
+        return 1;
+    }
+    
+    // -D: reload the configuration saved by the last run and log every
+    // change before it is acknowledged
+    if (wal_config.dir) {
+        wal = o1_wal_open(&wal_config, datastore);
+        if (!wal) {
+            fprintf(stderr, "Failed to load running configuration from %s\n", wal_config.dir);
+            o1_metrics_shutdown();
+            o1_candidate_destroy(candidate);
+            o1_datastore_destroy(datastore);
+            cleanup_netconf();
+            log_shutdown();
+            return 1;
+        }
+        o1_wal_stats_t wal_stats;
+        o1_wal_stats(wal, &wal_stats);
+        printf("Running configuration: %zu interfaces from %s in %.3f s\n",
+               o1_datastore_count(datastore), wal_config.dir, wal_stats.load_seconds);
+    }
+    
+    // Start the session workers
+    session_pool = o1_session_pool_create(&pool_config, handle_rpc_message);
+    if (!session_pool) {
+        fprintf(stderr, "Failed to start session pool\n");
+        o1_metrics_shutdown();
+        o1_wal_close(wal);
+        o1_candidate_destroy(candidate);
+        o1_datastore_destroy(datastore);
+        cleanup_netconf();
+        log_shutdown();
+        return 1;
+    }
+    
+    // SSH handshakes run on their own threads, ahead of the session workers
+    handshake_pool = o1_handshake_pool_create(&handshake_config, handle_established_session, NULL);
+    if (!handshake_pool) {
+        fprintf(stderr, "Failed to start handshake pool\n");
+        o1_session_pool_destroy(session_pool);
+        o1_metrics_shutdown();
+        o1_wal_close(wal);
+        o1_candidate_destroy(candidate);
+        o1_datastore_destroy(datastore);
+        cleanup_netconf();
+        log_shutdown();
+        return 1;
+    }
+    
     // Create server socket
     server_socket = setup_server_socket(port);
     if (server_socket < 0) {
         fprintf(stderr, "Failed to setup server socket\n");
+        o1_handshake_pool_destroy(handshake_pool);
+        o1_session_pool_destroy(session_pool);
+        o1_metrics_shutdown();
+        o1_wal_close(wal);
+        o1_candidate_destroy(candidate);
+        o1_datastore_destroy(datastore);
         cleanup_netconf();
+        log_shutdown();
         return 1;
     }
     
+    // Live statistics: one shard per core, fed over a local socket
+    if (stats_socket) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        int shards = cores < 1 ? 1 : cores > O1_STATS_MAX_SHARDS ? O1_STATS_MAX_SHARDS : (int)cores;
+        stats = o1_stats_create((size_t)capacity, shards);
+        if (stats) {
+            o1_datastore_set_stats(datastore, stats);
+            stats_feed = o1_stats_feed_start(stats_socket, datastore, stats);
+        }
+        if (!stats_feed) {
+            fprintf(stderr, "Failed to start statistics feed on %s\n", stats_socket);
+            close(server_socket);
+            o1_handshake_pool_destroy(handshake_pool);
+            o1_session_pool_destroy(session_pool);
+            o1_metrics_shutdown();
+            o1_wal_close(wal);
+            o1_candidate_destroy(candidate);
+            o1_datastore_destroy(datastore);
+            o1_stats_destroy(stats);
+            cleanup_netconf();
+            log_shutdown();
+            return 1;
+        }
+        printf("Statistics feed on %s, %d shards\n", stats_socket, shards);
+    }
+    
     printf("O1 NETCONF server listening on port %d\n", port);
     printf("Press Ctrl+C to stop the server\n");
     
@@ -359,16 +479,15 @@ int main(int argc, char *argv[]) {
         int client_socket = accept(server_socket, (struct sockaddr*)&client_addr, &client_len);
         if (client_socket < 0) {
             if (running) {
-                perror("Accept failed");
+                log_error("Accept failed: %s", strerror(errno));
             }
             continue;
         }
         
-        printf("Client connected from %s:%d\n", 
-               inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
+        log_info("Client connected from %s:%d",
+                 inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
         
-        // Handle client (in a real application, you'd use threads)
-        handle_client_connection(client_socket);
+        handle_client_connection(client_socket, pool_config.max_sessions);
     }
     
     // Cleanup
@@ -376,8 +495,20 @@ int main(int argc, char *argv[]) {
         close(server_socket);
     }
     
+    // Stop handshakes first: they hand sessions to the session pool
+    o1_handshake_pool_destroy(handshake_pool);
+    o1_session_pool_destroy(session_pool);
+    o1_stats_feed_stop(stats_feed);
+    o1_metrics_shutdown();
+    printf("Running datastore: %zu interfaces, %zu KB\n",
+           o1_datastore_count(datastore), o1_datastore_memory(datastore) / 1024);
+    o1_wal_close(wal);
+    o1_candidate_destroy(candidate);
+    o1_datastore_destroy(datastore);
+    o1_stats_destroy(stats);
     cleanup_netconf();
+    log_shutdown();
     printf("O1 NETCONF server stopped\n");
     
     return 0;
-} 
\ No newline at end of file
+}
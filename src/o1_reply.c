@@ -0,0 +1,439 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "o1_reply.h"
+#include "o1_xml.h"
+
+#define O1_REPLY_MIN_SEGS 32
+#define O1_REPLY_MAX_INDENT 64
+
+// Fragments up to this size are copied next to the variable text rather
+// than referenced. Copying is cheaper than an extra segment to track and
+// gather, and it keeps a typical reply entirely in the text buffer, which
+// o1_reply_flatten() hands out without copying again. The prolog is the
+// longest fragment a reply always carries.
+#define O1_REPLY_INLINE_MAX 128
+
+// Prolog up to the message-id value, or up to the end of the <rpc-reply>
+// start tag for a reply without one
+#define REPLY_HEAD \
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" \
+    "<rpc-reply xmlns=\"" O1_NS_NETCONF "\""
+static const char reply_head_id[] = REPLY_HEAD " message-id=\"";
+static const char reply_head[] = REPLY_HEAD;
+static const char reply_head_end[] = ">\n";
+static const char reply_tail[] = "</rpc-reply>\n";
+static const char spaces[O1_REPLY_MAX_INDENT + 1] =
+    "                                                                ";
+
+static const o1_reply_tag_t tag_ok = O1_REPLY_TAG("ok");
+static const o1_reply_tag_t tag_rpc_error = O1_REPLY_TAG("rpc-error");
+static const o1_reply_tag_t tag_error_type = O1_REPLY_TAG("error-type");
+static const o1_reply_tag_t tag_error_tag = O1_REPLY_TAG("error-tag");
+static const o1_reply_tag_t tag_error_severity = O1_REPLY_TAG("error-severity");
+
+void o1_reply_init(o1_reply_t *reply, int pretty) {
+    memset(reply, 0, sizeof(*reply));
+    o1_buf_init(&reply->text);
+    o1_buf_init(&reply->flat);
+    reply->pretty = pretty != 0;
+}
+
+// Keep every allocation for the next reply
+void o1_reply_reset(o1_reply_t *reply) {
+    reply->count = 0;
+    reply->len = 0;
+    reply->depth = 0;
+    reply->failed = 0;
+    o1_buf_reset(&reply->text);
+}
+
+void o1_reply_free(o1_reply_t *reply) {
+    free(reply->segs);
+    free(reply->iov);
+    o1_buf_free(&reply->text);
+    o1_buf_free(&reply->flat);
+    o1_reply_init(reply, reply->pretty);
+}
+
+static inline o1_reply_seg_t *next_seg(o1_reply_t *reply) {
+    if (reply->count == reply->cap) {
+        size_t cap = reply->cap ? reply->cap * 2 : O1_REPLY_MIN_SEGS;
+        o1_reply_seg_t *segs = realloc(reply->segs, cap * sizeof(*segs));
+        if (!segs) {
+            reply->failed = 1;
+            return NULL;
+        }
+        reply->segs = segs;
+        reply->cap = cap;
+    }
+    return &reply->segs[reply->count++];
+}
+
+// memcpy for len <= 32 as at most two overlapping fixed-size moves, which
+// the compiler inlines; a libc call costs more than the copy at this size
+static inline void copy_short(char *dst, const char *src, size_t len) {
+    if (len >= 16) {
+        memcpy(dst, src, 16);
+        memcpy(dst + len - 16, src + len - 16, 16);
+    } else if (len >= 8) {
+        memcpy(dst, src, 8);
+        memcpy(dst + len - 8, src + len - 8, 8);
+    } else if (len >= 4) {
+        memcpy(dst, src, 4);
+        memcpy(dst + len - 4, src + len - 4, 4);
+    } else {
+        for (size_t i = 0; i < len; i++) {
+            dst[i] = src[i];
+        }
+    }
+}
+
+// Room for len more bytes of text, plus the terminator o1_reply_flatten()
+// may write. NULL once the reply has failed.
+static inline char *text_reserve(o1_reply_t *reply, size_t len) {
+    o1_buf_t *text = &reply->text;
+    
+    if (reply->failed) {
+        return NULL;
+    }
+    if (text->len + len >= text->cap && o1_buf_reserve(text, len) != 0) {
+        reply->failed = 1;
+        return NULL;
+    }
+    return text->data + text->len;
+}
+
+// Copy into reserved text; returns the end of the copy
+static inline char *put(char *dst, const char *src, size_t len) {
+    if (len <= 32) {
+        copy_short(dst, src, len);
+    } else {
+        memcpy(dst, src, len);
+    }
+    return dst + len;
+}
+
+// Append to the text buffer
+static inline void text_copy(o1_reply_t *reply, const char *ptr, size_t len) {
+    char *dst = text_reserve(reply, len);
+    if (dst) {
+        memcpy(dst, ptr, len);
+        reply->text.len += len;
+    }
+}
+
+// Characters that must be written as entities in text and attributes
+static const unsigned char xml_special[256] = { ['&'] = 1, ['<'] = 1, ['>'] = 1, ['"'] = 1 };
+
+// Length of the prefix of value free of XML special characters. Trace and
+// span IDs are checked 16 bytes at a time.
+static inline size_t clean_prefix(const char *value, size_t len) {
+    size_t clean = 0;
+
+#ifdef __SSE2__
+    for (; clean + 16 <= len; clean += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(value + clean));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('&')), _mm_cmpeq_epi8(v, _mm_set1_epi8('<'))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('>')), _mm_cmpeq_epi8(v, _mm_set1_epi8('"'))));
+        unsigned mask = (unsigned)_mm_movemask_epi8(special);
+        if (mask) {
+            return clean + (size_t)__builtin_ctz(mask);
+        }
+    }
+#endif
+    
+    while (clean < len && !xml_special[(unsigned char)value[clean]]) {
+        clean++;
+    }
+    return clean;
+}
+
+// Append value to the text buffer with the XML special characters escaped
+static void text_escape(o1_reply_t *reply, const char *value, size_t len) {
+    size_t clean = clean_prefix(value, len);
+    text_copy(reply, value, clean);
+    
+    // Rare: names and identifiers seldom need escaping
+    size_t start = clean;
+    for (size_t i = clean; i < len; i++) {
+        if (!xml_special[(unsigned char)value[i]]) {
+            continue;
+        }
+        const char *entity = value[i] == '&' ? "&amp;" : value[i] == '<' ? "&lt;" :
+                             value[i] == '>' ? "&gt;" : "&quot;";
+        text_copy(reply, value + start, i - start);
+        text_copy(reply, entity, strlen(entity));
+        start = i + 1;
+    }
+    text_copy(reply, value + start, len - start);
+}
+
+// Reference a constant fragment, which must outlive the reply, or copy it
+// if it is short
+static inline void push_const(o1_reply_t *reply, const char *ptr, size_t len) {
+    if (len == 0 || reply->failed) {
+        return;
+    }
+    if (len <= O1_REPLY_INLINE_MAX) {
+        text_copy(reply, ptr, len);
+        return;
+    }
+    
+    o1_reply_seg_t *last = reply->count ? &reply->segs[reply->count - 1] : NULL;
+    if (last && last->off == reply->text.len && last->ptr + last->len == ptr) {
+        last->len += len;
+    } else {
+        o1_reply_seg_t *seg = next_seg(reply);
+        if (!seg) {
+            return;
+        }
+        seg->ptr = ptr;
+        seg->off = reply->text.len;
+        seg->len = len;
+    }
+    reply->len += len;
+}
+
+static inline size_t indent_len(const o1_reply_t *reply) {
+    if (!reply->pretty) {
+        return 0;
+    }
+    size_t n = (size_t)reply->depth * 2;
+    return n < O1_REPLY_MAX_INDENT ? n : O1_REPLY_MAX_INDENT;
+}
+
+// Indentation and one element fragment, copied together
+static inline void push_markup(o1_reply_t *reply, const char *ptr, size_t len) {
+    size_t indent = indent_len(reply);
+    if (len > O1_REPLY_INLINE_MAX) {
+        push_const(reply, spaces, indent);
+        push_const(reply, ptr, len);
+        return;
+    }
+    
+    char *dst = text_reserve(reply, indent + len);
+    if (dst) {
+        put(put(dst, spaces, indent), ptr, len);
+        reply->text.len += indent + len;
+    }
+}
+
+// A leaf copied piece by piece: long tags, values needing escapes, and the
+// error replies
+static void push_leaf(o1_reply_t *reply, const o1_reply_tag_t *tag, const char *value, size_t len) {
+    push_const(reply, spaces, indent_len(reply));
+    push_const(reply, tag->open, tag->open_len);
+    text_escape(reply, value, len);
+    push_const(reply, tag->close, tag->close_len + reply->pretty);
+}
+
+static int status(const o1_reply_t *reply) {
+    return reply->failed ? -1 : 0;
+}
+
+// Start a reply echoing the request's message-id, decoded, escaped again.
+// Without one the attribute is omitted.
+int o1_reply_begin(o1_reply_t *reply, const char *message_id, size_t len) {
+    if (!message_id) {
+        push_const(reply, reply_head, sizeof(reply_head) - 1);
+    } else if (!reply->failed) {
+        push_const(reply, reply_head_id, sizeof(reply_head_id) - 1);
+        text_escape(reply, message_id, len);
+        text_copy(reply, "\"", 1);
+    }
+    push_const(reply, reply_head_end, sizeof(reply_head_end) - 2 + reply->pretty);
+    reply->depth = 1;
+    return status(reply);
+}
+
+int o1_reply_end(o1_reply_t *reply) {
+    reply->depth = 0;
+    push_const(reply, reply_tail, sizeof(reply_tail) - 2 + reply->pretty);
+    return status(reply);
+}
+
+int o1_reply_open(o1_reply_t *reply, const o1_reply_tag_t *tag) {
+    push_markup(reply, tag->open, tag->open_len + reply->pretty);
+    reply->depth++;
+    return status(reply);
+}
+
+int o1_reply_close(o1_reply_t *reply, const o1_reply_tag_t *tag) {
+    reply->depth--;
+    push_markup(reply, tag->close, tag->close_len + reply->pretty);
+    return status(reply);
+}
+
+int o1_reply_empty(o1_reply_t *reply, const o1_reply_tag_t *tag) {
+    push_markup(reply, tag->empty, tag->empty_len + reply->pretty);
+    return status(reply);
+}
+
+// <name>value</name>, value escaped
+int o1_reply_leaf(o1_reply_t *reply, const o1_reply_tag_t *tag, const char *value, size_t len) {
+    size_t indent = indent_len(reply);
+    size_t close_len = tag->close_len + reply->pretty;
+    
+    if (tag->open_len > O1_REPLY_INLINE_MAX || close_len > O1_REPLY_INLINE_MAX ||
+        clean_prefix(value, len) < len) {
+        push_leaf(reply, tag, value, len);
+        return status(reply);
+    }
+    
+    // The usual short leaf needing no escapes is copied with one reserve
+    size_t total = indent + tag->open_len + len + close_len;
+    char *dst = text_reserve(reply, total);
+    if (dst) {
+        put(put(put(put(dst, spaces, indent), tag->open, tag->open_len), value, len),
+            tag->close, close_len);
+        reply->text.len += total;
+    }
+    return status(reply);
+}
+
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// <name>value</name>, the digits formatted two at a time
+int o1_reply_leaf_u64(o1_reply_t *reply, const o1_reply_tag_t *tag, uint64_t value) {
+    char digits[20];
+    char *p = digits + sizeof(digits);
+    
+    while (value >= 100) {
+        p -= 2;
+        memcpy(p, digit_pairs + (value % 100) * 2, 2);
+        value /= 100;
+    }
+    if (value >= 10) {
+        p -= 2;
+        memcpy(p, digit_pairs + value * 2, 2);
+    } else {
+        *--p = (char)('0' + value);
+    }
+    
+    size_t len = (size_t)(digits + sizeof(digits) - p);
+    size_t indent = indent_len(reply);
+    size_t close_len = tag->close_len + reply->pretty;
+    if (tag->open_len > O1_REPLY_INLINE_MAX || close_len > O1_REPLY_INLINE_MAX) {
+        return o1_reply_leaf(reply, tag, p, len);
+    }
+    
+    size_t total = indent + tag->open_len + len + close_len;
+    char *dst = text_reserve(reply, total);
+    if (dst) {
+        put(put(put(put(dst, spaces, indent), tag->open, tag->open_len), p, len),
+            tag->close, close_len);
+        reply->text.len += total;
+    }
+    return status(reply);
+}
+
+// <ok/> and <rpc-error> are copied with push_const() rather than through
+// the element functions above. Inlined here, those would let GCC see the
+// constant tags and warn about copy lengths the tags never reach.
+int o1_reply_ok(o1_reply_t *reply) {
+    push_const(reply, spaces, indent_len(reply));
+    push_const(reply, tag_ok.empty, tag_ok.empty_len + reply->pretty);
+    return status(reply);
+}
+
+// Application-level <rpc-error> of severity error
+int o1_reply_error(o1_reply_t *reply, const char *error_type, const char *error_tag) {
+    push_const(reply, spaces, indent_len(reply));
+    push_const(reply, tag_rpc_error.open, tag_rpc_error.open_len + reply->pretty);
+    reply->depth++;
+    push_leaf(reply, &tag_error_type, error_type, strlen(error_type));
+    push_leaf(reply, &tag_error_tag, error_tag, strlen(error_tag));
+    push_leaf(reply, &tag_error_severity, "error", 5);
+    reply->depth--;
+    push_const(reply, spaces, indent_len(reply));
+    push_const(reply, tag_rpc_error.close, tag_rpc_error.close_len + reply->pretty);
+    return status(reply);
+}
+
+size_t o1_reply_length(const o1_reply_t *reply) {
+    return reply->text.len + reply->len;
+}
+
+// The reply as iovecs, valid until the builder is next changed. A writev()
+// caller must split the array at IOV_MAX.
+const struct iovec *o1_reply_iov(o1_reply_t *reply, int *count) {
+    if (reply->failed) {
+        return NULL;
+    }
+    size_t need = 2 * reply->count + 1;
+    if (need > reply->iov_cap) {
+        struct iovec *iov = realloc(reply->iov, need * sizeof(*iov));
+        if (!iov) {
+            return NULL;
+        }
+        reply->iov = iov;
+        reply->iov_cap = need;
+    }
+    
+    // Text runs between the referenced fragments
+    int n = 0;
+    size_t off = 0;
+    for (size_t i = 0; i < reply->count; i++) {
+        const o1_reply_seg_t *seg = &reply->segs[i];
+        if (seg->off > off) {
+            reply->iov[n].iov_base = reply->text.data + off;
+            reply->iov[n++].iov_len = seg->off - off;
+        }
+        reply->iov[n].iov_base = (void *)seg->ptr;
+        reply->iov[n++].iov_len = seg->len;
+        off = seg->off;
+    }
+    if (reply->text.len > off) {
+        reply->iov[n].iov_base = reply->text.data + off;
+        reply->iov[n++].iov_len = reply->text.len - off;
+    }
+    
+    *count = n;
+    return reply->iov;
+}
+
+// The reply as one NUL-terminated string, for transports that cannot
+// gather. Valid until the builder is next changed.
+const char *o1_reply_flatten(o1_reply_t *reply) {
+    if (reply->failed || !text_reserve(reply, 0)) {
+        return NULL;
+    }
+    
+    // Without referenced fragments the text buffer is the reply
+    if (reply->count == 0) {
+        reply->text.data[reply->text.len] = '\0';
+        return reply->text.data;
+    }
+    
+    o1_buf_reset(&reply->flat);
+    if (o1_buf_reserve(&reply->flat, o1_reply_length(reply)) != 0) {
+        return NULL;
+    }
+    
+    char *out = reply->flat.data;
+    size_t off = 0;
+    for (size_t i = 0; i < reply->count; i++) {
+        const o1_reply_seg_t *seg = &reply->segs[i];
+        memcpy(out, reply->text.data + off, seg->off - off);
+        out += seg->off - off;
+        memcpy(out, seg->ptr, seg->len);
+        out += seg->len;
+        off = seg->off;
+    }
+    memcpy(out, reply->text.data + off, reply->text.len - off);
+    out += reply->text.len - off;
+    *out = '\0';
+    reply->flat.len = o1_reply_length(reply);
+    
+    return reply->flat.data;
+}
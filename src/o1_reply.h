@@ -0,0 +1,86 @@
+#ifndef O1_REPLY_H
+#define O1_REPLY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+#include "o1_buf.h"
+
+// Builder for <rpc-reply> documents.
+//
+// Markup comes from fragments fixed at compile time and is never formatted;
+// variable text is written, escaped, into the builder's own buffer, and
+// integers are converted in place. Long fragments are referenced in place,
+// short ones are copied alongside the text. The finished reply is a list
+// of segments for a gathering write, or one string for a transport that
+// takes one; a reply without long fragments is already that string.
+//
+// Compact replies carry no whitespace between elements. Pretty replies
+// indent two spaces per level and end every element line with a newline.
+
+// Precomputed markup for one element. Both forms of every fragment share
+// one literal: the trailing newline is counted only in pretty mode.
+typedef struct {
+    const char *open;       // "<name>\n"
+    size_t open_len;        // without the newline
+    const char *close;      // "</name>\n"
+    size_t close_len;
+    const char *empty;      // "<name/>\n"
+    size_t empty_len;
+} o1_reply_tag_t;
+
+#define O1_REPLY_FRAGMENT(s) s, sizeof(s) - 2
+
+#define O1_REPLY_TAG(name) { \
+    O1_REPLY_FRAGMENT("<" name ">\n"), \
+    O1_REPLY_FRAGMENT("</" name ">\n"), \
+    O1_REPLY_FRAGMENT("<" name "/>\n") }
+
+// Element declaring its namespace
+#define O1_REPLY_TAG_NS(name, ns) { \
+    O1_REPLY_FRAGMENT("<" name " xmlns=\"" ns "\">\n"), \
+    O1_REPLY_FRAGMENT("</" name ">\n"), \
+    O1_REPLY_FRAGMENT("<" name " xmlns=\"" ns "\"/>\n") }
+
+// A constant fragment referenced in place, following text[0, off)
+typedef struct {
+    const char *ptr;
+    size_t off;
+    size_t len;
+} o1_reply_seg_t;
+
+typedef struct {
+    o1_reply_seg_t *segs;   // referenced fragments, in reply order
+    size_t count;
+    size_t cap;
+    o1_buf_t text;          // escaped variable fields
+    o1_buf_t flat;          // o1_reply_flatten() output
+    struct iovec *iov;      // o1_reply_iov() output
+    size_t iov_cap;
+    size_t len;             // bytes in referenced fragments
+    int depth;
+    int pretty;
+    int failed;             // an allocation failed; the reply is incomplete
+} o1_reply_t;
+
+// Function declarations
+void o1_reply_init(o1_reply_t *reply, int pretty);
+void o1_reply_reset(o1_reply_t *reply);
+void o1_reply_free(o1_reply_t *reply);
+
+int o1_reply_begin(o1_reply_t *reply, const char *message_id, size_t len);
+int o1_reply_end(o1_reply_t *reply);
+int o1_reply_open(o1_reply_t *reply, const o1_reply_tag_t *tag);
+int o1_reply_close(o1_reply_t *reply, const o1_reply_tag_t *tag);
+int o1_reply_empty(o1_reply_t *reply, const o1_reply_tag_t *tag);
+int o1_reply_leaf(o1_reply_t *reply, const o1_reply_tag_t *tag, const char *value, size_t len);
+int o1_reply_leaf_u64(o1_reply_t *reply, const o1_reply_tag_t *tag, uint64_t value);
+int o1_reply_ok(o1_reply_t *reply);
+int o1_reply_error(o1_reply_t *reply, const char *error_type, const char *error_tag);
+
+size_t o1_reply_length(const o1_reply_t *reply);
+const struct iovec *o1_reply_iov(o1_reply_t *reply, int *count);
+const char *o1_reply_flatten(o1_reply_t *reply);
+
+#endif // O1_REPLY_H
@@ -0,0 +1,677 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hex.h"
+#include "log.h"
+#include "o1_rpc.h"
+#include "o1_yang.h"
+
+// printf precision with a NULL pointer is undefined even for zero length
+#define O1_STR_ARG(s) (int)(s).len, (s).ptr ? (s).ptr : ""
+
+// An edit-config with more interfaces than this indexes its changes
+#define EDIT_SCAN_MAX 16
+
+const char *const o1_rpc_op_names[O1_RPC_OP_COUNT] = {
+    "other", "get-config", "edit-config", "get-interface-status", "set-interface-status",
+    "commit", "discard-changes"
+};
+
+typedef struct {
+    o1_rpc_session_t *session;
+    size_t len;             // of the request
+    int rejected;
+} edit_config_ctx_t;
+
+// Without a candidate only running is served
+o1_rpc_session_t *o1_rpc_session_create(o1_datastore_t *ds, o1_candidate_t *candidate,
+                                        int pretty) {
+    o1_rpc_session_t *session = calloc(1, sizeof(*session));
+    if (!session) {
+        return NULL;
+    }
+    
+    session->ds = ds;
+    session->candidate = candidate;
+    o1_reply_init(&session->reply, pretty);
+    o1_buf_init(&session->text);
+    return session;
+}
+
+// Takes void * so it can be handed to nc_session_free() as the data destructor
+void o1_rpc_session_destroy(void *arg) {
+    o1_rpc_session_t *session = arg;
+    if (!session) {
+        return;
+    }
+    
+    o1_reply_free(&session->reply);
+    o1_buf_free(&session->text);
+    free(session->edit.changes);
+    free(session->edit.index);
+    free(session);
+}
+
+// Point str at its text with entity and character references decoded.
+// Decoded values go to the session's text buffer, which is sized for the
+// whole request (len) the first time one is needed: no value decodes to
+// more bytes than it spans, so the buffer never moves under the views
+// already handed out. Returns -1 for a malformed reference.
+static int decode_value(o1_rpc_session_t *session, size_t len, o1_str_t *str) {
+    o1_buf_t *text = &session->text;
+    
+    if (!str->ptr || !memchr(str->ptr, '&', str->len)) {
+        return 0;
+    }
+    if (text->len == 0 && o1_buf_reserve(text, len) != 0) {
+        return -1;
+    }
+    if (o1_str_decode(str, text->data + text->len) != 0) {
+        return -1;
+    }
+    text->len += str->len;
+    return 0;
+}
+
+// All leaves of an interface entry or RPC input
+static int decode_view(o1_rpc_session_t *session, size_t len, o1_interface_view_t *view) {
+    return decode_value(session, len, &view->interface_name) != 0 ||
+           decode_value(session, len, &view->status) != 0 ||
+           decode_value(session, len, &view->traceid) != 0 ||
+           decode_value(session, len, &view->spanid) != 0 ? -1 : 0;
+}
+
+static void print_o1_data(const char *operation, const o1_interface_view_t *view) {
+    log_debug("O1 interface %.*s: operation %s, status %.*s, traceid %.*s, spanid %.*s",
+              O1_STR_ARG(view->interface_name), operation, O1_STR_ARG(view->status),
+              O1_STR_ARG(view->traceid), O1_STR_ARG(view->spanid));
+}
+
+static void index_change(const o1_rpc_edit_t *edit, size_t n) {
+    const o1_ds_change_t *change = &edit->changes[n];
+    size_t i = o1_ds_hash_name(change->name, change->name_len) & edit->index_mask;
+    while (edit->index[i] != 0) {
+        i = (i + 1) & edit->index_mask;
+    }
+    edit->index[i] = (uint32_t)n + 1;
+}
+
+// Two buckets for every change there is room for, so the index is at most
+// half full until the array next grows. An index not in use is all empty.
+static int rebuild_index(o1_rpc_edit_t *edit) {
+    size_t buckets = EDIT_SCAN_MAX * 2;
+    while (buckets < edit->allocated * 2) {
+        buckets *= 2;
+    }
+    if (buckets != edit->index_mask + 1) {
+        uint32_t *index = realloc(edit->index, buckets * sizeof(*index));
+        if (!index) {
+            return -1;
+        }
+        memset(index, 0, buckets * sizeof(*index));
+        edit->index = index;
+        edit->index_mask = buckets - 1;
+    } else if (edit->indexed) {
+        memset(edit->index, 0, buckets * sizeof(*edit->index));
+    }
+    for (size_t n = 0; n < edit->count; n++) {
+        index_change(edit, n);
+    }
+    edit->indexed = 1;
+    return 0;
+}
+
+// The edit's change for an interface, added empty if it has none yet;
+// NULL when out of memory
+static o1_ds_change_t *edit_change(o1_rpc_edit_t *edit, const char *name, size_t len) {
+    if (!edit->indexed) {
+        for (size_t n = 0; n < edit->count; n++) {
+            o1_ds_change_t *change = &edit->changes[n];
+            if (change->name_len == len && memcmp(change->name, name, len) == 0) {
+                return change;
+            }
+        }
+    } else {
+        for (size_t i = o1_ds_hash_name(name, len) & edit->index_mask;;
+             i = (i + 1) & edit->index_mask) {
+            uint32_t entry = edit->index[i];
+            if (entry == 0) {
+                break;
+            }
+            o1_ds_change_t *change = &edit->changes[entry - 1];
+            if (change->name_len == len && memcmp(change->name, name, len) == 0) {
+                return change;
+            }
+        }
+    }
+    
+    if (edit->count == edit->allocated) {
+        size_t allocated = edit->allocated ? edit->allocated * 2 : EDIT_SCAN_MAX;
+        o1_ds_change_t *changes = realloc(edit->changes, allocated * sizeof(*changes));
+        if (!changes) {
+            return NULL;
+        }
+        edit->changes = changes;
+        edit->allocated = allocated;
+        if (edit->indexed && rebuild_index(edit) != 0) {
+            return NULL;
+        }
+    }
+    
+    size_t n = edit->count++;
+    o1_ds_change_t *change = &edit->changes[n];
+    memset(change, 0, sizeof(*change));
+    memcpy(change->name, name, len);
+    change->name_len = (uint8_t)len;
+    if (edit->indexed) {
+        index_change(edit, n);
+    } else if (edit->count > EDIT_SCAN_MAX && rebuild_index(edit) != 0) {
+        edit->count--;
+        return NULL;
+    }
+    return change;
+}
+
+// An empty edit. The index stays allocated for the next large edit; only
+// the buckets of the changes it held are emptied, so a small edit after a
+// large one does not pay for clearing all of it.
+static void edit_reset(o1_rpc_edit_t *edit) {
+    if (edit->indexed) {
+        for (size_t n = 0; n < edit->count; n++) {
+            const o1_ds_change_t *change = &edit->changes[n];
+            size_t i = o1_ds_hash_name(change->name, change->name_len) & edit->index_mask;
+            while (edit->index[i] != n + 1) {
+                i = (i + 1) & edit->index_mask;
+            }
+            edit->index[i] = 0;
+        }
+        edit->indexed = 0;
+    }
+    edit->count = 0;
+}
+
+// Validate one list entry of an edit-config and add it to the edit; every
+// leaf present must satisfy its YANG type. Nothing is applied yet.
+static int add_o1_interface(const o1_interface_view_t *raw, void *arg) {
+    edit_config_ctx_t *ctx = (edit_config_ctx_t *)arg;
+    o1_interface_view_t decoded = *raw;
+    const o1_interface_view_t *entry = &decoded;
+    o1_if_status_t status = O1_IF_UP;
+    
+    if (decode_view(ctx->session, ctx->len, &decoded) != 0) {
+        ctx->rejected = 1;
+        return 1;
+    }
+    
+    // Checks generated from o1-interface.yang; the key leaf is mandatory
+    if (!entry->interface_name.ptr || entry->interface_name.len == 0 ||
+        entry->interface_name.len > O1_DS_NAME_MAX ||
+        !o1_interface_interface_name_valid(entry->interface_name.ptr, entry->interface_name.len)) {
+        ctx->rejected = 1;
+        return 1;
+    }
+    if (entry->status.ptr &&
+        o1_if_status_parse(entry->status.ptr, entry->status.len, &status) != 0) {
+        ctx->rejected = 1;
+        return 1;
+    }
+    if (entry->traceid.ptr &&
+        !o1_interface_interface_tracing_traceid_valid(entry->traceid.ptr, entry->traceid.len)) {
+        ctx->rejected = 1;
+        return 1;
+    }
+    if (entry->spanid.ptr &&
+        !o1_interface_interface_tracing_spanid_valid(entry->spanid.ptr, entry->spanid.len)) {
+        ctx->rejected = 1;
+        return 1;
+    }
+    
+    print_o1_data("edit", entry);
+    
+    // A later entry for the same interface merges over the earlier one
+    o1_ds_change_t *change = edit_change(&ctx->session->edit, entry->interface_name.ptr,
+                                         entry->interface_name.len);
+    if (!change) {
+        log_error("Failed to add interface %.*s to edit: %s",
+                  O1_STR_ARG(entry->interface_name), strerror(errno));
+        ctx->rejected = 1;
+        return 1;
+    }
+    if (entry->status.ptr) {
+        change->status = (uint8_t)status;
+        change->fields |= O1_DS_STATUS;
+    }
+    if (entry->traceid.ptr) {
+        hex_decode(change->traceid, entry->traceid.ptr, sizeof(change->traceid));
+        change->fields |= O1_DS_TRACEID;
+    }
+    if (entry->spanid.ptr) {
+        hex_decode(change->spanid, entry->spanid.ptr, sizeof(change->spanid));
+        change->fields |= O1_DS_SPANID;
+    }
+    return 0;
+}
+
+// Operation element directly inside <rpc> (local name and namespace), and
+// the raw message-id attribute of <rpc> (ptr NULL when absent)
+int o1_rpc_parse_header(const char *xml, size_t len, o1_str_t *ns, o1_str_t *operation,
+                        o1_str_t *message_id) {
+    o1_xml_reader_t reader;
+    o1_xml_token_t token;
+    
+    message_id->ptr = NULL;
+    message_id->len = 0;
+    
+    o1_xml_reader_init(&reader, xml, len);
+    while (o1_xml_next(&reader, &token) != O1_XML_EOF) {
+        if (token.type == O1_XML_ERROR) {
+            return -1;
+        }
+        if (token.type != O1_XML_START && token.type != O1_XML_EMPTY) {
+            continue;
+        }
+        if (token.depth == 0) {
+            if (!o1_xml_is(&token, O1_NS_NETCONF, "rpc")) {
+                return -1;
+            }
+            o1_xml_attr(&token, "message-id", message_id);
+        } else if (token.depth == 1) {
+            *ns = token.ns;
+            *operation = token.name;
+            return 0;
+        }
+    }
+    
+    return -1;
+}
+
+// Replace whatever reply was being built with an <rpc-error>
+static int reply_error(o1_rpc_session_t *session, o1_str_t message_id, const char *error_type,
+                       const char *error_tag) {
+    o1_reply_t *reply = &session->reply;
+    
+    session->error = 1;
+    o1_reply_reset(reply);
+    o1_reply_begin(reply, message_id.ptr, message_id.len);
+    o1_reply_error(reply, error_type, error_tag);
+    return o1_reply_end(reply);
+}
+
+// The candidate when the RPC's <source> or <target> (parent) names it,
+// NULL for running, which is also assumed when parent is absent. Returns
+// -1 for a datastore this server does not serve.
+static int pick_datastore(o1_rpc_session_t *session, const char *xml, size_t len,
+                          const char *parent, o1_candidate_t **candidate) {
+    o1_str_t name;
+    
+    *candidate = NULL;
+    if (o1_parse_datastore(xml, len, parent, &name) != 0 || o1_str_eq(name, "running")) {
+        return 0;
+    }
+    if (o1_str_eq(name, "candidate") && session->candidate) {
+        *candidate = session->candidate;
+        return 0;
+    }
+    return -1;
+}
+
+static int handle_get_config(o1_rpc_session_t *session, const char *xml, size_t len,
+                             o1_str_t message_id) {
+    o1_reply_t *reply = &session->reply;
+    o1_candidate_t *candidate;
+    o1_ds_view_t view;
+    
+    log_debug("Received get-config request %.*s", O1_STR_ARG(message_id));
+    
+    if (pick_datastore(session, xml, len, "source", &candidate) != 0) {
+        log_warn("get-config %.*s from an unsupported datastore", O1_STR_ARG(message_id));
+        return reply_error(session, message_id, "protocol", "invalid-value");
+    }
+    
+    // Compile the subtree filter, then answer it from one version of the
+    // datastore
+    if (o1_filter_parse(xml, len, &session->filter) != 0) {
+        log_warn("Unsupported get-config filter in request %.*s", O1_STR_ARG(message_id));
+        return reply_error(session, message_id, "application", "operation-not-supported");
+    }
+    for (size_t i = 0; i < session->filter.count; i++) {
+        o1_filter_entry_t *entry = &session->filter.entries[i];
+        for (int leaf = 0; leaf < O1_LEAF_COUNT; leaf++) {
+            if ((entry->match & O1_LEAF_BIT(leaf)) &&
+                decode_value(session, len, &entry->value[leaf]) != 0) {
+                log_warn("Malformed reference in get-config filter %.*s",
+                         O1_STR_ARG(message_id));
+                return reply_error(session, message_id, "application", "invalid-value");
+            }
+        }
+    }
+    
+    int count = -1;
+    if (candidate) {
+        o1_candidate_view_begin(candidate, &view);
+    } else {
+        o1_datastore_view_begin(session->ds, &view);
+    }
+    if (o1_reply_begin(reply, message_id.ptr, message_id.len) == 0) {
+        count = o1_filter_render(&session->filter, &view, candidate, reply);
+    }
+    if (candidate) {
+        o1_candidate_view_end(candidate, &view);
+    } else {
+        o1_datastore_view_end(&view);
+    }
+    if (count < 0 || o1_reply_end(reply) != 0) {
+        log_error("Failed to build get-config response");
+        return reply_error(session, message_id, "application", "resource-denied");
+    }
+    
+    log_info("Answering get-config %.*s with %d interfaces", O1_STR_ARG(message_id), count);
+    return 0;
+}
+
+static int handle_edit_config(o1_rpc_session_t *session, const char *xml, size_t len,
+                              o1_str_t message_id) {
+    o1_reply_t *reply = &session->reply;
+    
+    log_debug("Received edit-config request %.*s", O1_STR_ARG(message_id));
+    
+    o1_candidate_t *candidate = NULL;
+    if (pick_datastore(session, xml, len, "target", &candidate) != 0) {
+        log_warn("edit-config %.*s of an unsupported datastore", O1_STR_ARG(message_id));
+        return reply_error(session, message_id, "protocol", "invalid-value");
+    }
+    
+    // Validate every entry before applying any, so a bad one leaves the
+    // target as it was
+    edit_config_ctx_t ctx = { session, len, 0 };
+    edit_reset(&session->edit);
+    int entries = o1_parse_edit_config_entries(xml, len, add_o1_interface, &ctx);
+    if (entries <= 0 || ctx.rejected) {
+        log_warn("Rejected edit-config %.*s after %d entries, nothing applied",
+                 O1_STR_ARG(message_id), entries);
+        return reply_error(session, message_id, "application", "invalid-value");
+    }
+    
+    // Then apply them in one step: one version of running, or one update
+    // of the candidate
+    int ret = candidate ?
+        o1_candidate_apply(candidate, session->edit.changes, session->edit.count) :
+        o1_datastore_commit(session->ds, session->edit.changes, session->edit.count);
+    if (ret != 0) {
+        log_error("Failed to apply edit-config %.*s: %s", O1_STR_ARG(message_id), strerror(errno));
+        return reply_error(session, message_id, "application", "resource-denied");
+    }
+    
+    // <ok/> promises a change to running survives a restart: one
+    // group-committed sync covers every entry of the edit. The candidate
+    // is not persisted.
+    if (!candidate && o1_datastore_sync(session->ds) != 0) {
+        log_error("Failed to persist edit-config %.*s: %s", O1_STR_ARG(message_id), strerror(errno));
+        return reply_error(session, message_id, "application", "operation-failed");
+    }
+    log_info("Processed O1 interface configuration %.*s for %zu interfaces in %s",
+             O1_STR_ARG(message_id), session->edit.count, candidate ? "candidate" : "running");
+    
+    o1_reply_begin(reply, message_id.ptr, message_id.len);
+    o1_reply_ok(reply);
+    return o1_reply_end(reply);
+}
+
+// Output leaves of the o1-interface RPCs, which are qualified by the module
+static const o1_reply_tag_t tag_status = O1_REPLY_TAG_NS("status", O1_NS_INTERFACE);
+static const o1_reply_tag_t tag_last_change = O1_REPLY_TAG_NS("last-change", O1_NS_INTERFACE);
+static const o1_reply_tag_t tag_result = O1_REPLY_TAG_NS("result", O1_NS_INTERFACE);
+static const o1_reply_tag_t tag_message = O1_REPLY_TAG_NS("message", O1_NS_INTERFACE);
+
+static int handle_get_interface_status(o1_rpc_session_t *session, const char *xml, size_t len,
+                                       o1_str_t message_id) {
+    o1_reply_t *reply = &session->reply;
+    o1_interface_view_t input;
+    o1_if_status_t status;
+    uint64_t last_change;
+    
+    log_debug("Received get-interface-status request %.*s", O1_STR_ARG(message_id));
+    
+    if (o1_parse_rpc_input(xml, len, &input) != 0 || decode_view(session, len, &input) != 0 ||
+        !input.interface_name.ptr ||
+        !o1_interface_get_interface_status_input_interface_name_valid(input.interface_name.ptr,
+                                                                        input.interface_name.len)) {
+        log_warn("Rejected get-interface-status %.*s", O1_STR_ARG(message_id));
+        return reply_error(session, message_id, "application", "invalid-value");
+    }
+    
+    if (o1_datastore_status(session->ds, input.interface_name.ptr, input.interface_name.len,
+                            &status, &last_change) != 0) {
+        log_warn("get-interface-status %.*s for unknown interface %.*s",
+                 O1_STR_ARG(message_id), O1_STR_ARG(input.interface_name));
+        return reply_error(session, message_id, "application", "data-missing");
+    }
+    
+    const char *name = o1_if_status_name(status);
+    o1_reply_begin(reply, message_id.ptr, message_id.len);
+    o1_reply_leaf(reply, &tag_status, name, strlen(name));
+    o1_reply_leaf_u64(reply, &tag_last_change, last_change);
+    
+    log_info("Answering get-interface-status %.*s: %.*s is %s", O1_STR_ARG(message_id),
+             O1_STR_ARG(input.interface_name), name);
+    return o1_reply_end(reply);
+}
+
+static int handle_set_interface_status(o1_rpc_session_t *session, const char *xml, size_t len,
+                                       o1_str_t message_id) {
+    o1_reply_t *reply = &session->reply;
+    o1_interface_view_t input;
+    o1_interface_update_t update = { 0 };
+    
+    log_debug("Received set-interface-status request %.*s", O1_STR_ARG(message_id));
+    
+    // Checks generated from the RPC input: both leaves are mandatory, and
+    // only up and down may be requested
+    int valid = o1_parse_rpc_input(xml, len, &input) == 0 &&
+        decode_view(session, len, &input) == 0 && input.interface_name.ptr && input.status.ptr &&
+        o1_interface_set_interface_status_input_interface_name_valid(input.interface_name.ptr,
+                                                                       input.interface_name.len) &&
+        o1_interface_set_interface_status_input_status_from_str(input.status.ptr,
+                                                                  input.status.len) >= 0 &&
+        o1_if_status_parse(input.status.ptr, input.status.len, &update.status) == 0;
+    update.fields = O1_DS_STATUS;
+    
+    if (valid && input.traceid.ptr) {
+        valid = o1_interface_set_interface_status_input_tracing_traceid_valid(input.traceid.ptr,
+                                                                              input.traceid.len);
+        update.traceid = input.traceid.ptr;
+        update.fields |= O1_DS_TRACEID;
+    }
+    if (valid && input.spanid.ptr) {
+        valid = o1_interface_set_interface_status_input_tracing_spanid_valid(input.spanid.ptr,
+                                                                             input.spanid.len);
+        update.spanid = input.spanid.ptr;
+        update.fields |= O1_DS_SPANID;
+    }
+    if (!valid) {
+        log_warn("Rejected set-interface-status %.*s", O1_STR_ARG(message_id));
+        return reply_error(session, message_id, "application", "invalid-value");
+    }
+    
+    print_o1_data("set-status", &input);
+    
+    // Status, its last-change and the tracing leaves change in one edit
+    if (o1_datastore_update(session->ds, input.interface_name.ptr, input.interface_name.len,
+                            &update) != 0) {
+        if (errno == ENOENT) {
+            log_warn("set-interface-status %.*s for unknown interface %.*s",
+                     O1_STR_ARG(message_id), O1_STR_ARG(input.interface_name));
+            return reply_error(session, message_id, "application", "data-missing");
+        }
+        log_error("Failed to set status of %.*s: %s",
+                  O1_STR_ARG(input.interface_name), strerror(errno));
+        return reply_error(session, message_id, "application", "operation-failed");
+    }
+    if (o1_datastore_sync(session->ds) != 0) {
+        log_error("Failed to persist status of %.*s: %s",
+                  O1_STR_ARG(input.interface_name), strerror(errno));
+        return reply_error(session, message_id, "application", "operation-failed");
+    }
+    
+    log_info("Set status of %.*s to %.*s (%.*s)", O1_STR_ARG(input.interface_name),
+             O1_STR_ARG(input.status), O1_STR_ARG(message_id));
+    
+    o1_reply_begin(reply, message_id.ptr, message_id.len);
+    o1_reply_leaf(reply, &tag_result, "success", 7);
+    o1_reply_leaf(reply, &tag_message, "Interface status updated", 24);
+    return o1_reply_end(reply);
+}
+
+static int handle_commit(o1_rpc_session_t *session, const char *xml, size_t len,
+                         o1_str_t message_id) {
+    o1_reply_t *reply = &session->reply;
+    (void)xml;
+    (void)len;
+    
+    log_debug("Received commit request %.*s", O1_STR_ARG(message_id));
+    
+    if (!session->candidate) {
+        return reply_error(session, message_id, "protocol", "operation-not-supported");
+    }
+    
+    // All of the candidate reaches running in one version swap, then one
+    // sync makes it durable before <ok/>
+    int count = o1_candidate_commit(session->candidate);
+    if (count < 0) {
+        int err = errno;
+        log_error("Failed to commit candidate %.*s: %s", O1_STR_ARG(message_id), strerror(err));
+        return reply_error(session, message_id, "application",
+                           err == ENOSPC ? "resource-denied" : "operation-failed");
+    }
+    if (o1_datastore_sync(session->ds) != 0) {
+        log_error("Failed to persist commit %.*s: %s", O1_STR_ARG(message_id), strerror(errno));
+        return reply_error(session, message_id, "application", "operation-failed");
+    }
+    log_info("Committed %d candidate interfaces to running (%.*s)", count,
+             O1_STR_ARG(message_id));
+    
+    o1_reply_begin(reply, message_id.ptr, message_id.len);
+    o1_reply_ok(reply);
+    return o1_reply_end(reply);
+}
+
+static int handle_discard_changes(o1_rpc_session_t *session, const char *xml, size_t len,
+                                  o1_str_t message_id) {
+    o1_reply_t *reply = &session->reply;
+    (void)xml;
+    (void)len;
+    
+    if (!session->candidate) {
+        return reply_error(session, message_id, "protocol", "operation-not-supported");
+    }
+    
+    o1_candidate_discard(session->candidate);
+    log_info("Discarded candidate changes (%.*s)", O1_STR_ARG(message_id));
+    
+    o1_reply_begin(reply, message_id.ptr, message_id.len);
+    o1_reply_ok(reply);
+    return o1_reply_end(reply);
+}
+
+typedef int (*rpc_handler_t)(o1_rpc_session_t *session, const char *xml, size_t len,
+                             o1_str_t message_id);
+
+typedef struct {
+    const char *ns;
+    const char *name;
+    o1_rpc_op_t op;
+    rpc_handler_t handler;
+} rpc_entry_t;
+
+// Perfect hash of the supported (namespace, operation) pairs: one probe and
+// one comparison per RPC. The slot is the low four bits of the name's
+// length, the namespace's length (39 for base:1.0, 24 for o1-interface) and
+// the name's first byte, XORed together:
+//
+//   commit                 6 ^ 39 ^ 'c' (99)  = 66  -> 2
+//   edit-config           11 ^ 39 ^ 'e' (101) = 73  -> 9
+//   get-config            10 ^ 39 ^ 'g' (103) = 74  -> 10
+//   get-interface-status  20 ^ 24 ^ 'g' (103) = 107 -> 11
+//   discard-changes       15 ^ 39 ^ 'd' (100) = 76  -> 12
+//   set-interface-status  20 ^ 24 ^ 's' (115) = 127 -> 15
+//
+// The six slots differ, so there is no collision. The two status RPCs
+// share both lengths and differ in their first byte; the two get
+// operations share a first byte and differ in their lengths. Adding an
+// operation means checking that its slot is free; bench_o1_rpc dispatches
+// every operation and fails if one is not found in its slot.
+#define RPC_TABLE_SIZE 16
+
+static unsigned rpc_slot(o1_str_t ns, o1_str_t name) {
+    return ((unsigned)(name.len ^ ns.len) ^ (unsigned char)name.ptr[0]) & (RPC_TABLE_SIZE - 1);
+}
+
+static const rpc_entry_t rpc_table[RPC_TABLE_SIZE] = {
+    [2] = { O1_NS_NETCONF, "commit", O1_RPC_OP_COMMIT, handle_commit },
+    [9] = { O1_NS_NETCONF, "edit-config", O1_RPC_OP_EDIT_CONFIG, handle_edit_config },
+    [10] = { O1_NS_NETCONF, "get-config", O1_RPC_OP_GET_CONFIG, handle_get_config },
+    [11] = { O1_NS_INTERFACE, "get-interface-status", O1_RPC_OP_GET_INTERFACE_STATUS,
+             handle_get_interface_status },
+    [12] = { O1_NS_NETCONF, "discard-changes", O1_RPC_OP_DISCARD_CHANGES,
+             handle_discard_changes },
+    [15] = { O1_NS_INTERFACE, "set-interface-status", O1_RPC_OP_SET_INTERFACE_STATUS,
+             handle_set_interface_status },
+};
+
+static const rpc_entry_t *rpc_lookup(o1_str_t ns, o1_str_t name) {
+    if (name.len == 0) {
+        return NULL;
+    }
+    
+    const rpc_entry_t *entry = &rpc_table[rpc_slot(ns, name)];
+    if (!entry->handler || !o1_str_eq(name, entry->name) || !o1_str_eq(ns, entry->ns)) {
+        return NULL;
+    }
+    return entry;
+}
+
+// Handle one RPC and leave the complete reply in session->reply. Returns 0
+// when there is a reply to send, or -1 if no reply could be built. A
+// message that is not a well-formed <rpc> is answered too, with an error.
+int o1_rpc_handle(o1_rpc_session_t *session, const char *xml, size_t len) {
+    o1_str_t ns, operation, message_id;
+    
+    session->rpcs++;
+    session->op = O1_RPC_OP_OTHER;
+    session->error = 0;
+    session->malformed = 0;
+    o1_reply_reset(&session->reply);
+    o1_buf_reset(&session->text);
+    
+    // RFC 6241, section 4.3: the message-id is echoed if it could be read
+    int ret = o1_rpc_parse_header(xml, len, &ns, &operation, &message_id);
+    if (decode_value(session, len, &message_id) != 0) {
+        message_id.ptr = NULL;
+        message_id.len = 0;
+        ret = -1;
+    }
+    if (ret != 0) {
+        log_warn("Malformed NETCONF message");
+        session->malformed = 1;
+        return reply_error(session, message_id, "rpc", "malformed-message");
+    }
+    const rpc_entry_t *entry = rpc_lookup(ns, operation);
+    if (entry) {
+        session->op = entry->op;
+    }
+    
+    // RFC 6241, section 4.1: the error to a missing message-id carries none
+    if (!message_id.ptr) {
+        log_warn("RPC without message-id");
+        return reply_error(session, message_id, "rpc", "missing-attribute");
+    }
+    
+    if (!entry) {
+        log_warn("Unsupported NETCONF operation %.*s", O1_STR_ARG(operation));
+        return reply_error(session, message_id, "protocol", "operation-not-supported");
+    }
+    
+    return entry->handler(session, xml, len, message_id);
+}
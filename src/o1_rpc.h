@@ -0,0 +1,71 @@
+#ifndef O1_RPC_H
+#define O1_RPC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "o1_candidate.h"
+#include "o1_datastore.h"
+#include "o1_filter.h"
+#include "o1_reply.h"
+#include "o1_xml.h"
+
+// Decode, dispatch and reply for the RPCs of one NETCONF session, kept
+// free of libnetconf2 so the path can be driven without a transport.
+//
+// Each session owns one o1_rpc_session_t for its lifetime. Its reply
+// builder and filter are the session's arena: they are reset, never freed,
+// between RPCs, so once the session has seen its largest reply an RPC
+// makes no heap allocation. The request itself is only ever viewed in
+// place, except for values holding entity or character references, which
+// are decoded into the session's text buffer. Edits of the candidate and
+// commits do allocate, for the changes they hold.
+
+// RPC types, as reported by metrics
+typedef enum {
+    O1_RPC_OP_OTHER,
+    O1_RPC_OP_GET_CONFIG,
+    O1_RPC_OP_EDIT_CONFIG,
+    O1_RPC_OP_GET_INTERFACE_STATUS,
+    O1_RPC_OP_SET_INTERFACE_STATUS,
+    O1_RPC_OP_COMMIT,
+    O1_RPC_OP_DISCARD_CHANGES,
+    O1_RPC_OP_COUNT
+} o1_rpc_op_t;
+
+extern const char *const o1_rpc_op_names[O1_RPC_OP_COUNT];
+
+// The changes of one edit-config, one per interface, all validated before
+// any is applied. Kept between RPCs like the reply.
+typedef struct {
+    o1_ds_change_t *changes;
+    size_t count;
+    size_t allocated;
+    uint32_t *index;        // change + 1 by name hash; 0 marks an empty bucket
+    size_t index_mask;
+    int indexed;            // 0 while small edits are searched in order
+} o1_rpc_edit_t;
+
+typedef struct {
+    o1_datastore_t *ds;
+    o1_candidate_t *candidate;  // shared by all sessions, NULL without :candidate
+    o1_reply_t reply;       // the reply to the last RPC handled
+    o1_filter_t filter;     // compiled get-config filter
+    o1_rpc_edit_t edit;     // changes of the last edit-config
+    o1_buf_t text;          // entity-decoded values of the last request
+    unsigned long rpcs;
+    o1_rpc_op_t op;         // type of the last RPC handled
+    int error;              // its reply is an <rpc-error>
+    int malformed;          // it was not a well-formed <rpc>
+} o1_rpc_session_t;
+
+// Function declarations
+o1_rpc_session_t *o1_rpc_session_create(o1_datastore_t *ds, o1_candidate_t *candidate,
+                                        int pretty);
+void o1_rpc_session_destroy(void *session);
+
+int o1_rpc_parse_header(const char *xml, size_t len, o1_str_t *ns, o1_str_t *operation,
+                        o1_str_t *message_id);
+int o1_rpc_handle(o1_rpc_session_t *session, const char *xml, size_t len);
+
+#endif // O1_RPC_H
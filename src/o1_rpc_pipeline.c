@@ -0,0 +1,362 @@
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "o1_rpc_pipeline.h"
+#include "o1_xml.h"
+
+#define RPC_HEADER_FMT \
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" \
+    "<rpc xmlns=\"" O1_NS_NETCONF "\" message-id=\"%llu\">\n"
+#define RPC_FOOTER "</rpc>\n"
+
+// An in-flight RPC; message_id 0 marks a free slot. Any free slot takes
+// the next RPC, so a reply that is slow to come holds up nothing else.
+typedef struct {
+    uint64_t message_id;
+    uint64_t deadline_ms;
+    o1_rpc_callback_t callback;
+    void *arg;
+} o1_rpc_slot_t;
+
+struct o1_rpc_pipeline {
+    struct nc_session *session;
+    int window;
+    int outstanding;
+    uint64_t next_id;
+    o1_rpc_slot_t *slots;   // window entries
+    int *free_slots;        // stack of the free ones
+    int num_free;
+    uint32_t *index;        // slot + 1 by message_id; 0 marks an empty bucket
+    size_t index_mask;      // at most half the buckets are used
+    o1_buf_t buf;           // the <rpc> being built between begin and commit
+    int building;
+};
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// The bucket of an in-flight message_id, or of the empty bucket ending its
+// probe sequence. Ids are sequential, so they spread without hashing.
+static size_t find_bucket(const o1_rpc_pipeline_t *pipeline, uint64_t message_id) {
+    size_t i = message_id & pipeline->index_mask;
+    while (pipeline->index[i] != 0 &&
+           pipeline->slots[pipeline->index[i] - 1].message_id != message_id) {
+        i = (i + 1) & pipeline->index_mask;
+    }
+    return i;
+}
+
+// Empty bucket i, moving later entries of its probe sequence back so that
+// every entry stays reachable from its home bucket
+static void remove_bucket(o1_rpc_pipeline_t *pipeline, size_t i) {
+    size_t mask = pipeline->index_mask;
+    for (size_t j = (i + 1) & mask; pipeline->index[j] != 0; j = (j + 1) & mask) {
+        size_t home = pipeline->slots[pipeline->index[j] - 1].message_id & mask;
+        // Movable unless home lies cyclically in (i, j]
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            pipeline->index[i] = pipeline->index[j];
+            i = j;
+        }
+    }
+    pipeline->index[i] = 0;
+}
+
+static void complete_rpc(o1_rpc_pipeline_t *pipeline, o1_rpc_slot_t *slot,
+                         o1_rpc_status_t status, const char *reply, size_t reply_len) {
+    o1_rpc_result_t result;
+    result.message_id = slot->message_id;
+    result.slot = (int)(slot - pipeline->slots);
+    result.status = status;
+    result.reply = reply;
+    result.reply_len = reply_len;
+    
+    // Free the slot first so the callback may submit follow-up RPCs
+    o1_rpc_callback_t callback = slot->callback;
+    void *arg = slot->arg;
+    remove_bucket(pipeline, find_bucket(pipeline, slot->message_id));
+    slot->message_id = 0;
+    pipeline->free_slots[pipeline->num_free++] = result.slot;
+    pipeline->outstanding--;
+    
+    if (callback) {
+        callback(&result, arg);
+    }
+}
+
+static void fail_rpcs(o1_rpc_pipeline_t *pipeline, int expired_only) {
+    uint64_t now = now_ms();
+    
+    for (int i = 0; i < pipeline->window; i++) {
+        o1_rpc_slot_t *slot = &pipeline->slots[i];
+        if (slot->message_id == 0 || (expired_only && slot->deadline_ms > now)) {
+            continue;
+        }
+        if (expired_only) {
+            fprintf(stderr, "RPC message-id %llu timed out\n", (unsigned long long)slot->message_id);
+        }
+        complete_rpc(pipeline, slot, O1_RPC_FAILED, NULL, 0);
+    }
+}
+
+// message-id of an <rpc-reply> and whether its first child is <rpc-error>
+static int parse_reply_header(const char *xml, size_t len, uint64_t *message_id,
+                              o1_rpc_status_t *status) {
+    o1_xml_reader_t reader;
+    o1_xml_token_t token;
+    o1_str_t id;
+    
+    o1_xml_reader_init(&reader, xml, len);
+    if (o1_xml_next(&reader, &token) != O1_XML_START ||
+        !o1_xml_is(&token, O1_NS_NETCONF, "rpc-reply") ||
+        o1_xml_attr(&token, "message-id", &id) != 0 || id.len == 0 || id.len > 19) {
+        return -1;
+    }
+    
+    uint64_t value = 0;
+    for (size_t i = 0; i < id.len; i++) {
+        if (id.ptr[i] < '0' || id.ptr[i] > '9') {
+            return -1;
+        }
+        value = value * 10 + (id.ptr[i] - '0');
+    }
+    *message_id = value;
+    
+    *status = O1_RPC_OK;
+    while (o1_xml_next(&reader, &token) != O1_XML_EOF) {
+        if (token.type == O1_XML_ERROR) {
+            return -1;
+        }
+        if (token.type == O1_XML_START || token.type == O1_XML_EMPTY) {
+            if (o1_xml_is(&token, O1_NS_NETCONF, "rpc-error")) {
+                *status = O1_RPC_ERROR;
+            }
+            break;
+        }
+    }
+    
+    return 0;
+}
+
+o1_rpc_pipeline_t *o1_rpc_pipeline_create(struct nc_session *session, int window) {
+    if (!session || window < 1) {
+        return NULL;
+    }
+    
+    o1_rpc_pipeline_t *pipeline = calloc(1, sizeof(*pipeline));
+    if (!pipeline) {
+        return NULL;
+    }
+    
+    pipeline->session = session;
+    pipeline->window = window;
+    pipeline->next_id = 1;
+    o1_buf_init(&pipeline->buf);
+    size_t buckets = 1;
+    while (buckets < (size_t)window * 2) {
+        buckets <<= 1;
+    }
+    pipeline->slots = calloc(window, sizeof(*pipeline->slots));
+    pipeline->free_slots = malloc(window * sizeof(*pipeline->free_slots));
+    pipeline->index = calloc(buckets, sizeof(*pipeline->index));
+    pipeline->index_mask = buckets - 1;
+    if (!pipeline->slots || !pipeline->free_slots || !pipeline->index) {
+        free(pipeline->slots);
+        free(pipeline->free_slots);
+        free(pipeline->index);
+        free(pipeline);
+        return NULL;
+    }
+    
+    // Lowest slot on top
+    for (int i = 0; i < window; i++) {
+        pipeline->free_slots[i] = window - 1 - i;
+    }
+    pipeline->num_free = window;
+    
+    return pipeline;
+}
+
+void o1_rpc_pipeline_destroy(o1_rpc_pipeline_t *pipeline) {
+    if (!pipeline) {
+        return;
+    }
+    
+    fail_rpcs(pipeline, 0);
+    free(pipeline->slots);
+    free(pipeline->free_slots);
+    free(pipeline->index);
+    o1_buf_free(&pipeline->buf);
+    free(pipeline);
+}
+
+// Start the next RPC: waits for a free window slot, then writes the <rpc>
+// start tag. The caller appends the operation to the returned buffer, so
+// large documents are generated straight into the send buffer, and
+// finishes with o1_rpc_pipeline_commit().
+o1_buf_t *o1_rpc_pipeline_begin(o1_rpc_pipeline_t *pipeline) {
+    if (!pipeline || pipeline->building) {
+        return NULL;
+    }
+    
+    // Callbacks run while polling may submit RPCs themselves, so the next
+    // id is read only once a slot is free
+    while (pipeline->num_free == 0) {
+        if (o1_rpc_pipeline_poll(pipeline, O1_PIPELINE_RPC_TIMEOUT) < 0) {
+            return NULL;
+        }
+    }
+    uint64_t id = pipeline->next_id;
+    
+    o1_buf_reset(&pipeline->buf);
+    if (o1_buf_printf(&pipeline->buf, RPC_HEADER_FMT, (unsigned long long)id) != 0) {
+        return NULL;
+    }
+    
+    pipeline->building = 1;
+    return &pipeline->buf;
+}
+
+// Close the <rpc> started by o1_rpc_pipeline_begin() and send it
+int o1_rpc_pipeline_commit(o1_rpc_pipeline_t *pipeline, o1_rpc_callback_t callback, void *arg,
+                           uint64_t *message_id) {
+    if (!pipeline || !pipeline->building) {
+        return -1;
+    }
+    pipeline->building = 0;
+    
+    uint64_t id = pipeline->next_id;
+    
+    if (o1_buf_append(&pipeline->buf, RPC_FOOTER, sizeof(RPC_FOOTER) - 1) != 0) {
+        return -1;
+    }
+    
+    int ret = nc_send_rpc(pipeline->session, pipeline->buf.data, 1000, NULL);
+    if (ret != NC_MSG_RPC) {
+        fprintf(stderr, "Failed to send RPC message-id %llu: %s\n",
+                (unsigned long long)id, nc_strerror(ret));
+        return -1;
+    }
+    
+    o1_rpc_slot_t *slot = &pipeline->slots[pipeline->free_slots[--pipeline->num_free]];
+    slot->message_id = id;
+    pipeline->index[find_bucket(pipeline, id)] = (uint32_t)(slot - pipeline->slots) + 1;
+    slot->deadline_ms = now_ms() + O1_PIPELINE_RPC_TIMEOUT;
+    slot->callback = callback;
+    slot->arg = arg;
+    pipeline->outstanding++;
+    pipeline->next_id++;
+    
+    if (message_id) {
+        *message_id = id;
+    }
+    return 0;
+}
+
+// Drop the <rpc> started by o1_rpc_pipeline_begin() without sending it
+void o1_rpc_pipeline_cancel(o1_rpc_pipeline_t *pipeline) {
+    if (pipeline) {
+        pipeline->building = 0;
+    }
+}
+
+// Send <rpc message-id="N">operation</rpc>. Blocks while the window is
+// full, completing earlier RPCs as their replies arrive.
+int o1_rpc_pipeline_submit(o1_rpc_pipeline_t *pipeline, const char *operation,
+                           o1_rpc_callback_t callback, void *arg, uint64_t *message_id) {
+    if (!operation) {
+        return -1;
+    }
+    
+    o1_buf_t *buf = o1_rpc_pipeline_begin(pipeline);
+    if (!buf) {
+        return -1;
+    }
+    if (o1_buf_puts(buf, operation) != 0) {
+        o1_rpc_pipeline_cancel(pipeline);
+        return -1;
+    }
+    
+    return o1_rpc_pipeline_commit(pipeline, callback, arg, message_id);
+}
+
+// Wait up to timeout ms for one reply and complete its RPC. Returns 1 when
+// a reply was dispatched, 0 when none arrived, -1 when the session failed
+// (every outstanding RPC is then completed with O1_RPC_FAILED).
+int o1_rpc_pipeline_poll(o1_rpc_pipeline_t *pipeline, int timeout) {
+    if (!pipeline) {
+        return -1;
+    }
+    if (pipeline->outstanding == 0) {
+        return 0;
+    }
+    
+    struct nc_msg *msg = NULL;
+    int ret = nc_recv_reply(pipeline->session, NULL, timeout, &msg);
+    if (ret == NC_MSG_WOULDBLOCK) {
+        fail_rpcs(pipeline, 1);
+        return 0;
+    }
+    if (ret != NC_MSG_REPLY) {
+        fprintf(stderr, "Failed to receive response: %s\n", nc_strerror(ret));
+        nc_msg_free(msg);
+        fail_rpcs(pipeline, 0);
+        return -1;
+    }
+    
+    size_t len = 0;
+    const char *xml = nc_msg_get_data(msg, &len);
+    uint64_t id = 0;
+    o1_rpc_status_t status;
+    
+    if (!xml || parse_reply_header(xml, len, &id, &status) != 0) {
+        fprintf(stderr, "Received malformed rpc-reply\n");
+        nc_msg_free(msg);
+        return 0;
+    }
+    
+    uint32_t entry = id != 0 ? pipeline->index[find_bucket(pipeline, id)] : 0;
+    if (entry == 0) {
+        fprintf(stderr, "Received reply for unknown message-id %llu\n", (unsigned long long)id);
+        nc_msg_free(msg);
+        return 0;
+    }
+    
+    complete_rpc(pipeline, &pipeline->slots[entry - 1], status, xml, len);
+    nc_msg_free(msg);
+    return 1;
+}
+
+// Complete every outstanding RPC
+int o1_rpc_pipeline_drain(o1_rpc_pipeline_t *pipeline) {
+    while (pipeline->outstanding > 0) {
+        if (o1_rpc_pipeline_poll(pipeline, 100) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int o1_rpc_pipeline_outstanding(const o1_rpc_pipeline_t *pipeline) {
+    return pipeline->outstanding;
+}
+
+// Window slot of an RPC still in flight, or -1
+int o1_rpc_pipeline_slot(const o1_rpc_pipeline_t *pipeline, uint64_t message_id) {
+    if (message_id == 0) {
+        return -1;
+    }
+    uint32_t entry = pipeline->index[find_bucket(pipeline, message_id)];
+    return entry ? (int)entry - 1 : -1;
+}
+
+// Whether the next RPC can start without waiting for a reply; event loops
+// that must not block check this before o1_rpc_pipeline_begin()
+int o1_rpc_pipeline_ready(const o1_rpc_pipeline_t *pipeline) {
+    return !pipeline->building && pipeline->num_free > 0;
+}
@@ -0,0 +1,58 @@
+#ifndef O1_RPC_PIPELINE_H
+#define O1_RPC_PIPELINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// NETCONF includes
+#include <libnetconf2/netconf.h>
+#include <libnetconf2/session.h>
+#include <libnetconf2/messages.h>
+
+#include "o1_buf.h"
+
+// Asynchronous RPC pipeline over one NETCONF session. Up to `window` RPCs
+// are in flight at once; each carries a unique message-id and its reply is
+// matched back through a slot table and handed to the caller's callback.
+// An RPC takes whichever slot is free, so replies may come in any order
+// without holding up later RPCs; callers keep per-RPC state in arrays of
+// `window` entries indexed by the slot.
+
+#define O1_PIPELINE_DEFAULT_WINDOW 64
+#define O1_PIPELINE_RPC_TIMEOUT 5000   // ms without a reply before an RPC fails
+
+typedef enum {
+    O1_RPC_OK,          // <rpc-reply> without <rpc-error>
+    O1_RPC_ERROR,       // <rpc-reply> carrying <rpc-error>
+    O1_RPC_FAILED       // not sent, timed out, or session lost
+} o1_rpc_status_t;
+
+typedef struct {
+    uint64_t message_id;
+    int slot;           // window slot the RPC held, 0 .. window-1
+    o1_rpc_status_t status;
+    const char *reply;  // reply XML, valid only during the callback
+    size_t reply_len;
+} o1_rpc_result_t;
+
+typedef void (*o1_rpc_callback_t)(const o1_rpc_result_t *result, void *arg);
+
+typedef struct o1_rpc_pipeline o1_rpc_pipeline_t;
+
+// Function declarations
+o1_rpc_pipeline_t *o1_rpc_pipeline_create(struct nc_session *session, int window);
+void o1_rpc_pipeline_destroy(o1_rpc_pipeline_t *pipeline);
+
+int o1_rpc_pipeline_submit(o1_rpc_pipeline_t *pipeline, const char *operation,
+                           o1_rpc_callback_t callback, void *arg, uint64_t *message_id);
+o1_buf_t *o1_rpc_pipeline_begin(o1_rpc_pipeline_t *pipeline);
+int o1_rpc_pipeline_commit(o1_rpc_pipeline_t *pipeline, o1_rpc_callback_t callback, void *arg,
+                           uint64_t *message_id);
+void o1_rpc_pipeline_cancel(o1_rpc_pipeline_t *pipeline);
+int o1_rpc_pipeline_poll(o1_rpc_pipeline_t *pipeline, int timeout);
+int o1_rpc_pipeline_drain(o1_rpc_pipeline_t *pipeline);
+int o1_rpc_pipeline_outstanding(const o1_rpc_pipeline_t *pipeline);
+int o1_rpc_pipeline_slot(const o1_rpc_pipeline_t *pipeline, uint64_t message_id);
+int o1_rpc_pipeline_ready(const o1_rpc_pipeline_t *pipeline);
+
+#endif // O1_RPC_PIPELINE_H
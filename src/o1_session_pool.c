@@ -0,0 +1,332 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include "log.h"
+#include "o1_metrics.h"
+#include "o1_session_pool.h"
+
+// An established session together with the socket it runs on
+typedef struct {
+    struct nc_session *session;
+    int fd;
+} o1_pooled_session_t;
+
+// A session thread multiplexes all of its sessions through one nc_pollsession.
+// It sleeps in poll() on their sockets and on an eventfd, which the
+// acceptor writes to when it hands the worker a session, so a worker busy
+// with its own sessions adopts a new one at once.
+typedef struct {
+    o1_session_pool_t *pool;
+    pthread_t thread;
+    struct nc_pollsession *ps;
+    o1_pooled_session_t *sessions;
+    struct pollfd *fds;         // wake_fd, then the socket of each session
+    int count;
+    int capacity;
+    int wake_fd;
+    
+    // Protected by the pool's lock
+    o1_pooled_session_t *pending;   // handed over, not yet adopted
+    int num_pending;
+    o1_pooled_session_t *adopting;  // swapped with pending to adopt them
+    int load;                   // sessions polled or pending
+} o1_session_worker_t;
+
+struct o1_session_pool {
+    o1_session_pool_config_t config;
+    o1_rpc_handler_t handler;
+    
+    // Hand-off to the workers, protected by lock
+    pthread_mutex_t lock;
+    int queued;     // pending across all workers, bounded by queue_size
+    int active;     // queued + polled sessions, bounded by max_sessions
+    volatile int running;
+    
+    o1_session_worker_t *workers;
+    int started;
+};
+
+void o1_session_pool_default_config(o1_session_pool_config_t *config) {
+    config->num_workers = O1_POOL_DEFAULT_WORKERS;
+    config->queue_size = O1_POOL_DEFAULT_QUEUE_SIZE;
+    config->max_sessions = O1_POOL_DEFAULT_MAX_SESSIONS;
+    config->poll_timeout = O1_POOL_DEFAULT_POLL_TIMEOUT;
+    config->session_data_free = NULL;
+}
+
+static void release_session(o1_session_pool_t *pool, o1_pooled_session_t *entry) {
+    nc_session_free(entry->session, pool->config.session_data_free);
+    close(entry->fd);
+}
+
+static void wake_worker(o1_session_worker_t *worker) {
+    uint64_t one = 1;
+    if (write(worker->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        log_error("Failed to wake session worker: %s", strerror(errno));
+    }
+}
+
+static void worker_remove_session(o1_session_worker_t *worker, struct nc_session *session) {
+    for (int i = 0; i < worker->count; i++) {
+        if (worker->sessions[i].session != session) {
+            continue;
+        }
+        
+        nc_ps_del_session(worker->ps, session);
+        release_session(worker->pool, &worker->sessions[i]);
+        worker->count--;
+        worker->sessions[i] = worker->sessions[worker->count];
+        worker->fds[i + 1] = worker->fds[worker->count + 1];
+        
+        pthread_mutex_lock(&worker->pool->lock);
+        worker->pool->active--;
+        worker->load--;
+        pthread_mutex_unlock(&worker->pool->lock);
+        
+        o1_metrics_add(O1_METRIC_SESSIONS_CLOSED, 1);
+        log_info("NETCONF session closed");
+        return;
+    }
+}
+
+// Adopt every session handed to this worker since the last pass; the
+// acceptor never hands a worker more than it has room for
+static void worker_adopt_sessions(o1_session_worker_t *worker) {
+    o1_session_pool_t *pool = worker->pool;
+    
+    pthread_mutex_lock(&pool->lock);
+    o1_pooled_session_t *adopted = worker->pending;
+    int n = worker->num_pending;
+    worker->pending = worker->adopting;
+    worker->adopting = adopted;
+    worker->num_pending = 0;
+    pool->queued -= n;
+    pthread_mutex_unlock(&pool->lock);
+    
+    for (int i = 0; i < n; i++) {
+        if (nc_ps_add_session(worker->ps, adopted[i].session) != 0) {
+            log_error("Failed to add session to poll set");
+            release_session(pool, &adopted[i]);
+            pthread_mutex_lock(&pool->lock);
+            pool->active--;
+            worker->load--;
+            pthread_mutex_unlock(&pool->lock);
+            continue;
+        }
+        worker->sessions[worker->count] = adopted[i];
+        worker->fds[worker->count + 1].fd = adopted[i].fd;
+        worker->fds[worker->count + 1].events = POLLIN;
+        worker->count++;
+    }
+}
+
+// Serve every session with input, until none has more. libnetconf2 may
+// already hold a message read off a socket, so the sockets alone do not
+// say when to stop.
+static void worker_serve_sessions(o1_session_worker_t *worker) {
+    o1_session_pool_t *pool = worker->pool;
+    
+    while (worker->count > 0) {
+        struct nc_session *session = NULL;
+        int ret = nc_ps_poll(worker->ps, 0, &session);
+        if (ret & (NC_PSPOLL_TIMEOUT | NC_PSPOLL_NOSESSIONS)) {
+            return;
+        }
+        
+        if (ret & NC_PSPOLL_RPC) {
+            struct nc_msg *msg = NULL;
+            if (nc_recv_msg(session, 0, &msg) == NC_MSG_RPC) {
+                pool->handler(session, msg);
+            }
+            nc_msg_free(msg);
+        }
+        
+        if (ret & (NC_PSPOLL_SESSION_TERM | NC_PSPOLL_SESSION_ERROR)) {
+            worker_remove_session(worker, session);
+        } else if (ret & NC_PSPOLL_ERROR) {
+            log_error("Session poll failed");
+            return;
+        }
+    }
+}
+
+static void *session_worker_main(void *arg) {
+    o1_session_worker_t *worker = arg;
+    o1_session_pool_t *pool = worker->pool;
+    
+    while (pool->running) {
+        // Sleep until a session has input or is handed over; the timeout
+        // bounds how long a message held by libnetconf2 could wait
+        int timeout = worker->count > 0 ? pool->config.poll_timeout : -1;
+        if (poll(worker->fds, worker->count + 1, timeout) < 0 && errno != EINTR) {
+            log_error("Session worker poll failed: %s", strerror(errno));
+        }
+        
+        if (worker->fds[0].revents & POLLIN) {
+            uint64_t wakeups;
+            if (read(worker->wake_fd, &wakeups, sizeof(wakeups)) < 0 && errno != EAGAIN) {
+                log_error("Failed to read session worker wakeup: %s", strerror(errno));
+            }
+            worker_adopt_sessions(worker);
+        }
+        worker_serve_sessions(worker);
+    }
+    
+    while (worker->count > 0) {
+        worker_remove_session(worker, worker->sessions[0].session);
+    }
+    
+    return NULL;
+}
+
+o1_session_pool_t *o1_session_pool_create(const o1_session_pool_config_t *config,
+                                          o1_rpc_handler_t handler) {
+    if (!config || !handler || config->num_workers < 1 || config->queue_size < 1 ||
+        config->max_sessions < 1) {
+        return NULL;
+    }
+    
+    o1_session_pool_t *pool = calloc(1, sizeof(*pool));
+    if (!pool) {
+        return NULL;
+    }
+    
+    pool->config = *config;
+    pool->handler = handler;
+    pool->running = 1;
+    pthread_mutex_init(&pool->lock, NULL);
+    
+    pool->workers = calloc(config->num_workers, sizeof(*pool->workers));
+    if (!pool->workers) {
+        o1_session_pool_destroy(pool);
+        return NULL;
+    }
+    for (int i = 0; i < config->num_workers; i++) {
+        pool->workers[i].wake_fd = -1;
+    }
+    
+    // Each worker serves an equal share of the session limit
+    int per_worker = (config->max_sessions + config->num_workers - 1) / config->num_workers;
+    
+    for (int i = 0; i < config->num_workers; i++) {
+        o1_session_worker_t *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->capacity = per_worker;
+        worker->ps = nc_ps_new();
+        worker->sessions = calloc(per_worker, sizeof(*worker->sessions));
+        worker->pending = calloc(per_worker, sizeof(*worker->pending));
+        worker->adopting = calloc(per_worker, sizeof(*worker->adopting));
+        worker->fds = calloc(per_worker + 1, sizeof(*worker->fds));
+        worker->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (!worker->ps || !worker->sessions || !worker->pending || !worker->adopting ||
+            !worker->fds || worker->wake_fd < 0) {
+            fprintf(stderr, "Failed to allocate session worker %d\n", i);
+            o1_session_pool_destroy(pool);
+            return NULL;
+        }
+        worker->fds[0].fd = worker->wake_fd;
+        worker->fds[0].events = POLLIN;
+        
+        if (pthread_create(&worker->thread, NULL, session_worker_main, worker) != 0) {
+            fprintf(stderr, "Failed to start session worker %d\n", i);
+            o1_session_pool_destroy(pool);
+            return NULL;
+        }
+        pool->started++;
+    }
+    
+    printf("Session pool started: %d workers, queue %d, max %d sessions\n",
+           config->num_workers, config->queue_size, config->max_sessions);
+    return pool;
+}
+
+// Hand an established session to the pool. Fails when the queue is full or
+// the session limit is reached; the caller keeps ownership in that case.
+// The session goes to the worker with the fewest, which is woken even if
+// it is busy polling the ones it has.
+int o1_session_pool_submit(o1_session_pool_t *pool, struct nc_session *session, int fd) {
+    if (!pool || !session) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    if (!pool->running || pool->queued == pool->config.queue_size ||
+        pool->active >= pool->config.max_sessions) {
+        pthread_mutex_unlock(&pool->lock);
+        return -1;
+    }
+    
+    // Below max_sessions some worker has room, as the shares add up to it
+    o1_session_worker_t *worker = &pool->workers[0];
+    for (int i = 1; i < pool->config.num_workers; i++) {
+        if (pool->workers[i].load < worker->load) {
+            worker = &pool->workers[i];
+        }
+    }
+    worker->pending[worker->num_pending].session = session;
+    worker->pending[worker->num_pending].fd = fd;
+    worker->num_pending++;
+    worker->load++;
+    pool->queued++;
+    pool->active++;
+    pthread_mutex_unlock(&pool->lock);
+    
+    wake_worker(worker);
+    return 0;
+}
+
+int o1_session_pool_active(o1_session_pool_t *pool) {
+    pthread_mutex_lock(&pool->lock);
+    int active = pool->active;
+    pthread_mutex_unlock(&pool->lock);
+    return active;
+}
+
+void o1_session_pool_destroy(o1_session_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    pool->running = 0;
+    pthread_mutex_unlock(&pool->lock);
+    
+    for (int i = 0; i < pool->started; i++) {
+        wake_worker(&pool->workers[i]);
+    }
+    for (int i = 0; i < pool->started; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+    
+    if (pool->workers) {
+        for (int i = 0; i < pool->config.num_workers; i++) {
+            o1_session_worker_t *worker = &pool->workers[i];
+            
+            // Sessions that never reached the worker
+            for (int n = 0; n < worker->num_pending; n++) {
+                release_session(pool, &worker->pending[n]);
+            }
+            if (worker->ps) {
+                nc_ps_free(worker->ps);
+            }
+            if (worker->wake_fd >= 0) {
+                close(worker->wake_fd);
+            }
+            free(worker->sessions);
+            free(worker->pending);
+            free(worker->adopting);
+            free(worker->fds);
+        }
+    }
+    
+    free(pool->workers);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
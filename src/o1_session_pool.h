@@ -0,0 +1,38 @@
+#ifndef O1_SESSION_POOL_H
+#define O1_SESSION_POOL_H
+
+#include <pthread.h>
+
+// NETCONF includes
+#include <libnetconf2/netconf.h>
+#include <libnetconf2/session.h>
+#include <libnetconf2/messages.h>
+
+// Called on a session worker thread for every RPC received on a pooled session
+typedef int (*o1_rpc_handler_t)(struct nc_session *session, struct nc_msg *msg);
+
+typedef struct o1_session_pool o1_session_pool_t;
+
+// Pool configuration
+typedef struct {
+    int num_workers;    // session threads, each polling its own nc_pollsession
+    int queue_size;     // bounded hand-off queue between acceptor and workers
+    int max_sessions;   // established sessions served at once, across all workers
+    int poll_timeout;   // longest a worker with sessions sleeps in poll(), in milliseconds
+    void (*session_data_free)(void *data);  // releases nc_session_get_data() on close
+} o1_session_pool_config_t;
+
+#define O1_POOL_DEFAULT_WORKERS 4
+#define O1_POOL_DEFAULT_QUEUE_SIZE 64
+#define O1_POOL_DEFAULT_MAX_SESSIONS 512
+#define O1_POOL_DEFAULT_POLL_TIMEOUT 100
+
+// Function declarations
+void o1_session_pool_default_config(o1_session_pool_config_t *config);
+o1_session_pool_t *o1_session_pool_create(const o1_session_pool_config_t *config,
+                                          o1_rpc_handler_t handler);
+int o1_session_pool_submit(o1_session_pool_t *pool, struct nc_session *session, int fd);
+int o1_session_pool_active(o1_session_pool_t *pool);
+void o1_session_pool_destroy(o1_session_pool_t *pool);
+
+#endif // O1_SESSION_POOL_H
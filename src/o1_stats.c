@@ -0,0 +1,149 @@
+#define _POSIX_C_SOURCE 200112L
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "o1_stats.h"
+
+#define PAGE_MASK (O1_STATS_PAGE_SIZE - 1)
+
+typedef struct {
+    o1_if_counters_t counters[O1_STATS_PAGE_SIZE];
+} o1_stats_page_t;
+
+typedef struct {
+    o1_stats_page_t **pages;    // num_pages entries, filled by the writer on demand
+    int in_use;                 // claimed by a writer
+} o1_stats_shard_t;
+
+struct o1_stats {
+    size_t capacity;
+    size_t num_pages;
+    int num_shards;
+    o1_stats_shard_t shards[O1_STATS_MAX_SHARDS];
+};
+
+o1_stats_t *o1_stats_create(size_t capacity, int shards) {
+    if (capacity == 0 || shards < 1 || shards > O1_STATS_MAX_SHARDS) {
+        errno = EINVAL;
+        return NULL;
+    }
+    
+    o1_stats_t *stats = calloc(1, sizeof(*stats));
+    if (!stats) {
+        return NULL;
+    }
+    
+    stats->capacity = capacity;
+    stats->num_pages = (capacity + O1_STATS_PAGE_SIZE - 1) / O1_STATS_PAGE_SIZE;
+    stats->num_shards = shards;
+    for (int i = 0; i < shards; i++) {
+        stats->shards[i].pages = calloc(stats->num_pages, sizeof(*stats->shards[i].pages));
+        if (!stats->shards[i].pages) {
+            o1_stats_destroy(stats);
+            return NULL;
+        }
+    }
+    
+    return stats;
+}
+
+void o1_stats_destroy(o1_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    
+    for (int i = 0; i < stats->num_shards; i++) {
+        if (!stats->shards[i].pages) {
+            continue;
+        }
+        for (size_t p = 0; p < stats->num_pages; p++) {
+            free(stats->shards[i].pages[p]);
+        }
+        free(stats->shards[i].pages);
+    }
+    free(stats);
+}
+
+int o1_stats_shards(const o1_stats_t *stats) {
+    return stats ? stats->num_shards : 0;
+}
+
+// Take a free shard for the calling writer. Returns its number, or -1 when
+// every shard has a writer. A released shard keeps its counts, and the
+// next writer adds to them.
+int o1_stats_claim_shard(o1_stats_t *stats) {
+    if (!stats) {
+        return -1;
+    }
+    
+    for (int i = 0; i < stats->num_shards; i++) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&stats->shards[i].in_use, &expected, 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void o1_stats_release_shard(o1_stats_t *stats, int shard) {
+    if (stats && shard >= 0 && shard < stats->num_shards) {
+        __atomic_store_n(&stats->shards[shard].in_use, 0, __ATOMIC_RELEASE);
+    }
+}
+
+// Single writer: a relaxed load and store, no locked instruction
+static inline void counter_add(uint64_t *value, uint64_t delta) {
+    __atomic_store_n(value, __atomic_load_n(value, __ATOMIC_RELAXED) + delta, __ATOMIC_RELAXED);
+}
+
+// Add delta to the counters of interface `index`. Only the writer that
+// claimed `shard` may call this. Returns -1 for an index out of range or
+// when a page could not be allocated.
+int o1_stats_add(o1_stats_t *stats, int shard, size_t index, const o1_if_counters_t *delta) {
+    if (!stats || shard < 0 || shard >= stats->num_shards || index >= stats->capacity) {
+        return -1;
+    }
+    
+    o1_stats_page_t **slot = &stats->shards[shard].pages[index >> O1_STATS_PAGE_SHIFT];
+    o1_stats_page_t *page = *slot;
+    if (!page) {
+        // Aligned so no cache line is shared with another shard's page
+        void *mem = NULL;
+        if (posix_memalign(&mem, 64, sizeof(o1_stats_page_t)) != 0) {
+            return -1;
+        }
+        page = memset(mem, 0, sizeof(o1_stats_page_t));
+        __atomic_store_n(slot, page, __ATOMIC_RELEASE);
+    }
+    
+    o1_if_counters_t *counters = &page->counters[index & PAGE_MASK];
+    counter_add(&counters->packets_in, delta->packets_in);
+    counter_add(&counters->packets_out, delta->packets_out);
+    counter_add(&counters->bytes_in, delta->bytes_in);
+    counter_add(&counters->bytes_out, delta->bytes_out);
+    return 0;
+}
+
+// Sum of every shard's counters for interface `index`
+void o1_stats_read(o1_stats_t *stats, size_t index, o1_if_counters_t *total) {
+    memset(total, 0, sizeof(*total));
+    if (!stats || index >= stats->capacity) {
+        return;
+    }
+    
+    size_t page_idx = index >> O1_STATS_PAGE_SHIFT;
+    for (int i = 0; i < stats->num_shards; i++) {
+        const o1_stats_page_t *page = __atomic_load_n(&stats->shards[i].pages[page_idx],
+                                                      __ATOMIC_ACQUIRE);
+        if (!page) {
+            continue;
+        }
+        const o1_if_counters_t *counters = &page->counters[index & PAGE_MASK];
+        total->packets_in += __atomic_load_n(&counters->packets_in, __ATOMIC_RELAXED);
+        total->packets_out += __atomic_load_n(&counters->packets_out, __ATOMIC_RELAXED);
+        total->bytes_in += __atomic_load_n(&counters->bytes_in, __ATOMIC_RELAXED);
+        total->bytes_out += __atomic_load_n(&counters->bytes_out, __ATOMIC_RELAXED);
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef O1_STATS_H
+#define O1_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Live per-interface statistics (the statistics container of
+// o1-interface.yang), indexed by datastore slot.
+//
+// Counters are split into shards, one per writer: a data-plane feed thread
+// claims a shard and is then its only writer, so an update is a few
+// relaxed loads and stores with no locked instruction and no cache line
+// shared with another writer or with readers' bookkeeping. Shards are
+// separate 64-byte aligned pages of O1_STATS_PAGE_SIZE interfaces,
+// allocated on the first update that touches them. Readers never write:
+// get-config sums the shards for the interfaces it renders, and nothing is
+// aggregated otherwise. The four counters of one interface are read
+// without a snapshot, so they may be one update apart.
+
+#define O1_STATS_MAX_SHARDS 64
+#define O1_STATS_PAGE_SHIFT 12
+#define O1_STATS_PAGE_SIZE (1u << O1_STATS_PAGE_SHIFT)
+
+typedef struct {
+    uint64_t packets_in;
+    uint64_t packets_out;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+} o1_if_counters_t;
+
+typedef struct o1_stats o1_stats_t;
+
+// Function declarations
+o1_stats_t *o1_stats_create(size_t capacity, int shards);
+void o1_stats_destroy(o1_stats_t *stats);
+int o1_stats_shards(const o1_stats_t *stats);
+
+int o1_stats_claim_shard(o1_stats_t *stats);
+void o1_stats_release_shard(o1_stats_t *stats, int shard);
+int o1_stats_add(o1_stats_t *stats, int shard, size_t index, const o1_if_counters_t *delta);
+void o1_stats_read(o1_stats_t *stats, size_t index, o1_if_counters_t *total);
+
+#endif // O1_STATS_H
@@ -0,0 +1,250 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "log.h"
+#include "o1_stats_feed.h"
+
+#define FEED_BUF_SIZE (64 * 1024)
+#define FEED_POLL_TIMEOUT 200       // ms between checks for shutdown
+
+// One feeder connection and the thread that applies its lines
+typedef struct {
+    o1_stats_feed_t *feed;
+    pthread_t thread;
+    int fd;
+    int shard;
+    int started;
+    int done;                       // set by the thread when it exits
+} feed_conn_t;
+
+struct o1_stats_feed {
+    char path[108];
+    int listen_fd;
+    o1_datastore_t *ds;
+    o1_stats_t *stats;
+    pthread_t listener;
+    volatile int running;
+    feed_conn_t conns[O1_STATS_MAX_SHARDS];
+};
+
+static const char *parse_u64(const char *p, const char *end, uint64_t *value) {
+    while (p < end && *p == ' ') {
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return NULL;
+    }
+    
+    uint64_t v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (uint64_t)(*p - '0');
+        p++;
+    }
+    *value = v;
+    return p;
+}
+
+// Apply one line. Returns 0, 1 for an interface not in the datastore, or
+// -1 for a malformed line.
+static int apply_line(o1_stats_feed_t *feed, int shard, const char *line, const char *end) {
+    const char *name = line;
+    const char *p = memchr(line, ' ', (size_t)(end - line));
+    if (!p || p == name) {
+        return -1;
+    }
+    size_t name_len = (size_t)(p - name);
+    
+    o1_if_counters_t delta;
+    p = parse_u64(p, end, &delta.packets_in);
+    p = p ? parse_u64(p, end, &delta.packets_out) : NULL;
+    p = p ? parse_u64(p, end, &delta.bytes_in) : NULL;
+    p = p ? parse_u64(p, end, &delta.bytes_out) : NULL;
+    if (!p) {
+        return -1;
+    }
+    
+    size_t index;
+    if (o1_datastore_lookup(feed->ds, name, name_len, &index) != 0) {
+        return 1;
+    }
+    return o1_stats_add(feed->stats, shard, index, &delta) == 0 ? 0 : -1;
+}
+
+static void *conn_main(void *arg) {
+    feed_conn_t *conn = arg;
+    o1_stats_feed_t *feed = conn->feed;
+    unsigned long long applied = 0, unknown = 0, malformed = 0;
+    size_t len = 0;
+    
+    char *buf = malloc(FEED_BUF_SIZE);
+    while (buf) {
+        ssize_t n = read(conn->fd, buf + len, FEED_BUF_SIZE - len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        len += (size_t)n;
+        
+        // Every complete line; the partial one moves to the front
+        char *line = buf;
+        char *end = buf + len;
+        char *nl;
+        while ((nl = memchr(line, '\n', (size_t)(end - line))) != NULL) {
+            int ret = apply_line(feed, conn->shard, line, nl);
+            if (ret == 0) {
+                applied++;
+            } else if (ret > 0) {
+                unknown++;
+            } else {
+                malformed++;
+            }
+            line = nl + 1;
+        }
+        len = (size_t)(end - line);
+        if (len == FEED_BUF_SIZE) {
+            // A line longer than the buffer can only be garbage
+            malformed++;
+            len = 0;
+        }
+        memmove(buf, line, len);
+    }
+    free(buf);
+    
+    log_info("Stats feed on shard %d closed: %llu updates, %llu for unknown interfaces, %llu malformed",
+             conn->shard, applied, unknown, malformed);
+    o1_stats_release_shard(feed->stats, conn->shard);
+    __atomic_store_n(&conn->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Join the threads of connections that have ended
+static void reap_conns(o1_stats_feed_t *feed, int all) {
+    for (int i = 0; i < O1_STATS_MAX_SHARDS; i++) {
+        feed_conn_t *conn = &feed->conns[i];
+        if (!conn->started) {
+            continue;
+        }
+        if (all) {
+            // Unblocks the read; the thread then exits on its own
+            shutdown(conn->fd, SHUT_RDWR);
+        } else if (!__atomic_load_n(&conn->done, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        pthread_join(conn->thread, NULL);
+        close(conn->fd);
+        conn->started = 0;
+    }
+}
+
+static void accept_conn(o1_stats_feed_t *feed, int fd) {
+    int shard = o1_stats_claim_shard(feed->stats);
+    if (shard < 0) {
+        log_warn("Stats feed rejected: all %d shards have a feeder", o1_stats_shards(feed->stats));
+        close(fd);
+        return;
+    }
+    
+    // A claimed shard is never in use by a running connection
+    feed_conn_t *conn = &feed->conns[shard];
+    conn->feed = feed;
+    conn->fd = fd;
+    conn->shard = shard;
+    conn->done = 0;
+    if (pthread_create(&conn->thread, NULL, conn_main, conn) != 0) {
+        log_error("Failed to start stats feed thread");
+        o1_stats_release_shard(feed->stats, shard);
+        close(fd);
+        return;
+    }
+    conn->started = 1;
+    log_info("Stats feed connected on shard %d", shard);
+}
+
+static void *listener_main(void *arg) {
+    o1_stats_feed_t *feed = arg;
+    struct pollfd pfd = { .fd = feed->listen_fd, .events = POLLIN };
+    
+    while (feed->running) {
+        reap_conns(feed, 0);
+        if (poll(&pfd, 1, FEED_POLL_TIMEOUT) <= 0) {
+            continue;
+        }
+        int fd = accept(feed->listen_fd, NULL, NULL);
+        if (fd >= 0) {
+            accept_conn(feed, fd);
+        }
+    }
+    
+    reap_conns(feed, 1);
+    return NULL;
+}
+
+// Listen for feeders on the UNIX socket `path`, replacing a stale one
+o1_stats_feed_t *o1_stats_feed_start(const char *path, o1_datastore_t *ds, o1_stats_t *stats) {
+    struct sockaddr_un addr;
+    if (!path || !ds || !stats || strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Invalid stats feed socket path\n");
+        return NULL;
+    }
+    
+    o1_stats_feed_t *feed = calloc(1, sizeof(*feed));
+    if (!feed) {
+        return NULL;
+    }
+    snprintf(feed->path, sizeof(feed->path), "%s", path);
+    feed->ds = ds;
+    feed->stats = stats;
+    
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, strlen(path) + 1);
+    
+    feed->listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (feed->listen_fd < 0) {
+        perror("Failed to create stats feed socket");
+        free(feed);
+        return NULL;
+    }
+    unlink(path);
+    if (bind(feed->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(feed->listen_fd, O1_STATS_MAX_SHARDS) < 0) {
+        perror(path);
+        close(feed->listen_fd);
+        free(feed);
+        return NULL;
+    }
+    
+    feed->running = 1;
+    if (pthread_create(&feed->listener, NULL, listener_main, feed) != 0) {
+        fprintf(stderr, "Failed to start stats feed listener\n");
+        close(feed->listen_fd);
+        unlink(path);
+        free(feed);
+        return NULL;
+    }
+    
+    return feed;
+}
+
+// Close the socket and every feeder connection
+void o1_stats_feed_stop(o1_stats_feed_t *feed) {
+    if (!feed) {
+        return;
+    }
+    
+    feed->running = 0;
+    pthread_join(feed->listener, NULL);
+    close(feed->listen_fd);
+    unlink(feed->path);
+    free(feed);
+}
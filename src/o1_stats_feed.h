@@ -0,0 +1,22 @@
+#ifndef O1_STATS_FEED_H
+#define O1_STATS_FEED_H
+
+#include "o1_datastore.h"
+#include "o1_stats.h"
+
+// Stand-in for the data plane: interface counters arrive over a UNIX
+// stream socket as text lines of deltas,
+//
+//   <interface-name> <packets-in> <packets-out> <bytes-in> <bytes-out>
+//
+// Each connection is served by its own thread writing its own stats shard,
+// so several feeders (one per core) update without contending. Lines for
+// interfaces not in the running datastore are counted and skipped.
+
+typedef struct o1_stats_feed o1_stats_feed_t;
+
+// Function declarations
+o1_stats_feed_t *o1_stats_feed_start(const char *path, o1_datastore_t *ds, o1_stats_t *stats);
+void o1_stats_feed_stop(o1_stats_feed_t *feed);
+
+#endif // O1_STATS_FEED_H
@@ -0,0 +1,732 @@
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "log.h"
+#include "o1_buf.h"
+#include "o1_wal.h"
+
+#define SNAPSHOT_MAGIC "O1SNAP01"
+#define SNAPSHOT_FILE "snapshot"
+#define SNAPSHOT_TMP "snapshot.tmp"
+#define SEGMENT_PREFIX "wal-"
+#define SNAPSHOT_CHUNK 4096     // images per write while taking a snapshot
+
+typedef struct {
+    char magic[8];
+    uint32_t record_size;       // sizeof(o1_ds_image_t)
+    uint32_t reserved;
+    uint64_t count;             // images that follow
+    uint64_t segment;           // first log segment the snapshot does not cover
+} snapshot_header_t;
+
+// Precedes every image in the log
+typedef struct {
+    uint32_t len;               // bytes of the image
+    uint32_t crc;               // CRC-32 of the image
+} record_header_t;
+
+struct o1_wal {
+    o1_wal_config_t config;
+    char *dir;
+    o1_datastore_t *ds;
+    
+    pthread_mutex_t lock;
+    pthread_cond_t flush;       // records or a segment switch for the flusher
+    pthread_cond_t synced;      // durable, segment or error changed
+    pthread_cond_t wake;        // the snapshot thread should stop
+    o1_buf_t pending;           // appended, not yet taken by the flusher
+    uint64_t appended;          // bytes appended since open
+    uint64_t durable;           // of those, bytes written and synced
+    int fd;                     // current segment
+    uint64_t segment;
+    uint64_t switch_to;         // segment a snapshot is waiting for, 0 for none
+    uint64_t since_snapshot;    // records appended since the last snapshot
+    int error;                  // errno of a failed write; nothing is logged after it
+    int running;                // flusher
+    int stopping;               // snapshot thread
+    o1_wal_stats_t stats;
+    
+    pthread_mutex_t snapshot_lock;  // one snapshot at a time
+    pthread_t flusher;
+    pthread_t snapshotter;
+    int snapshotter_started;
+};
+
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[i] = c;
+    }
+}
+
+static uint32_t checksum(const void *data, size_t len) {
+    const unsigned char *p = data;
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) {
+        c = crc_table[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+static void path_of(const o1_wal_t *wal, const char *name, char *path, size_t size) {
+    snprintf(path, size, "%s/%s", wal->dir, name);
+}
+
+static void segment_path(const o1_wal_t *wal, uint64_t segment, char *path, size_t size) {
+    snprintf(path, size, "%s/" SEGMENT_PREFIX "%08" PRIu64, wal->dir, segment);
+}
+
+// Number of a segment file name, or 0 for anything else
+static uint64_t parse_segment(const char *name) {
+    size_t prefix = strlen(SEGMENT_PREFIX);
+    if (strncmp(name, SEGMENT_PREFIX, prefix) != 0 || name[prefix] == '\0') {
+        return 0;
+    }
+    
+    uint64_t value = 0;
+    for (const char *p = name + prefix; *p; p++) {
+        if (*p < '0' || *p > '9') {
+            return 0;
+        }
+        value = value * 10 + (uint64_t)(*p - '0');
+    }
+    return value;
+}
+
+static int write_all(int fd, const void *data, size_t len) {
+    const char *p = data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// Make created, renamed and removed files in the directory durable
+static int sync_dir(const o1_wal_t *wal) {
+    int fd = open(wal->dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    int ret = fsync(fd);
+    close(fd);
+    return ret;
+}
+
+static int open_segment(const o1_wal_t *wal, uint64_t segment) {
+    char path[4096];
+    segment_path(wal, segment, path, sizeof(path));
+    
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    if (sync_dir(wal) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+// Journal hook: runs under the datastore's write lock, so records are in
+// edit order. Only copies; the flusher does the I/O.
+static void journal_append(void *arg, const o1_ds_image_t *image) {
+    o1_wal_t *wal = arg;
+    record_header_t header = { sizeof(*image), checksum(image, sizeof(*image)) };
+    
+    pthread_mutex_lock(&wal->lock);
+    if (wal->error == 0) {
+        if (o1_buf_reserve(&wal->pending, sizeof(header) + sizeof(*image)) != 0) {
+            log_error("Write-ahead log out of memory");
+            wal->error = ENOMEM;
+            pthread_cond_broadcast(&wal->synced);
+        } else {
+            // The flusher only sleeps with nothing pending
+            if (wal->pending.len == 0) {
+                pthread_cond_signal(&wal->flush);
+            }
+            o1_buf_append(&wal->pending, (const char *)&header, sizeof(header));
+            o1_buf_append(&wal->pending, (const char *)image, sizeof(*image));
+            wal->appended += sizeof(header) + sizeof(*image);
+            wal->since_snapshot++;
+            wal->stats.records++;
+        }
+    }
+    pthread_mutex_unlock(&wal->lock);
+}
+
+static int journal_sync(void *arg) {
+    return o1_wal_sync(arg);
+}
+
+// Group commit: each pass takes everything appended since the last one and
+// writes it with a single write and a single fdatasync, so concurrent edits
+// share the cost of the sync
+static void *flusher_thread(void *arg) {
+    o1_wal_t *wal = arg;
+    o1_buf_t batch;
+    o1_buf_init(&batch);
+    
+    pthread_mutex_lock(&wal->lock);
+    for (;;) {
+        while (wal->running && wal->pending.len == 0 && wal->switch_to == 0) {
+            pthread_cond_wait(&wal->flush, &wal->lock);
+        }
+        if (!wal->running && wal->pending.len == 0 && wal->switch_to == 0) {
+            break;
+        }
+        
+        o1_buf_t full = wal->pending;
+        wal->pending = batch;
+        batch = full;
+        uint64_t lsn = wal->appended;
+        uint64_t next = wal->switch_to;
+        int fd = wal->fd;
+        int error = wal->error;
+        pthread_mutex_unlock(&wal->lock);
+        
+        // Records taken so far belong to the old segment; a switch opens the
+        // new one once they are durable
+        int new_fd = -1;
+        if (error == 0 && (write_all(fd, batch.data, batch.len) != 0 || fdatasync(fd) != 0)) {
+            error = errno;
+        }
+        if (error == 0 && next != 0) {
+            new_fd = open_segment(wal, next);
+            if (new_fd < 0) {
+                error = errno;
+            }
+        }
+        o1_buf_reset(&batch);
+        
+        pthread_mutex_lock(&wal->lock);
+        if (error != 0) {
+            if (wal->error == 0) {
+                log_error("Write-ahead log failed, changes are no longer durable: %s",
+                          strerror(error));
+            }
+            wal->error = error;
+            wal->switch_to = 0;
+        } else {
+            wal->durable = lsn;
+            wal->stats.syncs++;
+            if (next != 0) {
+                close(fd);
+                wal->fd = new_fd;
+                wal->segment = next;
+                wal->switch_to = 0;
+            }
+        }
+        pthread_cond_broadcast(&wal->synced);
+    }
+    pthread_mutex_unlock(&wal->lock);
+    
+    o1_buf_free(&batch);
+    return NULL;
+}
+
+// Wait until every record appended so far is durable. Returns 0, or -1
+// with errno set once the log has failed.
+int o1_wal_sync(o1_wal_t *wal) {
+    pthread_mutex_lock(&wal->lock);
+    uint64_t target = wal->appended;
+    while (wal->durable < target && wal->error == 0) {
+        pthread_cond_wait(&wal->synced, &wal->lock);
+    }
+    int error = wal->error;
+    pthread_mutex_unlock(&wal->lock);
+    
+    if (error != 0) {
+        errno = error;
+        return -1;
+    }
+    return 0;
+}
+
+static int write_snapshot(o1_wal_t *wal, uint64_t segment) {
+    char tmp[4096], path[4096];
+    path_of(wal, SNAPSHOT_TMP, tmp, sizeof(tmp));
+    path_of(wal, SNAPSHOT_FILE, path, sizeof(path));
+    
+    o1_ds_image_t *chunk = malloc(SNAPSHOT_CHUNK * sizeof(*chunk));
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (!chunk || fd < 0) {
+        log_error("Failed to start snapshot %s: %s", tmp, strerror(errno));
+        free(chunk);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    
+    // Interfaces created after this count are in the new segment
+    size_t count = o1_datastore_count(wal->ds);
+    snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.record_size = sizeof(o1_ds_image_t);
+    header.count = count;
+    header.segment = segment;
+    
+    int ret = write_all(fd, &header, sizeof(header));
+    for (size_t i = 0; i < count && ret == 0; i += SNAPSHOT_CHUNK) {
+        size_t n = count - i < SNAPSHOT_CHUNK ? count - i : SNAPSHOT_CHUNK;
+        for (size_t j = 0; j < n; j++) {
+            o1_datastore_export(wal->ds, i + j, &chunk[j]);
+        }
+        ret = write_all(fd, chunk, n * sizeof(*chunk));
+    }
+    if (ret == 0) {
+        ret = fsync(fd);
+    }
+    if (close(fd) != 0) {
+        ret = -1;
+    }
+    
+    // The rename is the commit point: a crash before it leaves the old
+    // snapshot and every segment it needs
+    if (ret == 0) {
+        ret = rename(tmp, path);
+    }
+    if (ret == 0) {
+        ret = sync_dir(wal);
+    }
+    if (ret != 0) {
+        log_error("Failed to write snapshot %s: %s", path, strerror(errno));
+        unlink(tmp);
+    } else {
+        log_info("Snapshot of %zu interfaces written, log continues in segment %" PRIu64,
+                 count, segment);
+    }
+    
+    free(chunk);
+    return ret;
+}
+
+// Delete the segments numbered below `first`
+static void remove_segments(o1_wal_t *wal, uint64_t first) {
+    DIR *dir = opendir(wal->dir);
+    if (!dir) {
+        return;
+    }
+    
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        uint64_t segment = parse_segment(entry->d_name);
+        if (segment != 0 && segment < first) {
+            char path[4096];
+            segment_path(wal, segment, path, sizeof(path));
+            if (unlink(path) != 0) {
+                log_warn("Failed to remove log segment %s: %s", path, strerror(errno));
+            }
+        }
+    }
+    closedir(dir);
+}
+
+// Switch the log to a new segment, write every interface to a new snapshot
+// and drop the segments it replaces. Writers are not held up: edits made
+// meanwhile go to the new segment as usual.
+int o1_wal_snapshot(o1_wal_t *wal) {
+    pthread_mutex_lock(&wal->snapshot_lock);
+    
+    pthread_mutex_lock(&wal->lock);
+    uint64_t segment = wal->segment + 1;
+    uint64_t since = wal->since_snapshot;
+    wal->switch_to = segment;
+    wal->since_snapshot = 0;
+    pthread_cond_signal(&wal->flush);
+    while (wal->segment != segment && wal->error == 0) {
+        pthread_cond_wait(&wal->synced, &wal->lock);
+    }
+    int error = wal->error;
+    pthread_mutex_unlock(&wal->lock);
+    
+    int ret = error == 0 ? write_snapshot(wal, segment) : -1;
+    
+    pthread_mutex_lock(&wal->lock);
+    if (ret == 0) {
+        wal->stats.snapshots++;
+    } else {
+        // Not covered after all; the next check tries again
+        wal->since_snapshot += since;
+    }
+    pthread_mutex_unlock(&wal->lock);
+    
+    if (ret == 0) {
+        remove_segments(wal, segment);
+    } else if (error != 0) {
+        errno = error;
+    }
+    
+    pthread_mutex_unlock(&wal->snapshot_lock);
+    return ret;
+}
+
+static void *snapshot_thread(void *arg) {
+    o1_wal_t *wal = arg;
+    
+    pthread_mutex_lock(&wal->lock);
+    while (!wal->stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += wal->config.snapshot_interval / 1000;
+        deadline.tv_nsec += (long)(wal->config.snapshot_interval % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        
+        pthread_cond_timedwait(&wal->wake, &wal->lock, &deadline);
+        if (wal->stopping || wal->since_snapshot < wal->config.snapshot_records) {
+            continue;
+        }
+        
+        pthread_mutex_unlock(&wal->lock);
+        o1_wal_snapshot(wal);
+        pthread_mutex_lock(&wal->lock);
+    }
+    pthread_mutex_unlock(&wal->lock);
+    
+    return NULL;
+}
+
+// Map the snapshot and install its images in one pass. Sets *segment to the
+// first segment to replay (0 when there is no snapshot).
+static int load_snapshot(o1_wal_t *wal, uint64_t *segment) {
+    char path[4096];
+    path_of(wal, SNAPSHOT_FILE, path, sizeof(path));
+    *segment = 0;
+    
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        log_error("Failed to open snapshot %s: %s", path, strerror(errno));
+        return -1;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(snapshot_header_t)) {
+        log_error("Snapshot %s is truncated", path);
+        close(fd);
+        return -1;
+    }
+    
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        log_error("Failed to map snapshot %s: %s", path, strerror(errno));
+        return -1;
+    }
+    
+    const snapshot_header_t *header = map;
+    int ret = 0;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->record_size != sizeof(o1_ds_image_t) ||
+        (size_t)st.st_size != sizeof(*header) + header->count * sizeof(o1_ds_image_t)) {
+        log_error("Snapshot %s is not a valid snapshot", path);
+        ret = -1;
+    } else if (o1_datastore_restore(wal->ds, (const o1_ds_image_t *)(header + 1),
+                                    (size_t)header->count) != 0) {
+        log_error("Failed to load snapshot %s: %s", path, strerror(errno));
+        ret = -1;
+    } else {
+        wal->stats.loaded = (size_t)header->count;
+        *segment = header->segment;
+    }
+    
+    munmap(map, (size_t)st.st_size);
+    return ret;
+}
+
+static int compare_segments(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Numbers of the segments at or above first, ascending
+static int list_segments(o1_wal_t *wal, uint64_t first, uint64_t **segments, size_t *count) {
+    DIR *dir = opendir(wal->dir);
+    if (!dir) {
+        log_error("Failed to read %s: %s", wal->dir, strerror(errno));
+        return -1;
+    }
+    
+    uint64_t *list = NULL;
+    size_t len = 0, capacity = 0;
+    struct dirent *entry;
+    int ret = 0;
+    
+    while ((entry = readdir(dir)) != NULL) {
+        uint64_t segment = parse_segment(entry->d_name);
+        if (segment == 0 || segment < first) {
+            continue;
+        }
+        if (len == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            uint64_t *grown = realloc(list, capacity * sizeof(*list));
+            if (!grown) {
+                ret = -1;
+                break;
+            }
+            list = grown;
+        }
+        list[len++] = segment;
+    }
+    closedir(dir);
+    
+    if (ret != 0) {
+        free(list);
+        return -1;
+    }
+    qsort(list, len, sizeof(*list), compare_segments);
+    *segments = list;
+    *count = len;
+    return 0;
+}
+
+// Replay one segment. A bad record ends the log: at the end of the last
+// segment it is a write torn by a crash and is cut off, anywhere else the
+// log is corrupt.
+static int replay_segment(o1_wal_t *wal, uint64_t segment, int last) {
+    char path[4096];
+    segment_path(wal, segment, path, sizeof(path));
+    
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        log_error("Failed to open log segment %s: %s", path, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size == 0) {
+        close(fd);
+        return 0;
+    }
+    
+    const char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    if (map == MAP_FAILED) {
+        log_error("Failed to map log segment %s: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    
+    size_t off = 0;
+    int ret = 0;
+    while (off + sizeof(record_header_t) <= size) {
+        record_header_t header;
+        o1_ds_image_t image;
+        memcpy(&header, map + off, sizeof(header));
+        if (header.len != sizeof(image) || size - off - sizeof(header) < sizeof(image)) {
+            break;
+        }
+        memcpy(&image, map + off + sizeof(header), sizeof(image));
+        if (checksum(&image, sizeof(image)) != header.crc) {
+            break;
+        }
+        if (o1_datastore_restore(wal->ds, &image, 1) != 0) {
+            log_error("Failed to replay %s: %s", path, strerror(errno));
+            ret = -1;
+            break;
+        }
+        wal->stats.replayed++;
+        off += sizeof(header) + sizeof(image);
+    }
+    munmap((void *)map, size);
+    
+    if (ret == 0 && off < size) {
+        if (!last) {
+            log_error("Log segment %s is corrupt at offset %zu", path, off);
+            ret = -1;
+        } else {
+            log_warn("Dropping %zu bytes of torn log tail in %s", size - off, path);
+            if (ftruncate(fd, (off_t)off) != 0 || fsync(fd) != 0) {
+                log_error("Failed to truncate %s: %s", path, strerror(errno));
+                ret = -1;
+            }
+        }
+    }
+    
+    close(fd);
+    return ret;
+}
+
+void o1_wal_default_config(o1_wal_config_t *config) {
+    config->dir = NULL;
+    config->snapshot_interval = O1_WAL_DEFAULT_SNAPSHOT_INTERVAL;
+    config->snapshot_records = O1_WAL_DEFAULT_SNAPSHOT_RECORDS;
+}
+
+static void free_wal(o1_wal_t *wal) {
+    if (wal->fd >= 0) {
+        close(wal->fd);
+    }
+    o1_buf_free(&wal->pending);
+    pthread_cond_destroy(&wal->wake);
+    pthread_cond_destroy(&wal->synced);
+    pthread_cond_destroy(&wal->flush);
+    pthread_mutex_destroy(&wal->snapshot_lock);
+    pthread_mutex_destroy(&wal->lock);
+    free(wal->dir);
+    free(wal);
+}
+
+// Load the snapshot and log in config->dir into ds, which must be empty,
+// then journal every change of ds there. Returns NULL if the directory
+// cannot be used or its contents cannot be loaded completely.
+o1_wal_t *o1_wal_open(const o1_wal_config_t *config, o1_datastore_t *ds) {
+    if (!config || !config->dir || !ds) {
+        errno = EINVAL;
+        return NULL;
+    }
+    pthread_once(&crc_once, crc_init);
+    
+    if (mkdir(config->dir, 0755) != 0 && errno != EEXIST) {
+        log_error("Failed to create %s: %s", config->dir, strerror(errno));
+        return NULL;
+    }
+    
+    o1_wal_t *wal = calloc(1, sizeof(*wal));
+    if (!wal) {
+        return NULL;
+    }
+    wal->config = *config;
+    wal->dir = strdup(config->dir);
+    wal->ds = ds;
+    wal->fd = -1;
+    o1_buf_init(&wal->pending);
+    pthread_mutex_init(&wal->lock, NULL);
+    pthread_mutex_init(&wal->snapshot_lock, NULL);
+    pthread_cond_init(&wal->flush, NULL);
+    pthread_cond_init(&wal->synced, NULL);
+    pthread_cond_init(&wal->wake, NULL);
+    if (!wal->dir) {
+        free_wal(wal);
+        return NULL;
+    }
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    // The snapshot first, then every segment written since it was taken
+    uint64_t first = 0;
+    uint64_t *segments = NULL;
+    size_t num_segments = 0;
+    if (load_snapshot(wal, &first) != 0 || list_segments(wal, first, &segments, &num_segments) != 0) {
+        free_wal(wal);
+        return NULL;
+    }
+    for (size_t i = 0; i < num_segments; i++) {
+        if (replay_segment(wal, segments[i], i + 1 == num_segments) != 0) {
+            free(segments);
+            free_wal(wal);
+            return NULL;
+        }
+    }
+    
+    // New records always go to a fresh segment
+    wal->segment = num_segments > 0 ? segments[num_segments - 1] + 1 : first > 0 ? first : 1;
+    free(segments);
+    wal->fd = open_segment(wal, wal->segment);
+    if (wal->fd < 0) {
+        log_error("Failed to create log segment in %s: %s", wal->dir, strerror(errno));
+        free_wal(wal);
+        return NULL;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    wal->stats.load_seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    wal->since_snapshot = wal->stats.replayed;
+    
+    wal->running = 1;
+    if (pthread_create(&wal->flusher, NULL, flusher_thread, wal) != 0) {
+        log_error("Failed to start write-ahead log flusher");
+        free_wal(wal);
+        return NULL;
+    }
+    if (config->snapshot_interval > 0) {
+        if (pthread_create(&wal->snapshotter, NULL, snapshot_thread, wal) == 0) {
+            wal->snapshotter_started = 1;
+        } else {
+            log_warn("Failed to start snapshot thread; snapshots only at close");
+        }
+    }
+    
+    o1_datastore_journal_t journal = { journal_append, journal_sync, wal };
+    o1_datastore_set_journal(ds, &journal);
+    
+    log_info("Loaded %zu interfaces from snapshot and %zu log records from %s in %.3f s",
+             wal->stats.loaded, wal->stats.replayed, wal->dir, wal->stats.load_seconds);
+    return wal;
+}
+
+// Detach from the datastore, take a last snapshot if anything changed since
+// the previous one, and stop. Call once no edits are in progress.
+void o1_wal_close(o1_wal_t *wal) {
+    if (!wal) {
+        return;
+    }
+    
+    o1_datastore_set_journal(wal->ds, NULL);
+    
+    if (wal->snapshotter_started) {
+        pthread_mutex_lock(&wal->lock);
+        wal->stopping = 1;
+        pthread_cond_signal(&wal->wake);
+        pthread_mutex_unlock(&wal->lock);
+        pthread_join(wal->snapshotter, NULL);
+    }
+    
+    // The next start then loads one file instead of replaying the log
+    pthread_mutex_lock(&wal->lock);
+    int changed = wal->since_snapshot > 0 && wal->error == 0;
+    pthread_mutex_unlock(&wal->lock);
+    if (changed) {
+        o1_wal_snapshot(wal);
+    }
+    
+    pthread_mutex_lock(&wal->lock);
+    wal->running = 0;
+    pthread_cond_signal(&wal->flush);
+    pthread_mutex_unlock(&wal->lock);
+    pthread_join(wal->flusher, NULL);
+    
+    free_wal(wal);
+}
+
+void o1_wal_stats(o1_wal_t *wal, o1_wal_stats_t *stats) {
+    pthread_mutex_lock(&wal->lock);
+    *stats = wal->stats;
+    pthread_mutex_unlock(&wal->lock);
+}
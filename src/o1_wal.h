@@ -0,0 +1,57 @@
+#ifndef O1_WAL_H
+#define O1_WAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "o1_datastore.h"
+
+// Persistence for the running datastore: an append-only write-ahead log of
+// interface images plus periodic binary snapshots, kept in one directory.
+//
+// Attached as the datastore's journal, the log takes the image of every
+// change under the datastore's write lock. A flusher thread writes what
+// has accumulated and fsyncs once for the whole batch (group commit);
+// o1_datastore_sync() waits for the batch holding the caller's edits. Each
+// record carries a CRC, so a tail torn by a crash is cut off on replay.
+//
+// A snapshot switches the log to a new segment, writes every interface to
+// a new snapshot file and deletes the segments it covers. Changes made
+// while it is written land in both, which is harmless: records are whole
+// images, so replaying one again gives the same interface. On open the
+// snapshot is mapped and loaded in one pass, then the newer segments are
+// replayed, before the datastore is used.
+//
+// Files: snapshot, snapshot.tmp while one is written, and wal-NNNNNNNN
+// segments. Both formats are in host byte order.
+
+typedef struct o1_wal o1_wal_t;
+
+typedef struct {
+    const char *dir;            // created if missing
+    int snapshot_interval;      // ms between snapshot checks, 0 for none until close
+    uint64_t snapshot_records;  // log records needed since the last snapshot to take one
+} o1_wal_config_t;
+
+#define O1_WAL_DEFAULT_SNAPSHOT_INTERVAL 60000
+#define O1_WAL_DEFAULT_SNAPSHOT_RECORDS 10000
+
+typedef struct {
+    size_t loaded;              // interfaces loaded from the snapshot at open
+    size_t replayed;            // log records replayed at open
+    double load_seconds;        // snapshot load and replay
+    uint64_t records;           // records appended since open
+    uint64_t syncs;             // fsyncs of the log, one per batch
+    uint64_t snapshots;
+} o1_wal_stats_t;
+
+// Function declarations
+void o1_wal_default_config(o1_wal_config_t *config);
+o1_wal_t *o1_wal_open(const o1_wal_config_t *config, o1_datastore_t *ds);
+void o1_wal_close(o1_wal_t *wal);
+
+int o1_wal_sync(o1_wal_t *wal);
+int o1_wal_snapshot(o1_wal_t *wal);
+void o1_wal_stats(o1_wal_t *wal, o1_wal_stats_t *stats);
+
+#endif // O1_WAL_H
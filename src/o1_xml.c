@@ -0,0 +1,835 @@
+#define _GNU_SOURCE
+#include <string.h>
+
+#include "o1_xml.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Character classes, indexed by byte value
+#define CC_SPACE 0x1    // XML whitespace
+#define CC_NAME_END 0x2 // terminates an element or attribute name
+
+static const unsigned char char_class[256] = {
+    [' '] = CC_SPACE | CC_NAME_END,
+    ['\t'] = CC_SPACE | CC_NAME_END,
+    ['\n'] = CC_SPACE | CC_NAME_END,
+    ['\r'] = CC_SPACE | CC_NAME_END,
+    ['>'] = CC_NAME_END,
+    ['/'] = CC_NAME_END,
+    ['='] = CC_NAME_END,
+};
+
+static inline int is_space(char c) {
+    return char_class[(unsigned char)c] & CC_SPACE;
+}
+
+static inline const char *skip_space(const char *p, const char *end) {
+    while (p < end && is_space(*p)) {
+        p++;
+    }
+    return p;
+}
+
+static inline const char *scan_name(const char *p, const char *end) {
+    while (p < end && !(char_class[(unsigned char)*p] & CC_NAME_END)) {
+        p++;
+    }
+    return p;
+}
+
+#ifdef __SSE2__
+
+// Bytes of a 16-byte block equal to c, one bit each
+static inline unsigned match_byte(__m128i block, char c) {
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(c)));
+}
+
+static inline unsigned match_space(__m128i block) {
+    return match_byte(block, ' ') | match_byte(block, '\n') | match_byte(block, '\t') |
+           match_byte(block, '\r');
+}
+
+#endif // __SSE2__
+
+// Character data from p: returns the next '<', or end, and sets *text if
+// anything but whitespace comes before it. Most runs are the indentation
+// between tags, so they are classified 16 bytes at a time.
+static inline const char *scan_text(const char *p, const char *end, int *text) {
+    int found = 0;
+    
+#ifdef __SSE2__
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)p);
+        unsigned tags = match_byte(block, '<');
+        unsigned other = ~(tags | match_space(block)) & 0xffff;
+        if (tags) {
+            unsigned before = (1u << __builtin_ctz(tags)) - 1;
+            *text = (other & before) != 0;
+            return p + __builtin_ctz(tags);
+        }
+        p += 16;
+        if (other) {
+            // Past the whitespace: the rest of the run only needs its end
+            const char *lt = memchr(p, '<', end - p);
+            *text = 1;
+            return lt ? lt : end;
+        }
+    }
+#endif
+    
+    for (; p < end && *p != '<'; p++) {
+        found |= !is_space(*p);
+    }
+    *text = found;
+    return p;
+}
+
+// Element name from p: returns its end and points *colon at the last ':'
+// in it, or NULL, in the same pass
+static inline const char *scan_qname(const char *p, const char *end, const char **colon) {
+    *colon = NULL;
+    
+#ifdef __SSE2__
+    while (end - p >= 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)p);
+        unsigned stop = match_space(block) | match_byte(block, '>') | match_byte(block, '/') |
+                        match_byte(block, '=');
+        unsigned colons = match_byte(block, ':');
+        if (stop) {
+            colons &= (1u << __builtin_ctz(stop)) - 1;
+        }
+        if (colons) {
+            *colon = p + 31 - __builtin_clz(colons);
+        }
+        if (stop) {
+            return p + __builtin_ctz(stop);
+        }
+        p += 16;
+    }
+#endif
+    
+    for (; p < end && !(char_class[(unsigned char)*p] & CC_NAME_END); p++) {
+        if (*p == ':') {
+            *colon = p;
+        }
+    }
+    return p;
+}
+
+// The "?>", "-->" or "]]>" closing a construct that starts before p, or
+// NULL. Every such marker ends in '>', and a memchr for it costs far less
+// than memmem's setup on the short runs these usually are.
+static const char *find_marker(const char *p, const char *end, const char *marker, size_t len) {
+    for (const char *q = p + len - 1; q < end; q++) {
+        q = memchr(q, '>', end - q);
+        if (!q) {
+            break;
+        }
+        if (memcmp(q - (len - 1), marker, len - 1) == 0) {
+            return q - (len - 1);
+        }
+    }
+    return NULL;
+}
+
+// Innermost namespace bound to prefix (empty prefix = default namespace)
+static o1_str_t lookup_ns(const o1_xml_reader_t *reader, const char *prefix, size_t prefix_len) {
+    for (int i = reader->ns_count - 1; i >= 0; i--) {
+        if (reader->ns[i].prefix.len == prefix_len &&
+            (prefix_len == 0 || memcmp(reader->ns[i].prefix.ptr, prefix, prefix_len) == 0)) {
+            return reader->ns[i].uri;
+        }
+    }
+    
+    o1_str_t none = { "", 0 };
+    return none;
+}
+
+void o1_xml_reader_init(o1_xml_reader_t *reader, const char *data, size_t len) {
+    reader->cur = data;
+    reader->end = data + len;
+    reader->depth = 0;
+    reader->ns_count = 0;
+}
+
+int o1_str_copy(char *dst, size_t dst_size, o1_str_t str) {
+    if (!dst || dst_size == 0 || str.len >= dst_size) {
+        return -1;
+    }
+    
+    memcpy(dst, str.ptr, str.len);
+    dst[str.len] = '\0';
+    return 0;
+}
+
+// Code point of a character reference's digits, or -1 if it names none
+// that XML allows
+static long char_ref(const char *p, const char *end) {
+    int base = 10;
+    long code = 0;
+    
+    if (p < end && *p == 'x') {
+        base = 16;
+        p++;
+    }
+    if (p == end) {
+        return -1;
+    }
+    for (; p < end; p++) {
+        int digit = *p >= '0' && *p <= '9' ? *p - '0' :
+                    base == 16 && *p >= 'a' && *p <= 'f' ? *p - 'a' + 10 :
+                    base == 16 && *p >= 'A' && *p <= 'F' ? *p - 'A' + 10 : -1;
+        if (digit < 0) {
+            return -1;
+        }
+        code = code * base + digit;
+        if (code > 0x10ffff) {
+            return -1;
+        }
+    }
+    
+    // XML 1.0 Char: no other controls, no surrogates, no FFFE/FFFF
+    if ((code < 0x20 && code != '\t' && code != '\n' && code != '\r') ||
+        (code >= 0xd800 && code <= 0xdfff) || code == 0xfffe || code == 0xffff) {
+        return -1;
+    }
+    return code;
+}
+
+// Character data and attribute values are views of the raw document, with
+// entity and character references as written. A reference is never
+// shorter than what it stands for, so the decoded text fits in str->len
+// bytes at dst. Text without a '&' is left where it is.
+int o1_str_decode(o1_str_t *str, char *dst) {
+    const char *p = str->ptr;
+    const char *end = p + str->len;
+    const char *amp = memchr(p, '&', str->len);
+    char *out = dst;
+    
+    if (!amp) {
+        return 0;
+    }
+    
+    while (amp) {
+        memcpy(out, p, amp - p);
+        out += amp - p;
+        
+        const char *semi = memchr(amp, ';', end - amp);
+        if (!semi) {
+            return -1;
+        }
+        o1_str_t ref = { amp + 1, semi - (amp + 1) };
+        if (o1_str_eq(ref, "lt")) {
+            *out++ = '<';
+        } else if (o1_str_eq(ref, "gt")) {
+            *out++ = '>';
+        } else if (o1_str_eq(ref, "amp")) {
+            *out++ = '&';
+        } else if (o1_str_eq(ref, "apos")) {
+            *out++ = '\'';
+        } else if (o1_str_eq(ref, "quot")) {
+            *out++ = '"';
+        } else if (ref.len > 1 && ref.ptr[0] == '#') {
+            // UTF-8
+            long code = char_ref(ref.ptr + 1, semi);
+            if (code < 0) {
+                return -1;
+            } else if (code < 0x80) {
+                *out++ = (char)code;
+            } else if (code < 0x800) {
+                *out++ = (char)(0xc0 | (code >> 6));
+                *out++ = (char)(0x80 | (code & 0x3f));
+            } else if (code < 0x10000) {
+                *out++ = (char)(0xe0 | (code >> 12));
+                *out++ = (char)(0x80 | ((code >> 6) & 0x3f));
+                *out++ = (char)(0x80 | (code & 0x3f));
+            } else {
+                *out++ = (char)(0xf0 | (code >> 18));
+                *out++ = (char)(0x80 | ((code >> 12) & 0x3f));
+                *out++ = (char)(0x80 | ((code >> 6) & 0x3f));
+                *out++ = (char)(0x80 | (code & 0x3f));
+            }
+        } else {
+            return -1;
+        }
+        
+        p = semi + 1;
+        amp = memchr(p, '&', end - p);
+    }
+    
+    memcpy(out, p, end - p);
+    out += end - p;
+    str->ptr = dst;
+    str->len = out - dst;
+    return 0;
+}
+
+// Parse the attributes of a start tag, recording namespace declarations.
+// Returns the position just past '>' or '/>', or NULL on malformed input.
+static const char *parse_attributes(o1_xml_reader_t *reader, const char *p, int depth,
+                                    o1_xml_token_t *token) {
+    const char *end = reader->end;
+    token->attrs.ptr = p;
+    
+    while (1) {
+        p = skip_space(p, end);
+        if (p >= end) {
+            return NULL;
+        }
+        
+        if (*p == '>') {
+            token->type = O1_XML_START;
+            token->attrs.len = p - token->attrs.ptr;
+            return p + 1;
+        }
+        
+        if (*p == '/') {
+            if (p + 1 >= end || p[1] != '>') {
+                return NULL;
+            }
+            token->type = O1_XML_EMPTY;
+            token->attrs.len = p - token->attrs.ptr;
+            return p + 2;
+        }
+        
+        // name="value" or name='value'
+        const char *attr_name = p;
+        p = scan_name(p, end);
+        size_t attr_len = p - attr_name;
+        p = skip_space(p, end);
+        if (attr_len == 0 || p >= end || *p != '=') {
+            return NULL;
+        }
+        p = skip_space(p + 1, end);
+        if (p >= end || (*p != '"' && *p != '\'')) {
+            return NULL;
+        }
+        const char *value = p + 1;
+        const char *value_end = memchr(value, *p, end - value);
+        if (!value_end) {
+            return NULL;
+        }
+        p = value_end + 1;
+        
+        if (attr_len >= 5 && memcmp(attr_name, "xmlns", 5) == 0 &&
+            (attr_len == 5 || attr_name[5] == ':')) {
+            if (reader->ns_count == O1_XML_MAX_NS) {
+                return NULL;
+            }
+            int n = reader->ns_count++;
+            reader->ns[n].prefix.ptr = attr_name + 6;
+            reader->ns[n].prefix.len = attr_len == 5 ? 0 : attr_len - 6;
+            reader->ns[n].uri.ptr = value;
+            reader->ns[n].uri.len = value_end - value;
+            reader->ns[n].depth = depth;
+        }
+    }
+}
+
+// The tokenizer proper. The parsers below inline it into their loops, so
+// the token fields they never read are not written.
+static inline __attribute__((always_inline))
+o1_xml_token_type_t read_token(o1_xml_reader_t *reader, o1_xml_token_t *token) {
+    const char *end = reader->end;
+    
+    while (1) {
+        const char *p = reader->cur;
+        
+        if (p >= end) {
+            token->type = O1_XML_EOF;
+            return token->type;
+        }
+        
+        // Character data runs up to the next tag; whitespace-only runs, the
+        // indentation between tags, are skipped
+        if (*p != '<') {
+            int text;
+            const char *lt = scan_text(p, end, &text);
+            reader->cur = lt;
+            if (!text) {
+                continue;
+            }
+            
+            token->type = O1_XML_TEXT;
+            token->text.ptr = p;
+            token->text.len = lt - p;
+            token->depth = reader->depth;
+            return token->type;
+        }
+        
+        if (p + 1 >= end) {
+            break;
+        }
+        
+        // Prolog, processing instructions, comments, CDATA, DOCTYPE
+        if (p[1] == '?') {
+            const char *q = find_marker(p + 2, end, "?>", 2);
+            if (!q) {
+                break;
+            }
+            reader->cur = q + 2;
+            continue;
+        }
+        
+        if (p[1] == '!') {
+            if (end - p >= 4 && memcmp(p, "<!--", 4) == 0) {
+                const char *q = find_marker(p + 4, end, "-->", 3);
+                if (!q) {
+                    break;
+                }
+                reader->cur = q + 3;
+                continue;
+            }
+            if (end - p >= 9 && memcmp(p, "<![CDATA[", 9) == 0) {
+                const char *q = find_marker(p + 9, end, "]]>", 3);
+                if (!q) {
+                    break;
+                }
+                reader->cur = q + 3;
+                token->type = O1_XML_TEXT;
+                token->text.ptr = p + 9;
+                token->text.len = q - (p + 9);
+                token->depth = reader->depth;
+                return token->type;
+            }
+            const char *q = memchr(p, '>', end - p);
+            if (!q) {
+                break;
+            }
+            reader->cur = q + 1;
+            continue;
+        }
+        
+        int closing = p[1] == '/';
+        const char *name = p + (closing ? 2 : 1);
+        const char *colon;
+        const char *name_end = scan_qname(name, end, &colon);
+        // A tag cut off after its name, as in "<a" or "</a", is malformed
+        if (name_end == name || name_end == end) {
+            break;
+        }
+        
+        // Split prefix:local
+        const char *local = colon ? colon + 1 : name;
+        token->name.ptr = local;
+        token->name.len = name_end - local;
+        
+        if (closing) {
+            const char *gt = skip_space(name_end, end);
+            if (gt == end || *gt != '>' || reader->depth == 0) {
+                break;
+            }
+            
+            reader->depth--;
+            token->type = O1_XML_END;
+            token->ns = reader->elem_ns[reader->depth];
+            token->depth = reader->depth;
+            token->attrs.ptr = gt;
+            token->attrs.len = 0;
+            
+            // Drop namespace declarations made on the element just closed
+            while (reader->ns_count > 0 && reader->ns[reader->ns_count - 1].depth >= reader->depth) {
+                reader->ns_count--;
+            }
+            reader->cur = gt + 1;
+            return token->type;
+        }
+        
+        // Most tags carry no attributes
+        int depth = reader->depth;
+        int ns_mark = reader->ns_count;
+        const char *next;
+        if (*name_end == '>') {
+            token->type = O1_XML_START;
+            token->attrs.ptr = name_end;
+            token->attrs.len = 0;
+            next = name_end + 1;
+        } else if (*name_end == '/' && name_end + 1 < end && name_end[1] == '>') {
+            token->type = O1_XML_EMPTY;
+            token->attrs.ptr = name_end;
+            token->attrs.len = 0;
+            next = name_end + 2;
+        } else if (!(next = parse_attributes(reader, name_end, depth, token))) {
+            break;
+        }
+        
+        token->ns = lookup_ns(reader, name, colon ? (size_t)(colon - name) : 0);
+        token->depth = depth;
+        reader->cur = next;
+        
+        if (token->type == O1_XML_START) {
+            if (depth == O1_XML_MAX_DEPTH) {
+                break;
+            }
+            reader->elem_ns[depth] = token->ns;
+            reader->depth++;
+        } else {
+            reader->ns_count = ns_mark;
+        }
+        return token->type;
+    }
+    
+    reader->cur = end;
+    token->type = O1_XML_ERROR;
+    return token->type;
+}
+
+o1_xml_token_type_t o1_xml_next(o1_xml_reader_t *reader, o1_xml_token_t *token) {
+    return read_token(reader, token);
+}
+
+int o1_xml_attr(const o1_xml_token_t *token, const char *name, o1_str_t *value) {
+    const char *p = token->attrs.ptr;
+    const char *end = p + token->attrs.len;
+    size_t name_len = strlen(name);
+    
+    while (1) {
+        p = skip_space(p, end);
+        if (p >= end) {
+            return -1;
+        }
+        
+        const char *attr_name = p;
+        p = scan_name(p, end);
+        size_t attr_len = p - attr_name;
+        p = skip_space(p, end);
+        if (p >= end || *p != '=') {
+            return -1;
+        }
+        p = skip_space(p + 1, end);
+        if (p >= end) {
+            return -1;
+        }
+        const char *value_start = p + 1;
+        const char *value_end = memchr(value_start, *p, end - value_start);
+        if (!value_end) {
+            return -1;
+        }
+        p = value_end + 1;
+        
+        if (attr_len == name_len && memcmp(attr_name, name, name_len) == 0) {
+            value->ptr = value_start;
+            value->len = value_end - value_start;
+            return 0;
+        }
+    }
+}
+
+// Whether ns is the o1-interface namespace. Elements below one declaration
+// all resolve to the same view of it, so after the first match the URI is
+// only compared again for a different declaration.
+static inline int is_interface_ns(o1_str_t ns, o1_str_t *matched) {
+    if (ns.ptr == matched->ptr && ns.len == matched->len) {
+        return 1;
+    }
+    if (!o1_str_eq(ns, O1_NS_INTERFACE)) {
+        return 0;
+    }
+    *matched = ns;
+    return 1;
+}
+
+// Leaves of an interface entry, as bits
+#define LEAF_NAME 0x1u
+#define LEAF_STATUS 0x2u
+#define LEAF_TRACEID 0x4u
+#define LEAF_SPANID 0x8u
+#define LEAF_ALL 0xfu
+
+// Walk the o1-interface entries below the NETCONF <config> or <filter>
+// element in a single pass, handing each one to callback as soon as it
+// closes. Both the flat form (leaves directly under o1-interface) and list
+// entries (o1-interface/interface) are accepted; matching is
+// namespace-aware, so elements such as <name> from other modules are
+// ignored. A non-zero callback return stops the walk. Callers that only
+// take the first entry pass the leaves they need as `want`: the entry is
+// delivered as soon as they have all closed and the rest of the document
+// is not read. Returns the number of entries delivered, or -1 on
+// malformed XML.
+static int parse_o1_interfaces(const char *xml, size_t len, const char *section, unsigned want,
+                               o1_interface_cb_t callback, void *arg) {
+    o1_xml_reader_t reader;
+    o1_xml_token_t token;
+    o1_interface_view_t view;
+    o1_str_t interface_ns = { NULL, 0 };
+    int section_depth = -1;
+    int o1_depth = -1;
+    int entry_depth = -1;
+    int tracing_depth = -1;
+    o1_str_t *leaf = NULL;
+    unsigned leaf_bit = 0;
+    int leaf_depth = -1;
+    int entries = 0;
+    unsigned have_leaves = 0;
+    
+    memset(&view, 0, sizeof(view));
+    o1_xml_reader_init(&reader, xml, len);
+    
+    while (read_token(&reader, &token) != O1_XML_EOF) {
+        switch (token.type) {
+        case O1_XML_ERROR:
+            return -1;
+        
+        case O1_XML_START:
+        case O1_XML_EMPTY:
+            if (section_depth < 0) {
+                if (token.type == O1_XML_START && o1_xml_is(&token, O1_NS_NETCONF, section)) {
+                    section_depth = token.depth;
+                }
+            } else if (o1_depth < 0) {
+                if (token.type == O1_XML_START && o1_xml_is(&token, O1_NS_INTERFACE, "o1-interface")) {
+                    o1_depth = token.depth;
+                    entry_depth = token.depth;
+                }
+            } else if (!is_interface_ns(token.ns, &interface_ns)) {
+                break;
+            } else if (token.depth == o1_depth + 1 && entry_depth == o1_depth &&
+                       token.type == O1_XML_START && o1_str_eq(token.name, "interface")) {
+                entry_depth = token.depth;
+            } else if (token.depth == entry_depth + 1) {
+                if (o1_str_eq(token.name, "name")) {
+                    leaf = &view.interface_name;
+                    leaf_bit = LEAF_NAME;
+                } else if (o1_str_eq(token.name, "status")) {
+                    leaf = &view.status;
+                    leaf_bit = LEAF_STATUS;
+                } else if (o1_str_eq(token.name, "tracing") && token.type == O1_XML_START) {
+                    tracing_depth = token.depth;
+                }
+            } else if (tracing_depth >= 0 && token.depth == tracing_depth + 1) {
+                if (o1_str_eq(token.name, "traceid")) {
+                    leaf = &view.traceid;
+                    leaf_bit = LEAF_TRACEID;
+                } else if (o1_str_eq(token.name, "spanid")) {
+                    leaf = &view.spanid;
+                    leaf_bit = LEAF_SPANID;
+                }
+            }
+            
+            if (leaf) {
+                // Present but empty until character data arrives
+                leaf->ptr = token.name.ptr;
+                leaf->len = 0;
+                leaf_depth = token.depth;
+                if (token.type == O1_XML_EMPTY) {
+                    leaf = NULL;
+                    have_leaves |= leaf_bit;
+                }
+            }
+            break;
+        
+        case O1_XML_TEXT:
+            if (leaf && token.depth == leaf_depth + 1) {
+                *leaf = token.text;
+            }
+            break;
+        
+        case O1_XML_END:
+            if (leaf && token.depth == leaf_depth) {
+                leaf = NULL;
+                have_leaves |= leaf_bit;
+            } else if (token.depth == tracing_depth) {
+                tracing_depth = -1;
+            } else if (token.depth == entry_depth && have_leaves) {
+                // Entry complete: a list entry, or the flat form closing with o1-interface
+                entries++;
+                if (callback(&view, arg) != 0) {
+                    return entries;
+                }
+                memset(&view, 0, sizeof(view));
+                have_leaves = 0;
+                entry_depth = o1_depth;
+                if (token.depth == o1_depth) {
+                    o1_depth = -1;
+                }
+            } else if (token.depth == entry_depth) {
+                entry_depth = o1_depth;
+                if (token.depth == o1_depth) {
+                    o1_depth = -1;
+                }
+            } else if (token.depth == section_depth) {
+                return entries;
+            }
+            break;
+        
+        default:
+            break;
+        }
+        
+        if (want && !leaf && (have_leaves & want) == want) {
+            callback(&view, arg);
+            return entries + 1;
+        }
+    }
+    
+    return entries;
+}
+
+// Keep the first entry and stop
+static int take_first_entry(const o1_interface_view_t *entry, void *arg) {
+    *(o1_interface_view_t *)arg = *entry;
+    return 1;
+}
+
+int o1_parse_get_config(const char *xml, size_t len, o1_interface_view_t *view) {
+    if (!xml || !view) {
+        return -1;
+    }
+    
+    memset(view, 0, sizeof(*view));
+    if (parse_o1_interfaces(xml, len, "filter", LEAF_NAME, take_first_entry, view) != 1 ||
+        !view->interface_name.ptr) {
+        return -1;
+    }
+    
+    return 0;
+}
+
+int o1_parse_edit_config(const char *xml, size_t len, o1_interface_view_t *view) {
+    if (!xml || !view) {
+        return -1;
+    }
+    
+    memset(view, 0, sizeof(*view));
+    if (parse_o1_interfaces(xml, len, "config", LEAF_ALL, take_first_entry, view) != 1) {
+        return -1;
+    }
+    
+    if (!view->interface_name.ptr || !view->status.ptr ||
+        !view->traceid.ptr || !view->spanid.ptr) {
+        return -1;
+    }
+    
+    return 0;
+}
+
+int o1_parse_edit_config_entries(const char *xml, size_t len,
+                                 o1_interface_cb_t callback, void *arg) {
+    if (!xml || !callback) {
+        return -1;
+    }
+    
+    return parse_o1_interfaces(xml, len, "config", 0, callback, arg);
+}
+
+// Input leaves of an o1-interface RPC (get-interface-status,
+// set-interface-status): interface-name and status directly below the
+// operation element, traceid and spanid below its tracing container.
+// Leaves absent from the input are left with ptr NULL. Returns 0, or -1 on
+// malformed XML.
+int o1_parse_rpc_input(const char *xml, size_t len, o1_interface_view_t *view) {
+    o1_xml_reader_t reader;
+    o1_xml_token_t token;
+    o1_str_t interface_ns = { NULL, 0 };
+    o1_str_t *leaf = NULL;
+    int leaf_depth = -1;
+    int tracing_depth = -1;
+    
+    if (!xml || !view) {
+        return -1;
+    }
+    
+    memset(view, 0, sizeof(*view));
+    o1_xml_reader_init(&reader, xml, len);
+    
+    while (read_token(&reader, &token) != O1_XML_EOF) {
+        switch (token.type) {
+        case O1_XML_ERROR:
+            return -1;
+        
+        case O1_XML_START:
+        case O1_XML_EMPTY:
+            if (!is_interface_ns(token.ns, &interface_ns)) {
+                break;
+            }
+            if (token.depth == 2) {
+                if (o1_str_eq(token.name, "interface-name")) {
+                    leaf = &view->interface_name;
+                } else if (o1_str_eq(token.name, "status")) {
+                    leaf = &view->status;
+                } else if (o1_str_eq(token.name, "tracing") && token.type == O1_XML_START) {
+                    tracing_depth = token.depth;
+                }
+            } else if (tracing_depth >= 0 && token.depth == tracing_depth + 1) {
+                if (o1_str_eq(token.name, "traceid")) {
+                    leaf = &view->traceid;
+                } else if (o1_str_eq(token.name, "spanid")) {
+                    leaf = &view->spanid;
+                }
+            }
+            
+            if (leaf) {
+                // Present but empty until character data arrives
+                leaf->ptr = token.name.ptr;
+                leaf->len = 0;
+                leaf_depth = token.depth;
+                if (token.type == O1_XML_EMPTY) {
+                    leaf = NULL;
+                }
+            }
+            break;
+        
+        case O1_XML_TEXT:
+            if (leaf && token.depth == leaf_depth + 1) {
+                *leaf = token.text;
+            }
+            break;
+        
+        case O1_XML_END:
+            if (leaf && token.depth == leaf_depth) {
+                leaf = NULL;
+            } else if (token.depth == tracing_depth) {
+                tracing_depth = -1;
+            } else if (token.depth == 1) {
+                return 0;
+            }
+            break;
+        
+        default:
+            break;
+        }
+    }
+    
+    return 0;
+}
+
+// Datastore named inside the <target> or <source> element (parent) of an
+// RPC: the local name of its first child, such as running or candidate.
+// Returns 0, or -1 on malformed XML or when parent is absent or empty.
+int o1_parse_datastore(const char *xml, size_t len, const char *parent, o1_str_t *name) {
+    o1_xml_reader_t reader;
+    o1_xml_token_t token;
+    int parent_depth = -1;
+    
+    if (!xml || !parent || !name) {
+        return -1;
+    }
+    
+    o1_xml_reader_init(&reader, xml, len);
+    while (read_token(&reader, &token) != O1_XML_EOF) {
+        if (token.type == O1_XML_ERROR) {
+            return -1;
+        }
+        if (token.type == O1_XML_END && token.depth <= parent_depth) {
+            return -1;
+        }
+        if (token.type != O1_XML_START && token.type != O1_XML_EMPTY) {
+            continue;
+        }
+        
+        if (parent_depth < 0) {
+            // <rpc><operation><parent>
+            if (token.depth == 2 && token.type == O1_XML_START &&
+                o1_xml_is(&token, O1_NS_NETCONF, parent)) {
+                parent_depth = token.depth;
+            }
+        } else if (token.depth == parent_depth + 1 && o1_str_eq(token.ns, O1_NS_NETCONF)) {
+            *name = token.name;
+            return 0;
+        }
+    }
+    
+    return -1;
+}
@@ -0,0 +1,88 @@
+#ifndef O1_XML_H
+#define O1_XML_H
+
+#include <stddef.h>
+#include <string.h>
+
+// XML namespaces understood by the O1 parsers
+#define O1_NS_NETCONF "urn:ietf:params:xml:ns:netconf:base:1.0"
+#define O1_NS_INTERFACE "urn:example:o1-interface"
+#define O1_NS_TRACING "urn:example:tracing"
+
+#define O1_XML_MAX_DEPTH 64
+#define O1_XML_MAX_NS 32
+
+// String view into the document being parsed; never NUL-terminated
+typedef struct {
+    const char *ptr;
+    size_t len;
+} o1_str_t;
+
+typedef enum {
+    O1_XML_START,   // <name attr="...">
+    O1_XML_END,     // </name>
+    O1_XML_EMPTY,   // <name/>
+    O1_XML_TEXT,    // character data (whitespace-only runs are skipped)
+    O1_XML_EOF,
+    O1_XML_ERROR
+} o1_xml_token_type_t;
+
+typedef struct {
+    o1_xml_token_type_t type;
+    o1_str_t name;      // local name, prefix stripped
+    o1_str_t ns;        // resolved namespace URI, empty if none is in scope
+    o1_str_t attrs;     // raw attribute text of a start/empty tag
+    o1_str_t text;      // raw character data of a text token
+    int depth;          // nesting depth of the element (0 for the root)
+} o1_xml_token_t;
+
+// Streaming pull tokenizer; all views point into the caller's buffer
+typedef struct {
+    const char *cur;
+    const char *end;
+    int depth;
+    int ns_count;
+    struct {
+        o1_str_t prefix;
+        o1_str_t uri;
+        int depth;
+    } ns[O1_XML_MAX_NS];
+    o1_str_t elem_ns[O1_XML_MAX_DEPTH];
+} o1_xml_reader_t;
+
+// Leaves of one o1-interface entry, as views into the RPC text
+typedef struct {
+    o1_str_t interface_name;
+    o1_str_t status;
+    o1_str_t traceid;
+    o1_str_t spanid;
+} o1_interface_view_t;
+
+// Receives each o1-interface entry of a document; non-zero stops the walk
+typedef int (*o1_interface_cb_t)(const o1_interface_view_t *entry, void *arg);
+
+// Function declarations
+void o1_xml_reader_init(o1_xml_reader_t *reader, const char *data, size_t len);
+o1_xml_token_type_t o1_xml_next(o1_xml_reader_t *reader, o1_xml_token_t *token);
+int o1_xml_attr(const o1_xml_token_t *token, const char *name, o1_str_t *value);
+int o1_str_copy(char *dst, size_t dst_size, o1_str_t str);
+int o1_str_decode(o1_str_t *str, char *dst);
+
+int o1_parse_get_config(const char *xml, size_t len, o1_interface_view_t *view);
+int o1_parse_edit_config(const char *xml, size_t len, o1_interface_view_t *view);
+int o1_parse_edit_config_entries(const char *xml, size_t len,
+                                 o1_interface_cb_t callback, void *arg);
+int o1_parse_rpc_input(const char *xml, size_t len, o1_interface_view_t *view);
+int o1_parse_datastore(const char *xml, size_t len, const char *parent, o1_str_t *name);
+
+// Inline so that strlen() of a literal argument folds to a constant
+static inline int o1_str_eq(o1_str_t str, const char *literal) {
+    size_t len = strlen(literal);
+    return str.len == len && memcmp(str.ptr, literal, len) == 0;
+}
+
+static inline int o1_xml_is(const o1_xml_token_t *token, const char *ns, const char *name) {
+    return o1_str_eq(token->name, name) && o1_str_eq(token->ns, ns);
+}
+
+#endif // O1_XML_H
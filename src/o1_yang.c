@@ -0,0 +1,337 @@
+// Generated by scripts/gen_yang_validators.py from config/o1-interface.yang config/tracing.yang; do not edit.
+#include <string.h>
+
+#include "o1_yang.h"
+
+// Decimal digits only, no sign or whitespace, rejecting overflow
+static int yang_parse_uint(const char *s, size_t len, uint64_t *value) {
+    if (len == 0 || len > 20) {
+        return -1;
+    }
+    
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned d = (unsigned char)s[i] - '0';
+        if (d > 9 || v > (UINT64_MAX - d) / 10) {
+            return -1;
+        }
+        v = v * 10 + d;
+    }
+    
+    *value = v;
+    return 0;
+}
+
+int o1_interface_interface_name_valid(const char *s, size_t len) {
+    (void)len;
+    (void)s;
+    return 1;
+}
+
+int o1_interface_interface_status_from_str(const char *s, size_t len) {
+    // Lengths tell most names apart; one memcmp confirms
+    switch (len) {
+    case 2:
+        if (memcmp(s, "up", 2) == 0) {
+            return O1_INTERFACE_INTERFACE_STATUS_UP;
+        }
+        break;
+    case 4:
+        if (memcmp(s, "down", 4) == 0) {
+            return O1_INTERFACE_INTERFACE_STATUS_DOWN;
+        }
+        break;
+    case 5:
+        if (memcmp(s, "error", 5) == 0) {
+            return O1_INTERFACE_INTERFACE_STATUS_ERROR;
+        }
+        break;
+    }
+    return -1;
+}
+
+const char *o1_interface_interface_status_to_str(int value) {
+    switch (value) {
+    case O1_INTERFACE_INTERFACE_STATUS_UP:
+        return "up";
+    case O1_INTERFACE_INTERFACE_STATUS_DOWN:
+        return "down";
+    case O1_INTERFACE_INTERFACE_STATUS_ERROR:
+        return "error";
+    default:
+        return NULL;
+    }
+}
+
+int o1_interface_interface_description_valid(const char *s, size_t len) {
+    (void)len;
+    (void)s;
+    return 1;
+}
+
+int o1_interface_interface_tracing_traceid_valid(const char *s, size_t len) {
+    if (len != 32) {
+        return 0;
+    }
+    
+    // Accumulate instead of branching per character
+    unsigned char ok = 1;
+    for (size_t i = 0; i < 32; i++) {
+        unsigned char c = (unsigned char)s[i];
+        ok &= ((unsigned char)(c - '0') <= 9) | ((unsigned char)(c - 'A') <= 5) | ((unsigned char)(c - 'a') <= 5);
+    }
+    return ok;
+}
+
+int o1_interface_interface_tracing_spanid_valid(const char *s, size_t len) {
+    if (len != 16) {
+        return 0;
+    }
+    
+    // Accumulate instead of branching per character
+    unsigned char ok = 1;
+    for (size_t i = 0; i < 16; i++) {
+        unsigned char c = (unsigned char)s[i];
+        ok &= ((unsigned char)(c - '0') <= 9) | ((unsigned char)(c - 'A') <= 5) | ((unsigned char)(c - 'a') <= 5);
+    }
+    return ok;
+}
+
+int o1_interface_interface_tracing_timestamp_parse(const char *s, size_t len, uint64_t *value) {
+    uint64_t v;
+    if (yang_parse_uint(s, len, &v) != 0) {
+        return -1;
+    }
+    
+    *value = v;
+    return 0;
+}
+
+int o1_interface_interface_statistics_packets_in_parse(const char *s, size_t len, uint64_t *value) {
+    uint64_t v;
+    if (yang_parse_uint(s, len, &v) != 0) {
+        return -1;
+    }
+    
+    *value = v;
+    return 0;
+}
+
+int o1_interface_interface_statistics_packets_out_parse(const char *s, size_t len, uint64_t *value) {
+    uint64_t v;
+    if (yang_parse_uint(s, len, &v) != 0) {
+        return -1;
+    }
+    
+    *value = v;
+    return 0;
+}
+
+int o1_interface_interface_statistics_bytes_in_parse(const char *s, size_t len, uint64_t *value) {
+    uint64_t v;
+    if (yang_parse_uint(s, len, &v) != 0) {
+        return -1;
+    }
+    
+    *value = v;
+    return 0;
+}
+
+int o1_interface_interface_statistics_bytes_out_parse(const char *s, size_t len, uint64_t *value) {
+    uint64_t v;
+    if (yang_parse_uint(s, len, &v) != 0) {
+        return -1;
+    }
+    
+    *value = v;
+    return 0;
+}
+
+int o1_interface_get_interface_status_input_interface_name_valid(const char *s, size_t len) {
+    (void)len;
+    (void)s;
+    return 1;
+}
+
+int o1_interface_get_interface_status_output_status_from_str(const char *s, size_t len) {
+    // Lengths tell most names apart; one memcmp confirms
+    switch (len) {
+    case 2:
+        if (memcmp(s, "up", 2) == 0) {
+            return O1_INTERFACE_GET_INTERFACE_STATUS_OUTPUT_STATUS_UP;
+        }
+        break;
+    case 4:
+        if (memcmp(s, "down", 4) == 0) {
+            return O1_INTERFACE_GET_INTERFACE_STATUS_OUTPUT_STATUS_DOWN;
+        }
+        break;
+    case 5:
+        if (memcmp(s, "error", 5) == 0) {
+            return O1_INTERFACE_GET_INTERFACE_STATUS_OUTPUT_STATUS_ERROR;
+        }
+        break;
+    }
+    return -1;
+}
+
+const char *o1_interface_get_interface_status_output_status_to_str(int value) {
+    switch (value) {
+    case O1_INTERFACE_GET_INTERFACE_STATUS_OUTPUT_STATUS_UP:
+        return "up";
+    case O1_INTERFACE_GET_INTERFACE_STATUS_OUTPUT_STATUS_DOWN:
+        return "down";
+    case O1_INTERFACE_GET_INTERFACE_STATUS_OUTPUT_STATUS_ERROR:
+        return "error";
+    default:
+        return NULL;
+    }
+}
+
+int o1_interface_get_interface_status_output_last_change_parse(const char *s, size_t len, uint64_t *value) {
+    uint64_t v;
+    if (yang_parse_uint(s, len, &v) != 0) {
+        return -1;
+    }
+    
+    *value = v;
+    return 0;
+}
+
+int o1_interface_set_interface_status_input_interface_name_valid(const char *s, size_t len) {
+    (void)len;
+    (void)s;
+    return 1;
+}
+
+int o1_interface_set_interface_status_input_status_from_str(const char *s, size_t len) {
+    // Lengths tell most names apart; one memcmp confirms
+    switch (len) {
+    case 2:
+        if (memcmp(s, "up", 2) == 0) {
+            return O1_INTERFACE_SET_INTERFACE_STATUS_INPUT_STATUS_UP;
+        }
+        break;
+    case 4:
+        if (memcmp(s, "down", 4) == 0) {
+            return O1_INTERFACE_SET_INTERFACE_STATUS_INPUT_STATUS_DOWN;
+        }
+        break;
+    }
+    return -1;
+}
+
+const char *o1_interface_set_interface_status_input_status_to_str(int value) {
+    switch (value) {
+    case O1_INTERFACE_SET_INTERFACE_STATUS_INPUT_STATUS_UP:
+        return "up";
+    case O1_INTERFACE_SET_INTERFACE_STATUS_INPUT_STATUS_DOWN:
+        return "down";
+    default:
+        return NULL;
+    }
+}
+
+int o1_interface_set_interface_status_input_tracing_traceid_valid(const char *s, size_t len) {
+    if (len != 32) {
+        return 0;
+    }
+    
+    // Accumulate instead of branching per character
+    unsigned char ok = 1;
+    for (size_t i = 0; i < 32; i++) {
+        unsigned char c = (unsigned char)s[i];
+        ok &= ((unsigned char)(c - '0') <= 9) | ((unsigned char)(c - 'A') <= 5) | ((unsigned char)(c - 'a') <= 5);
+    }
+    return ok;
+}
+
+int o1_interface_set_interface_status_input_tracing_spanid_valid(const char *s, size_t len) {
+    if (len != 16) {
+        return 0;
+    }
+    
+    // Accumulate instead of branching per character
+    unsigned char ok = 1;
+    for (size_t i = 0; i < 16; i++) {
+        unsigned char c = (unsigned char)s[i];
+        ok &= ((unsigned char)(c - '0') <= 9) | ((unsigned char)(c - 'A') <= 5) | ((unsigned char)(c - 'a') <= 5);
+    }
+    return ok;
+}
+
+int o1_interface_set_interface_status_output_result_from_str(const char *s, size_t len) {
+    // Lengths tell most names apart; one memcmp confirms
+    switch (len) {
+    case 7:
+        if (memcmp(s, "success", 7) == 0) {
+            return O1_INTERFACE_SET_INTERFACE_STATUS_OUTPUT_RESULT_SUCCESS;
+        }
+        if (memcmp(s, "failure", 7) == 0) {
+            return O1_INTERFACE_SET_INTERFACE_STATUS_OUTPUT_RESULT_FAILURE;
+        }
+        break;
+    }
+    return -1;
+}
+
+const char *o1_interface_set_interface_status_output_result_to_str(int value) {
+    switch (value) {
+    case O1_INTERFACE_SET_INTERFACE_STATUS_OUTPUT_RESULT_SUCCESS:
+        return "success";
+    case O1_INTERFACE_SET_INTERFACE_STATUS_OUTPUT_RESULT_FAILURE:
+        return "failure";
+    default:
+        return NULL;
+    }
+}
+
+int o1_interface_set_interface_status_output_message_valid(const char *s, size_t len) {
+    (void)len;
+    (void)s;
+    return 1;
+}
+
+int tracing_traceid_valid(const char *s, size_t len) {
+    if (len != 32) {
+        return 0;
+    }
+    
+    // Accumulate instead of branching per character
+    unsigned char ok = 1;
+    for (size_t i = 0; i < 32; i++) {
+        unsigned char c = (unsigned char)s[i];
+        ok &= ((unsigned char)(c - '0') <= 9) | ((unsigned char)(c - 'A') <= 5) | ((unsigned char)(c - 'a') <= 5);
+    }
+    return ok;
+}
+
+int tracing_spanid_valid(const char *s, size_t len) {
+    if (len != 16) {
+        return 0;
+    }
+    
+    // Accumulate instead of branching per character
+    unsigned char ok = 1;
+    for (size_t i = 0; i < 16; i++) {
+        unsigned char c = (unsigned char)s[i];
+        ok &= ((unsigned char)(c - '0') <= 9) | ((unsigned char)(c - 'A') <= 5) | ((unsigned char)(c - 'a') <= 5);
+    }
+    return ok;
+}
+
+int tracing_timestamp_parse(const char *s, size_t len, uint64_t *value) {
+    uint64_t v;
+    if (yang_parse_uint(s, len, &v) != 0) {
+        return -1;
+    }
+    
+    *value = v;
+    return 0;
+}
+
+int tracing_source_valid(const char *s, size_t len) {
+    (void)len;
+    (void)s;
+    return 1;
+}
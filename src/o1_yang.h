@@ -0,0 +1,84 @@
+// Generated by scripts/gen_yang_validators.py from config/o1-interface.yang config/tracing.yang; do not edit.
+#ifndef O1_YANG_H
+#define O1_YANG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+int o1_interface_interface_name_valid(const char *s, size_t len);
+
+typedef enum {
+    O1_INTERFACE_INTERFACE_STATUS_UP = 0,
+    O1_INTERFACE_INTERFACE_STATUS_DOWN = 1,
+    O1_INTERFACE_INTERFACE_STATUS_ERROR = 2,
+} o1_interface_interface_status_t;
+
+int o1_interface_interface_status_from_str(const char *s, size_t len);
+
+const char *o1_interface_interface_status_to_str(int value);
+
+int o1_interface_interface_description_valid(const char *s, size_t len);
+
+int o1_interface_interface_tracing_traceid_valid(const char *s, size_t len);
+
+int o1_interface_interface_tracing_spanid_valid(const char *s, size_t len);
+
+int o1_interface_interface_tracing_timestamp_parse(const char *s, size_t len, uint64_t *value);
+
+int o1_interface_interface_statistics_packets_in_parse(const char *s, size_t len, uint64_t *value);
+
+int o1_interface_interface_statistics_packets_out_parse(const char *s, size_t len, uint64_t *value);
+
+int o1_interface_interface_statistics_bytes_in_parse(const char *s, size_t len, uint64_t *value);
+
+int o1_interface_interface_statistics_bytes_out_parse(const char *s, size_t len, uint64_t *value);
+
+int o1_interface_get_interface_status_input_interface_name_valid(const char *s, size_t len);
+
+typedef enum {
+    O1_INTERFACE_GET_INTERFACE_STATUS_OUTPUT_STATUS_UP = 0,
+    O1_INTERFACE_GET_INTERFACE_STATUS_OUTPUT_STATUS_DOWN = 1,
+    O1_INTERFACE_GET_INTERFACE_STATUS_OUTPUT_STATUS_ERROR = 2,
+} o1_interface_get_interface_status_output_status_t;
+
+int o1_interface_get_interface_status_output_status_from_str(const char *s, size_t len);
+
+const char *o1_interface_get_interface_status_output_status_to_str(int value);
+
+int o1_interface_get_interface_status_output_last_change_parse(const char *s, size_t len, uint64_t *value);
+
+int o1_interface_set_interface_status_input_interface_name_valid(const char *s, size_t len);
+
+typedef enum {
+    O1_INTERFACE_SET_INTERFACE_STATUS_INPUT_STATUS_UP = 0,
+    O1_INTERFACE_SET_INTERFACE_STATUS_INPUT_STATUS_DOWN = 1,
+} o1_interface_set_interface_status_input_status_t;
+
+int o1_interface_set_interface_status_input_status_from_str(const char *s, size_t len);
+
+const char *o1_interface_set_interface_status_input_status_to_str(int value);
+
+int o1_interface_set_interface_status_input_tracing_traceid_valid(const char *s, size_t len);
+
+int o1_interface_set_interface_status_input_tracing_spanid_valid(const char *s, size_t len);
+
+typedef enum {
+    O1_INTERFACE_SET_INTERFACE_STATUS_OUTPUT_RESULT_SUCCESS = 0,
+    O1_INTERFACE_SET_INTERFACE_STATUS_OUTPUT_RESULT_FAILURE = 1,
+} o1_interface_set_interface_status_output_result_t;
+
+int o1_interface_set_interface_status_output_result_from_str(const char *s, size_t len);
+
+const char *o1_interface_set_interface_status_output_result_to_str(int value);
+
+int o1_interface_set_interface_status_output_message_valid(const char *s, size_t len);
+
+int tracing_traceid_valid(const char *s, size_t len);
+
+int tracing_spanid_valid(const char *s, size_t len);
+
+int tracing_timestamp_parse(const char *s, size_t len, uint64_t *value);
+
+int tracing_source_valid(const char *s, size_t len);
+
+#endif // O1_YANG_H
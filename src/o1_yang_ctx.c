@@ -0,0 +1,293 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "o1_yang_ctx.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000    // Linux 4.17; older kernels treat it as a hint
+#endif
+
+#define CACHE_MAGIC "O1YCTX1"
+
+// Modules the O1 server serves, in load order
+static const char *const yang_modules[] = { "tracing.yang", "o1-interface.yang" };
+#define NUM_YANG_MODULES (sizeof(yang_modules) / sizeof(yang_modules[0]))
+
+// Cache file layout: this header in the first page, the printed context
+// from the second page on. The context is printed for, and must be mapped
+// at, `base`.
+typedef struct {
+    char magic[8];
+    uint64_t fingerprint;   // module sources + libyang version
+    uint64_t base;
+    uint64_t size;
+    uint64_t page_size;
+} cache_header_t;
+
+static struct ly_ctx *yang_ctx = NULL;
+static void *mapping = NULL;        // cache mapping backing a printed context
+static size_t mapping_len = 0;
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t len) {
+    const unsigned char *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Hash of every module file and the libyang version, so a stale cache is
+// never mapped
+static int modules_fingerprint(const char *search_dir, uint64_t *fingerprint) {
+    uint64_t h = 14695981039346656037ULL;
+    char path[4096];
+    char buf[8192];
+
+#ifdef LY_VERSION
+    h = fnv1a(h, LY_VERSION, strlen(LY_VERSION));
+#endif
+    for (size_t i = 0; i < NUM_YANG_MODULES; i++) {
+        snprintf(path, sizeof(path), "%s/%s", search_dir, yang_modules[i]);
+        FILE *f = fopen(path, "rb");
+        if (!f) {
+            perror(path);
+            return -1;
+        }
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+            h = fnv1a(h, buf, n);
+        }
+        fclose(f);
+        h = fnv1a(h, yang_modules[i], strlen(yang_modules[i]));
+    }
+    
+    *fingerprint = h;
+    return 0;
+}
+
+static void destroy_context(struct ly_ctx *ctx) {
+#ifdef O1_LIBYANG_V2
+    ly_ctx_destroy(ctx);
+#else
+    ly_ctx_destroy(ctx, NULL);
+#endif
+}
+
+// Parse and compile the modules from search_dir
+static struct ly_ctx *compile_context(const char *search_dir) {
+    struct ly_ctx *ctx = NULL;
+    char path[4096];
+
+#ifdef O1_LIBYANG_V2
+    if (ly_ctx_new(search_dir, 0, &ctx) != LY_SUCCESS) {
+        ctx = NULL;
+    }
+#else
+    ctx = ly_ctx_new(search_dir, 0);
+#endif
+    if (!ctx) {
+        fprintf(stderr, "Failed to create libyang context\n");
+        return NULL;
+    }
+    
+    for (size_t i = 0; i < NUM_YANG_MODULES; i++) {
+        snprintf(path, sizeof(path), "%s/%s", search_dir, yang_modules[i]);
+#ifdef O1_LIBYANG_V2
+        int ok = lys_parse_path(ctx, path, LYS_IN_YANG, NULL) == LY_SUCCESS;
+#else
+        int ok = lys_parse_path(ctx, path, LYS_IN_YANG) != NULL;
+#endif
+        if (!ok) {
+            fprintf(stderr, "Failed to load YANG module %s\n", path);
+            destroy_context(ctx);
+            return NULL;
+        }
+    }
+    
+    return ctx;
+}
+
+#ifdef O1_YANG_PRINTED_CTX
+
+// Map a cache written by save_cache() at its recorded address
+static struct ly_ctx *load_cache(const char *cache_path, uint64_t fingerprint) {
+    cache_header_t header;
+    struct stat st;
+    
+    int fd = open(cache_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header) || fstat(fd, &st) != 0 ||
+        memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.fingerprint != fingerprint || header.page_size != (uint64_t)sysconf(_SC_PAGESIZE) ||
+        (uint64_t)st.st_size != header.page_size + header.size) {
+        printf("YANG context cache %s is stale, rebuilding\n", cache_path);
+        close(fd);
+        return NULL;
+    }
+    
+    size_t len = header.page_size + header.size;
+    void *want = (void *)(uintptr_t)(header.base - header.page_size);
+    void *addr = mmap(want, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED_NOREPLACE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        printf("YANG context cache address is in use, rebuilding\n");
+        return NULL;
+    }
+    if (addr != want) {
+        munmap(addr, len);
+        printf("YANG context cache address is in use, rebuilding\n");
+        return NULL;
+    }
+    
+    struct ly_ctx *ctx = NULL;
+    if (ly_ctx_new_printed((char *)addr + header.page_size, &ctx) != LY_SUCCESS) {
+        fprintf(stderr, "Failed to open printed YANG context from %s\n", cache_path);
+        munmap(addr, len);
+        return NULL;
+    }
+    
+    mapping = addr;
+    mapping_len = len;
+    return ctx;
+}
+
+// Print ctx into a fresh mapping and write it out as the cache. The file
+// is written next to its final path and renamed, so a crash never leaves
+// a truncated cache behind.
+static int save_cache(const struct ly_ctx *ctx, const char *cache_path, uint64_t fingerprint) {
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    int size = ly_ctx_compiled_size(ctx);
+    if (size <= 0) {
+        return -1;
+    }
+    
+    size_t len = page_size + (size_t)size;
+    char *region = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    
+    void *end = NULL;
+    if (ly_ctx_compiled_print(ctx, region + page_size, &end) != LY_SUCCESS) {
+        fprintf(stderr, "Failed to print YANG context\n");
+        munmap(region, len);
+        return -1;
+    }
+    
+    cache_header_t *header = (cache_header_t *)region;
+    memcpy(header->magic, CACHE_MAGIC, sizeof(header->magic));
+    header->fingerprint = fingerprint;
+    header->base = (uint64_t)(uintptr_t)(region + page_size);
+    header->size = (uint64_t)size;
+    header->page_size = page_size;
+    
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache_path);
+    int ret = -1;
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd >= 0) {
+        size_t off = 0;
+        while (off < len) {
+            ssize_t n = write(fd, region + off, len - off);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            off += (size_t)n;
+        }
+        if (close(fd) == 0 && off == len && rename(tmp_path, cache_path) == 0) {
+            ret = 0;
+        }
+    }
+    if (ret != 0) {
+        perror(cache_path);
+        unlink(tmp_path);
+    }
+    
+    munmap(region, len);
+    return ret;
+}
+
+#endif // O1_YANG_PRINTED_CTX
+
+// Build the shared context, from the cache when one is usable
+int o1_yang_ctx_init(const char *search_dir, const char *cache_path) {
+    if (yang_ctx) {
+        return 0;
+    }
+    if (!search_dir) {
+        search_dir = O1_YANG_DEFAULT_DIR;
+    }
+    
+    double start = now_ms();
+
+#ifdef O1_YANG_PRINTED_CTX
+    uint64_t fingerprint = 0;
+    if (cache_path && modules_fingerprint(search_dir, &fingerprint) == 0) {
+        yang_ctx = load_cache(cache_path, fingerprint);
+        if (yang_ctx) {
+            printf("YANG context mapped from %s in %.2f ms\n", cache_path, now_ms() - start);
+            return 0;
+        }
+    }
+#else
+    if (cache_path) {
+        printf("libyang cannot print compiled contexts; ignoring cache %s\n", cache_path);
+    }
+#endif
+    
+    yang_ctx = compile_context(search_dir);
+    if (!yang_ctx) {
+        return -1;
+    }
+    printf("YANG context compiled from %s in %.2f ms\n", search_dir, now_ms() - start);
+
+#ifdef O1_YANG_PRINTED_CTX
+    if (cache_path && fingerprint && save_cache(yang_ctx, cache_path, fingerprint) == 0) {
+        printf("YANG context cached in %s\n", cache_path);
+    }
+#else
+    (void)modules_fingerprint;
+#endif
+    
+    return 0;
+}
+
+// The context libnetconf2 builds every server session on
+struct ly_ctx *o1_yang_ctx_get(void) {
+    return yang_ctx;
+}
+
+// Call after every session thread has stopped
+void o1_yang_ctx_cleanup(void) {
+    if (mapping) {
+        // A printed context lives entirely inside the mapping
+        munmap(mapping, mapping_len);
+        mapping = NULL;
+        mapping_len = 0;
+    } else if (yang_ctx) {
+        destroy_context(yang_ctx);
+    }
+    yang_ctx = NULL;
+}
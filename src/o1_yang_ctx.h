@@ -0,0 +1,26 @@
+#ifndef O1_YANG_CTX_H
+#define O1_YANG_CTX_H
+
+#include <libyang/libyang.h>
+
+// One libyang context holding o1-interface and tracing, built once at
+// startup and handed to nc_server_init(), so every NETCONF session is
+// created on it and session threads share it read-only. No module is
+// loaded after o1_yang_ctx_init() returns, which is what makes the
+// concurrent read-only use safe.
+//
+// With a cache path, the compiled context is printed to that file and
+// memory-mapped on the next start instead of compiling the YANG modules
+// again. The cache is keyed on the module sources and the libyang version
+// and is rebuilt when either changes. Printed contexts need libyang with
+// ly_ctx_compiled_print() (O1_YANG_PRINTED_CTX); otherwise the cache path
+// is ignored.
+
+#define O1_YANG_DEFAULT_DIR "config"
+
+// Function declarations
+int o1_yang_ctx_init(const char *search_dir, const char *cache_path);
+struct ly_ctx *o1_yang_ctx_get(void);
+void o1_yang_ctx_cleanup(void);
+
+#endif // O1_YANG_CTX_H
@@ -1,4 +1,5 @@
 #include "common.h"
+#include "o1_handshake.h"
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -7,6 +8,13 @@
 
 static volatile int running = 1;
 static int server_socket = -1;
+static o1_handshake_pool_t *handshake_pool = NULL;
+
+// An established session and its socket, passed to its serving thread
+typedef struct {
+    struct nc_session *session;
+    int fd;
+} client_session_t;
 
 void signal_handler(int sig) {
     printf("\nReceived signal %d, shutting down...\n", sig);
@@ -52,19 +60,12 @@ int setup_server_socket(int port) {
     return sock;
 }
 
-int handle_client_connection(int client_socket) {
-    printf("New client connected\n");
-    
-    // Initialize NETCONF session for this client
-    struct nc_session *session = NULL;
-    int ret = nc_accept_ssh(client_socket, NULL, NULL, &session);
-    if (ret != NC_MSG_HELLO) {
-        fprintf(stderr, "Failed to accept NETCONF session: %s\n", nc_strerror(ret));
-        close(client_socket);
-        return ERROR_SESSION;
-    }
-    
-    printf("NETCONF session established with client\n");
+static void *serve_client_session(void *arg) {
+    client_session_t *client = arg;
+    struct nc_session *session = client->session;
+    int client_socket = client->fd;
+    int ret;
+    free(client);
     
     // Handle NETCONF messages
     while (running) {
@@ -73,7 +74,7 @@ int handle_client_connection(int client_socket) {
         
         if (ret == NC_MSG_RPC) {
             // Handle RPC message
-            printf("Received RPC message from client\n");
+            log_debug("Received RPC message from client");
             
             // Extract tracing data from the message
             // This is a simplified implementation
@@ -82,7 +83,7 @@ int handle_client_connection(int client_socket) {
             
             // In a real implementation, you would parse the XML message
             // to extract traceid and spanid
-            printf("Processing tracing data...\n");
+            log_debug("Processing tracing data...");
             
             // Send response
             char response[512];
@@ -94,23 +95,23 @@ int handle_client_connection(int client_socket) {
             
             ret = nc_send_reply(session, response, 1000);
             if (ret != NC_MSG_REPLY) {
-                fprintf(stderr, "Failed to send response: %s\n", nc_strerror(ret));
+                log_error("Failed to send response: %s", nc_strerror(ret));
                 break;
             }
             
-            printf("Response sent to client\n");
+            log_debug("Response sent to client");
             
         } else if (ret == NC_MSG_CLOSE) {
-            printf("Client closed connection\n");
+            log_info("Client closed connection");
             break;
         } else if (ret == NC_MSG_ERROR) {
-            fprintf(stderr, "Received error message from client\n");
+            log_warn("Received error message from client");
             break;
         } else if (ret == NC_MSG_WOULDBLOCK) {
             // Timeout, continue
             continue;
         } else {
-            fprintf(stderr, "Unexpected message type: %d\n", ret);
+            log_warn("Unexpected message type: %d", ret);
             break;
         }
         
@@ -123,21 +124,61 @@ int handle_client_connection(int client_socket) {
     }
     close(client_socket);
     
+    return NULL;
+}
+
+// Called on a handshake thread once a session is established: serve it on
+// its own thread so the handshake thread can take the next connection
+static int handle_established_session(struct nc_session *session, int client_socket, void *arg) {
+    (void)arg;
+    pthread_t thread;
+    
+    client_session_t *client = malloc(sizeof(*client));
+    if (!client) {
+        return -1;
+    }
+    client->session = session;
+    client->fd = client_socket;
+    
+    if (pthread_create(&thread, NULL, serve_client_session, client) != 0) {
+        log_error("Failed to start session thread");
+        free(client);
+        return -1;
+    }
+    pthread_detach(thread);
+    return SUCCESS;
+}
+
+int handle_client_connection(int client_socket) {
+    log_debug("New client connected");
+    
+    // The SSH handshake runs on the handshake pool, not the accept loop
+    if (o1_handshake_submit(handshake_pool, client_socket) != 0) {
+        log_warn("Handshake queue full, rejecting client");
+        close(client_socket);
+        return ERROR_SESSION;
+    }
+    
     return SUCCESS;
 }
 
 int main(int argc, char *argv[]) {
     int port = DEFAULT_PORT;
+    log_level_t log_level = LOG_LEVEL_INFO;
     
     // Parse command line arguments
     if (argc > 1) {
         port = atoi(argv[1]);
     }
+    if (argc > 2 && log_parse_level(argv[2], &log_level) != 0) {
+        fprintf(stderr, "Unknown log level %s\n", argv[2]);
+        return 1;
+    }
     
     printf("Starting NETCONF Server on port %d\n", port);
     
     // Initialize logging
-    init_logging();
+    init_logging(log_level);
     
     // Set up signal handler
     signal(SIGINT, signal_handler);
@@ -151,6 +192,17 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
+    // Bounded pool for SSH handshakes
+    o1_handshake_config_t handshake_config;
+    o1_handshake_default_config(&handshake_config);
+    handshake_pool = o1_handshake_pool_create(&handshake_config, handle_established_session, NULL);
+    if (!handshake_pool) {
+        fprintf(stderr, "Failed to start handshake pool\n");
+        close(server_socket);
+        cleanup_logging();
+        return 1;
+    }
+    
     printf("Server listening on port %d\n", port);
     printf("Press Ctrl+C to stop the server\n");
     
@@ -162,15 +214,14 @@ int main(int argc, char *argv[]) {
         int client_socket = accept(server_socket, (struct sockaddr*)&client_addr, &client_len);
         if (client_socket < 0) {
             if (running) {
-                perror("Accept failed");
+                log_error("Accept failed: %s", strerror(errno));
             }
             continue;
         }
         
-        printf("Client connected from %s:%d\n", 
-               inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
+        log_info("Client connected from %s:%d",
+                 inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
         
-        // Handle client in a new thread (simplified - in production use pthread)
         handle_client_connection(client_socket);
     }
     
@@ -179,6 +230,7 @@ int main(int argc, char *argv[]) {
         close(server_socket);
     }
     
+    o1_handshake_pool_destroy(handshake_pool);
     cleanup_logging();
     printf("Server stopped\n");
     
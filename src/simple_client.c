@@ -1,3 +1,4 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -5,19 +6,22 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <openssl/rand.h>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include <time.h>
 
+#include "frame.h"
+#include "trace_id.h"
+
 #define DEFAULT_HOST "127.0.0.1"
 #define DEFAULT_PORT 8443
 #define BUFFER_SIZE 1024
-
-typedef struct {
-    char traceid[33];  // 32 hex chars + null terminator
-    char spanid[17];   // 16 hex chars + null terminator
-} tracing_data_t;
+#define MAX_IN_FLIGHT 256
+#define RESPONSE_TIMEOUT_MS 5000
 
 void init_openssl() {
     SSL_library_init();
@@ -37,30 +41,12 @@ int generate_tracing_data(tracing_data_t *tracing) {
         return -1;
     }
     
-    // Generate random traceid (32 hex characters)
-    unsigned char traceid_bytes[16];
-    if (RAND_bytes(traceid_bytes, 16) != 1) {
-        fprintf(stderr, "Failed to generate random traceid\n");
-        return -1;
-    }
-    
-    for (int i = 0; i < 16; i++) {
-        sprintf(&tracing->traceid[i * 2], "%02x", traceid_bytes[i]);
-    }
-    tracing->traceid[32] = '\0';
-    
-    // Generate random spanid (16 hex characters)
-    unsigned char spanid_bytes[8];
-    if (RAND_bytes(spanid_bytes, 8) != 1) {
-        fprintf(stderr, "Failed to generate random spanid\n");
+    // Random traceid (32 hex characters) and spanid (16 hex characters)
+    if (trace_id_generate(tracing) != 0) {
+        fprintf(stderr, "Failed to generate tracing data\n");
         return -1;
     }
     
-    for (int i = 0; i < 8; i++) {
-        sprintf(&tracing->spanid[i * 2], "%02x", spanid_bytes[i]);
-    }
-    tracing->spanid[16] = '\0';
-    
     return 0;
 }
 
@@ -75,53 +61,144 @@ void print_tracing_data(const tracing_data_t *tracing) {
     printf("  SpanID:  %s\n", tracing->spanid);
 }
 
-int send_tracing_data(int sockfd, const tracing_data_t *tracing) {
+// Queue one record as a single-line JSON frame
+int send_tracing_data(frame_buf_t *out, const tracing_data_t *tracing, int verbose) {
     if (!tracing) {
         return -1;
     }
     
-    // Create JSON-like message
     char message[BUFFER_SIZE];
-    snprintf(message, sizeof(message),
-        "{\n"
-        "  \"type\": \"tracing_data\",\n"
-        "  \"traceid\": \"%s\",\n"
-        "  \"spanid\": \"%s\",\n"
-        "  \"timestamp\": %ld\n"
-        "}\n",
+    int len = snprintf(message, sizeof(message),
+        "{\"type\": \"tracing_data\", "
+        "\"traceid\": \"%s\", "
+        "\"spanid\": \"%s\", "
+        "\"timestamp\": %ld}\n",
         tracing->traceid, tracing->spanid, time(NULL));
     
-    // Send the message
-    int bytes_sent = send(sockfd, message, strlen(message), 0);
-    if (bytes_sent < 0) {
-        perror("Failed to send data");
+    if (frame_buf_append(out, message, len) != 0) {
         return -1;
     }
     
-    printf("Sent %d bytes to server\n", bytes_sent);
-    printf("Message sent:\n%s\n", message);
+    if (verbose) {
+        printf("Message queued (%d bytes): %s", len, message);
+    }
     
     return 0;
 }
 
-int receive_response(int sockfd) {
-    char buffer[BUFFER_SIZE];
-    int bytes_received = recv(sockfd, buffer, sizeof(buffer) - 1, 0);
+int receive_response(const char *frame, size_t len, int verbose) {
+    if (verbose) {
+        printf("Received response (%zu bytes): %s\n", len, frame);
+    }
     
-    if (bytes_received < 0) {
-        perror("Failed to receive response");
+    if (!strstr(frame, "\"status\": \"success\"")) {
+        fprintf(stderr, "Server rejected record: %s\n", frame);
         return -1;
     }
     
-    buffer[bytes_received] = '\0';
-    printf("Received response (%d bytes):\n%s\n", bytes_received, buffer);
-    
     return 0;
 }
 
+// Stream all records over one connection, keeping up to `window`
+// unacknowledged so the link never idles waiting for a round trip
+int run_tracing_session(int sockfd, const tracing_data_t *records, int count, int window, int verbose) {
+    frame_buf_t in, out;
+    int sent = 0;
+    int acked = 0;
+    int failed = 0;
+    
+    if (frame_buf_init(&in, FRAME_BUF_SIZE) != 0 || frame_buf_init(&out, FRAME_BUF_SIZE) != 0) {
+        fprintf(stderr, "Failed to allocate frame buffers\n");
+        frame_buf_free(&in);
+        return -1;
+    }
+    
+    int ret = 0;
+    while (acked < count) {
+        while (sent < count && sent - acked < window) {
+            if (send_tracing_data(&out, &records[sent], verbose) != 0) {
+                break;  // output buffer full; drain it first
+            }
+            sent++;
+        }
+        
+        struct pollfd pfd;
+        pfd.fd = sockfd;
+        pfd.events = POLLIN | (frame_buf_pending(&out) ? POLLOUT : 0);
+        pfd.revents = 0;
+        
+        int n = poll(&pfd, 1, RESPONSE_TIMEOUT_MS);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll failed");
+            ret = -1;
+            break;
+        }
+        if (n == 0) {
+            fprintf(stderr, "Timed out waiting for server (%d of %d acknowledged)\n", acked, count);
+            ret = -1;
+            break;
+        }
+        
+        if ((pfd.revents & POLLOUT) && frame_buf_flush(&out, sockfd) < 0) {
+            perror("Failed to send data");
+            ret = -1;
+            break;
+        }
+        
+        if (pfd.revents & (POLLIN | POLLHUP | POLLERR)) {
+            int bytes_received = frame_buf_read(&in, sockfd);
+            if (bytes_received == 0) {
+                fprintf(stderr, "Server closed connection (%d of %d acknowledged)\n", acked, count);
+                ret = -1;
+                break;
+            }
+            if (bytes_received < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("Failed to receive response");
+                ret = -1;
+                break;
+            }
+            
+            // Replies may arrive split across reads or several per read
+            char *frame;
+            size_t frame_len;
+            while ((frame = frame_next(&in, &frame_len)) != NULL) {
+                if (receive_response(frame, frame_len, verbose) != 0) {
+                    failed++;
+                }
+                acked++;
+            }
+            if (errno == EMSGSIZE) {
+                fprintf(stderr, "Server frame exceeds %d bytes\n", FRAME_MAX_SIZE);
+                ret = -1;
+                break;
+            }
+        }
+    }
+    
+    frame_buf_free(&in);
+    frame_buf_free(&out);
+    
+    if (ret == 0 && failed > 0) {
+        fprintf(stderr, "%d of %d records rejected\n", failed, count);
+        ret = -1;
+    }
+    return ret;
+}
+
+double elapsed_seconds(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
 int main(int argc, char *argv[]) {
     char *host = DEFAULT_HOST;
     int port = DEFAULT_PORT;
+    int count = 1;
+    int window = MAX_IN_FLIGHT;
     
     // Parse command line arguments
     if (argc > 1) {
@@ -130,6 +207,22 @@ int main(int argc, char *argv[]) {
     if (argc > 2) {
         port = atoi(argv[2]);
     }
+    if (argc > 3) {
+        count = atoi(argv[3]);
+    }
+    if (count < 1) {
+        count = 1;
+    }
+    
+    // A window as large as the count sends every record before reading a
+    // reply, the burst a pipelining client can produce
+    if (argc > 4) {
+        window = atoi(argv[4]);
+    }
+    if (window < 1) {
+        window = 1;
+    }
+    int verbose = count == 1;
     
     printf("Simple Tracing Client\n");
     printf("Connecting to %s:%d\n", host, port);
@@ -138,20 +231,26 @@ int main(int argc, char *argv[]) {
     init_openssl();
     
     // Generate tracing data
-    tracing_data_t tracing;
-    if (generate_tracing_data(&tracing) != 0) {
+    tracing_data_t *records = malloc(count * sizeof(*records));
+    if (!records || trace_id_generate_bulk(records, count) != 0) {
         fprintf(stderr, "Failed to generate tracing data\n");
+        free(records);
         cleanup_openssl();
         return 1;
     }
     
-    printf("Generated tracing data:\n");
-    print_tracing_data(&tracing);
+    if (verbose) {
+        printf("Generated tracing data:\n");
+        print_tracing_data(&records[0]);
+    } else {
+        printf("Generated %d tracing records\n", count);
+    }
     
     // Create socket
     int sockfd = socket(AF_INET, SOCK_STREAM, 0);
     if (sockfd < 0) {
         perror("Failed to create socket");
+        free(records);
         cleanup_openssl();
         return 1;
     }
@@ -165,6 +264,7 @@ int main(int argc, char *argv[]) {
     if (inet_pton(AF_INET, host, &server_addr.sin_addr) <= 0) {
         perror("Invalid address");
         close(sockfd);
+        free(records);
         cleanup_openssl();
         return 1;
     }
@@ -173,34 +273,35 @@ int main(int argc, char *argv[]) {
     if (connect(sockfd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         perror("Connection failed");
         close(sockfd);
+        free(records);
         cleanup_openssl();
         return 1;
     }
     
     printf("Connected to server successfully\n");
+    fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL) | O_NONBLOCK);
     
-    // Send tracing data
-    if (send_tracing_data(sockfd, &tracing) != 0) {
-        fprintf(stderr, "Failed to send tracing data\n");
-        close(sockfd);
-        cleanup_openssl();
-        return 1;
-    }
+    // Send all records over the one connection
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
     
-    // Receive response
-    if (receive_response(sockfd) != 0) {
-        fprintf(stderr, "Failed to receive response\n");
+    if (run_tracing_session(sockfd, records, count, window, verbose) != 0) {
+        fprintf(stderr, "Failed to send tracing data\n");
         close(sockfd);
+        free(records);
         cleanup_openssl();
         return 1;
     }
     
-    printf("Successfully sent tracing data to server\n");
+    double seconds = elapsed_seconds(&start);
+    printf("Successfully sent %d tracing record%s to server in %.3f s (%.0f records/s)\n",
+           count, count == 1 ? "" : "s", seconds, count / seconds);
     
     // Cleanup
     close(sockfd);
+    free(records);
     cleanup_openssl();
     
     printf("Client completed successfully\n");
     return 0;
-} 
\ No newline at end of file
+}
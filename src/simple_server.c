@@ -1,3 +1,4 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -6,29 +7,47 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <signal.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/epoll.h>
 #include <openssl/rand.h>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include <time.h>
 
+#include "frame.h"
+#include "log.h"
+#include "trace_id.h"
+
 #define DEFAULT_PORT 8443
 #define BUFFER_SIZE 1024
-#define MAX_CLIENTS 10
+#define MAX_CLIENTS SOMAXCONN
+#define MAX_EVENTS 256
+#define MAX_WORKERS 256
+#define OUT_HIGH_WATER (FRAME_BUF_SIZE / 2)
+
+// Per-connection state for a long-lived, framed client connection
+typedef struct {
+    int fd;
+    int peer_closed;
+    frame_buf_t in;
+    frame_buf_t out;
+} client_conn_t;
 
+// Each worker owns its own SO_REUSEPORT listener and epoll instance
 typedef struct {
-    char traceid[33];  // 32 hex chars + null terminator
-    char spanid[17];   // 16 hex chars + null terminator
-} tracing_data_t;
+    int id;
+    int port;
+    int listen_fd;
+    int epoll_fd;
+    pthread_t thread;
+} worker_t;
 
-static volatile int running = 1;
-static int server_socket = -1;
+static volatile sig_atomic_t running = 1;
 
 void signal_handler(int sig) {
-    printf("\nReceived signal %d, shutting down...\n", sig);
+    (void)sig;
     running = 0;
-    if (server_socket != -1) {
-        close(server_socket);
-    }
 }
 
 void init_openssl() {
@@ -46,122 +65,183 @@ void cleanup_openssl() {
 
 void print_tracing_data(const tracing_data_t *tracing) {
     if (!tracing) {
-        printf("Tracing data: NULL\n");
+        log_debug("Tracing data: NULL");
         return;
     }
     
-    printf("Received Tracing Data:\n");
-    printf("  TraceID: %s\n", tracing->traceid);
-    printf("  SpanID:  %s\n", tracing->spanid);
+    log_debug("Received tracing data: TraceID %s, SpanID %s", tracing->traceid, tracing->spanid);
 }
 
-int parse_tracing_data(const char *json_data, tracing_data_t *tracing) {
-    if (!json_data || !tracing) {
-        return -1;
-    }
-    
-    // Simple JSON parsing (in production, use a proper JSON library)
-    char *traceid_start = strstr(json_data, "\"traceid\": \"");
-    char *spanid_start = strstr(json_data, "\"spanid\": \"");
-    
-    if (!traceid_start || !spanid_start) {
-        printf("Could not find traceid or spanid in JSON data\n");
+int send_response(client_conn_t *conn, const char *message, int len) {
+    if (frame_buf_append(&conn->out, message, len) != 0) {
+        log_warn("Response queue full, dropping client");
         return -1;
     }
     
-    // Extract traceid
-    traceid_start += 12; // Skip "\"traceid\": \""
-    char *traceid_end = strchr(traceid_start, '"');
-    if (!traceid_end || (traceid_end - traceid_start) != 32) {
-        printf("Invalid traceid format\n");
-        return -1;
-    }
-    strncpy(tracing->traceid, traceid_start, 32);
-    tracing->traceid[32] = '\0';
-    
-    // Extract spanid
-    spanid_start += 11; // Skip "\"spanid\": \""
-    char *spanid_end = strchr(spanid_start, '"');
-    if (!spanid_end || (spanid_end - spanid_start) != 16) {
-        printf("Invalid spanid format\n");
-        return -1;
-    }
-    strncpy(tracing->spanid, spanid_start, 16);
-    tracing->spanid[16] = '\0';
-    
+    // The response already ends with its newline
+    log_debug("Queued response (%d bytes): %.*s", len, len > 0 ? len - 1 : 0, message);
     return 0;
 }
 
-int send_response(int client_socket, const char *message) {
-    int bytes_sent = send(client_socket, message, strlen(message), 0);
-    if (bytes_sent < 0) {
-        perror("Failed to send response");
-        return -1;
-    }
-    
-    printf("Sent response (%d bytes): %s\n", bytes_sent, message);
-    return 0;
-}
-
-int handle_client_connection(int client_socket) {
-    printf("New client connected\n");
-    
-    char buffer[BUFFER_SIZE];
-    int bytes_received = recv(client_socket, buffer, sizeof(buffer) - 1, 0);
-    
-    if (bytes_received < 0) {
-        perror("Failed to receive data");
-        close(client_socket);
-        return -1;
-    }
-    
-    buffer[bytes_received] = '\0';
-    printf("Received data (%d bytes):\n%s\n", bytes_received, buffer);
+int handle_client_message(client_conn_t *conn, char *frame, size_t frame_len) {
+    log_debug("Received frame (%zu bytes): %s", frame_len, frame);
     
     // Parse the tracing data
     tracing_data_t tracing;
-    if (parse_tracing_data(buffer, &tracing) == 0) {
+    char response[BUFFER_SIZE];
+    int len;
+    
+    if (trace_id_parse_json(frame, &tracing) == 0) {
         print_tracing_data(&tracing);
         
         // Process the tracing data (in a real application, you might store it in a database)
-        printf("Processing tracing data...\n");
+        log_debug("Processing tracing data...");
         
-        // Send acknowledgment response
-        char response[BUFFER_SIZE];
-        snprintf(response, sizeof(response),
-            "{\n"
-            "  \"status\": \"success\",\n"
-            "  \"message\": \"Tracing data received and processed\",\n"
-            "  \"received_traceid\": \"%s\",\n"
-            "  \"received_spanid\": \"%s\",\n"
-            "  \"timestamp\": %ld\n"
-            "}\n",
+        // Acknowledge with a single-line JSON frame
+        len = snprintf(response, sizeof(response),
+            "{\"status\": \"success\", "
+            "\"message\": \"Tracing data received and processed\", "
+            "\"received_traceid\": \"%s\", "
+            "\"received_spanid\": \"%s\", "
+            "\"timestamp\": %ld}\n",
             tracing.traceid, tracing.spanid, time(NULL));
+    } else {
+        log_warn("Failed to parse tracing data: missing or malformed traceid/spanid");
+        
+        len = snprintf(response, sizeof(response),
+            "{\"status\": \"error\", "
+            "\"message\": \"Failed to parse tracing data\"}\n");
+    }
+    
+    return send_response(conn, response, len);
+}
+
+void close_client_connection(worker_t *worker, client_conn_t *conn) {
+    epoll_ctl(worker->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    frame_buf_free(&conn->in);
+    frame_buf_free(&conn->out);
+    free(conn);
+    log_info("Client connection closed");
+}
+
+// Service a connection after a readiness event. Edge-triggered, so input is
+// read until EAGAIN unless queued replies back up past the high-water mark.
+// Frames are then left unanswered in `in`, and input unread in the socket,
+// until the next EPOLLOUT shows the peer has drained some replies. Returns 1
+// when the connection should be closed, 0 while it stays open.
+int handle_client_connection(client_conn_t *conn) {
+    while (1) {
+        int queued = frame_buf_flush(&conn->out, conn->fd);
+        if (queued < 0) {
+            log_warn("Failed to send response: %s", strerror(errno));
+            return 1;
+        }
         
-        send_response(client_socket, response);
+        // A single read may carry several frames, or only part of one. Each
+        // reply fits in the room left above the high-water mark.
+        char *frame;
+        size_t frame_len;
+        while (frame_buf_pending(&conn->out) < OUT_HIGH_WATER) {
+            frame = frame_next(&conn->in, &frame_len);
+            if (!frame) {
+                if (errno == EMSGSIZE) {
+                    log_warn("Client frame exceeds %d bytes", FRAME_MAX_SIZE);
+                    return 1;
+                }
+                break;
+            }
+            if (handle_client_message(conn, frame, frame_len) != 0) {
+                return 1;
+            }
+        }
         
-    } else {
-        printf("Failed to parse tracing data\n");
+        size_t pending = frame_buf_pending(&conn->out);
+        if (pending >= OUT_HIGH_WATER || conn->peer_closed) {
+            if (queued > 0) {
+                // The socket is full; EPOLLOUT resumes us once it drains
+                return 0;
+            }
+            if (pending == 0) {
+                // Half-closed and every reply delivered
+                return 1;
+            }
+            // The socket took everything so far, so try the new replies now
+            continue;
+        }
         
-        // Send error response
-        char error_response[BUFFER_SIZE];
-        snprintf(error_response, sizeof(error_response),
-            "{\n"
-            "  \"status\": \"error\",\n"
-            "  \"message\": \"Failed to parse tracing data\"\n"
-            "}\n");
+        int bytes_received = frame_buf_read(&conn->in, conn->fd);
+        if (bytes_received < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            log_warn("Failed to receive data: %s", strerror(errno));
+            return 1;
+        }
         
-        send_response(client_socket, error_response);
+        if (bytes_received == 0) {
+            // Half-close: the client is done sending but may await replies
+            conn->peer_closed = 1;
+        }
+    }
+}
+
+void accept_client_connections(worker_t *worker) {
+    while (1) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        
+        int client_socket = accept4(worker->listen_fd, (struct sockaddr*)&client_addr,
+                                    &client_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_socket < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && running) {
+                log_error("Accept failed: %s", strerror(errno));
+            }
+            return;
+        }
+        
+        log_info("Client connected from %s:%d (worker %d)",
+                 inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port), worker->id);
+        
+        client_conn_t *conn = calloc(1, sizeof(*conn));
+        if (!conn || frame_buf_init(&conn->in, FRAME_BUF_SIZE) != 0 ||
+            frame_buf_init(&conn->out, FRAME_BUF_SIZE) != 0) {
+            log_error("Failed to allocate client connection");
+            if (conn) {
+                frame_buf_free(&conn->in);
+                free(conn);
+            }
+            close(client_socket);
+            continue;
+        }
+        conn->fd = client_socket;
+        
+        // EPOLLOUT is edge-triggered too, so it only fires when a full
+        // socket buffer drains, which is exactly when queued replies can move
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        ev.data.ptr = conn;
+        if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, client_socket, &ev) < 0) {
+            log_error("epoll_ctl failed: %s", strerror(errno));
+            close(client_socket);
+            frame_buf_free(&conn->in);
+            frame_buf_free(&conn->out);
+            free(conn);
+            continue;
+        }
+        
+        // Data may already be queued; with edge triggering no event would follow
+        if (handle_client_connection(conn)) {
+            close_client_connection(worker, conn);
+        }
     }
-    
-    close(client_socket);
-    printf("Client connection closed\n");
-    
-    return 0;
 }
 
 int setup_server_socket(int port) {
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    int sock = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (sock < 0) {
         perror("Failed to create socket");
         return -1;
@@ -175,6 +255,13 @@ int setup_server_socket(int port) {
         return -1;
     }
     
+    // Every worker binds its own listener; the kernel spreads connections across them
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("setsockopt SO_REUSEPORT failed");
+        close(sock);
+        return -1;
+    }
+    
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
@@ -196,62 +283,154 @@ int setup_server_socket(int port) {
     return sock;
 }
 
+int setup_worker(worker_t *worker, int id, int port) {
+    worker->id = id;
+    worker->port = port;
+    worker->epoll_fd = -1;
+    
+    worker->listen_fd = setup_server_socket(port);
+    if (worker->listen_fd < 0) {
+        return -1;
+    }
+    
+    worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (worker->epoll_fd < 0) {
+        perror("epoll_create1 failed");
+        close(worker->listen_fd);
+        return -1;
+    }
+    
+    // The listener is tagged with a NULL pointer; clients carry their conn state
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = NULL;
+    if (epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, worker->listen_fd, &ev) < 0) {
+        perror("epoll_ctl failed");
+        close(worker->epoll_fd);
+        close(worker->listen_fd);
+        return -1;
+    }
+    
+    return 0;
+}
+
+void *worker_main(void *arg) {
+    worker_t *worker = arg;
+    struct epoll_event events[MAX_EVENTS];
+    
+    while (running) {
+        // Wake periodically so a shutdown request is noticed
+        int n = epoll_wait(worker->epoll_fd, events, MAX_EVENTS, 500);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_error("epoll_wait failed: %s", strerror(errno));
+            break;
+        }
+        
+        for (int i = 0; i < n; i++) {
+            client_conn_t *conn = events[i].data.ptr;
+            if (!conn) {
+                accept_client_connections(worker);
+                continue;
+            }
+            
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close_client_connection(worker, conn);
+            } else if (handle_client_connection(conn)) {
+                close_client_connection(worker, conn);
+            }
+        }
+    }
+    
+    return NULL;
+}
+
 int main(int argc, char *argv[]) {
     int port = DEFAULT_PORT;
+    long num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+    log_config_t log_config;
+    log_default_config(&log_config);
     
     // Parse command line arguments
     if (argc > 1) {
         port = atoi(argv[1]);
     }
+    if (argc > 2) {
+        num_workers = atoi(argv[2]);
+    }
+    if (argc > 3 && log_parse_level(argv[3], &log_config.level) != 0) {
+        fprintf(stderr, "Unknown log level %s\n", argv[3]);
+        return 1;
+    }
+    if (num_workers < 1) {
+        num_workers = 1;
+    }
+    if (num_workers > MAX_WORKERS) {
+        num_workers = MAX_WORKERS;
+    }
     
     printf("Simple Tracing Server\n");
-    printf("Starting server on port %d\n", port);
+    printf("Starting server on port %d with %ld worker threads\n", port, num_workers);
     
     // Initialize OpenSSL
     init_openssl();
     
+    // Request-path messages go through the asynchronous log
+    if (log_init(&log_config) != 0) {
+        cleanup_openssl();
+        return 1;
+    }
+    
     // Set up signal handler
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGPIPE, SIG_IGN);
     
-    // Create server socket
-    server_socket = setup_server_socket(port);
-    if (server_socket < 0) {
-        fprintf(stderr, "Failed to setup server socket\n");
+    worker_t *workers = calloc(num_workers, sizeof(*workers));
+    if (!workers) {
+        fprintf(stderr, "Failed to allocate workers\n");
+        log_shutdown();
         cleanup_openssl();
         return 1;
     }
     
-    printf("Server listening on port %d\n", port);
-    printf("Press Ctrl+C to stop the server\n");
-    
-    // Main server loop
-    while (running) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        
-        int client_socket = accept(server_socket, (struct sockaddr*)&client_addr, &client_len);
-        if (client_socket < 0) {
-            if (running) {
-                perror("Accept failed");
-            }
-            continue;
+    // Create one listener per worker
+    int started = 0;
+    for (int i = 0; i < num_workers; i++) {
+        if (setup_worker(&workers[i], i, port) != 0) {
+            fprintf(stderr, "Failed to setup server socket\n");
+            break;
         }
-        
-        printf("Client connected from %s:%d\n", 
-               inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
-        
-        // Handle client (in a real application, you'd use threads)
-        handle_client_connection(client_socket);
+        if (pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]) != 0) {
+            fprintf(stderr, "Failed to start worker thread %d\n", i);
+            close(workers[i].epoll_fd);
+            close(workers[i].listen_fd);
+            break;
+        }
+        started++;
+    }
+    
+    if (started < num_workers) {
+        running = 0;
+    } else {
+        printf("Server listening on port %d\n", port);
+        printf("Press Ctrl+C to stop the server\n");
     }
     
-    // Cleanup
-    if (server_socket != -1) {
-        close(server_socket);
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        close(workers[i].epoll_fd);
+        close(workers[i].listen_fd);
     }
+    free(workers);
     
+    printf("\nShutting down...\n");
+    
+    log_shutdown();
     cleanup_openssl();
     printf("Server stopped\n");
     
-    return 0;
-} 
\ No newline at end of file
+    return started == num_workers ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <openssl/rand.h>
+
+#include "trace_id.h"
+#include "hex.h"
+
+#define TRACEID_BYTES 16
+#define SPANID_BYTES 8
+#define TRACE_CONTEXT_BYTES (TRACEID_BYTES + SPANID_BYTES)
+
+typedef struct {
+    unsigned char buf[TRACE_ID_POOL_SIZE];
+    size_t pos;
+} trace_id_pool_t;
+
+// Starts out empty so the first use refills it
+static __thread trace_id_pool_t pool = { .pos = TRACE_ID_POOL_SIZE };
+static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+
+// A forked child must not hand out the IDs still buffered in its parent
+static void pool_reset_after_fork(void) {
+    pool.pos = TRACE_ID_POOL_SIZE;
+}
+
+static void register_atfork(void) {
+    pthread_atfork(NULL, NULL, pool_reset_after_fork);
+}
+
+static inline const unsigned char *pool_take(size_t len) {
+    if (pool.pos + len > TRACE_ID_POOL_SIZE) {
+        pthread_once(&atfork_once, register_atfork);
+        if (RAND_bytes(pool.buf, TRACE_ID_POOL_SIZE) != 1) {
+            fprintf(stderr, "Failed to refill trace ID pool\n");
+            return NULL;
+        }
+        pool.pos = 0;
+    }
+    
+    const unsigned char *bytes = pool.buf + pool.pos;
+    pool.pos += len;
+    return bytes;
+}
+
+// Fill a 33-byte traceid and a 17-byte spanid buffer with fresh IDs
+int trace_id_fill(char *traceid, char *spanid) {
+    if (!traceid || !spanid) {
+        return -1;
+    }
+    
+    const unsigned char *bytes = pool_take(TRACE_CONTEXT_BYTES);
+    if (!bytes) {
+        return -1;
+    }
+    
+    hex_encode(traceid, bytes, TRACEID_BYTES);
+    traceid[TRACEID_BYTES * 2] = '\0';
+    hex_encode(spanid, bytes + TRACEID_BYTES, SPANID_BYTES);
+    spanid[SPANID_BYTES * 2] = '\0';
+    
+    return 0;
+}
+
+int trace_id_generate(tracing_data_t *tracing) {
+    if (!tracing) {
+        return -1;
+    }
+    
+    return trace_id_fill(tracing->traceid, tracing->spanid);
+}
+
+int trace_id_generate_bulk(tracing_data_t *tracing, size_t count) {
+    if (!tracing) {
+        return -1;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        if (trace_id_fill(tracing[i].traceid, tracing[i].spanid) != 0) {
+            return -1;
+        }
+    }
+    
+    return 0;
+}
+
+// Read "traceid" and "spanid" from a JSON frame of the simple protocol:
+// both must be present, with 32 and 16 hex characters
+int trace_id_parse_json(const char *json_data, tracing_data_t *tracing) {
+    if (!json_data || !tracing) {
+        return -1;
+    }
+    
+    // Simple JSON parsing (in production, use a proper JSON library)
+    const char *traceid_start = strstr(json_data, "\"traceid\": \"");
+    const char *spanid_start = strstr(json_data, "\"spanid\": \"");
+    if (!traceid_start || !spanid_start) {
+        return -1;
+    }
+    
+    // Extract traceid
+    traceid_start += 12; // Skip "\"traceid\": \""
+    const char *traceid_end = strchr(traceid_start, '"');
+    if (!traceid_end || (traceid_end - traceid_start) != 32 || !hex_validate(traceid_start, 32)) {
+        return -1;
+    }
+    
+    // Extract spanid
+    spanid_start += 11; // Skip "\"spanid\": \""
+    const char *spanid_end = strchr(spanid_start, '"');
+    if (!spanid_end || (spanid_end - spanid_start) != 16 || !hex_validate(spanid_start, 16)) {
+        return -1;
+    }
+    
+    memcpy(tracing->traceid, traceid_start, 32);
+    tracing->traceid[32] = '\0';
+    memcpy(tracing->spanid, spanid_start, 16);
+    tracing->spanid[16] = '\0';
+    return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef TRACE_ID_H
+#define TRACE_ID_H
+
+#include <stddef.h>
+
+// Tracing structure
+typedef struct {
+    char traceid[33];  // 32 hex chars + null terminator
+    char spanid[17];   // 16 hex chars + null terminator
+} tracing_data_t;
+
+// Random bytes are drawn from a per-thread pool that is refilled from
+// RAND_bytes() in TRACE_ID_POOL_SIZE chunks, so minting an ID takes no
+// locks and calls into OpenSSL only once every ~170 IDs.
+#define TRACE_ID_POOL_SIZE 4096
+
+// Function declarations
+int trace_id_fill(char *traceid, char *spanid);
+int trace_id_generate(tracing_data_t *tracing);
+int trace_id_generate_bulk(tracing_data_t *tracing, size_t count);
+int trace_id_parse_json(const char *json_data, tracing_data_t *tracing);
+
+#endif // TRACE_ID_H